@@ -874,6 +874,28 @@ unsigned int Array::width(bool constrained) const
 }
 #endif
 
+/**
+ * @brief Returns the width of the data, in bytes, as a 64-bit value.
+ *
+ * The number of elements is computed from the sizes of the dimensions,
+ * which avoids the overflow of length() for very large arrays.
+ *
+ * @param constrained If true, use the sizes of the dimensions after the
+ * current constraint has been applied. False by default.
+ * @return The number of bytes needed to store the array values.
+ */
+int64_t Array::width_ll(bool constrained) const
+{
+    if (_shape.empty())
+        return Vector::width_ll(constrained);
+
+    int64_t length = 1;
+    for (Dim_citer i = _shape.begin(); i != _shape.end(); i++)
+        length *= constrained ? (*i).c_size : (*i).size;
+
+    return length * prototype()->width_ll(constrained);
+}
+
 class PrintD4ArrayDimXMLWriter: public unary_function<Array::dimension&, void> {
     XMLWriter &xml;
 // Was this variable constrained using local/direct slicing? i.e., is d_local_constraint set?
@@ -246,6 +246,8 @@ public:
 
     virtual unsigned int dimensions(bool constrained = false);
 
+    virtual int64_t width_ll(bool constrained = false) const;
+
     virtual D4Maps *maps();
 
     virtual void print_dap4(XMLWriter &xml, bool constrained = false);
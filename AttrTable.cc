@@ -33,6 +33,8 @@
 #include "config.h"
 
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <sstream>
 
 #include "AttrTable.h"
@@ -40,6 +42,7 @@
 #include "util.h"
 #include "escaping.h"
 #include "DapIndent.h"
+#include "IndexLock.h"
 
 #include "debug.h"
 
@@ -155,6 +158,133 @@ AttrType String_to_AttrType(const string &s)
         return Attr_unknown;
 }
 
+// Numeric values added using the typed versions of append_attr() are held in
+// binary form in entry::buf. These functions read them and convert them to
+// text.
+
+// The size of a value of type t held in entry::buf; zero for types that are
+// not held in binary form.
+static unsigned int attr_type_width(AttrType t)
+{
+    switch (t) {
+    case Attr_byte:
+        return sizeof(dods_byte);
+    case Attr_int16:
+        return sizeof(dods_int16);
+    case Attr_uint16:
+        return sizeof(dods_uint16);
+    case Attr_int32:
+        return sizeof(dods_int32);
+    case Attr_uint32:
+        return sizeof(dods_uint32);
+    case Attr_float32:
+        return sizeof(dods_float32);
+    case Attr_float64:
+        return sizeof(dods_float64);
+    default:
+        return 0;
+    }
+}
+
+template<typename T>
+static T binary_value(const char *p)
+{
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+// Write the value of type t at p using the same format the Byte, ...,
+// Float64 classes use to print values.
+static void write_binary_value(ostream &out, AttrType t, const char *p)
+{
+    switch (t) {
+    case Attr_byte:
+        out << (int) binary_value<dods_byte>(p);
+        break;
+    case Attr_int16:
+        out << binary_value<dods_int16>(p);
+        break;
+    case Attr_uint16:
+        out << binary_value<dods_uint16>(p);
+        break;
+    case Attr_int32:
+        out << binary_value<dods_int32>(p);
+        break;
+    case Attr_uint32:
+        out << binary_value<dods_uint32>(p);
+        break;
+    case Attr_float32: {
+        std::streamsize prec = out.precision(6);
+        out << binary_value<dods_float32>(p);
+        out.precision(prec);
+        break;
+    }
+    case Attr_float64: {
+        std::streamsize prec = out.precision(15);
+        out << binary_value<dods_float64>(p);
+        out.precision(prec);
+        break;
+    }
+    default:
+        throw InternalErr(__FILE__, __LINE__, "Unexpected attribute type.");
+    }
+}
+
+// Return the ith value of e, which holds binary values, as text
+static string binary_value_to_string(const AttrTable::entry *e, unsigned int i)
+{
+    ostringstream oss;
+    write_binary_value(oss, e->type, &(*e->buf)[0] + i * attr_type_width(e->type));
+    return oss.str();
+}
+
+// Return the ith value of e, which holds binary values, as a double
+static double binary_value_to_double(const AttrTable::entry *e, unsigned int i)
+{
+    const char *p = &(*e->buf)[0] + i * attr_type_width(e->type);
+    switch (e->type) {
+    case Attr_byte:
+        return binary_value<dods_byte>(p);
+    case Attr_int16:
+        return binary_value<dods_int16>(p);
+    case Attr_uint16:
+        return binary_value<dods_uint16>(p);
+    case Attr_int32:
+        return binary_value<dods_int32>(p);
+    case Attr_uint32:
+        return binary_value<dods_uint32>(p);
+    case Attr_float32:
+        return binary_value<dods_float32>(p);
+    case Attr_float64:
+        return binary_value<dods_float64>(p);
+    default:
+        throw InternalErr(__FILE__, __LINE__, "Unexpected attribute type.");
+    }
+}
+
+// Convert the values of e from binary form to strings. Call this before
+// using e->attr.
+static void make_strings(AttrTable::entry *e)
+{
+    if (!e->buf)
+        return;
+
+    unsigned int num = e->buf->size() / attr_type_width(e->type);
+    vector<string> *strings = new vector<string>;
+    strings->reserve(num);
+    for (unsigned int i = 0; i < num; ++i)
+        strings->push_back(binary_value_to_string(e, i));
+
+    delete e->buf;
+    e->buf = 0;
+    delete e->attr;
+    e->attr = strings;
+}
+
+// Tables with fewer entries than this are searched linearly
+static const unsigned int min_indexed_entries = 16;
+
 /** Clone the given attribute table in <tt>this</tt>.
  Protected. */
 void AttrTable::clone(const AttrTable &at)
@@ -172,7 +302,7 @@ void AttrTable::clone(const AttrTable &at)
     for (; i != ie; ++i) {
         // this deep-copies containers recursively
         entry *e = new entry(*(*i));
-        attr_map.push_back(e);
+        m_add_entry(e);
 
         // If the entry being added was a container,
         // set its parent to this to maintain invariant.
@@ -187,12 +317,12 @@ void AttrTable::clone(const AttrTable &at)
 
 //@{
 AttrTable::AttrTable() :
-    DapObj(), d_name(""), d_parent(0), attr_map(), d_is_global_attribute(true)
+    DapObj(), d_name(""), d_parent(0), attr_map(), d_is_global_attribute(true), d_index(), d_indexed(false)
 {
 }
 
 AttrTable::AttrTable(const AttrTable &rhs) :
-    DapObj()
+    DapObj(), d_index(), d_indexed(false)
 {
     clone(rhs);
 }
@@ -204,6 +334,34 @@ void AttrTable::delete_attr_table()
         delete *i;
     }
     attr_map.clear();
+    m_clear_index();
+}
+
+// Private. Add an entry to the end of the table and to the name index, if
+// the index has been built. If there is already an entry with the same name,
+// the index continues to reference the first one, as a linear search would.
+void AttrTable::m_add_entry(entry *e)
+{
+    attr_map.push_back(e);
+    if (d_indexed)
+        d_index.insert(std::make_pair(e->name, (unsigned int) (attr_map.size() - 1)));
+}
+
+// Private
+void AttrTable::m_build_index()
+{
+    d_index.clear();
+    for (unsigned int i = 0; i < attr_map.size(); ++i)
+        d_index.insert(std::make_pair(attr_map[i]->name, i));
+    d_indexed = true;
+}
+
+// Private. Call this when an entry is removed since the positions of the
+// entries that follow it change.
+void AttrTable::m_clear_index()
+{
+    d_index.clear();
+    d_indexed = false;
 }
 
 AttrTable::~AttrTable()
@@ -323,6 +481,7 @@ unsigned int AttrTable::append_attr(const string &name, const string &type, cons
         throw Error(string("An attribute called `") + name + string("' already exists but is a container."));
 
     if (iter != attr_map.end()) { // Must be a new attribute value; add it.
+        make_strings(*iter);
         (*iter)->attr->push_back(value);
         return (*iter)->attr->size();
     }
@@ -335,7 +494,7 @@ unsigned int AttrTable::append_attr(const string &name, const string &type, cons
         e->attr = new vector<string> ;
         e->attr->push_back(value);
 
-        attr_map.push_back(e);
+        m_add_entry(e);
 
         return e->attr->size(); // return the length of the attr vector
     }
@@ -377,6 +536,7 @@ unsigned int AttrTable::append_attr(const string &name, const string &type, vect
         throw Error(string("An attribute called `") + name + string("' already exists but is a container."));
 
     if (iter != attr_map.end()) { // Must be new attribute values; add.
+        make_strings(*iter);
         vector<string>::iterator i = values->begin();
         while (i != values->end())
             (*iter)->attr->push_back(*i++);
@@ -391,12 +551,117 @@ unsigned int AttrTable::append_attr(const string &name, const string &type, vect
         e->type = String_to_AttrType(type); // Record type using standard names.
         e->attr = new vector<string> (*values);
 
-        attr_map.push_back(e);
+        m_add_entry(e);
 
         return e->attr->size(); // return the length of the attr vector
     }
 }
 
+/** Add numeric values to an attribute, creating it if needed. The values
+ are stored in binary form; if the attribute already holds its values as
+ strings, the new values are added as strings. */
+template<typename T>
+unsigned int AttrTable::append_attr_worker(const string &name, AttrType type, const T *values, unsigned int num)
+{
+#if WWW_ENCODING
+    string lname = www2id(name);
+#else
+    string lname = remove_space_encoding(name);
+#endif
+    Attr_iter iter = simple_find(lname);
+
+    if (iter != attr_map.end() && (*iter)->type == Attr_container)
+        throw Error(string("An attribute called `") + name + string("' already exists but is a container."));
+    if (iter != attr_map.end() && (*iter)->type != type)
+        throw Error(string("An attribute called `") + name + string("' already exists but is of a different type"));
+
+    // An attribute without values cannot be written in a DAS
+    if (num == 0 && iter == attr_map.end())
+        throw Error(string("The attribute `") + name + string("' must have at least one value."));
+
+    const char *bytes = reinterpret_cast<const char *>(values);
+
+    if (iter != attr_map.end()) {
+        entry *e = *iter;
+        if (e->buf) {
+            e->buf->insert(e->buf->end(), bytes, bytes + num * sizeof(T));
+            return e->buf->size() / sizeof(T);
+        }
+
+        for (unsigned int i = 0; i < num; ++i) {
+            ostringstream oss;
+            write_binary_value(oss, type, bytes + i * sizeof(T));
+            e->attr->push_back(oss.str());
+        }
+        return e->attr->size();
+    }
+    else {
+        entry *e = new entry;
+
+        e->name = lname;
+        e->is_alias = false;
+        e->type = type;
+        e->buf = new vector<char>(bytes, bytes + num * sizeof(T));
+
+        m_add_entry(e);
+
+        return num;
+    }
+}
+
+/** @name Add numeric values
+ These versions of append_attr() store the values in binary form. The values
+ are converted to text only when the attribute is printed or its values are
+ read as strings (e.g., using get_attr() or get_attr_vector()), so adding
+ large numeric attributes is much faster than formatting each value and
+ using the string version of append_attr().
+
+ The type of the attribute is determined by the type of \e values. As with
+ the other versions, the values are added to an existing attribute.
+
+ @param name The name of the attribute to add or modify.
+ @param values The values
+ @param num The number of values
+ @return The number of values held by the attribute.
+ @exception Error if an attribute with the same name but a different type
+ already exists, or if \e num is zero and the attribute does not exist. */
+//@{
+unsigned int AttrTable::append_attr(const string &name, const dods_byte *values, unsigned int num)
+{
+    return append_attr_worker(name, Attr_byte, values, num);
+}
+
+unsigned int AttrTable::append_attr(const string &name, const dods_int16 *values, unsigned int num)
+{
+    return append_attr_worker(name, Attr_int16, values, num);
+}
+
+unsigned int AttrTable::append_attr(const string &name, const dods_uint16 *values, unsigned int num)
+{
+    return append_attr_worker(name, Attr_uint16, values, num);
+}
+
+unsigned int AttrTable::append_attr(const string &name, const dods_int32 *values, unsigned int num)
+{
+    return append_attr_worker(name, Attr_int32, values, num);
+}
+
+unsigned int AttrTable::append_attr(const string &name, const dods_uint32 *values, unsigned int num)
+{
+    return append_attr_worker(name, Attr_uint32, values, num);
+}
+
+unsigned int AttrTable::append_attr(const string &name, const dods_float32 *values, unsigned int num)
+{
+    return append_attr_worker(name, Attr_float32, values, num);
+}
+
+unsigned int AttrTable::append_attr(const string &name, const dods_float64 *values, unsigned int num)
+{
+    return append_attr_worker(name, Attr_float64, values, num);
+}
+//@}
+
 /** Create and append an attribute container to this AttrTable. If this
  attribute table already contains an attribute container called
  <tt>name</tt> an exception is thrown. Return a pointer to the new container.
@@ -457,7 +722,7 @@ AttrTable::append_container(AttrTable *at, const string &name)
     e->type = Attr_container;
     e->attributes = at;
 
-    attr_map.push_back(e);
+    m_add_entry(e);
 
     at->d_parent = this;
 
@@ -512,23 +777,19 @@ void AttrTable::find(const string &target, AttrTable **at, Attr_iter *iter)
 AttrTable *
 AttrTable::recurrsive_find(const string &target, Attr_iter *location)
 {
-    Attr_iter i = attr_begin();
-    while (i != attr_end()) {
-        if (target == (*i)->name) {
-            *location = i;
-            return this;
-        }
-        else if ((*i)->type == Attr_container) {
+    // Only the containers that come before a match in this table need to
+    // be searched.
+    Attr_iter match = simple_find(target);
+    for (Attr_iter i = attr_begin(); i != match; ++i) {
+        if ((*i)->type == Attr_container) {
             AttrTable *at = (*i)->attributes->recurrsive_find(target, location);
             if (at)
                 return at;
         }
-
-        ++i;
     }
 
-    *location = i;
-    return 0;
+    *location = match;
+    return (match != attr_end()) ? this : 0;
 }
 
 // Made public for callers that want non-recursive find.  [mjohnson 6 oct 09]
@@ -540,13 +801,22 @@ AttrTable::recurrsive_find(const string &target, Attr_iter *location)
  @return An Attr_iter which references \c target. */
 AttrTable::Attr_iter AttrTable::simple_find(const string &target)
 {
-    Attr_iter i;
-    for (i = attr_map.begin(); i != attr_map.end(); ++i) {
-        if (target == (*i)->name) {
-            break;
+    if (attr_map.size() < min_indexed_entries) {
+        Attr_iter i;
+        for (i = attr_map.begin(); i != attr_map.end(); ++i) {
+            if (target == (*i)->name) {
+                break;
+            }
         }
+        return i;
     }
-    return i;
+
+    IndexLock lock(this);
+    if (!d_indexed)
+        m_build_index();
+
+    std::map<string, unsigned int>::const_iterator i = d_index.find(target);
+    return (i != d_index.end()) ? attr_map.begin() + i->second : attr_map.end();
 }
 
 /** Look in this attribute table for an attribute container named
@@ -585,13 +855,10 @@ AttrTable::simple_find_container(const string &target)
     if (get_name() == target)
         return this;
 
-    for (Attr_iter i = attr_map.begin(); i != attr_map.end(); ++i) {
-        if (is_container(i) && target == (*i)->name) {
-            return (*i)->attributes;
-        }
-    }
-
-    return 0;
+    // The append methods ensure that an attribute and a container never
+    // share a name, so the first entry called target is the only candidate.
+    Attr_iter i = simple_find(target);
+    return (i != attr_map.end() && is_container(i)) ? (*i)->attributes : 0;
 }
 
 /** Each of the following accessors get information using the name of an
@@ -685,6 +952,7 @@ void AttrTable::del_attr(const string &name, int i)
         if (i == -1) { // Delete the whole attribute
             entry *e = *iter;
             attr_map.erase(iter);
+            m_clear_index();
             delete e;
             e = 0;
         }
@@ -694,7 +962,21 @@ void AttrTable::del_attr(const string &name, int i)
             if ((*iter)->type == Attr_container)
                 return;
 
-            vector<string> *sxp = (*iter)->attr;
+            entry *e = *iter;
+            if (e->buf) {
+                unsigned int width = attr_type_width(e->type);
+                assert(i >= 0 && i < (int) (e->buf->size() / width));
+                e->buf->erase(e->buf->begin() + i * width, e->buf->begin() + (i + 1) * width);
+                // A numeric attribute must have at least one value
+                if (e->buf->empty()) {
+                    attr_map.erase(iter);
+                    m_clear_index();
+                    delete e;
+                }
+                return;
+            }
+
+            vector<string> *sxp = e->attr;
 
             assert(i >= 0 && i < (int) sxp->size());
             sxp->erase(sxp->begin() + i); // rm the element
@@ -799,6 +1081,7 @@ AttrTable::Attr_iter AttrTable::del_attr_table(Attr_iter iter)
 
     delete e;
 
+    m_clear_index();
     return attr_map.erase(iter);
 }
 
@@ -829,7 +1112,12 @@ AttrType AttrTable::get_attr_type(Attr_iter iter)
 unsigned int AttrTable::get_attr_num(Attr_iter iter)
 {
     assert(iter != attr_map.end());
-    return ((*iter)->type == Attr_container) ? (*iter)->attributes->get_size() : (*iter)->attr->size();
+    if ((*iter)->type == Attr_container)
+        return (*iter)->attributes->get_size();
+    else if ((*iter)->buf)
+        return (*iter)->buf->size() / attr_type_width((*iter)->type);
+    else
+        return (*iter)->attr->size();
 }
 
 /** Returns the value of an attribute. If the attribute has a vector
@@ -852,7 +1140,12 @@ string AttrTable::get_attr(Attr_iter iter, unsigned int i)
 {
     assert(iter != attr_map.end());
 
-    return (*iter)->type == Attr_container ? (string) "None" : (*(*iter)->attr)[i];
+    if ((*iter)->type == Attr_container)
+        return "None";
+    else if ((*iter)->buf)
+        return binary_value_to_string(*iter, i);
+    else
+        return (*(*iter)->attr)[i];
 }
 
 string AttrTable::get_attr(const string &name, unsigned int i)
@@ -876,9 +1169,93 @@ vector<string> *
 AttrTable::get_attr_vector(Attr_iter iter)
 {
     assert(iter != attr_map.end());
-    return (*iter)->type != Attr_container ? (*iter)->attr : 0;
+    if ((*iter)->type == Attr_container)
+        return 0;
+
+    make_strings(*iter);
+    return (*iter)->attr;
+}
+
+/** Copy the values of a numeric attribute into \e values, converting them
+ to type T. Values held as strings are parsed. */
+template<typename T>
+void AttrTable::get_attr_values_worker(Attr_iter iter, AttrType type, vector<T> &values)
+{
+    assert(iter != attr_map.end());
+
+    entry *e = *iter;
+    if (attr_type_width(e->type) == 0)
+        throw Error("The attribute `" + e->name + "' does not hold numeric values.");
+
+    unsigned int num = get_attr_num(iter);
+    values.clear();
+    values.reserve(num);
+
+    if (e->buf && e->type == type) {
+        values.resize(num);
+        if (num > 0)
+            memcpy(&values[0], &(*e->buf)[0], num * sizeof(T));
+    }
+    else if (e->buf) {
+        for (unsigned int i = 0; i < num; ++i)
+            values.push_back(static_cast<T>(binary_value_to_double(e, i)));
+    }
+    else {
+        for (unsigned int i = 0; i < num; ++i) {
+            const char *start = (*e->attr)[i].c_str();
+            char *end;
+            double value = strtod(start, &end);
+            if (end == start)
+                throw Error("The value `" + (*e->attr)[i] + "' of the attribute `" + e->name + "' is not a number.");
+            values.push_back(static_cast<T>(value));
+        }
+    }
+}
+
+/** @name Get numeric values
+ Copy the values of the numeric attribute referenced by \e iter into
+ \e values. Values are converted to the type of \e values if needed.
+
+ @param iter Reference to the attribute.
+ @param values Value-result parameter; holds the values on return.
+ @exception Error if the attribute does not hold numeric values. */
+//@{
+void AttrTable::get_attr_values(Attr_iter iter, vector<dods_byte> &values)
+{
+    get_attr_values_worker(iter, Attr_byte, values);
+}
+
+void AttrTable::get_attr_values(Attr_iter iter, vector<dods_int16> &values)
+{
+    get_attr_values_worker(iter, Attr_int16, values);
+}
+
+void AttrTable::get_attr_values(Attr_iter iter, vector<dods_uint16> &values)
+{
+    get_attr_values_worker(iter, Attr_uint16, values);
 }
 
+void AttrTable::get_attr_values(Attr_iter iter, vector<dods_int32> &values)
+{
+    get_attr_values_worker(iter, Attr_int32, values);
+}
+
+void AttrTable::get_attr_values(Attr_iter iter, vector<dods_uint32> &values)
+{
+    get_attr_values_worker(iter, Attr_uint32, values);
+}
+
+void AttrTable::get_attr_values(Attr_iter iter, vector<dods_float32> &values)
+{
+    get_attr_values_worker(iter, Attr_float32, values);
+}
+
+void AttrTable::get_attr_values(Attr_iter iter, vector<dods_float64> &values)
+{
+    get_attr_values_worker(iter, Attr_float64, values);
+}
+//@}
+
 bool AttrTable::is_global_attribute(Attr_iter iter)
 {
     assert(iter != attr_map.end());
@@ -924,7 +1301,7 @@ void AttrTable::add_container_alias(const string &name, AttrTable *src)
 
     e->attributes = src;
 
-    attr_map.push_back(e);
+    m_add_entry(e);
 }
 
 /** Assume \e source names an attribute value in some container. Add an alias
@@ -987,10 +1364,13 @@ void AttrTable::add_value_alias(AttrTable *das, const string &name, const string
     e->type = get_attr_type(iter);
     if (at && e->type == Attr_container)
         e->attributes = at->get_attr_table(iter);
-    else
+    else {
+        // The alias shares the vector of strings with its source
+        make_strings(*iter);
         e->attr = (*iter)->attr;
+    }
 
-    attr_map.push_back(e);
+    m_add_entry(e);
 }
 
 // Deprecated
@@ -1041,6 +1421,7 @@ void AttrTable::erase()
     }
 
     attr_map.erase(attr_map.begin(), attr_map.end());
+    m_clear_index();
 
     d_name = "";
 }
@@ -1219,6 +1600,18 @@ void AttrTable::simple_print(ostream &out, string pad, Attr_iter i, bool derefer
 #else
         out << pad << get_type(i) << " " << add_space_encoding(get_name(i)) << " ";
 #endif
+        if ((*i)->buf) {
+            // Format binary values directly to the stream
+            unsigned int width = attr_type_width((*i)->type);
+            unsigned int num = (*i)->buf->size() / width;
+            const char *values = num > 0 ? &(*(*i)->buf)[0] : 0;
+            for (unsigned int j = 0; j < num; ++j) {
+                write_binary_value(out, (*i)->type, values + j * width);
+                out << ((j < num - 1) ? ", " : ";\n");
+            }
+            break;
+        }
+
         vector<string> *sxp = (*i)->attr;
         vector<string>::iterator last = sxp->end() - 1;
         for (vector<string>::iterator i = sxp->begin(); i != last; ++i) {
@@ -1533,6 +1926,13 @@ void AttrTable::dump(ostream &strm) const
                 strm << DapIndent::LMarg << "attr: " << e->name << " of type " << type << endl;
                 DapIndent::Indent();
                 strm << DapIndent::LMarg;
+                if (e->buf) {
+                    unsigned int num = e->buf->size() / attr_type_width(e->type);
+                    for (unsigned int j = 0; j < num; ++j)
+                        strm << binary_value_to_string(e, j) << ((j < num - 1) ? ", " : "\n");
+                    DapIndent::UnIndent();
+                    continue;
+                }
                 vector<string>::const_iterator iter = e->attr->begin();
                 vector<string>::const_iterator last = e->attr->end() - 1;
                 for (; iter != last; ++iter) {
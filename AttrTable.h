@@ -35,6 +35,7 @@
 #define _attrtable_h 1
 
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -50,6 +51,8 @@ using std::vector;
 #include "DapObj.h"
 #endif
 
+#include "dods-datatypes.h"
+
 #ifndef XMLWRITER_H_
 #include "XMLWriter.h"
 #endif
@@ -100,9 +103,11 @@ AttrType String_to_AttrType(const string &s);
     each name, either a type and a value, or another attribute table.
     The attribute value can be a vector containing many values of the
     same type.  The attributes can have any of the types listed in the
-    <tt>AttrType</tt> list.  However, all attribute types are stored as
-    string data, except for the container type, which is stored as a
-    pointer to another attribute table.
+    <tt>AttrType</tt> list.  Attribute values are stored as string data,
+    except for the container type, which is stored as a pointer to another
+    attribute table, and numeric values added using the typed versions of
+    append_attr(), which are stored in binary form and converted to text
+    only when they are printed or read as strings.
 
     Each element in the attribute table can itself be an attribute
     table.  The table can also contain ``alias'' attributes whose
@@ -159,15 +164,18 @@ public:
         bool is_global; // use this to mark non-container attributes. see below.
 
         // If type == Attr_container, use attributes to read the contained
-        // table, otherwise use attr to read the vector of values.
+        // table, otherwise use attr to read the vector of values. Numeric
+        // values added in binary form are held in buf and attr is null until
+        // the values are needed as strings.
         AttrTable *attributes;
         std::vector<string> *attr; // a vector of values. jhrg 12/5/94
+        std::vector<char> *buf;
 
         entry(): name(""), type(Attr_unknown), is_alias(false),
-                aliased_to(""), is_global(true), attributes(0), attr(0) {}
+                aliased_to(""), is_global(true), attributes(0), attr(0), buf(0) {}
 
         entry(const entry &rhs): name(rhs.name), type(rhs.type), is_alias(rhs.is_alias),
-                aliased_to(rhs.aliased_to), is_global(rhs.is_global),attributes(0), attr(0)
+                aliased_to(rhs.aliased_to), is_global(rhs.is_global),attributes(0), attr(0), buf(0)
         {
             clone(rhs);
         }
@@ -181,6 +189,7 @@ public:
             }
             else {
                 delete attr; attr = 0;
+                delete buf; buf = 0;
             }
         }
 
@@ -211,6 +220,8 @@ public:
             default: {
                 if (rhs.is_alias)
                     attr = rhs.attr;
+                else if (rhs.buf)
+                    buf = new std::vector<char>(*rhs.buf);
                 else
                     attr = new std::vector<string>(*rhs.attr);
                 break;
@@ -244,8 +255,23 @@ private:
     // bound to a container and not any of the container's children.
     bool d_is_global_attribute;
 
+    // Positions of the entries in attr_map, keyed by name. Built by
+    // simple_find() when the table holds enough entries that a linear search
+    // is slow, kept up to date as entries are added and thrown away when one
+    // is removed. Entries stay in attr_map in the order they were added.
+    std::map<string, unsigned int> d_index;
+    bool d_indexed;
+
     void delete_attr_table();
 
+    void m_add_entry(entry *e);
+    void m_build_index();
+    void m_clear_index();
+
+    template <typename T> unsigned int append_attr_worker(const string &name, AttrType type, const T *values,
+        unsigned int num);
+    template <typename T> void get_attr_values_worker(Attr_iter iter, AttrType type, vector<T> &values);
+
     friend class AttrTableTest;
 
 protected:
@@ -284,6 +310,17 @@ public:
     virtual unsigned int append_attr(const string &name, const string &type,
 				     vector<string> *values);
 
+    // The typed overloads are not virtual; a subclass that overrides
+    // append_attr() or get_attr_values() should add 'using
+    // AttrTable::append_attr;' (or get_attr_values) to keep them visible.
+    unsigned int append_attr(const string &name, const dods_byte *values, unsigned int num);
+    unsigned int append_attr(const string &name, const dods_int16 *values, unsigned int num);
+    unsigned int append_attr(const string &name, const dods_uint16 *values, unsigned int num);
+    unsigned int append_attr(const string &name, const dods_int32 *values, unsigned int num);
+    unsigned int append_attr(const string &name, const dods_uint32 *values, unsigned int num);
+    unsigned int append_attr(const string &name, const dods_float32 *values, unsigned int num);
+    unsigned int append_attr(const string &name, const dods_float64 *values, unsigned int num);
+
     virtual AttrTable *append_container(const string &name);
     virtual AttrTable *append_container(AttrTable *at, const string &name);
 
@@ -316,6 +353,14 @@ public:
     virtual unsigned int get_attr_num(Attr_iter iter);
     virtual string get_attr(Attr_iter iter, unsigned int i = 0);
     virtual std::vector<string> *get_attr_vector(Attr_iter iter);
+
+    void get_attr_values(Attr_iter iter, vector<dods_byte> &values);
+    void get_attr_values(Attr_iter iter, vector<dods_int16> &values);
+    void get_attr_values(Attr_iter iter, vector<dods_uint16> &values);
+    void get_attr_values(Attr_iter iter, vector<dods_int32> &values);
+    void get_attr_values(Attr_iter iter, vector<dods_uint32> &values);
+    void get_attr_values(Attr_iter iter, vector<dods_float32> &values);
+    void get_attr_values(Attr_iter iter, vector<dods_float64> &values);
     virtual bool is_global_attribute(Attr_iter iter);
     virtual void set_is_global_attribute(Attr_iter iter, bool ga);
 
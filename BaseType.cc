@@ -97,12 +97,9 @@ BaseType::m_duplicate(const BaseType &bt)
 
     d_parent = bt.d_parent; // copy pointers 6/4/2001 jhrg
 
-    d_attr = bt.d_attr;  // Deep copy.
-
-    if (bt.d_attributes)
-        d_attributes = new D4Attributes(*bt.d_attributes); // deep copy
-    else
-        d_attributes = 0; // init to null if not used.
+    // Share the attributes; they are copied if either variable changes them.
+    d_attr = bt.d_attr;
+    d_attributes = bt.d_attributes;
 
     d_is_dap4 = bt.d_is_dap4;
 
@@ -125,8 +122,8 @@ BaseType::m_duplicate(const BaseType &bt)
     @see Type */
 BaseType::BaseType(const string &n, const Type &t, bool is_dap4)
 : d_name(n), d_type(t), d_dataset(""), d_is_read(false), d_is_send(false),
-  d_parent(0), d_attributes(0), d_is_dap4(is_dap4),
-  d_in_selection(false), d_is_synthesized(false)
+  d_parent(0), d_holder(0), d_attr(), d_attributes(), d_is_dap4(is_dap4),
+  d_names_version(1), d_sizes_version(1), d_dds(0), d_in_selection(false), d_is_synthesized(false)
 {}
 
 /** The BaseType constructor needs a name, a dataset, and a type.
@@ -143,12 +140,12 @@ BaseType::BaseType(const string &n, const Type &t, bool is_dap4)
     @see Type */
 BaseType::BaseType(const string &n, const string &d, const Type &t, bool is_dap4)
 : d_name(n), d_type(t), d_dataset(d), d_is_read(false), d_is_send(false),
-  d_parent(0), d_attributes(0), d_is_dap4(is_dap4),
-  d_in_selection(false), d_is_synthesized(false)
+  d_parent(0), d_holder(0), d_attr(), d_attributes(), d_is_dap4(is_dap4),
+  d_names_version(1), d_sizes_version(1), d_dds(0), d_in_selection(false), d_is_synthesized(false)
 {}
 
 /** @brief The BaseType copy constructor. */
-BaseType::BaseType(const BaseType &copy_from) : DapObj()
+BaseType::BaseType(const BaseType &copy_from) : DapObj(), d_holder(0), d_names_version(1), d_sizes_version(1), d_dds(0)
 {
     DBG(cerr << "In BaseTpe::copy_ctor for " << copy_from.name() << endl);
     m_duplicate(copy_from);
@@ -157,10 +154,6 @@ BaseType::BaseType(const BaseType &copy_from) : DapObj()
 BaseType::~BaseType()
 {
     DBG2(cerr << "Entering ~BaseType (" << this << ")" << endl);
-
-    if (d_attributes)
-        delete d_attributes;
-
     DBG2(cerr << "Exiting ~BaseType" << endl);
 }
 
@@ -172,6 +165,7 @@ BaseType::operator=(const BaseType &rhs)
         return *this;
 
     m_duplicate(rhs);
+    names_changed();
 
     DBG(cerr << "Exiting BaseType::operator=" << endl);
     return *this;
@@ -192,7 +186,8 @@ string BaseType::toString()
         << "          _send_p: " << d_is_send << endl
         << "          _synthesized_p: " << d_is_synthesized << endl
         << "          d_parent: " << d_parent << endl
-        << "          d_attr: " << hex << &d_attr << dec << endl;
+        << "          d_attr: " << hex << d_attr.get() << dec
+        << (d_attr.shared() ? " (shared)" : "") << endl;
 
     return oss.str();
 }
@@ -304,10 +299,10 @@ BaseType::dump(ostream &strm) const
     strm << DapIndent::LMarg << "attributes: " << endl ;
     DapIndent::Indent() ;
 
-    if (d_attributes)
-        d_attributes->dump(strm);
-    else
-        d_attr.dump(strm) ;
+    if (d_attributes.get())
+        d_attributes.get()->dump(strm);
+    else if (d_attr.get())
+        d_attr.get()->dump(strm) ;
 
     DapIndent::UnIndent() ;
 
@@ -345,6 +340,7 @@ BaseType::set_name(const string &n)
 {
     string name = n;
     d_name = www2id(name); // www2id writes into its param.
+    names_changed();
 }
 
 /** @brief Returns the name of the dataset used to create this instance
@@ -569,6 +565,8 @@ BaseType::set_send_p(bool state)
 {
     DBG2(cerr << "Calling BaseType::set_send_p() for: " << this->name()
         << endl);
+    if (d_is_send != state)
+        sizes_changed();
     d_is_send = state;
 }
 
@@ -577,11 +575,15 @@ BaseType::set_send_p(bool state)
     reference to a contained object, but in this case it seems that building
     an interface inside BaseType is overkill.
 
-    Use the AttrTable methods to manipulate the table. */
+    Use the AttrTable methods to manipulate the table.
+
+    @note Copies of a variable share its attributes until one of them calls
+    this method. Do not keep the reference after copying the variable;
+    changes made using it would be seen by the copy. */
 AttrTable &
 BaseType::get_attr_table()
 {
-    return d_attr;
+    return *d_attr.get_for_write();
 }
 
 /** Set this variable's attribute table.
@@ -589,29 +591,42 @@ BaseType::get_attr_table()
 void
 BaseType::set_attr_table(const AttrTable &at)
 {
-    d_attr = at;
+    d_attr.reset(new AttrTable(at));
 }
 
 /** DAP4 Attribute methods
  * @{
  */
+/** @note See the note about sharing attributes in get_attr_table(). */
 D4Attributes *
 BaseType::attributes()
 {
-    if (!d_attributes) d_attributes = new D4Attributes();
-    return d_attributes;
+    return d_attributes.get_for_write();
 }
 
 void
 BaseType::set_attributes(D4Attributes *attrs)
 {
-    d_attributes = new D4Attributes(*attrs);
+    d_attributes.reset(new D4Attributes(*attrs));
 }
 
+/** Use \e attrs as this variable's attributes. The variable takes
+    ownership of \e attrs and deletes the attributes it held before.
+
+    Passing null gives up the attributes without deleting them. This is the
+    second half of moving the attributes from one variable to another (see
+    D4ParserSax2::process_dimension()):
+    @code
+    a->set_attributes_nocopy(b->attributes());
+    b->set_attributes_nocopy(0);
+    @endcode */
 void
 BaseType::set_attributes_nocopy(D4Attributes *attrs)
 {
-    d_attributes = attrs;
+    D4Attributes *old = d_attributes.release();
+    d_attributes.reset(attrs);
+    if (attrs && old != attrs)
+        delete old;
 }
 ///@}
 
@@ -738,6 +753,81 @@ BaseType::set_parent(BaseType *parent)
         throw InternalErr("Call to set_parent with incorrect variable type.");
 
     d_parent = parent;
+    d_holder = parent;
+    // A variable held by a Constructor or Vector is not at the top level
+    // of a DDS
+    if (parent)
+        m_set_dds(0);
+    names_changed();
+}
+
+// Private. Record that \e dds holds this variable at its top level (or, if
+// \e dds is null, that no DDS does). DDS calls this when it adds, inserts
+// or deletes a variable. A variable at the top level of a DDS is not held
+// by a Constructor or Vector, even if it was before it was moved there.
+void
+BaseType::m_set_dds(DDS *dds)
+{
+    // The DDS that held the variable must rebuild its index
+    if (d_dds && d_dds != dds)
+        d_dds->names_changed();
+
+    d_dds = dds;
+    if (dds)
+        d_holder = 0;
+}
+
+/** Record that this variable was renamed, or that a variable was added to
+    or removed from it. set_name() and set_parent() call this; code that
+    changes the variables held by a Constructor without using set_parent()
+    must call it too.
+
+    The DDS and Constructor classes build indexes of the names of the
+    variables they hold to speed up var(). This method changes the value of
+    names_version() for this variable and for the Constructors, Vectors and
+    DDS that hold it, so that only their indexes are rebuilt. */
+void
+BaseType::names_changed()
+{
+    for (BaseType *btp = this; btp; btp = btp->d_holder) {
+        ++btp->d_names_version;
+        if (btp->d_dds)
+            btp->d_dds->names_changed();
+    }
+
+    sizes_changed();
+}
+
+/** @return A number that changes whenever names_changed() is called for
+    this variable or for one of the variables it holds. */
+unsigned long
+BaseType::names_version() const
+{
+    return d_names_version;
+}
+
+/** Record that the value returned by width_ll() might have changed for this
+    variable. set_send_p(), Vector::set_length() and names_changed() call
+    this. It changes the value of sizes_version() for this variable and for
+    the Constructors and Vectors that hold it, and tells the DDS that holds
+    them. DDS::get_request_size_kb() and DMR::request_size_kb() cache their
+    results until the DDS or the root group of the DMR changes. */
+void
+BaseType::sizes_changed()
+{
+    for (BaseType *btp = this; btp; btp = btp->d_holder) {
+        ++btp->d_sizes_version;
+        if (btp->d_dds)
+            btp->d_dds->sizes_changed();
+    }
+}
+
+/** @return A number that changes whenever sizes_changed() is called for
+    this variable or for one of the variables it holds. */
+unsigned long
+BaseType::sizes_version() const
+{
+    return d_sizes_version;
 }
 
 // Public method.
@@ -1301,4 +1391,19 @@ BaseType::width(bool /* constrained */) const
     throw InternalErr(__FILE__, __LINE__, "not implemented");
 }
 
+/**
+ * Like width(), but returns a 64-bit value so that the size of large
+ * arrays, and of the variables that hold them, does not overflow. The
+ * default is the value returned by width(); the Vector, Array and
+ * Constructor classes compute their size using 64-bit arithmetic.
+ *
+ * @param constrained Should the current constraint be taken into account?
+ * @return Bytes of storage
+ */
+int64_t
+BaseType::width_ll(bool constrained) const
+{
+    return width(constrained);
+}
+
 } // namespace libdap
@@ -48,6 +48,7 @@
 #include <string>
 
 #include "AttrTable.h"
+#include "CopyOnWrite.h"
 
 #include "InternalErr.h"
 
@@ -129,13 +130,38 @@ private:
     // classes must maintain this variable.
     BaseType *d_parent;
 
+    // The Constructor or Vector that holds this variable, as set by
+    // set_parent(). Unlike d_parent it is not copied: a copy has the same
+    // d_parent as the variable it was copied from, but that variable does
+    // not hold it. names_changed() and sizes_changed() follow this pointer.
+    BaseType *d_holder;
+
     // Attributes for this variable. Added 05/20/03 jhrg
-    AttrTable d_attr;
+    // Copies of a variable share its attributes until either one changes
+    // them; neither table is made until it is used.
+    CopyOnWrite<AttrTable> d_attr;
 
-    D4Attributes *d_attributes;
+    CopyOnWrite<D4Attributes> d_attributes;
 
     bool d_is_dap4;         // True if this is a DAP4 variable, false ... DAP2
 
+    // Changes when this variable, or one it holds, is renamed, added or
+    // removed; see names_changed().
+    unsigned long d_names_version;
+
+    // Changes when the value returned by width_ll() might have changed for
+    // this variable or one it holds; see sizes_changed().
+    unsigned long d_sizes_version;
+
+    // The DDS that holds this variable at its top level, or null. Set by
+    // the DDS so names_changed() and sizes_changed() can tell it its index
+    // or size estimate is stale.
+    DDS *d_dds;
+
+    void m_set_dds(DDS *dds);
+
+    friend class DDS;
+
     // These are non-empty only for DAP4 variables. Added 9/27/12 jhrg
 
 protected:
@@ -242,6 +268,12 @@ public:
     virtual void set_parent(BaseType *parent);
     virtual BaseType *get_parent() const;
 
+    void names_changed();
+    unsigned long names_version() const;
+
+    void sizes_changed();
+    unsigned long sizes_version() const;
+
     virtual void transfer_attributes(AttrTable *at);
 
     // I put this comment here because the version in BaseType.cc does not
@@ -292,6 +324,7 @@ public:
     virtual bool d4_ops(BaseType *b, int op);
 
     virtual unsigned int width(bool constrained = false) const;
+    virtual int64_t width_ll(bool constrained = false) const;
 
     virtual void print_decl(FILE *out, string space = "    ",
                             bool print_semi = true,
@@ -245,4 +245,21 @@ Clause::value(DDS &dds, BaseType **value)
     }
 }
 
+/** @brief The variables used by this clause.
+    Append the variables (and constants) named as arguments of the clause to
+    \e vars. The clause is not evaluated.
+
+    @param vars Value-result parameter */
+void
+Clause::variables(std::vector<BaseType *> &vars) const
+{
+    if (_arg1)
+        _arg1->variables(vars);
+
+    if (_args) {
+        for (rvalue_list_citer i = _args->begin(); i != _args->end(); ++i)
+            (*i)->variables(vars);
+    }
+}
+
 } // namespace libdap
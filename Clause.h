@@ -124,6 +124,8 @@ public:
     bool value(DDS &dds);
 
     bool value(DDS &dds, BaseType **value);
+
+    void variables(std::vector<BaseType *> &vars) const;
 };
 
 } // namespace libdap
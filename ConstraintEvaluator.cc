@@ -24,12 +24,16 @@
 
 #include "config.h"
 
+#include <memory>
+
 //#define DODS_DEBUG
 
 #include "ServerFunctionsList.h"
 #include "ConstraintEvaluator.h"
 #include "Clause.h"
 #include "DataDDS.h"
+#include "ConstraintPlan.h"
+#include "ParallelTasks.h"
 
 #include "ce_parser.h"
 #include "debug.h"
@@ -38,16 +42,20 @@
 
 struct yy_buffer_state;
 
-int ce_exprparse(libdap::ce_parser_arg *arg);
+int ce_exprparse(libdap::ce_parser_arg *arg, void *scanner);
+
+// Made by flex for the reentrant scanner in ce_expr.lex
+int ce_exprlex_init(void **scanner);
+int ce_exprlex_destroy(void *scanner);
 
-// Glue routines declared in expr.lex
-void ce_expr_switch_to_buffer(void *new_buffer);
-void ce_expr_delete_buffer(void * buffer);
-void *ce_expr_string(const char *yy_str);
+// Glue routines declared in ce_expr.lex
+void ce_expr_switch_to_buffer(void *new_buffer, void *scanner);
+void ce_expr_delete_buffer(void * buffer, void *scanner);
+void *ce_expr_string(const char *yy_str, void *scanner);
 
 namespace libdap {
 
-ConstraintEvaluator::ConstraintEvaluator()
+ConstraintEvaluator::ConstraintEvaluator() : d_function_threads(1)
 {
     // Functions are now held in BES modules. jhrg 1/30/13
 
@@ -237,6 +245,103 @@ bool ConstraintEvaluator::function_clauses()
     return true;
 }
 
+// Evaluate the btp_func clauses of one group, in order, storing each result
+// at the clause's index in d_results.
+class FunctionClauseTasks: public ParallelTasks {
+private:
+    std::vector<Clause *> &d_clauses;
+    DDS &d_dds;
+    const std::vector<std::vector<unsigned int> > &d_groups;
+    std::vector<BaseType *> &d_results;
+
+protected:
+    virtual void run_task(unsigned int g)
+    {
+        for (std::vector<unsigned int>::const_iterator i = d_groups[g].begin(), e = d_groups[g].end(); i != e; ++i) {
+            if (!d_clauses[*i]->value(d_dds, &d_results[*i]))
+                throw Error(internal_error, "A function was called but failed to return a value.");
+        }
+    }
+
+public:
+    FunctionClauseTasks(std::vector<Clause *> &clauses, DDS &dds, const std::vector<std::vector<unsigned int> > &groups,
+        std::vector<BaseType *> &results) :
+        d_clauses(clauses), d_dds(dds), d_groups(groups), d_results(results)
+    {
+    }
+};
+
+// Private. Evaluate the clauses, adding the results to fdds in the order of
+// the clauses. When more than one thread may be used, clauses that use
+// different (top-level) variables are evaluated at the same time.
+void
+ConstraintEvaluator::m_eval_function_clauses(DDS &dds, DDS &fdds)
+{
+    if (d_function_threads < 2 || expr.size() < 2) {
+        for (unsigned int i = 0; i < expr.size(); ++i) {
+            Clause *cp = expr[i];
+            BaseType *result;
+            if (cp->value(dds, &result)) {
+                // This is correct: The function must allocate the memory for the result
+                // variable. 11/30/12 jhrg
+                fdds.add_var_nocopy(result);
+            }
+            else {
+                throw Error(internal_error, "A function was called but failed to return a value.");
+            }
+        }
+
+        return;
+    }
+
+    std::vector<std::vector<BaseType *> > vars(expr.size());
+    for (unsigned int i = 0; i < expr.size(); ++i)
+        expr[i]->variables(vars[i]);
+
+    std::vector<std::vector<unsigned int> > groups;
+    ParallelTasks::independent_groups(vars, groups);
+
+    std::vector<BaseType *> results(expr.size(), 0);
+    FunctionClauseTasks tasks(expr, dds, groups, results);
+    try {
+        tasks.run(groups.size(), d_function_threads);
+    }
+    catch (...) {
+        for (std::vector<BaseType *>::iterator i = results.begin(), e = results.end(); i != e; ++i)
+            delete *i;
+        throw;
+    }
+
+    for (std::vector<BaseType *>::iterator i = results.begin(), e = results.end(); i != e; ++i)
+        fdds.add_var_nocopy(*i);
+}
+
+/** @brief How many threads can eval_function_clauses() use?
+ @see set_function_threads() */
+unsigned int
+ConstraintEvaluator::get_function_threads() const
+{
+    return d_function_threads;
+}
+
+/** @brief Set the number of threads eval_function_clauses() can use.
+
+ By default the function clauses are evaluated one after the other. When
+ more than one thread is allowed, clauses that do not use the same
+ variables (clauses that use different fields of one Structure or Grid use
+ the same variable) are evaluated in parallel; the results are still
+ returned in the order of the clauses. Only use this when the server
+ functions, and the read() methods of the variables they use, are
+ reentrant. If any of the functions fail, the error returned for the first
+ one is thrown as an Error.
+
+ @param num_threads The maximum number of threads, including the caller's */
+void
+ConstraintEvaluator::set_function_threads(unsigned int num_threads)
+{
+    d_function_threads = num_threads;
+}
+
 /** @brief Evaluate a function-valued constraint expression that contains
  several function calls.
 
@@ -259,18 +364,12 @@ ConstraintEvaluator::eval_function_clauses(DDS &dds)
         throw InternalErr(__FILE__, __LINE__, "The constraint expression is empty.");
 
     DDS *fdds = new DDS(dds.get_factory(), "function_result_" + dds.get_dataset_name());
-    for (unsigned int i = 0; i < expr.size(); ++i) {
-        Clause *cp = expr[i];
-        BaseType *result;
-        if (cp->value(dds, &result)) {
-            // This is correct: The function must allocate the memory for the result
-            // variable. 11/30/12 jhrg
-            fdds->add_var_nocopy(result);
-        }
-        else {
-            delete fdds;
-            throw Error(internal_error, "A function was called but failed to return a value.");
-        }
+    try {
+        m_eval_function_clauses(dds, *fdds);
+    }
+    catch (...) {
+        delete fdds;
+        throw;
     }
 
     return fdds;
@@ -290,16 +389,12 @@ ConstraintEvaluator::eval_function_clauses(DataDDS &dds)
     DataDDS *fdds = new DataDDS(dds.get_factory(), "function_result_" + dds.get_dataset_name(), dds.get_version(),
             dds.get_protocol());
 
-    for (unsigned int i = 0; i < expr.size(); ++i) {
-        Clause *cp = expr[i];
-        BaseType *result;
-        if (cp->value(dds, &result)) {
-            fdds->add_var_nocopy(result);
-        }
-        else {
-            delete fdds;
-            throw Error(internal_error, "A function was called but failed to return a value.");
-        }
+    try {
+        m_eval_function_clauses(dds, *fdds);
+    }
+    catch (...) {
+        delete fdds;
+        throw;
     }
 
     return fdds;
@@ -356,27 +451,59 @@ bool ConstraintEvaluator::eval_selection(DDS &dds, const string &)
  As a side effect, mark the DDS so that BaseType's mfuncs can be used to
  correctly read the variable's value and send it to the client.
 
+ Projections (including array and sequence slices) are recorded in the
+ ConstraintPlanCache; when the same constraint is used again with a DDS
+ for the same dataset, the recorded changes are applied to the DDS and
+ the constraint is not parsed. Constraints with selection clauses or
+ function calls are always parsed.
+
  @param constraint A string containing the constraint expression.
  @param dds The DDS that provides the environment within which the
  constraint is evaluated.
  @exception Throws Error if the constraint does not parse. */
 void ConstraintEvaluator::parse_constraint(const string &constraint, DDS &dds)
 {
-    void *buffer = ce_expr_string(constraint.c_str());
+    // Functions and selections bind rvalues to this DDS; only projections
+    // are cached, so don't record the state of the DDS for other constraints
+    bool cacheable = constraint.find_first_of("(&") == string::npos;
+
+    ConstraintPlanCache *cache = ConstraintPlanCache::TheCache();
+    std::auto_ptr<ConstraintState> before(0);
+    if (cacheable && cache->get_max_plans() > 0) {
+        before.reset(new ConstraintState(dds));
+        if (cache->apply(constraint, *before)) return;
+    }
+
+    unsigned long num_clauses = expr.size();
+    unsigned long num_constants = constants.size();
+
+    // The scanner and parser are reentrant; each parse has its own scanner
+    void *scanner;
+    if (ce_exprlex_init(&scanner) != 0)
+        throw InternalErr(__FILE__, __LINE__, "Could not initialize the constraint expression scanner.");
 
-    ce_expr_switch_to_buffer(buffer);
+    void *buffer = ce_expr_string(constraint.c_str(), scanner);
+
+    ce_expr_switch_to_buffer(buffer, scanner);
 
     ce_parser_arg arg(this, &dds);
 
     // For all errors, exprparse will throw Error.
     try {
-    	ce_exprparse(&arg);
-    	ce_expr_delete_buffer(buffer);
+        ce_exprparse(&arg, scanner);
+        ce_expr_delete_buffer(buffer, scanner);
+        ce_exprlex_destroy(scanner);
     }
     catch (...) {
-    	// Make sure to remove the buffer when there's an error
-    	ce_expr_delete_buffer(buffer);
-    	throw;
+        // Make sure to remove the buffer and scanner when there's an error
+        ce_expr_delete_buffer(buffer, scanner);
+        ce_exprlex_destroy(scanner);
+        throw;
+    }
+
+    if (before.get() && expr.size() == num_clauses && constants.size() == num_constants) {
+        ConstraintState after(dds);
+        cache->add(constraint, *before, after);
     }
 }
 
@@ -49,6 +49,10 @@ private:
     ServerFunctionsList *d_functions_list;  // Known external functions from
                                             // modules
 
+    unsigned int d_function_threads;    // Max threads for eval_function_clauses()
+
+    void m_eval_function_clauses(DDS &dds, DDS &fdds);
+
     // The default versions of these methods will break this class. Because
     // Clause does not support deep copies, that class will need to be modified
     // before these can be properly implemented. jhrg 4/3/06
@@ -86,6 +90,9 @@ public:
     DDS *eval_function_clauses(DDS &dds);
     DataDDS *eval_function_clauses(DataDDS &dds);
 
+    unsigned int get_function_threads() const;
+    void set_function_threads(unsigned int num_threads);
+
     Clause_iter clause_begin();
     Clause_iter clause_end();
     bool clause_value(Clause_iter &i, DDS &dds);
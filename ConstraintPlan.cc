@@ -0,0 +1,498 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <pthread.h>
+#include <cstdlib>
+
+//#define DODS_DEBUG
+
+#include "BaseType.h"
+#include "Constructor.h"
+#include "Vector.h"
+#include "Array.h"
+#include "Sequence.h"
+#include "DDS.h"
+#include "DMR.h"
+#include "D4Group.h"
+#include "D4Dimensions.h"
+#include "D4Maps.h"
+
+#include "ConstraintPlan.h"
+#include "InternalErr.h"
+#include "debug.h"
+
+using namespace std;
+
+namespace libdap {
+
+// Used to hash the structure and state of a DDS or DMR (64-bit FNV-1a).
+static const uint64_t fnv_offset = 14695981039346656037ULL;
+static const uint64_t fnv_prime = 1099511628211ULL;
+
+static inline void hash_bytes(uint64_t &h, const void *data, size_t len)
+{
+    const unsigned char *p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= fnv_prime;
+    }
+}
+
+static inline void hash_string(uint64_t &h, const string &s)
+{
+    hash_bytes(h, s.data(), s.length());
+    hash_bytes(h, "", 1);   // so that 'ab','c' and 'a','bc' differ
+}
+
+template<typename T>
+static inline void hash_value(uint64_t &h, T v)
+{
+    hash_bytes(h, &v, sizeof(T));
+}
+
+/**
+ * Record the state of the variables in a DDS.
+ * @param dds Walk this DDS
+ */
+ConstraintState::ConstraintState(DDS &dds) : d_structure(fnv_offset), d_state(fnv_offset)
+{
+    for (DDS::Vars_iter i = dds.var_begin(), e = dds.var_end(); i != e; ++i)
+        m_add_var(*i);
+}
+
+/**
+ * Record the state of the variables and shared dimensions in a DMR.
+ * @param dmr Walk this DMR
+ */
+ConstraintState::ConstraintState(DMR &dmr) : d_structure(fnv_offset), d_state(fnv_offset)
+{
+    m_add_group(dmr.root());
+}
+
+void ConstraintState::m_add_var(BaseType *btp)
+{
+    hash_string(d_structure, btp->name());
+    hash_value(d_structure, btp->type());
+
+    var_state state;
+    state.name = btp->name();
+    state.type = btp->type();
+    state.send_p = btp->send_p();
+    state.in_selection = btp->is_in_selection();
+    state.row_start = state.row_stride = state.row_stop = 0;
+
+    hash_value(d_state, state.send_p);
+    hash_value(d_state, state.in_selection);
+
+    // D4Sequence is not a Sequence and has no row number constraint
+    Sequence *seq = 0;
+    if (btp->type() == dods_sequence_c && (seq = dynamic_cast<Sequence*>(btp))) {
+        state.row_start = seq->get_starting_row_number();
+        state.row_stride = seq->get_row_stride();
+        state.row_stop = seq->get_ending_row_number();
+
+        hash_value(d_state, state.row_start);
+        hash_value(d_state, state.row_stride);
+        hash_value(d_state, state.row_stop);
+    }
+    else if (btp->type() == dods_array_c) {
+        Array *a = static_cast<Array*>(btp);
+        for (Array::Dim_iter d = a->dim_begin(), e = a->dim_end(); d != e; ++d) {
+            hash_value(d_structure, (*d).size);
+            hash_string(d_structure, (*d).name);
+
+            slice s;
+            s.size = (*d).size;
+            s.start = (*d).start;
+            s.stop = (*d).stop;
+            s.stride = (*d).stride;
+            s.c_size = (*d).c_size;
+            s.use_sdim_for_slice = (*d).use_sdim_for_slice;
+            state.slices.push_back(s);
+
+            hash_value(d_state, s.start);
+            hash_value(d_state, s.stop);
+            hash_value(d_state, s.stride);
+            hash_value(d_state, s.use_sdim_for_slice);
+        }
+
+        // A DAP4 CE may remove Maps from an Array
+        if (a->is_dap4()) hash_value(d_structure, a->maps()->size());
+    }
+
+    d_vars.push_back(btp);
+    d_var_states.push_back(state);
+
+    if (btp->is_constructor_type()) {
+        Constructor *c = static_cast<Constructor*>(btp);
+        hash_value(d_structure, c->element_count());
+        for (Constructor::Vars_iter i = c->var_begin(), e = c->var_end(); i != e; ++i)
+            m_add_var(*i);
+    }
+    else if (btp->is_vector_type() && static_cast<Vector*>(btp)->prototype()) {
+        m_add_var(static_cast<Vector*>(btp)->prototype());
+    }
+}
+
+void ConstraintState::m_add_group(D4Group *g)
+{
+    for (D4Dimensions::D4DimensionsIter i = g->dims()->dim_begin(), e = g->dims()->dim_end(); i != e; ++i) {
+        D4Dimension *dim = *i;
+        hash_string(d_structure, dim->name());
+        hash_value(d_structure, dim->size());
+
+        dim_state state;
+        state.name = dim->name();
+        state.size = dim->size();
+        state.constrained = dim->constrained();
+        state.start = dim->c_start();
+        state.stride = dim->c_stride();
+        state.stop = dim->c_stop();
+        state.used_by_projected_var = dim->used_by_projected_var();
+
+        hash_value(d_state, state.constrained);
+        hash_value(d_state, state.start);
+        hash_value(d_state, state.stride);
+        hash_value(d_state, state.stop);
+        hash_value(d_state, state.used_by_projected_var);
+
+        d_dims.push_back(dim);
+        d_dim_states.push_back(state);
+    }
+
+    // m_add_var() records the group itself and its variables
+    m_add_var(g);
+
+    for (D4Group::groupsIter i = g->grp_begin(), e = g->grp_end(); i != e; ++i)
+        m_add_group(*i);
+}
+
+static bool operator==(const ConstraintState::slice &a, const ConstraintState::slice &b)
+{
+    return a.size == b.size && a.start == b.start && a.stop == b.stop && a.stride == b.stride && a.c_size == b.c_size
+        && a.use_sdim_for_slice == b.use_sdim_for_slice;
+}
+
+static bool operator==(const ConstraintState::var_state &a, const ConstraintState::var_state &b)
+{
+    return a.name == b.name && a.type == b.type && a.send_p == b.send_p && a.in_selection == b.in_selection
+        && a.row_start == b.row_start
+        && a.row_stride == b.row_stride && a.row_stop == b.row_stop && a.slices == b.slices;
+}
+
+static bool operator==(const ConstraintState::dim_state &a, const ConstraintState::dim_state &b)
+{
+    return a.name == b.name && a.size == b.size && a.constrained == b.constrained && a.start == b.start && a.stride == b.stride && a.stop == b.stop
+        && a.used_by_projected_var == b.used_by_projected_var;
+}
+
+/**
+ * Build a plan that holds the changes between two states of one DDS or DMR.
+ *
+ * @param before The state before the constraint expression was parsed
+ * @param after The state after it was parsed
+ * @param result The value returned by the parser
+ * @exception InternalErr if \e before and \e after do not have the same
+ * structure.
+ */
+ConstraintPlan::ConstraintPlan(const ConstraintState &before, const ConstraintState &after, bool result) :
+    d_before_vars(before.d_var_states), d_before_dims(before.d_dim_states), d_result(result)
+{
+    if (before.structure() != after.structure() || before.d_vars.size() != after.d_vars.size()
+        || before.d_dims.size() != after.d_dims.size())
+        throw InternalErr(__FILE__, __LINE__, "The constraint expression changed the structure of the dataset.");
+
+    for (unsigned int i = 0; i < d_before_vars.size(); ++i) {
+        const ConstraintState::var_state &b = before.d_var_states[i];
+        const ConstraintState::var_state &a = after.d_var_states[i];
+        if (b.name != a.name || b.type != a.type || b.slices.size() != a.slices.size())
+            throw InternalErr(__FILE__, __LINE__, "The constraint expression changed the structure of the dataset.");
+
+        if (!(b == a))
+            d_vars.push_back(make_pair(i, a));
+    }
+
+    for (unsigned int i = 0; i < d_before_dims.size(); ++i) {
+        if (!(before.d_dim_states[i] == after.d_dim_states[i]))
+            d_dims.push_back(make_pair(i, after.d_dim_states[i]));
+    }
+}
+
+/**
+ * Can this plan be applied to a DDS or DMR? Signatures are hashes, so two
+ * different states can have the same signature; this compares every
+ * variable's name, type, shape and constraint state with the state the
+ * plan was built from.
+ *
+ * @param target The state of the DDS or DMR
+ * @return True if \e target is the same as the \e before state used to
+ * build the plan
+ */
+bool ConstraintPlan::matches(const ConstraintState &target) const
+{
+    return target.d_var_states == d_before_vars && target.d_dim_states == d_before_dims;
+}
+
+/**
+ * Apply this plan to a DDS or DMR. The state of the target must match the
+ * \e before state used to build the plan (see matches()). The target is
+ * not updated; make a new ConstraintState to see the result.
+ *
+ * @note The constraint is set using the variables' own set_send_p(),
+ * set_in_selection() and, for arrays, add_constraint() methods, so types
+ * that specialize them see the change. Since the first two also change the
+ * variables held by a Constructor or Vector, every variable is visited,
+ * parents first, and set again if its state does not match the plan.
+ *
+ * @param target The state of the DDS or DMR to change
+ * @exception InternalErr if \e target does not match the plan
+ */
+void ConstraintPlan::apply(ConstraintState &target) const
+{
+    if (!matches(target))
+        throw InternalErr(__FILE__, __LINE__, "A constraint plan was applied to the wrong dataset.");
+
+    for (vector<pair<unsigned int, ConstraintState::dim_state> >::const_iterator i = d_dims.begin(), e = d_dims.end();
+        i != e; ++i) {
+        D4Dimension *dim = target.d_dims[i->first];
+        const ConstraintState::dim_state &state = i->second;
+
+        if (state.constrained) dim->set_constraint(state.start, state.stride, state.stop);
+        dim->set_used_by_projected_var(state.used_by_projected_var);
+    }
+
+    // The variables not in d_vars keep the state recorded in target
+    vector<pair<unsigned int, ConstraintState::var_state> >::const_iterator changed = d_vars.begin();
+    for (unsigned int i = 0; i < d_before_vars.size(); ++i) {
+        const ConstraintState::var_state *state = &target.d_var_states[i];
+        if (changed != d_vars.end() && changed->first == i) {
+            state = &changed->second;
+            ++changed;
+        }
+
+        BaseType *btp = target.d_vars[i];
+        if (btp->send_p() != state->send_p) btp->set_send_p(state->send_p);
+        if (btp->is_in_selection() != state->in_selection) btp->set_in_selection(state->in_selection);
+    }
+
+    for (vector<pair<unsigned int, ConstraintState::var_state> >::const_iterator i = d_vars.begin(), e = d_vars.end();
+        i != e; ++i) {
+        BaseType *btp = target.d_vars[i->first];
+        const ConstraintState::var_state &state = i->second;
+
+        Sequence *seq = 0;
+        if (btp->type() == dods_sequence_c && (seq = dynamic_cast<Sequence*>(btp))) {
+            seq->set_row_number_constraint(state.row_start, state.row_stop, state.row_stride);
+        }
+        else if (btp->type() == dods_array_c) {
+            // Replay the slices the parser made, the way it made them
+            Array *a = static_cast<Array*>(btp);
+            vector<ConstraintState::slice>::const_iterator s = state.slices.begin();
+            vector<ConstraintState::slice>::const_iterator old = d_before_vars[i->first].slices.begin();
+            for (Array::Dim_iter d = a->dim_begin(), e = a->dim_end(); d != e; ++d, ++s, ++old) {
+                if (*s == *old)
+                    continue;
+
+                if (s->use_sdim_for_slice && (*d).dim)
+                    a->add_constraint(d, (*d).dim);
+                else
+                    a->add_constraint(d, s->start, s->stride, s->stop);
+            }
+        }
+    }
+}
+
+ConstraintPlanCache *ConstraintPlanCache::d_instance = 0;
+
+static pthread_once_t ConstraintPlanCache_instance_control = PTHREAD_ONCE_INIT;
+
+// The largest number of plans held; when the cache is full it is emptied.
+static const unsigned int default_max_plans = 1024;
+
+void ConstraintPlanCache::initialize_instance()
+{
+    if (d_instance == 0) {
+        DBG(cerr << "ConstraintPlanCache::initialize_instance() - Creating singleton ConstraintPlanCache instance." << endl);
+        d_instance = new ConstraintPlanCache;
+#if HAVE_ATEXIT
+        atexit(delete_instance);
+#endif
+    }
+}
+
+void ConstraintPlanCache::delete_instance()
+{
+    delete d_instance;
+    d_instance = 0;
+}
+
+ConstraintPlanCache::ConstraintPlanCache() : d_max_plans(default_max_plans), d_hits(0), d_misses(0)
+{
+    pthread_mutex_init(&d_mutex, 0);
+}
+
+ConstraintPlanCache::~ConstraintPlanCache()
+{
+    m_clear();
+    pthread_mutex_destroy(&d_mutex);
+}
+
+/// @return The single instance of the cache
+ConstraintPlanCache *ConstraintPlanCache::TheCache()
+{
+    pthread_once(&ConstraintPlanCache_instance_control, initialize_instance);
+    return d_instance;
+}
+
+// Call with d_mutex locked
+void ConstraintPlanCache::m_clear()
+{
+    for (PlanMap::iterator i = d_plans.begin(), e = d_plans.end(); i != e; ++i)
+        delete i->second;
+    d_plans.clear();
+}
+
+/**
+ * Look for a plan for this constraint expression and DDS (or DMR) and, if
+ * there is one, apply it.
+ *
+ * @param expr The constraint expression
+ * @param target The current state of the DDS or DMR
+ * @param result If not null and a plan is found, value-result parameter
+ * that holds the value the parser returned for \e expr
+ * @return True if a plan was found and applied, false otherwise
+ */
+bool ConstraintPlanCache::apply(const string &expr, ConstraintState &target, bool *result)
+{
+    pthread_mutex_lock(&d_mutex);
+
+    PlanMap::iterator i = d_plans.find(make_pair(expr, target.signature()));
+    if (i == d_plans.end() || !i->second->matches(target)) {
+        ++d_misses;
+        pthread_mutex_unlock(&d_mutex);
+        return false;
+    }
+
+    ++d_hits;
+
+    try {
+        i->second->apply(target);
+        if (result) *result = i->second->result();
+    }
+    catch (...) {
+        pthread_mutex_unlock(&d_mutex);
+        throw;
+    }
+
+    pthread_mutex_unlock(&d_mutex);
+    return true;
+}
+
+/**
+ * Add a plan for a constraint expression. If the expression changed the
+ * structure of the DDS or DMR (e.g., by adding a variable), no plan is
+ * added.
+ *
+ * @param expr The constraint expression
+ * @param before The state of the DDS or DMR before \e expr was parsed
+ * @param after The state after \e expr was parsed
+ * @param result The value returned by the parser
+ */
+void ConstraintPlanCache::add(const string &expr, const ConstraintState &before, const ConstraintState &after,
+    bool result)
+{
+    if (before.structure() != after.structure()) return;
+
+    ConstraintPlan *plan = new ConstraintPlan(before, after, result);
+
+    pthread_mutex_lock(&d_mutex);
+
+    if (d_plans.size() >= d_max_plans) m_clear();
+
+    if (d_max_plans == 0 || !d_plans.insert(make_pair(make_pair(expr, before.signature()), plan)).second)
+        delete plan;
+
+    pthread_mutex_unlock(&d_mutex);
+}
+
+/// Remove all of the plans
+void ConstraintPlanCache::clear()
+{
+    pthread_mutex_lock(&d_mutex);
+    m_clear();
+    d_hits = d_misses = 0;
+    pthread_mutex_unlock(&d_mutex);
+}
+
+/// @return The number of plans in the cache
+unsigned int ConstraintPlanCache::size() const
+{
+    pthread_mutex_lock(&d_mutex);
+    unsigned int size = d_plans.size();
+    pthread_mutex_unlock(&d_mutex);
+    return size;
+}
+
+unsigned int ConstraintPlanCache::get_max_plans() const
+{
+    pthread_mutex_lock(&d_mutex);
+    unsigned int max_plans = d_max_plans;
+    pthread_mutex_unlock(&d_mutex);
+    return max_plans;
+}
+
+/**
+ * Set the largest number of plans the cache will hold. Use zero to turn
+ * the cache off.
+ * @param max_plans The number of plans
+ */
+void ConstraintPlanCache::set_max_plans(unsigned int max_plans)
+{
+    pthread_mutex_lock(&d_mutex);
+    d_max_plans = max_plans;
+    if (d_plans.size() > d_max_plans) m_clear();
+    pthread_mutex_unlock(&d_mutex);
+}
+
+/// @return The number of times apply() found a plan
+unsigned long ConstraintPlanCache::hits() const
+{
+    pthread_mutex_lock(&d_mutex);
+    unsigned long hits = d_hits;
+    pthread_mutex_unlock(&d_mutex);
+    return hits;
+}
+
+/// @return The number of times apply() did not find a plan
+unsigned long ConstraintPlanCache::misses() const
+{
+    pthread_mutex_lock(&d_mutex);
+    unsigned long misses = d_misses;
+    pthread_mutex_unlock(&d_mutex);
+    return misses;
+}
+
+} // namespace libdap
@@ -0,0 +1,195 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#ifndef _constraint_plan_h
+#define _constraint_plan_h 1
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace libdap {
+
+class BaseType;
+class DDS;
+class DMR;
+class D4Group;
+class D4Dimension;
+
+/**
+ * @brief The constraint state of every variable in a DDS or DMR.
+ *
+ * A ConstraintState records the projection (send_p and in_selection), the
+ * array slices and the sequence row ranges of each variable, and for a
+ * DMR the slice of each shared dimension, in the order they are found by
+ * a preorder walk of the DDS or DMR. Two DDSs (or DMRs) built for the same
+ * dataset have the same structure() and, until one of them is constrained,
+ * the same signature().
+ */
+class ConstraintState {
+public:
+    struct slice {
+        int size;
+        int start, stop, stride, c_size;
+        bool use_sdim_for_slice;
+    };
+
+    struct var_state {
+        std::string name;
+        int type;
+        bool send_p;
+        bool in_selection;
+        // Only used for Sequence
+        int row_start, row_stride, row_stop;
+        // Only used for Array
+        std::vector<slice> slices;
+    };
+
+    struct dim_state {
+        std::string name;
+        unsigned long long size;
+        bool constrained;
+        unsigned long long start, stride, stop;
+        bool used_by_projected_var;
+    };
+
+private:
+    std::vector<BaseType*> d_vars;
+    std::vector<var_state> d_var_states;
+
+    std::vector<D4Dimension*> d_dims;
+    std::vector<dim_state> d_dim_states;
+
+    uint64_t d_structure;
+    uint64_t d_state;
+
+    void m_add_var(BaseType *btp);
+    void m_add_group(D4Group *g);
+
+    friend class ConstraintPlan;
+
+public:
+    ConstraintState(DDS &dds);
+    ConstraintState(DMR &dmr);
+
+    /// @return A hash of the names, types and shapes of the variables
+    uint64_t structure() const { return d_structure; }
+    /// @return A hash of structure() and the constraint state of the variables
+    uint64_t signature() const { return d_structure ^ (d_state * 0x9e3779b97f4a7c15ULL); }
+};
+
+/**
+ * @brief The changes a constraint expression made to a DDS or DMR.
+ *
+ * A ConstraintPlan is built from the ConstraintState of a DDS (or DMR)
+ * before and after a constraint expression was parsed. It holds the whole
+ * state before the expression was parsed and the new state of each
+ * variable and shared dimension the parser changed. It can apply those
+ * changes to a different DDS built for the same dataset, with the same
+ * result as parsing the expression again.
+ */
+class ConstraintPlan {
+private:
+    std::vector<ConstraintState::var_state> d_before_vars;
+    std::vector<ConstraintState::dim_state> d_before_dims;
+
+    std::vector<std::pair<unsigned int, ConstraintState::var_state> > d_vars;
+    std::vector<std::pair<unsigned int, ConstraintState::dim_state> > d_dims;
+
+    bool d_result;
+
+public:
+    ConstraintPlan(const ConstraintState &before, const ConstraintState &after, bool result = true);
+
+    /// @return The value the parser returned for the expression
+    bool result() const { return d_result; }
+
+    bool matches(const ConstraintState &target) const;
+    void apply(ConstraintState &target) const;
+};
+
+/**
+ * @brief A process-wide cache of ConstraintPlans.
+ *
+ * Plans are found using the constraint expression and the signature() of
+ * the DDS or DMR it is applied to. A plan is applied only if the state of
+ * the DDS or DMR matches the one it was recorded from, so a plan recorded
+ * for one dataset is never applied to another, even if their signatures
+ * are the same. Only expressions that are projections (with
+ * array and sequence slices) are cached; an expression with a selection,
+ * a function call or one that adds variables must be parsed each time. The
+ * ConstraintEvaluator and D4ConstraintEvaluator parse() methods use this
+ * cache.
+ *
+ * All of the methods are MT-safe.
+ */
+class ConstraintPlanCache {
+private:
+    static ConstraintPlanCache *d_instance;
+
+    typedef std::map<std::pair<std::string, uint64_t>, ConstraintPlan*> PlanMap;
+
+    PlanMap d_plans;
+    unsigned int d_max_plans;
+
+    unsigned long d_hits;
+    unsigned long d_misses;
+
+    mutable pthread_mutex_t d_mutex;
+
+    static void initialize_instance();
+    static void delete_instance();
+
+    void m_clear();
+
+    ConstraintPlanCache();
+    virtual ~ConstraintPlanCache();
+
+    ConstraintPlanCache(const ConstraintPlanCache &);
+    ConstraintPlanCache &operator=(const ConstraintPlanCache &);
+
+public:
+    static ConstraintPlanCache *TheCache();
+
+    bool apply(const std::string &expr, ConstraintState &target, bool *result = 0);
+    void add(const std::string &expr, const ConstraintState &before, const ConstraintState &after,
+        bool result = true);
+
+    void clear();
+
+    unsigned int size() const;
+
+    unsigned int get_max_plans() const;
+    void set_max_plans(unsigned int max_plans);
+
+    unsigned long hits() const;
+    unsigned long misses() const;
+};
+
+} // namespace libdap
+
+#endif // _constraint_plan_h
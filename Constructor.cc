@@ -59,6 +59,7 @@
 #include "Error.h"
 #include "InternalErr.h"
 #include "DapIndent.h"
+#include "IndexLock.h"
 
 // #define DODS_DEBUG 1
 #include "debug.h"
@@ -76,6 +77,7 @@ Constructor::m_duplicate(const Constructor &c)
 	// Clear out any spurious vars in Constructor::d_vars
 	// Moved from Grid::m_duplicate. jhrg 4/3/13
 	d_vars.clear(); // [mjohnson 10 Sep 2009]
+	names_changed();
 
 	Vars_citer i = c.d_vars.begin();
 	while (i != c.d_vars.end()) {
@@ -87,10 +89,38 @@ Constructor::m_duplicate(const Constructor &c)
 	DBG(cerr << "Exiting Constructor::m_duplicate for " << c.name() << endl);
 }
 
+// Constructors with fewer variables than this are searched linearly
+static const unsigned int min_indexed_vars = 16;
+
+// Private. Return the first variable held directly by this Constructor
+// called name, or null.
+BaseType *
+Constructor::m_find(const string &name)
+{
+    if (d_vars.size() < min_indexed_vars) {
+        for (Vars_iter i = d_vars.begin(); i != d_vars.end(); i++) {
+            if ((*i)->name() == name)
+                return *i;
+        }
+        return 0;
+    }
+
+    IndexLock lock(this);
+    if (d_index_version != names_version()) {
+        d_index.clear();
+        for (unsigned int i = 0; i < d_vars.size(); ++i)
+            d_index.insert(make_pair(d_vars[i]->name(), i));
+        d_index_version = names_version();
+    }
+
+    map<string, unsigned int>::const_iterator i = d_index.find(name);
+    return (i != d_index.end()) ? d_vars[i->second] : 0;
+}
+
 // Public member functions
 
 Constructor::Constructor(const string &name, const Type &type, bool is_dap4)
-        : BaseType(name, type, is_dap4)
+        : BaseType(name, type, is_dap4), d_index_version(0)
 {}
 
 /** Server-side constructor that takes the name of the variable to be
@@ -104,10 +134,10 @@ Constructor::Constructor(const string &name, const Type &type, bool is_dap4)
  * @param type type of data being stored
  */
 Constructor::Constructor(const string &name, const string &dataset, const Type &type, bool is_dap4)
-        : BaseType(name, dataset, type, is_dap4)
+        : BaseType(name, dataset, type, is_dap4), d_index_version(0)
 {}
 
-Constructor::Constructor(const Constructor &rhs) : BaseType(rhs), d_vars(0)
+Constructor::Constructor(const Constructor &rhs) : BaseType(rhs), d_index_version(0), d_vars(0)
 {
     DBG(cerr << "In Constructor::copy_ctor for " << rhs.name() << endl);
     m_duplicate(rhs);
@@ -263,6 +293,21 @@ Constructor::width(bool constrained) const
     return sz;
 }
 
+/** Like width(), but returns a 64-bit value.
+    @see BaseType::width_ll() */
+int64_t
+Constructor::width_ll(bool constrained) const
+{
+    int64_t sz = 0;
+
+    for (Vars_citer i = d_vars.begin(); i != d_vars.end(); i++) {
+        if (!constrained || (*i)->send_p())
+            sz += (*i)->width_ll(constrained);
+    }
+
+    return sz;
+}
+
 BaseType *
 Constructor::var(const string &name, bool exact_match, btp_stack *s)
 {
@@ -293,8 +338,11 @@ Constructor::var(const string &n, btp_stack &s)
 BaseType *
 Constructor::m_leaf_match(const string &name, btp_stack *s)
 {
+    // Only the Constructors that come before a variable called name need
+    // to be searched.
+    BaseType *match = m_find(name);
     for (Vars_iter i = d_vars.begin(); i != d_vars.end(); i++) {
-        if ((*i)->name() == name) {
+        if (*i == match) {
             if (s) {
                 DBG(cerr << "Pushing " << this->name() << endl);
                 s->push(static_cast<BaseType *>(this));
@@ -321,13 +369,12 @@ BaseType *
 Constructor::m_exact_match(const string &name, btp_stack *s)
 {
     // Look for name at the top level first.
-    for (Vars_iter i = d_vars.begin(); i != d_vars.end(); i++) {
-        if ((*i)->name() == name) {
-            if (s)
-                s->push(static_cast<BaseType *>(this));
+    BaseType *match = m_find(name);
+    if (match) {
+        if (s)
+            s->push(static_cast<BaseType *>(this));
 
-            return *i;
-        }
+        return match;
     }
 
     // If it was not found using the simple search, look for a dot and
@@ -452,6 +499,7 @@ Constructor::del_var(const string &n)
         if ((*i)->name() == n) {
             BaseType *bt = *i ;
             d_vars.erase(i) ;
+            names_changed();
             delete bt ; bt = 0;
             return;
         }
@@ -464,6 +512,7 @@ Constructor::del_var(Vars_iter i)
     if (*i != 0) {
         BaseType *bt = *i;
         d_vars.erase(i);
+        names_changed();
         delete bt;
     }
 }
@@ -26,6 +26,7 @@
 #ifndef _constructor_h
 #define _constructor_h 1
 
+#include <map>
 #include <vector>
 
 #include "BaseType.h"
@@ -45,6 +46,14 @@ class Constructor: public BaseType
 private:
     Constructor();  // No default ctor.
 
+    // Positions of the variables in d_vars, keyed by name. Built by
+    // m_find() for Constructors that hold many variables and rebuilt when
+    // names_version() shows that a name may have changed.
+    std::map<string, unsigned int> d_index;
+    unsigned long d_index_version;
+
+    BaseType *m_find(const string &name);
+
 protected:
     std::vector<BaseType *> d_vars;
 
@@ -75,6 +84,7 @@ public:
     virtual void set_read_p(bool state);
 
     virtual unsigned int width(bool constrained = false) const;
+    virtual int64_t width_ll(bool constrained = false) const;
 #if 0
     virtual unsigned int width(bool constrained);
 #endif
@@ -0,0 +1,156 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#ifndef _copy_on_write_h
+#define _copy_on_write_h 1
+
+namespace libdap {
+
+/**
+ * @brief A value shared by several objects until one of them changes it.
+ *
+ * Copying a CopyOnWrite copies a pointer and increments a reference count;
+ * the value itself is copied only when get_for_write() is called on an
+ * instance that shares it. BaseType uses this for its attributes, so
+ * that copies of variables that are only used to hold data values (e.g.,
+ * the elements of an Array of Structure or the rows of a Sequence) do not
+ * each make a deep copy of the attribute tables.
+ *
+ * The reference count is updated atomically, so instances that share a
+ * value may be used by different threads. A pointer returned by
+ * get_for_write() is valid until the next time this instance is copied
+ * or assigned; using it after that may change the value seen by the copy.
+ *
+ * @note Not a general-purpose smart pointer. T must have a default
+ * constructor and a copy constructor.
+ */
+template <class T>
+class CopyOnWrite {
+private:
+    struct Block {
+        T *value;
+        unsigned int count;
+
+        Block(T *v) : value(v), count(1) { }
+    };
+
+    Block *d_block; // null until there is a value
+
+    void m_release()
+    {
+        if (d_block && __sync_sub_and_fetch(&d_block->count, 1) == 0) {
+            delete d_block->value;
+            delete d_block;
+        }
+        d_block = 0;
+    }
+
+public:
+    CopyOnWrite() : d_block(0) { }
+
+    CopyOnWrite(const CopyOnWrite &rhs) : d_block(rhs.d_block)
+    {
+        if (d_block)
+            __sync_add_and_fetch(&d_block->count, 1);
+    }
+
+    ~CopyOnWrite() { m_release(); }
+
+    CopyOnWrite &operator=(const CopyOnWrite &rhs)
+    {
+        if (d_block != rhs.d_block) {
+            if (rhs.d_block)
+                __sync_add_and_fetch(&rhs.d_block->count, 1);
+            m_release();
+            d_block = rhs.d_block;
+        }
+
+        return *this;
+    }
+
+    /// @return The value, which must not be modified; null if there is none
+    const T *get() const { return d_block ? d_block->value : 0; }
+
+    /// @return True if the value is shared with another instance
+    bool shared() const { return d_block && d_block->count > 1; }
+
+    /**
+     * Get the value so that it can be modified. If the value is shared,
+     * this instance first makes its own copy; if there is no value, a
+     * default-constructed one is made.
+     *
+     * @return The value; never null
+     */
+    T *get_for_write()
+    {
+        if (!d_block) {
+            d_block = new Block(new T());
+        }
+        else if (shared()) {
+            Block *copy = new Block(new T(*d_block->value));
+            m_release();
+            d_block = copy;
+        }
+
+        return d_block->value;
+    }
+
+    /**
+     * Replace the value.
+     *
+     * @param value The new value; this instance takes ownership of it.
+     * May be null.
+     */
+    void reset(T *value)
+    {
+        m_release();
+        if (value)
+            d_block = new Block(value);
+    }
+
+    /**
+     * Stop referencing the value without deleting it. If no other instance
+     * shares the value, the caller takes ownership of it.
+     *
+     * @return The value if this was its only reference, otherwise null.
+     */
+    T *release()
+    {
+        T *value = 0;
+        if (d_block && !shared()) {
+            value = d_block->value;
+            delete d_block;
+            d_block = 0;
+        }
+        else {
+            m_release();
+        }
+
+        return value;
+    }
+};
+
+} // namespace libdap
+
+#endif // _copy_on_write_h
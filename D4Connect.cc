@@ -48,6 +48,7 @@
 #include "D4ParserSax2.h"
 #include "chunked_stream.h"
 #include "chunked_istream.h"
+#include "chunked_codec.h"
 #include "D4StreamUnMarshaller.h"
 
 #include "escaping.h"
@@ -250,6 +251,8 @@ D4Connect::D4Connect(const string &url, string uname, string password) :
         DBG(cerr << "Connect: The identifier is an http URL" << endl);
         d_http = new HTTPConnect(RCReader::instance());
         d_http->set_use_cpp_streams(true);
+        // Tell the server which chunk features and codecs can be read
+        d_http->set_chunk_features(chunk_client_features());
 
         d_URL = name;
 
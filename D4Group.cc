@@ -408,27 +408,34 @@ D4Group::find_var(const string &path)
 long
 D4Group::request_size(bool constrained)
 {
-    long long size = 0;
-    // variables
-    Constructor::Vars_iter v = var_begin();
-    while (v != var_end()) {
-        if (constrained) {
-            if ((*v)->send_p())
-                size += (*v)->width(constrained);
-        }
-        else {
-            size += (*v)->width(constrained);
-        }
+    return request_size_kb(constrained);
+}
 
-        ++v;
-    }
+/** Compute the size of all of the variables in this group and its children,
+ * in kilobytes, using 64-bit arithmetic.
+ *
+ * @param constrained Should the current constraint be taken into account?
+ * @return The size in kilobytes
+ */
+uint64_t
+D4Group::request_size_kb(bool constrained)
+{
+    return m_request_size(constrained) / 1024;
+}
+
+// Private. The size of the variables in this group and its children, in bytes
+int64_t
+D4Group::m_request_size(bool constrained)
+{
+    // variables
+    int64_t size = width_ll(constrained);
 
     // groups
     groupsIter g = d_groups.begin();
     while (g != d_groups.end())
-        size += (*g++)->request_size(constrained);
+        size += (*g++)->m_request_size(constrained);
 
-    return size / 1024;
+    return size;
 }
 
 void
@@ -689,7 +696,7 @@ D4Group::transform_to_dap2(AttrTable *parent_attr_table)
                 parent_attr_table->append_container(at, at->get_name());
             }
             else {
-                parent_attr_table->append_attr((*i)->name, AttrType_to_String((*i)->type), (*i)->attr);
+                parent_attr_table->append_attr((*i)->name, AttrType_to_String((*i)->type), group_attrs->get_attr_vector(i));
             }
         }
         delete group_attrs;
@@ -59,6 +59,7 @@ private:
     vector<D4Group*> d_groups;
 
     BaseType *m_find_map_source_helper(const string &name);
+    int64_t m_request_size(bool constrained);
 
 protected:
     void m_duplicate(const D4Group &g);
@@ -129,6 +130,7 @@ public:
     D4Group *find_child_grp(const string &grp_name);
 
     long request_size(bool constrained);
+    uint64_t request_size_kb(bool constrained);
 
     virtual void set_send_p(bool state);
     virtual void set_read_p(bool state);
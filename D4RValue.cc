@@ -25,7 +25,10 @@
 
 #include "config.h"
 
+#include <pthread.h>
+
 #include <iostream>
+#include <sstream>
 
 #include "BaseType.h"
 #include "Array.h"
@@ -53,6 +56,11 @@ using namespace std;
 
 namespace libdap {
 
+struct D4RValue::memo_state {
+    pthread_mutex_t mutex;
+    BaseType *value;    // the result of the function; deleted with the rvalue
+};
+
 void
 D4RValueList::m_duplicate(const D4RValueList &src)
 {
@@ -79,6 +87,11 @@ D4RValue::m_duplicate(const D4RValue &src)
     d_args = (src.d_args != 0) ? new D4RValueList(*src.d_args) : 0; // deep copy these
 
     d_constant = (src.d_constant != 0) ? src.d_constant->ptr_duplicate() : 0;
+
+    // The copy does not share values with the rvalues of the source
+    d_shared = 0;
+    d_memo = 0;
+    d_pure = src.d_pure;
 }
 
 template<typename T, class DAP_TYPE>
@@ -101,28 +114,28 @@ build_constant_array(vector<T> &values, DAP_TYPE &dt)
     return array;
 }
 
-D4RValue::D4RValue(unsigned long long ull) : d_variable(0), d_func(0), d_args(0), d_constant(0), d_value_kind(constant)
+D4RValue::D4RValue(unsigned long long ull) : d_variable(0), d_func(0), d_args(0), d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	UInt64 *ui = new UInt64("constant");
 	ui->set_value(ull);
 	d_constant = ui;
 }
 
-D4RValue::D4RValue(long long ll) : d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+D4RValue::D4RValue(long long ll) : d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	Int64 *i = new Int64("constant");
 	i->set_value(ll);
 	d_constant = i;
 }
 
-D4RValue::D4RValue(double r) : d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+D4RValue::D4RValue(double r) : d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	Float64 *f = new Float64("constant");
 	f->set_value(r);
 	d_constant = f;
 }
 
-D4RValue::D4RValue(std::string cpps) : d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+D4RValue::D4RValue(std::string cpps) : d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	Str *s = new Str("constant");
 	s->set_value(remove_quotes(cpps));
@@ -130,70 +143,70 @@ D4RValue::D4RValue(std::string cpps) : d_variable(0), d_func(0), d_args(0),  d_c
 }
 
 D4RValue::D4RValue(std::vector<dods_byte> &byte_args)
-	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	Byte b("");
 	d_constant = build_constant_array(byte_args, b);
 }
 
 D4RValue::D4RValue(std::vector<dods_int8> &byte_int8)
-	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	Int8 b("");
 	d_constant = build_constant_array(byte_int8, b);
 }
 
 D4RValue::D4RValue(std::vector<dods_uint16> &byte_uint16)
-	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	UInt16 b("");
 	d_constant = build_constant_array(byte_uint16, b);
 }
 
 D4RValue::D4RValue(std::vector<dods_int16> &byte_int16)
-	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	Int16 b("");
 	d_constant = build_constant_array(byte_int16, b);
 }
 
 D4RValue::D4RValue(std::vector<dods_uint32> &byte_uint32)
-	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	UInt32 b("");
 	d_constant = build_constant_array(byte_uint32, b);
 }
 
 D4RValue::D4RValue(std::vector<dods_int32> &byte_int32)
-	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	Int32 b("");
 	d_constant = build_constant_array(byte_int32, b);
 }
 
 D4RValue::D4RValue(std::vector<dods_uint64> &byte_uint64)
-	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	UInt64 b("");
 	d_constant = build_constant_array(byte_uint64, b);
 }
 
 D4RValue::D4RValue(std::vector<dods_int64> &byte_int64)
-	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	Int64 b("");
 	d_constant = build_constant_array(byte_int64, b);
 }
 
 D4RValue::D4RValue(std::vector<dods_float32> &byte_float32)
-	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	Float32 b("");
 	d_constant = build_constant_array(byte_float32, b);
 }
 
 D4RValue::D4RValue(std::vector<dods_float64> &byte_float64)
-	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant)
+	: d_variable(0), d_func(0), d_args(0),  d_constant(0), d_value_kind(constant), d_shared(0), d_memo(0), d_pure(false)
 {
 	Float64 b("");
 	d_constant = build_constant_array(byte_float64, b);
@@ -203,6 +216,12 @@ D4RValue::~D4RValue() {
 	// d_variable and d_func are weak pointers; don't delete.
 	delete d_args;
 	delete d_constant;
+
+	if (d_memo) {
+	    pthread_mutex_destroy(&d_memo->mutex);
+	    delete d_memo->value;
+	    delete d_memo;
+	}
 }
 
 /**
@@ -276,6 +295,10 @@ D4RValue::value(DMR &dmr)
 		return d_variable;
 
 	case function:
+		if (d_shared)
+		    return d_shared->value(dmr);
+		if (d_memo)
+		    return m_memo_value(dmr);
 		return (*d_func)(d_args, dmr);
 
 	case constant:
@@ -316,5 +339,132 @@ D4RValue::value()
     }
 }
 
+/**
+ * @brief The dataset variables used by this RValue
+ *
+ * Append the variables this RValue reads, including those passed to a
+ * function (and to functions passed to it), to \e vars. Nothing is read
+ * or evaluated.
+ *
+ * @param vars Value-result parameter
+ */
+void
+D4RValue::variables(std::vector<BaseType *> &vars)
+{
+    switch (d_value_kind) {
+    case basetype:
+        vars.push_back(d_variable);
+        break;
+
+    case function:
+        if (d_args) {
+            for (D4RValueList::iter i = d_args->begin(), e = d_args->end(); i != e; ++i)
+                (*i)->variables(vars);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief A key for the expression held by this RValue
+ *
+ * Two RValues have the same key when they use the same variables, constants
+ * and functions in the same way, so that, if the functions are pure, they
+ * have the same value.
+ *
+ * @return The key
+ */
+string
+D4RValue::key() const
+{
+    ostringstream oss;
+
+    switch (d_value_kind) {
+    case basetype:
+        oss << "v" << d_variable;
+        break;
+
+    case function:
+        oss << "f" << reinterpret_cast<size_t>(d_func) << "(";
+        if (d_args) {
+            for (unsigned int i = 0; i < d_args->size(); ++i)
+                oss << (i == 0 ? "" : ",") << d_args->get_rvalue(i)->key();
+        }
+        oss << ")";
+        break;
+
+    case constant:
+        oss << "c" << d_constant->type_name() << ":";
+        d_constant->print_val(oss, "", false);
+        break;
+
+    default:
+        oss << "u" << this;
+        break;
+    }
+
+    return oss.str();
+}
+
+/**
+ * @brief Keep the value of this function call.
+ *
+ * The function is called the first time value(DMR&) is called; after that
+ * its result is returned. Used for function calls that are repeated in an
+ * expression. This object owns the result and deletes it, so the caller of
+ * value(DMR&) must not (see caller_owns_value()). Only calls to functions
+ * that were declared pure (see set_pure()) are changed.
+ *
+ * @see use_value_of()
+ */
+void
+D4RValue::memoize()
+{
+    if (d_value_kind != function || !d_pure || d_memo)
+        return;
+
+    d_memo = new memo_state;
+    pthread_mutex_init(&d_memo->mutex, 0);
+    d_memo->value = 0;
+}
+
+/**
+ * @brief Use the value of another RValue.
+ *
+ * After this call value(DMR&) returns the value of \e rv instead of calling
+ * the function again, so \e rv should hold the same expression (see key())
+ * and should be memoized. Only calls to pure functions are changed.
+ *
+ * @param rv Use the value of this RValue; a weak pointer.
+ */
+void
+D4RValue::use_value_of(D4RValue *rv)
+{
+    if (d_value_kind == function && d_pure && rv != this)
+        d_shared = rv;
+}
+
+// Private. Call the function once; the lock makes this safe when
+// D4FunctionEvaluator uses more than one thread.
+BaseType *
+D4RValue::m_memo_value(DMR &dmr)
+{
+    pthread_mutex_lock(&d_memo->mutex);
+    try {
+        if (!d_memo->value)
+            d_memo->value = (*d_func)(d_args, dmr);
+    }
+    catch (...) {
+        pthread_mutex_unlock(&d_memo->mutex);
+        throw;
+    }
+    pthread_mutex_unlock(&d_memo->mutex);
+
+    return d_memo->value;
+}
+
 } // namespace libdap
 
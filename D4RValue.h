@@ -102,16 +102,26 @@ private:
 
     value_kind d_value_kind;
 
+    // Set when the expression is repeated. A repeated call to a pure
+    // function uses the value of the first call (d_shared) and the first
+    // call keeps its result (d_memo) and deletes it with this object.
+    D4RValue *d_shared;     // weak pointer
+    struct memo_state;
+    memo_state *d_memo;
+    bool d_pure;            // the function was declared pure
+
     /** @brief Clone 'src' to 'this'. */
     void m_duplicate(const D4RValue &src);
 
+    BaseType *m_memo_value(DMR &dmr);
+
     friend class D4RValueList;
 
 public:
-    D4RValue() : d_variable(0), d_func(0), d_args(0), d_constant(0), d_value_kind(unknown) { }
+    D4RValue() : d_variable(0), d_func(0), d_args(0), d_constant(0), d_value_kind(unknown), d_shared(0), d_memo(0), d_pure(false) { }
     D4RValue(const D4RValue &src) { m_duplicate(src); }
-    D4RValue(BaseType *btp)  : d_variable(btp), d_func(0), d_args(0), d_constant(0), d_value_kind(basetype) { }
-    D4RValue(D4Function f, D4RValueList *args)  : d_variable(0), d_func(f), d_args(args), d_constant(0), d_value_kind(function) { }
+    D4RValue(BaseType *btp)  : d_variable(btp), d_func(0), d_args(0), d_constant(0), d_value_kind(basetype), d_shared(0), d_memo(0), d_pure(false) { }
+    D4RValue(D4Function f, D4RValueList *args)  : d_variable(0), d_func(f), d_args(args), d_constant(0), d_value_kind(function), d_shared(0), d_memo(0), d_pure(false) { }
 
     D4RValue(unsigned long long ui);
     D4RValue(long long i);
@@ -152,9 +162,25 @@ public:
     // This is the call that will be used to return the value of a function.
     // jhrg 3/10/14
     virtual BaseType *value(DMR &dmr);
+    /// @return True if the caller of value(DMR&) must delete the value; a
+    /// function call's result when it is not kept by this object
+    bool caller_owns_value() const { return d_value_kind == function && !d_shared && !d_memo; }
     // And this optimizes value() for filters, where functions are not supported.
     virtual BaseType *value();
 
+    void variables(std::vector<BaseType *> &vars);
+
+    /// @return The arguments of a function; null for other kinds of values
+    D4RValueList *get_args() const { return d_args; }
+
+    std::string key() const;
+
+    /// @return True if this is a call to a function that was declared pure
+    bool is_pure() const { return d_pure; }
+    void set_pure(bool pure) { d_pure = pure; }
+
+    void memoize();
+    void use_value_of(D4RValue *rv);
 };
 
 } // namespace libdap
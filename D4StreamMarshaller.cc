@@ -42,6 +42,8 @@
 #endif
 
 #include "D4StreamMarshaller.h"
+#include "chunked_codec.h"
+#include "chunked_ostream.h"
 #ifdef USE_POSIX_THREADS
 #include "MarshallerThread.h"
 #endif
@@ -199,7 +201,8 @@ void D4StreamMarshaller::m_serialize_reals(char *val, unsigned int num, int widt
  * @param write_data If true, write data values. True by default
  */
 D4StreamMarshaller::D4StreamMarshaller(ostream &out, bool write_data) :
-        d_out(out), d_write_data(write_data), tm(0)
+        d_out(out), d_chunked(dynamic_cast<chunked_ostream*>(&out)), d_write_data(write_data), d_filters(vector_filter_none), d_vector_parts(false),
+        d_first_part(false), tm(0)
 {
 	assert(sizeof(std::streamsize) >= sizeof(int64_t));
 
@@ -538,6 +541,86 @@ void D4StreamMarshaller::put_opaque_dap4(const char *val, int64_t len)
     }
 }
 
+/**
+ * @brief Use pre-filters for arrays of 2, 4 and 8 byte values
+ *
+ * When filters are set, each array of 2, 4 or 8 byte values (integers,
+ * multi-byte enums and floating point values) starts with a byte that holds
+ * the filters applied to its values; the values follow. This makes the
+ * data compress better; see chunked_ostream::set_compression(). The
+ * checksums are computed using the unfiltered values.
+ *
+ * When writing to a chunked_ostream, the filter byte is written only when
+ * the stream is marked using chunked_ostream::set_filtered(), since that is
+ * what tells the receiver to read it; arrays in a stream that is not marked
+ * are not filtered. When writing to any other stream, the filter byte is
+ * written when filters are set and the receiver must be told to read it
+ * using D4StreamUnMarshaller::set_filtered().
+ *
+ * @param filters Zero or more vector_filter values ORed together;
+ * vector_filter_none turns this off.
+ * @see D4StreamUnMarshaller::set_filtered()
+ */
+void D4StreamMarshaller::set_filters(unsigned int filters)
+{
+    if (filters & ~VECTOR_FILTER_MASK)
+        throw InternalErr(__FILE__, __LINE__, "Unknown vector filter.");
+
+    d_filters = filters;
+}
+
+/**
+ * @brief Write the values of an array, filtered if filters are set
+ *
+ * The values passed to put_vector_part() are written as one array: the
+ * filter byte is written before the first part and the parts are not
+ * filtered.
+ *
+ * @param val The values
+ * @param num_elem The number of values
+ * @param width The size of a value
+ */
+void D4StreamMarshaller::m_write_vector(const char *val, int64_t num_elem, int width)
+{
+    int64_t bytes = num_elem * width;
+
+    // A chunked stream says whether the filter byte is there
+    bool prefix = d_chunked ? d_chunked->get_filtered() : d_filters != vector_filter_none;
+    uint8_t filters = vector_filter_none;
+    if (d_vector_parts) {
+        prefix = prefix && d_first_part;
+        d_first_part = false;
+    }
+    else if (prefix && num_elem > 1) {
+        filters = d_filters;
+    }
+
+#ifdef USE_POSIX_THREADS
+    Locker lock(tm->get_mutex(), tm->get_cond(), tm->get_child_thread_count());
+
+    if (prefix)
+        d_out.write(reinterpret_cast<const char*>(&filters), sizeof(uint8_t));
+
+    char *buf = new char[bytes];
+    vector_filter_encode(val, buf, num_elem, width, filters);
+
+    tm->increment_child_thread_count();
+    tm->start_thread(MarshallerThread::write_thread, d_out, buf, bytes);
+#else
+    if (prefix)
+        d_out.write(reinterpret_cast<const char*>(&filters), sizeof(uint8_t));
+
+    if (filters == vector_filter_none) {
+        d_out.write(val, bytes);
+    }
+    else {
+        vector<char> buf(bytes);
+        vector_filter_encode(val, &buf[0], num_elem, width, filters);
+        d_out.write(&buf[0], bytes);
+    }
+#endif
+}
+
 /**
  * @brief Write a fixed size vector
  * @param val Pointer to the data
@@ -598,19 +681,8 @@ void D4StreamMarshaller::put_vector(char *val, int64_t num_elem, int elem_size)
 
     checksum_update(val, bytes);
 
-    if (d_write_data) {
-#ifdef USE_POSIX_THREADS
-        Locker lock(tm->get_mutex(), tm->get_cond(), tm->get_child_thread_count());
-
-        char *buf = new char[bytes];
-        memcpy(buf, val, bytes);
-
-        tm->increment_child_thread_count();
-        tm->start_thread(MarshallerThread::write_thread, d_out, buf, bytes);
-#else
-        d_out.write(val, bytes);
-#endif
-    }
+    if (d_write_data)
+        m_write_vector(val, num_elem, elem_size);
 }
 
 /**
@@ -635,23 +707,12 @@ void D4StreamMarshaller::put_vector_float32(char *val, int64_t num_elem)
 	// to test that num can be multiplied by 4. A
 	assert(!(num_elem & 0xe000000000000000));
 
-	num_elem = num_elem << 2;	// num_elem is now the number of bytes
-
-    checksum_update(val, num_elem);
+	int64_t bytes = num_elem << 2;
 
-    if (d_write_data) {
-#ifdef USE_POSIX_THREADS
-        Locker lock(tm->get_mutex(), tm->get_cond(), tm->get_child_thread_count());
+    checksum_update(val, bytes);
 
-        char *buf = new char[num_elem];
-        memcpy(buf, val, num_elem);
-
-        tm->increment_child_thread_count();
-        tm->start_thread(MarshallerThread::write_thread, d_out, buf, num_elem);
-#else
-    	d_out.write(val, num_elem);
-#endif
-    }
+    if (d_write_data)
+        m_write_vector(val, num_elem, 4);
 
 #else
 	assert(val);
@@ -672,17 +733,7 @@ void D4StreamMarshaller::put_vector_float32(char *val, int64_t num_elem)
             m_serialize_reals(val, num_elem, 4, type);
         }
         else {
-#ifdef USE_POSIX_THREADS
-        Locker lock(tm->get_mutex(), tm->get_cond(), tm->get_child_thread_count());
-
-        char *buf = new char[bytes];
-        memcpy(buf, val, bytes);
-
-        tm->increment_child_thread_count();
-        tm->start_thread(MarshallerThread::write_thread, d_out, buf, bytes);
-#else
-        d_out.write(val, bytes);
-#endif
+            m_write_vector(val, num_elem, 4);
         }
     }
 #endif
@@ -706,23 +757,12 @@ void D4StreamMarshaller::put_vector_float64(char *val, int64_t num_elem)
 	// See comment above
 	assert(!(num_elem & 0xf000000000000000));
 
-	num_elem = num_elem << 3;	// num_elem is now the number of bytes
+	int64_t bytes = num_elem << 3;
 
-    checksum_update(val, num_elem);
-
-    if (d_write_data) {
-#ifdef USE_POSIX_THREADS
-        Locker lock(tm->get_mutex(), tm->get_cond(), tm->get_child_thread_count());
-
-        char *buf = new char[num_elem];
-        memcpy(buf, val, num_elem);
+    checksum_update(val, bytes);
 
-        tm->increment_child_thread_count();
-        tm->start_thread(MarshallerThread::write_thread, d_out, buf, num_elem);
-#else
-        d_out.write(val, num_elem);
-#endif
-    }
+    if (d_write_data)
+        m_write_vector(val, num_elem, 8);
 #else
 	assert(val);
 	assert(num_elem >= 0);
@@ -742,17 +782,7 @@ void D4StreamMarshaller::put_vector_float64(char *val, int64_t num_elem)
             m_serialize_reals(val, num_elem, 8, type);
         }
         else {
-#ifdef USE_POSIX_THREADS
-        Locker lock(tm->get_mutex(), tm->get_cond(), tm->get_child_thread_count());
-
-        char *buf = new char[bytes];
-        memcpy(buf, val, bytes);
-
-        tm->increment_child_thread_count();
-        tm->start_thread(MarshallerThread::write_thread, d_out, buf, bytes);
-#else
-        d_out.write(val, bytes);
-#endif
+            m_write_vector(val, num_elem, 8);
         }
     }
 #endif
@@ -794,7 +824,7 @@ void D4StreamMarshaller::put_vector_part(char *val, unsigned int num, int width,
         break;
 
     case dods_float64_c:
-        put_vector_float32(val, num);
+        put_vector_float64(val, num);
         break;
 
     case dods_str_c:
@@ -57,6 +57,7 @@ namespace libdap {
 
 class Vector;
 class MarshallerThread;
+class chunked_ostream;
 
 /** @brief Marshaller that knows how to marshal/serialize dap data objects
  * to a C++ iostream using DAP4's receiver-makes-right scheme. This code
@@ -77,8 +78,13 @@ private:
 #endif
 
     ostream &d_out;
+    chunked_ostream *d_chunked; // d_out, if it is a chunked_ostream; weak pointer
     bool d_write_data; // jhrg 1/27/12
 
+    unsigned int d_filters;     // vector_filter values; see set_filters()
+    bool d_vector_parts;        // Between put_vector_start() and put_vector_end()
+    bool d_first_part;
+
     Crc32 d_checksum;
 
     MarshallerThread *tm;
@@ -92,6 +98,8 @@ private:
     void m_serialize_reals(char *val, int64_t num, int width, Type type);
 #endif
 
+    void m_write_vector(const char *val, int64_t num_elem, int width);
+
 public:
     D4StreamMarshaller(std::ostream &out, bool write_data = true);
     virtual ~D4StreamMarshaller();
@@ -103,6 +111,10 @@ public:
     virtual void put_checksum();
     virtual void put_count(int64_t count);
 
+    void set_filters(unsigned int filters);
+    /// @return The vector_filter values used for arrays
+    unsigned int get_filters() const { return d_filters; }
+
     virtual void put_byte(dods_byte val);
     virtual void put_int8(dods_int8 val);
 
@@ -147,27 +159,31 @@ public:
 
     /**
      * Prepare to send a single array/vector using a series of 'put' calls.
-     * In DAP4 this does nothing because arrays are serialized using the server's
-     * binary representation (i.e., using 'reader make right').
+     * In DAP4 arrays are serialized using the server's binary representation
+     * (i.e., using 'reader make right'), so this only notes that the parts
+     * that follow are one array (see set_filters()).
      *
      * @param num Ignored
      * @see put_vector_part()
      * @see put_vector_end()
      */
     virtual void put_vector_start(int /*num*/) {
+        d_vector_parts = true;
+        d_first_part = true;
     }
 
     virtual void put_vector_part(char */*val*/, unsigned int /*num*/, int /*width*/, Type /*type*/);
 
     /**
      * Close a vector when its values are written using put_vector_part().
-     * In DAP4 this does nothing because arrays are serialized using the server's
-     * binary representation (i.e., using 'reader make right').
+     * In DAP4 arrays are serialized using the server's binary representation
+     * (i.e., using 'reader make right'), so this only ends the array.
      *
      * @see put_vector_start()
      * @see put_vector_part()
      */
     virtual void put_vector_end() {
+        d_vector_parts = false;
     }
 
     virtual void dump(std::ostream &strm) const;
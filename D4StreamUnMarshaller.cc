@@ -41,6 +41,8 @@
 #include "util.h"
 #include "InternalErr.h"
 #include "D4StreamUnMarshaller.h"
+#include "chunked_codec.h"
+#include "chunked_istream.h"
 #include "debug.h"
 #include "DapIndent.h"
 
@@ -56,7 +58,7 @@ namespace libdap {
  * @param in Read from this input stream
  * @param is_stream_bigendian The byte order of the data in the stream
  */
-D4StreamUnMarshaller::D4StreamUnMarshaller(istream &in, bool twiddle_bytes) : d_in( in ), d_twiddle_bytes(twiddle_bytes)
+D4StreamUnMarshaller::D4StreamUnMarshaller(istream &in, bool twiddle_bytes) : d_in( in ), d_chunked(dynamic_cast<chunked_istream*>(&in)), d_twiddle_bytes(twiddle_bytes), d_filtered(false)
 {
 	assert(sizeof(std::streamsize) >= sizeof(int64_t));
 
@@ -77,7 +79,7 @@ D4StreamUnMarshaller::D4StreamUnMarshaller(istream &in, bool twiddle_bytes) : d_
  *
  * @param in
  */
-D4StreamUnMarshaller::D4StreamUnMarshaller(istream &in) : d_in( in ), d_twiddle_bytes(false)
+D4StreamUnMarshaller::D4StreamUnMarshaller(istream &in) : d_in( in ), d_chunked(dynamic_cast<chunked_istream*>(&in)), d_twiddle_bytes(false), d_filtered(false)
 {
 	assert(sizeof(std::streamsize) >= sizeof(int64_t));
 
@@ -360,6 +362,41 @@ void D4StreamUnMarshaller::m_twidle_vector_elements(char *vals, int64_t num, int
     }
 }
 
+/**
+ * @brief Read the values of an array of 2, 4 or 8 byte values
+ *
+ * If the data were filtered, read the filter byte and undo the filters.
+ * When reading from a chunked_istream, its CHUNK_FILTERED bit says whether
+ * the filter byte is there.
+ * The shuffle filter is undone before the byte order is fixed and the delta
+ * filter after.
+ *
+ * @param val Read the values here
+ * @param num_elem The number of values
+ * @param width The size of a value
+ * @param bytes The size of the array in bytes
+ */
+void D4StreamUnMarshaller::m_read_vector(char *val, int64_t num_elem, int width, int64_t bytes)
+{
+    uint8_t filters = vector_filter_none;
+    if (d_chunked ? d_chunked->filtered() : d_filtered) {
+        d_in.read(reinterpret_cast<char*>(&filters), sizeof(uint8_t));
+        if (filters & ~VECTOR_FILTER_MASK)
+            throw InternalErr(__FILE__, __LINE__, "Unknown array filter in the data.");
+    }
+
+    d_in.read(val, bytes);
+
+    if (filters & vector_filter_shuffle)
+        vector_unshuffle(val, num_elem, width);
+
+    if (d_twiddle_bytes)
+        m_twidle_vector_elements(val, num_elem, width);
+
+    if (filters & vector_filter_delta)
+        vector_undelta(val, num_elem, width);
+}
+
 void
 D4StreamUnMarshaller::get_vector(char *val, int64_t num_elem, int elem_size)
 {
@@ -394,10 +431,7 @@ D4StreamUnMarshaller::get_vector(char *val, int64_t num_elem, int elem_size)
 		break;
 	}
 
-    d_in.read(val, bytes);
-
-    if (d_twiddle_bytes)
-        m_twidle_vector_elements(val, num_elem, elem_size);
+    m_read_vector(val, num_elem, elem_size, bytes);
 }
 
 void
@@ -411,10 +445,7 @@ D4StreamUnMarshaller::get_vector_float32(char *val, int64_t num_elem)
 
 	int64_t bytes = num_elem << 2;
 
-    d_in.read(val, bytes);
-
-    if (d_twiddle_bytes)
-        m_twidle_vector_elements(val, num_elem, sizeof(dods_float32));
+    m_read_vector(val, num_elem, sizeof(dods_float32), bytes);
 
 #else
     if (type == dods_float32_c && !std::numeric_limits<float>::is_iec559) {
@@ -425,9 +456,7 @@ D4StreamUnMarshaller::get_vector_float32(char *val, int64_t num_elem)
         m_deserialize_reals(val, num, 8, type);
     }
     else {
-        d_in.read(val, num * width);
-        if (d_twiddle_bytes)
-            m_twidle_vector_elements(val, num, width);
+        m_read_vector(val, num, width, num * width);
     }
 #endif
 }
@@ -443,10 +472,7 @@ D4StreamUnMarshaller::get_vector_float64(char *val, int64_t num_elem)
 
 	int64_t bytes = num_elem << 3;
 
-    d_in.read(val, bytes);
-
-    if (d_twiddle_bytes)
-        m_twidle_vector_elements(val, num_elem, sizeof(dods_float64));
+    m_read_vector(val, num_elem, sizeof(dods_float64), bytes);
 
 #else
     if (type == dods_float32_c && !std::numeric_limits<float>::is_iec559) {
@@ -457,9 +483,7 @@ D4StreamUnMarshaller::get_vector_float64(char *val, int64_t num_elem)
         m_deserialize_reals(val, num, 8, type);
     }
     else {
-        d_in.read(val, num * width);
-        if (d_twiddle_bytes)
-            m_twidle_vector_elements(val, num, width);
+        m_read_vector(val, num, width, num * width);
     }
 #endif
 }
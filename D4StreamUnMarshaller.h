@@ -59,6 +59,7 @@ using std::istream;
 namespace libdap {
 
 class Vector;
+class chunked_istream;
 
 /** @brief Read data from the stream made by D4StreamMarshaller.
  */
@@ -68,7 +69,9 @@ public:
 
 private:
     istream &d_in;
+    chunked_istream *d_chunked; // d_in, if it is a chunked_istream; weak pointer
     bool d_twiddle_bytes;
+    bool d_filtered;
 
 #if USE_XDR_FOR_IEEE754_ENCODING
     // These are used for reals that need to be converted from IEEE 754
@@ -83,6 +86,7 @@ private:
     void m_deserialize_reals(char *val, int64_t num, int width, Type type);
 #endif
     void m_twidle_vector_elements(char *vals, int64_t num, int width);
+    void m_read_vector(char *val, int64_t num_elem, int width, int64_t bytes);
 
 public:
     D4StreamUnMarshaller(istream &in, bool twiddle_bytes);
@@ -91,6 +95,16 @@ public:
 
     void set_twiddle_bytes(bool twiddle) { d_twiddle_bytes = twiddle; }
 
+    /**
+     * @brief Were the arrays written using pre-filters?
+     * Only used when reading from a stream that is not a chunked_istream;
+     * for a chunked_istream, the CHUNK_FILTERED bit of its chunks is used
+     * (see chunked_istream::filtered()).
+     * @see D4StreamMarshaller::set_filters()
+     */
+    void set_filtered(bool filtered) { d_filtered = filtered; }
+    bool get_filtered() const { return d_filtered; }
+
     /**
      * @brief Is the data source we are reading from a big-endian machine?
      * We need this because the value of the CRC32 checksum is dependent on
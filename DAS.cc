@@ -295,15 +295,20 @@ DAS::parse(FILE *in)
         throw InternalErr(__FILE__, __LINE__, "Null input stream.");
     }
 
-    void *buffer = das_buffer(in);
-    das_switch_to_buffer(buffer);
-
     parser_arg arg(this);
+    bool status;
+
+    {
+        // The scanner and parser use global state; see parser_lock
+        parser_lock lock(parser_lock::das_grammar);
 
-    //bool status = dasparse((void *) & arg) == 0;
-    bool status = dasparse(&arg) == 0;
+        void *buffer = das_buffer(in);
+        das_switch_to_buffer(buffer);
 
-    das_delete_buffer(buffer);
+        status = dasparse(&arg) == 0;
+
+        das_delete_buffer(buffer);
+    }
 
     //  STATUS is the result of the parser function; if a recoverable error
     //  was found it will be true but arg.status() will be false.
@@ -71,6 +71,7 @@
 #include "debug.h"
 #include "util.h"
 #include "DapIndent.h"
+#include "IndexLock.h"
 
 #include "Byte.h"
 #include "Int16.h"
@@ -173,6 +174,11 @@ DDS::duplicate(const DDS &dds)
 
     d_attr = dds.d_attr;
 
+    d_index_version = 0;
+    d_names_version = 1;
+    d_sizes_version = 1;
+    d_request_size_version[0] = d_request_size_version[1] = 0;
+
     DDS &dds_tmp = const_cast<DDS &>(dds);
 
     // copy the things pointed to by the list, not just the pointers
@@ -204,8 +210,10 @@ DDS::duplicate(const DDS &dds)
 DDS::DDS(BaseTypeFactory *factory, const string &name)
         : d_factory(factory), d_name(name), d_container_name(""), d_container(0),
           d_request_xml_base(""),
-          d_timeout(0), /*d_keywords(),*/ d_max_response_size(0)
+          d_timeout(0), /*d_keywords(),*/ d_max_response_size(0), d_index_version(0), d_names_version(1), d_sizes_version(1)
 {
+    d_request_size_version[0] = d_request_size_version[1] = 0;
+
     DBG(cerr << "Building a DDS for the default version (2.0)" << endl);
 
     // This method sets a number of values, including those returned by
@@ -231,8 +239,10 @@ DDS::DDS(BaseTypeFactory *factory, const string &name)
 DDS::DDS(BaseTypeFactory *factory, const string &name, const string &version)
         : d_factory(factory), d_name(name), d_container_name(""), d_container(0),
           d_request_xml_base(""),
-          d_timeout(0), /*d_keywords(),*/ d_max_response_size(0)
+          d_timeout(0), /*d_keywords(),*/ d_max_response_size(0), d_index_version(0), d_names_version(1), d_sizes_version(1)
 {
+    d_request_size_version[0] = d_request_size_version[1] = 0;
+
     DBG(cerr << "Building a DDS for version: " << version << endl);
 
     // This method sets a number of values, including those returned by
@@ -558,6 +568,9 @@ DDS::container()
  *  implementation would look at row-constraint-based limitations and use them
  *  for size computations. If a row-constraint is missing, return an error.
  *
+ *  @note The result overflows for responses larger than 2GB; use
+ *  get_request_size_kb() or too_big() instead.
+ *
  *  @param constrained Should the size of the whole DDS be used or should the
  *  current constraint be taken into account?
  */
@@ -578,6 +591,59 @@ DDS::get_request_size(bool constrained)
     return w;
 }
 
+/** @brief Get the size of a response, in kilobytes.
+ *
+ *  Like get_request_size(), but computed using 64-bit arithmetic (see
+ *  BaseType::width_ll()) so that the size of very large requests does not
+ *  overflow. The result is cached until a variable's send_p property,
+ *  length or constraint changes or a variable is added, removed or renamed
+ *  (see BaseType::sizes_changed()), so the response limit can be
+ *  checked as often as needed while a request is processed.
+ *
+ *  @param constrained Should the size of the whole DDS be used or should the
+ *  current constraint be taken into account?
+ *  @return The size of the request in kilobytes
+ */
+uint64_t
+DDS::get_request_size_kb(bool constrained)
+{
+    return m_request_size(constrained) / 1024;
+}
+
+/** @brief Is the constrained response larger than the response limit?
+ *
+ *  Call this after the constraint has been parsed and before any data are
+ *  read, so that requests that are too large are rejected before doing any
+ *  I/O.
+ *
+ *  @return True if a response limit is set and the size of the constrained
+ *  response exceeds it, false otherwise.
+ */
+bool
+DDS::too_big()
+{
+    return d_max_response_size != 0 && m_request_size(true) > (uint64_t) d_max_response_size;
+}
+
+// Private. The size of the response in bytes.
+uint64_t
+DDS::m_request_size(bool constrained)
+{
+    if (d_request_size_version[constrained] == d_sizes_version)
+        return d_request_size[constrained];
+
+    int64_t w = 0;
+    for (Vars_iter i = vars.begin(); i != vars.end(); i++) {
+        if (!constrained || (*i)->send_p())
+            w += (*i)->width_ll(constrained);
+    }
+
+    d_request_size[constrained] = w;
+    d_request_size_version[constrained] = d_sizes_version;
+
+    return w;
+}
+
 /** @brief Adds a copy of the variable to the DDS.
     Using the ptr_duplicate() method, perform a deep copy on the variable
     \e bt and adds the result to this DDS.
@@ -603,7 +669,9 @@ void DDS::add_var(BaseType *bt) {
         btp = 0;
     }
     else {
+        btp->m_set_dds(this);
         vars.push_back(btp);
+        names_changed();
     }
 }
 
@@ -621,7 +689,9 @@ DDS::add_var_nocopy(BaseType *bt)
         d_container->add_var_nocopy(bt);
     }
     else {
+        bt->m_set_dds(this);
         vars.push_back(bt);
+        names_changed();
     }
 }
 
@@ -645,6 +715,8 @@ DDS::del_var(const string &n)
         if ((*i)->name() == n) {
             BaseType *bt = *i ;
             vars.erase(i) ;
+            names_changed();
+            bt->m_set_dds(0);
             delete bt ; bt = 0;
             return;
         }
@@ -661,6 +733,8 @@ DDS::del_var(Vars_iter i)
     if (i != vars.end()) {
         BaseType *bt = *i ;
         vars.erase(i) ;
+        names_changed();
+        bt->m_set_dds(0);
         delete bt ; bt = 0;
     }
 }
@@ -676,9 +750,35 @@ DDS::del_var(Vars_iter i1, Vars_iter i2)
 {
     for (Vars_iter i_tmp = i1; i_tmp != i2; i_tmp++) {
         BaseType *bt = *i_tmp ;
+        bt->m_set_dds(0);
         delete bt ; bt = 0;
     }
     vars.erase(i1, i2) ;
+    names_changed();
+}
+
+/** Record that a variable in this DDS was renamed, or that a variable was
+    added to or removed from it. The methods that add and remove variables
+    call this, and BaseType::names_changed() calls it for the variables held
+    by this DDS, so it is needed only when the variables are changed some
+    other way, e.g., using the iterators returned by var_begin().
+
+    The index used by var() is rebuilt the next time it is used. */
+void
+DDS::names_changed()
+{
+    ++d_names_version;
+    sizes_changed();
+}
+
+/** Record that the size of a variable in this DDS might have changed.
+    BaseType::sizes_changed() calls this for the variables held by this
+    DDS; get_request_size_kb() and too_big() compute the size of the
+    response again the next time they are called. */
+void
+DDS::sizes_changed()
+{
+    ++d_sizes_version;
 }
 
 /** Search for for variable <i>n</i> as above but record all
@@ -707,6 +807,11 @@ DDS::var(const string &n, BaseType::btp_stack &s)
     that are the same (say point.x and pair.x) you should use fully qualified
     names to get each of those variables.
 
+    @note The first call builds an index of the variables' names that later
+    calls use until a variable is renamed, added or removed. The index is
+    locked while it is built and searched, so several threads may look up
+    names in the same DDS, but not while another thread changes it.
+
     @param n The name of the variable to find.
     @param s If given, this value-result parameter holds the path to the
     returned BaseType. Thus, this method can return the FQN for the variable
@@ -726,11 +831,80 @@ DDS::var(const string &n, BaseType::btp_stack *s)
     return leaf_match(name, s);
 }
 
+// Private. Can the indexes be used to look up \e name? If so, make sure
+// they are current.
+bool
+DDS::m_use_index(const string &name)
+{
+    // Constructor::var() decodes the name a second time, so the result of
+    // looking up a name that still contains escapes can depend on the depth
+    // at which it is found.
+    if (d_container || name.find('%') != string::npos)
+        return false;
+
+    if (d_index_version != d_names_version)
+        m_build_index();
+
+    return true;
+}
+
+// Private
+void
+DDS::m_build_index()
+{
+    d_index_version = d_names_version;
+
+    d_var_index.clear();
+    d_leaf_index.clear();
+
+    vector<BaseType *> containers;
+    for (Vars_iter i = vars.begin(); i != vars.end(); i++) {
+        d_var_index.insert(make_pair((*i)->name(), *i));
+        m_index_var(*i, containers);
+    }
+}
+
+// Private. Add btp and the variables it holds to the leaf index, visiting
+// them in the same order as leaf_match() and Constructor::var().
+void
+DDS::m_index_var(BaseType *btp, vector<BaseType *> &containers)
+{
+    if (d_leaf_index.find(btp->name()) == d_leaf_index.end()) {
+        vector<BaseType *> &entry = d_leaf_index[btp->name()];
+        entry.push_back(btp);
+        entry.insert(entry.end(), containers.rbegin(), containers.rend());
+    }
+
+    Constructor *c = btp->is_constructor_type() ? dynamic_cast<Constructor *>(btp) : 0;
+    if (c) {
+        containers.push_back(c);
+        for (Constructor::Vars_iter i = c->var_begin(); i != c->var_end(); i++)
+            m_index_var(*i, containers);
+        containers.pop_back();
+    }
+}
+
 BaseType *
 DDS::leaf_match(const string &n, BaseType::btp_stack *s)
 {
     DBG(cerr << "DDS::leaf_match: Looking for " << n << endl);
 
+    {
+        IndexLock lock(this);
+        if (m_use_index(n)) {
+            map<string, vector<BaseType *> >::iterator i = d_leaf_index.find(n);
+            if (i == d_leaf_index.end())
+                return 0;
+
+            if (s) {
+                for (vector<BaseType *>::iterator c = i->second.begin() + 1; c != i->second.end(); c++)
+                    s->push(*c);
+            }
+
+            return i->second.front();
+        }
+    }
+
     for (Vars_iter i = vars.begin(); i != vars.end(); i++) {
         BaseType *btp = *i;
         DBG(cerr << "DDS::leaf_match: Looking for " << n << " in: " << btp->name() << endl);
@@ -765,13 +939,26 @@ DDS::leaf_match(const string &n, BaseType::btp_stack *s)
 BaseType *
 DDS::exact_match(const string &name, BaseType::btp_stack *s)
 {
-    for (Vars_iter i = vars.begin(); i != vars.end(); i++) {
-        BaseType *btp = *i;
-        DBG2(cerr << "Looking for " << d_name << " in: " << btp << endl);
-        // Look for the d_name in the current ctor type or the top level
-        if (btp->name() == name) {
-            DBG2(cerr << "Found " << d_name << " in: " << btp << endl);
-            return btp;
+    bool indexed;
+    {
+        IndexLock lock(this);
+        indexed = m_use_index(name);
+        if (indexed) {
+            map<string, BaseType *>::iterator i = d_var_index.find(name);
+            if (i != d_var_index.end())
+                return i->second;
+        }
+    }
+
+    if (!indexed) {
+        for (Vars_iter i = vars.begin(); i != vars.end(); i++) {
+            BaseType *btp = *i;
+            DBG2(cerr << "Looking for " << d_name << " in: " << btp << endl);
+            // Look for the d_name in the current ctor type or the top level
+            if (btp->name() == name) {
+                DBG2(cerr << "Found " << d_name << " in: " << btp << endl);
+                return btp;
+            }
         }
     }
 
@@ -848,7 +1035,10 @@ DDS::insert_var(Vars_iter i, BaseType *ptr)
     if (ptr->is_dap4_only_type())
         throw InternalErr(__FILE__, __LINE__, "Attempt to add a DAP4 type to a DAP2 DDS.");
 #endif
-    vars.insert(i, ptr->ptr_duplicate());
+    BaseType *btp = ptr->ptr_duplicate();
+    btp->m_set_dds(this);
+    vars.insert(i, btp);
+    names_changed();
 }
 
 /** Insert the BaseType before the position given.
@@ -865,7 +1055,9 @@ DDS::insert_var_nocopy(Vars_iter i, BaseType *ptr)
     if (ptr->is_dap4_only_type())
         throw InternalErr(__FILE__, __LINE__, "Attempt to add a DAP4 type to a DAP2 DDS.");
 #endif
+    ptr->m_set_dds(this);
     vars.insert(i, ptr);
+    names_changed();
 }
 
 /** @brief Returns the number of variables in the DDS. */
@@ -999,14 +1191,20 @@ DDS::parse(FILE *in)
         throw InternalErr(__FILE__, __LINE__, "Null input stream.");
     }
 
-    void *buffer = dds_buffer(in);
-    dds_switch_to_buffer(buffer);
-
     parser_arg arg(this);
+    bool status;
+
+    {
+        // The scanner and parser use global state; see parser_lock
+        parser_lock lock(parser_lock::dds_grammar);
 
-    bool status = ddsparse(&arg) == 0;
+        void *buffer = dds_buffer(in);
+        dds_switch_to_buffer(buffer);
 
-    dds_delete_buffer(buffer);
+        status = ddsparse(&arg) == 0;
+
+        dds_delete_buffer(buffer);
+    }
 
     DBG2(cout << "Status from parser: " << status << endl);
 
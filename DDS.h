@@ -39,6 +39,7 @@
 
 #include <cstdio>
 #include <iostream>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -210,6 +211,32 @@ private:
 
     long d_max_response_size;   // In bytes...
 
+    // Indexes used by exact_match() and leaf_match(). d_var_index holds the
+    // top-level variables; d_leaf_index holds every variable, keyed by its
+    // name, followed by the Constructors that hold it, innermost first. Only
+    // the first variable with a given name (in the order leaf_match() would
+    // find it) is recorded. Rebuilt when d_names_version shows that the DDS
+    // may have changed.
+    std::map<string, BaseType *> d_var_index;
+    std::map<string, std::vector<BaseType *> > d_leaf_index;
+    unsigned long d_index_version;
+
+    // Changes when a variable in the DDS is renamed, added or removed
+    unsigned long d_names_version;
+
+    // Changes when the size of a variable in the DDS might have changed
+    unsigned long d_sizes_version;
+
+    // Cached values of get_request_size_kb(), unconstrained and constrained,
+    // in bytes; valid while d_sizes_version matches d_request_size_version.
+    uint64_t d_request_size[2];
+    unsigned long d_request_size_version[2];
+
+    uint64_t m_request_size(bool constrained);
+    bool m_use_index(const string &name);
+    void m_build_index();
+    void m_index_var(BaseType *btp, std::vector<BaseType *> &containers);
+
     friend class DDSTest;
 
 protected:
@@ -304,6 +331,9 @@ public:
 
     /// Get the estimated response size.
     int get_request_size(bool constrained);
+    uint64_t get_request_size_kb(bool constrained);
+
+    bool too_big();
 
     string container_name() ;
     void container_name( const string &cn ) ;
@@ -312,6 +342,9 @@ public:
     void add_var(BaseType *bt);
     void add_var_nocopy(BaseType *bt);
 
+    void names_changed();
+    void sizes_changed();
+
     /// Removes a variable from the DDS.
     void del_var(const string &n);
 
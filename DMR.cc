@@ -99,6 +99,7 @@ DMR::m_duplicate(const DMR &dmr)
     // Deep copy, using ptr_duplicate()
     // d_root can only be a D4Group, so the thing returned by ptr_duplicate() must be a D4Group.
     d_root = static_cast<D4Group*>(dmr.d_root->ptr_duplicate());
+    d_request_size_version[0] = d_request_size_version[1] = 0;
     DBG(cerr << "dmr.d_root: " << dmr.d_root << endl);
     DBG(cerr << "d_root (from ptr_dup(): " << d_root << endl);
 
@@ -123,6 +124,8 @@ DMR::DMR(D4BaseTypeFactory *factory, const string &name)
           d_dmr_version("1.0"), d_request_xml_base(""),
           d_namespace(c_dap40_namespace), d_max_response_size(0), d_root(0)
 {
+    d_request_size_version[0] = d_request_size_version[1] = 0;
+
     // sets d_dap_version string and the two integer fields too
     set_dap_version("4.0");
 }
@@ -153,6 +156,8 @@ DMR::DMR(D4BaseTypeFactory *factory, DDS &dds)
           d_dmr_version("1.0"), d_request_xml_base(""),
           d_namespace(c_dap40_namespace), d_max_response_size(0), d_root(0)
 {
+    d_request_size_version[0] = d_request_size_version[1] = 0;
+
     // sets d_dap_version string and the two integer fields too
     set_dap_version("4.0");
 
@@ -184,6 +189,8 @@ DMR::DMR()
           d_dap_version("4.0"), d_dmr_version("1.0"), d_request_xml_base(""),
           d_namespace(c_dap40_namespace), d_max_response_size(0), d_root(0)
 {
+    d_request_size_version[0] = d_request_size_version[1] = 0;
+
     // sets d_dap_version string and the two integer fields too
     set_dap_version("4.0");
 }
@@ -464,7 +471,45 @@ DMR::set_dap_version(const string &v)
 long
 DMR::request_size(bool constrained)
 {
-    return d_root->request_size(constrained);
+    return request_size_kb(constrained);
+}
+
+/**
+ * Like request_size(), but uses 64-bit arithmetic so the size of very large
+ * requests does not overflow. The result is cached until a variable's
+ * send_p property, length or constraint changes or a variable is added,
+ * removed or renamed (see BaseType::sizes_changed()), so calling this
+ * repeatedly while a request is processed is cheap.
+ *
+ * @param constrained Should the size of the whole DMR be used or should the
+ * current constraint be taken into account?
+ * @return The size of the request in kilobytes
+ */
+uint64_t
+DMR::request_size_kb(bool constrained)
+{
+    unsigned long version = root()->sizes_version();
+    if (d_request_size_version[constrained] != version) {
+        d_request_size[constrained] = root()->request_size_kb(constrained);
+        d_request_size_version[constrained] = version;
+    }
+
+    return d_request_size[constrained];
+}
+
+/**
+ * @brief Is the constrained response larger than the response limit?
+ *
+ * Call this after the constraint has been applied and before any data are
+ * read, so that requests that are too large can be rejected early.
+ *
+ * @return True if a response limit is set and the size of the constrained
+ * response exceeds it, false otherwise.
+ */
+bool
+DMR::too_big()
+{
+    return d_max_response_size != 0 && request_size_kb(true) > (uint64_t) d_max_response_size;
 }
 
 /**
@@ -82,6 +82,11 @@ private:
     /// The root group; holds dimensions, enums, variables, groups, ...
     D4Group *d_root;
 
+    /// Cached values of request_size_kb(), unconstrained and constrained;
+    /// valid while the sizes_version() of d_root matches d_request_size_version
+    uint64_t d_request_size[2];
+    unsigned long d_request_size_version[2];
+
     friend class DMRTest;
 
 protected:
@@ -164,6 +169,9 @@ public:
 
     /// Get the estimated response size, in kilo bytes
     long request_size(bool constrained);
+    uint64_t request_size_kb(bool constrained);
+
+    bool too_big();
 
     /** Return the root group of this Dataset. If no root group has been
      * set, use the D4BaseType factory to make it.
@@ -73,6 +73,9 @@
 #include "escaping.h"
 #include "DODSFilter.h"
 #include "XDRStreamMarshaller.h"
+#include "XDRFdMarshaller.h"
+#include "fdiostream.h"
+#include "deflate_ostream.h"
 #include "InternalErr.h"
 
 #ifndef WIN32
@@ -92,7 +95,7 @@ const string usage =
     \n\
     options: -o <response>: DAS, DDS, DataDDS, DDX, BLOB or Version (Required)\n\
     -u <url>: The complete URL minus the CE (required for DDX)\n\
-    -c: Compress the response using the deflate algorithm.\n\
+    -c: Compress the response using gzip.\n\
     -e <expr>: When returning a DataDDS, use <expr> as the constraint.\n\
     -v <version>: Use <version> as the version number\n\
     -d <dir>: Look for ancillary file in <dir> (deprecated).\n\
@@ -127,7 +130,11 @@ and is useful for debugging, et cetera. Each response returns version
 information in an HTTP header for internal use by a client.
 
 <dt><tt>-c</tt><dd>
-Send compressed data. Data are compressed using the deflate program.
+Send compressed data. This is ignored unless the server has called
+set_compression_enabled(true); by default the data are sent uncompressed
+and the web server or dispatch script that runs the handler may compress
+them. When enabled, the data are compressed using gzip by
+get_compression_threads() threads.
 
 <dt><tt>-e</tt> <i>expression</i><dd>
 This option specifies a non-blank constraint expression used to
@@ -211,6 +218,8 @@ DODSFilter::initialize()
     d_url = "";
     d_program_name = "Unknown";
     d_timeout = 0;
+    d_compression_enabled = false;
+    d_compression_threads = DEFLATE_THREADS;
 
 #ifdef WIN32
     //  We want serving from win32 to behave in a manner
@@ -613,6 +622,46 @@ DODSFilter::get_timeout() const
     return d_timeout;
 }
 
+/** Should the \c -c option compress data responses here? This is off by
+    default, so \c -c has no effect and the data are sent uncompressed; a
+    server that does not compress its responses some other way can turn it
+    on.
+
+    @param enabled If true, compress the data responses (but not their
+    MIME headers) using gzip when the client asked for compressed data.
+    @see set_compression_threads() */
+void
+DODSFilter::set_compression_enabled(bool enabled)
+{
+    d_compression_enabled = enabled;
+}
+
+/** Will the \c -c option compress data responses here? */
+bool
+DODSFilter::get_compression_enabled() const
+{
+    return d_compression_enabled;
+}
+
+/** Set the number of threads used to compress a data response. Each
+    compressed response uses this many threads, so a server that sends many
+    responses at once should keep it small.
+
+    @param num_threads The number of threads; DEFLATE_THREADS by default.
+    @see deflate_ostream */
+void
+DODSFilter::set_compression_threads(unsigned int num_threads)
+{
+    d_compression_threads = num_threads;
+}
+
+/** Get the number of threads used to compress a data response. */
+unsigned int
+DODSFilter::get_compression_threads() const
+{
+    return d_compression_threads;
+}
+
 /** Use values of this instance to establish a timeout alarm for the server.
     If the timeout value is zero, do nothing.
 
@@ -855,13 +904,16 @@ DODSFilter::functional_constraint(BaseType &var, DDS &dds,
     }
 }
 
+// Write to the FILE's descriptor using the ostream method, so that a
+// subclass that specializes that method changes this response too.
 void
 DODSFilter::dataset_constraint(DDS & dds, ConstraintEvaluator & eval,
                                FILE * out, bool ce_eval) const
 {
-    ostringstream oss;
-    dataset_constraint(dds, eval, oss, ce_eval);
-    fwrite(oss.str().data(), sizeof(char), oss.str().length(), out);
+    fflush(out);
+    fdostream os(fileno(out));
+    dataset_constraint(dds, eval, os, ce_eval);
+    os << flush ;
 }
 
 void
@@ -873,19 +925,50 @@ DODSFilter::dataset_constraint(DDS & dds, ConstraintEvaluator & eval,
     out << "Data:\n" ;
     out << flush ;
 
-    // Grab a stream that encodes using XDR.
-    XDRStreamMarshaller m( out ) ;
+    serialize_data(dds, eval, out, ce_eval);
+}
+
+/** Send the values of the variables in the current projection. This is
+    called by dataset_constraint() once the constrained DDS has been sent.
+
+    If \c out writes to a file descriptor (it is an fdostream, as when one of
+    the FILE methods was called), the values are encoded in large blocks and
+    written straight to the descriptor using XDRFdMarshaller. Otherwise they
+    are written to \c out using XDRStreamMarshaller.
+
+    @param dds The DDS
+    @param eval The ConstraintEvaluator
+    @param out Write the values here
+    @param ce_eval If true, evaluate the selection clauses of the constraint */
+void
+DODSFilter::serialize_data(DDS & dds, ConstraintEvaluator & eval,
+                           ostream &out, bool ce_eval) const
+{
+    fdoutbuf *fdbuf = dynamic_cast<fdoutbuf*>(out.rdbuf());
+    if (fdbuf) {
+        out << flush ;
+
+        XDRFdMarshaller m(fdbuf->get_fd());
 
-    try {
         // Send all variables in the current projection (send_p())
         for (DDS::Vars_iter i = dds.var_begin(); i != dds.var_end(); i++)
             if ((*i)->send_p()) {
                 DBG(cerr << "Sending " << (*i)->name() << endl);
                 (*i)->serialize(eval, dds, m, ce_eval);
             }
+
+        m.flush();
     }
-    catch (Error & e) {
-        throw;
+    else {
+        // Grab a stream that encodes using XDR.
+        XDRStreamMarshaller m( out ) ;
+
+        // Send all variables in the current projection (send_p())
+        for (DDS::Vars_iter i = dds.var_begin(); i != dds.var_end(); i++)
+            if ((*i)->send_p()) {
+                DBG(cerr << "Sending " << (*i)->name() << endl);
+                (*i)->serialize(eval, dds, m, ce_eval);
+            }
     }
 }
 
@@ -930,6 +1013,87 @@ DODSFilter::dataset_constraint_ddx(DDS & dds, ConstraintEvaluator & eval,
     }
 }
 
+// Throw Error if the constrained response would be larger than the limit
+// set with DDS::set_response_limit(). If there are function clauses, fdds
+// holds their result; it is the DDS that will be sent, but the limit is set
+// on dds. Check before any part of the response is written, so that the
+// client gets the error instead of a truncated response.
+static void
+check_response_size(DDS &dds, DDS *fdds)
+{
+    if (fdds)
+        fdds->set_response_limit(dds.get_response_limit() / 1024);
+
+    DDS &response = fdds ? *fdds : dds;
+    if (response.too_big())
+        throw Error("The Request for " + long_to_string(response.get_request_size_kb(true))
+                + "KB is too large; requests for this user are limited to "
+                + long_to_string(dds.get_response_limit() / 1024) + "KB.");
+}
+
+/** Do the work common to the send_data() methods up to the data: send a
+    304 response to a conditional request if the data have not changed, set
+    up the alarm, parse the constraint, evaluate any function clauses, check
+    the size of the response and send the MIME headers.
+
+    @param dds The dataset's DDS
+    @param eval A reference to the ConstraintEvaluator to use.
+    @param out Write the response to this stream
+    @param anc_location A directory to search for ancillary files
+    @param with_mime_headers If true, send the MIME headers
+    @param compressed If true, the headers say the data are gzip'd
+    @param fdds Value-result parameter; the DDS made by the function clauses,
+    or null if there are none. The caller must delete it.
+    @exception Error if the response is larger than the limit set using
+    DDS::set_response_limit()
+    @return False if a 304 response was sent, in which case no data should
+    be sent. */
+bool
+DODSFilter::start_data_response(DDS &dds, ConstraintEvaluator &eval,
+                                ostream &out, const string &anc_location,
+                                bool with_mime_headers, bool compressed,
+                                DDS **fdds) const
+{
+    // If this is a conditional request and the server should send a 304
+    // response, do that and exit. Otherwise, continue on and send the full
+    // response.
+    time_t data_lmt = get_data_last_modified_time(anc_location);
+    if (is_conditional()
+        && data_lmt <= get_request_if_modified_since()
+        && with_mime_headers) {
+        set_mime_not_modified(out);
+        return false;
+    }
+    // Set up the alarm.
+    establish_timeout(out);
+    dds.set_timeout(d_timeout);
+
+    eval.parse_constraint(d_dap2ce, dds);   // Throws Error if the ce doesn't
+					// parse.
+
+    dds.tag_nested_sequences(); // Tag Sequences as Parent or Leaf node.
+
+    *fdds = 0;
+    if (eval.function_clauses())
+	*fdds = eval.eval_function_clauses(dds);
+
+    try {
+        check_response_size(dds, *fdds);
+
+        if (with_mime_headers) {
+            EncodingType enc = compressed ? gzip : x_plain;
+            set_mime_binary(out, dods_data, d_cgi_ver, enc, data_lmt);
+        }
+    }
+    catch (...) {
+        delete *fdds;
+        *fdds = 0;
+        throw;
+    }
+
+    return true;
+}
+
 /** Send the data in the DDS object back to the client program. The data is
     encoded using a Marshaller, and enclosed in a MIME document which is all sent
     to \c data_stream. If this is being called from a CGI, \c data_stream is
@@ -939,7 +1103,10 @@ DODSFilter::dataset_constraint_ddx(DDS & dds, ConstraintEvaluator & eval,
     @brief Transmit data.
     @param dds A DDS object containing the data to be sent.
     @param eval A reference to the ConstraintEvaluator to use.
-    @param data_stream Write the response to this FILE.
+    @param data_stream Write the response to this FILE's file descriptor,
+    using send_data(DDS&, ConstraintEvaluator&, ostream&, const string&, bool).
+    Unless the response is compressed, the data values are written using
+    XDRFdMarshaller; see serialize_data().
     @param anc_location A directory to search for ancillary files (in
     addition to the CWD).  This is used in a call to
     get_data_last_modified_time().
@@ -951,9 +1118,12 @@ DODSFilter::send_data(DDS & dds, ConstraintEvaluator & eval,
                       FILE * data_stream, const string & anc_location,
                       bool with_mime_headers) const
 {
-    ostringstream oss;
-    send_data(dds, eval, oss, anc_location, with_mime_headers);
-    fwrite(oss.str().data(), sizeof(char), oss.str().length(), data_stream);
+    // Write to the FILE's descriptor using the ostream method, so that a
+    // subclass that specializes that method changes this response too.
+    fflush(data_stream);
+    fdostream os(fileno(data_stream));
+    send_data(dds, eval, os, anc_location, with_mime_headers);
+    os << flush ;
 }
 
 /** Send the data in the DDS object back to the client program. The data is
@@ -977,62 +1147,33 @@ DODSFilter::send_data(DDS & dds, ConstraintEvaluator & eval,
                       ostream & data_stream, const string & anc_location,
                       bool with_mime_headers) const
 {
-    // If this is a conditional request and the server should send a 304
-    // response, do that and exit. Otherwise, continue on and send the full
-    // response.
-    time_t data_lmt = get_data_last_modified_time(anc_location);
-    if (is_conditional()
-        && data_lmt <= get_request_if_modified_since()
-        && with_mime_headers) {
-        set_mime_not_modified(data_stream);
-        return;
-    }
-    // Set up the alarm.
-    establish_timeout(data_stream);
-    dds.set_timeout(d_timeout);
-
-    eval.parse_constraint(d_dap2ce, dds);   // Throws Error if the ce doesn't
-					// parse.
-
-    dds.tag_nested_sequences(); // Tag Sequences as Parent or Leaf node.
+    // If the client asked for a compressed response and the server enabled
+    // compression, compress the data using d_compression_threads; the MIME
+    // headers are not compressed.
+    bool compressed = d_comp && d_compression_enabled && deflate_ostream::available();
 
-    // Start sending the response...
-
-    // Handle *functional* constraint expressions specially
-#if 0
-    if (eval.functional_expression()) {
-        // Get the result and then start sending the headers. This provides a
-        // way to send errors back to the client w/o colliding with the
-        // normal response headers. There's some duplication of code with this
-        // and the else-clause.
-        BaseType *var = eval.eval_function(dds, d_dataset);
-        if (!var)
-            throw Error(unknown_error, "Error calling the CE function.");
-
-       if (with_mime_headers)
-            set_mime_binary(data_stream, dods_data, d_cgi_ver, x_plain, data_lmt);
+    DDS *fdds = 0;
+    if (!start_data_response(dds, eval, data_stream, anc_location, with_mime_headers, compressed, &fdds))
+        return;
 
-	data_stream << flush ;
+    try {
+        if (compressed) {
+            data_stream << flush ;
 
-        functional_constraint(*var, dds, eval, data_stream);
-        delete var;
-        var = 0;
+            deflate_ostream zout(data_stream, deflate_gzip, -1, d_compression_threads);
+            dataset_constraint(fdds ? *fdds : dds, eval, zout, fdds == 0);
+            zout.finish();
+        }
+        else {
+            dataset_constraint(fdds ? *fdds : dds, eval, data_stream, fdds == 0);
+        }
     }
-#endif
-    if (eval.function_clauses()) {
-	DDS *fdds = eval.eval_function_clauses(dds);
-        if (with_mime_headers)
-            set_mime_binary(data_stream, dods_data, d_cgi_ver, x_plain, data_lmt);
-
-        dataset_constraint(*fdds, eval, data_stream, false);
-	delete fdds;
+    catch (...) {
+        delete fdds;
+        throw;
     }
-    else {
-        if (with_mime_headers)
-            set_mime_binary(data_stream, dods_data, d_cgi_ver, x_plain, data_lmt);
 
-        dataset_constraint(dds, eval, data_stream);
-    }
+    delete fdds;
 
     data_stream << flush ;
 }
@@ -1165,14 +1306,24 @@ DODSFilter::send_data_ddx(DDS & dds, ConstraintEvaluator & eval,
 #endif
     if (eval.function_clauses()) {
     	DDS *fdds = eval.eval_function_clauses(dds);
-        if (with_mime_headers)
-            set_mime_multipart(data_stream, boundary, start, dods_data_ddx,
-        	    d_cgi_ver, x_plain, data_lmt);
-        data_stream << flush ;
-        dataset_constraint(*fdds, eval, data_stream, false);
+        try {
+            check_response_size(dds, fdds);
+
+            if (with_mime_headers)
+                set_mime_multipart(data_stream, boundary, start, dods_data_ddx,
+            	    d_cgi_ver, x_plain, data_lmt);
+            data_stream << flush ;
+            dataset_constraint(*fdds, eval, data_stream, false);
+        }
+        catch (...) {
+            delete fdds;
+            throw;
+        }
     	delete fdds;
     }
     else {
+        check_response_size(dds, 0);
+
         if (with_mime_headers)
             set_mime_multipart(data_stream, boundary, start, dods_data_ddx,
         	    d_cgi_ver, x_plain, data_lmt);
@@ -108,6 +108,8 @@ protected:
     string d_action;  // string name of the response to generate
 
     int d_timeout;  // Server timeout after N seconds
+    bool d_compression_enabled; // True if -c compresses the data here
+    unsigned int d_compression_threads; // Threads that compress a response
 
     time_t d_anc_das_lmt; // Last modified time of the anc. DAS.
     time_t d_anc_dds_lmt; // Last modified time of the anc. DDS.
@@ -118,6 +120,9 @@ protected:
 
     virtual int process_options(int argc, char *argv[]);
 
+    virtual void serialize_data(DDS &dds, ConstraintEvaluator &eval,
+                                ostream &out, bool ce_eval) const;
+
 public:
     /** Make an empty instance. Use the set_*() methods to load with needed
         values. You must call at least set_dataset_name() or be requesting
@@ -170,6 +175,14 @@ public:
 
     int get_timeout() const;
 
+    void set_compression_enabled(bool enabled);
+
+    bool get_compression_enabled() const;
+
+    void set_compression_threads(unsigned int num_threads);
+
+    unsigned int get_compression_threads() const;
+
     virtual void establish_timeout(ostream &stream) const;
 
     virtual void print_usage() const;
@@ -231,6 +244,12 @@ public:
                            bool with_mime_headers = true) const;
     virtual void send_ddx(DDS &dds, ConstraintEvaluator &eval, FILE *out,
                           bool with_mime_headers = true) const;
+
+private:
+    bool start_data_response(DDS &dds, ConstraintEvaluator &eval,
+                             ostream &out, const string &anc_location,
+                             bool with_mime_headers, bool compressed,
+                             DDS **fdds) const;
 };
 
 } // namespace libdap
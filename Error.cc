@@ -160,19 +160,24 @@ Error::parse(FILE *fp)
     if (!fp)
         throw InternalErr(__FILE__, __LINE__, "Null input stream");
 
-    void *buffer = Error_buffer(fp);
-    Error_switch_to_buffer(buffer);
-
     parser_arg arg(this);
 
     bool status;
-    try {
-        status = Errorparse(&arg) == 0;
-        Error_delete_buffer(buffer);
-    }
-    catch (Error &e) {
-        Error_delete_buffer(buffer);
-        throw InternalErr(__FILE__, __LINE__, e.get_error_message());
+    {
+        // The scanner and parser use global state; see parser_lock
+        parser_lock lock(parser_lock::error_grammar);
+
+        void *buffer = Error_buffer(fp);
+        Error_switch_to_buffer(buffer);
+
+        try {
+            status = Errorparse(&arg) == 0;
+            Error_delete_buffer(buffer);
+        }
+        catch (Error &e) {
+            Error_delete_buffer(buffer);
+            throw InternalErr(__FILE__, __LINE__, e.get_error_message());
+        }
     }
 
     // STATUS is the result of the parser function; if a recoverable error
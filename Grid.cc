@@ -356,6 +356,7 @@ Grid::add_var_nocopy(BaseType *bt, Part part)
     	// FIXME Why is this commented out?
             //bt->set_parent(this);
             d_vars.push_back(bt);
+            names_changed();
         }
     break;
 
@@ -367,6 +368,7 @@ Grid::add_var_nocopy(BaseType *bt, Part part)
         }
         else {
             d_vars.push_back(bt);
+            names_changed();
         }
     }
     break;
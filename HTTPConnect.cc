@@ -60,6 +60,7 @@
 #include "GNURegex.h"
 #include "HTTPCache.h"
 #include "HTTPConnect.h"
+#include "chunked_stream.h"
 #include "RCReader.h"
 #include "HTTPResponse.h"
 #include "HTTPCacheResponse.h"
@@ -1060,6 +1061,28 @@ HTTPConnect::set_xdap_protocol(int major, int minor)
              ostream_iterator<string>(cerr, "\n")));
 }
 
+/** Set the list of DAP4 chunk features the client can read. This is sent
+    to servers using the XDAP-Accept-Chunk-Features HTTP request header
+    (CHUNK_FEATURES_HEADER) so that they only use those features.
+
+    @param features A comma separated list of features, e.g.,
+    CHUNK_FEATURE_FILTERED; an empty string removes the header. */
+void
+HTTPConnect::set_chunk_features(const string &features)
+{
+    string header = CHUNK_FEATURES_HEADER;
+
+    // Look for, and remove if one exists, an XDAP-Accept-Chunk-Features header
+    vector<string>::iterator i;
+    i = find_if(d_request_headers.begin(), d_request_headers.end(),
+                HeaderMatch(header + ":"));
+    if (i != d_request_headers.end())
+        d_request_headers.erase(i);
+
+    if (!features.empty())
+        d_request_headers.push_back(header + ": " + features);
+}
+
 /** Set the credentials for responding to challenges while dereferencing
     URLs. Alternatively, these can be embedded in the URL. This method
     provides a way for clients of HTTPConnect to get credentials from users
@@ -131,6 +131,7 @@ public:
     void set_credentials(const string &u, const string &p);
     void set_accept_deflate(bool defalte);
     void set_xdap_protocol(int major, int minor);
+    void set_chunk_features(const string &features);
 
     bool use_cpp_streams() const { return d_use_cpp_streams; }
     void set_use_cpp_streams(bool use_cpp_streams) { d_use_cpp_streams = use_cpp_streams; }
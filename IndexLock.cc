@@ -0,0 +1,74 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "IndexLock.h"
+#include "InternalErr.h"
+
+namespace libdap {
+
+// Must be a power of two
+static const unsigned int num_index_mutexes = 64;
+
+static pthread_mutex_t index_mutex[num_index_mutexes];
+static pthread_once_t index_mutex_control = PTHREAD_ONCE_INIT;
+
+static void initialize_index_mutexes()
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+
+    for (unsigned int i = 0; i < num_index_mutexes; ++i)
+        pthread_mutex_init(&index_mutex[i], &attr);
+
+    pthread_mutexattr_destroy(&attr);
+}
+
+/**
+ * Lock the index of \e owner.
+ * @param owner The object that holds the index
+ */
+IndexLock::IndexLock(const void *owner)
+{
+    pthread_once(&index_mutex_control, initialize_index_mutexes);
+
+    // The low bits of an address are the same for most objects
+    uintptr_t p = reinterpret_cast<uintptr_t>(owner);
+    d_mutex = (p >> 4 ^ p >> 10) & (num_index_mutexes - 1);
+
+    if (pthread_mutex_lock(&index_mutex[d_mutex]) != 0)
+        throw InternalErr(__FILE__, __LINE__, "Could not lock an index mutex.");
+}
+
+IndexLock::~IndexLock()
+{
+    pthread_mutex_unlock(&index_mutex[d_mutex]);
+}
+
+} // namespace libdap
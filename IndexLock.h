@@ -0,0 +1,56 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#ifndef _index_lock_h
+#define _index_lock_h 1
+
+namespace libdap {
+
+/**
+ * @brief Lock the name index of a DDS, Constructor or AttrTable.
+ *
+ * Those classes build their name indexes the first time a name is looked
+ * up (and again after a variable is renamed), so two threads looking up
+ * names in the same object, e.g., server functions evaluated in parallel,
+ * must not use the index at the same time. An IndexLock locks one of a
+ * small, fixed set of recursive mutexes chosen using the address of the
+ * object, so the objects themselves do not each need a mutex. Hold the
+ * lock only while the index is built and searched.
+ */
+class IndexLock {
+private:
+    unsigned int d_mutex;
+
+    IndexLock();
+    IndexLock(const IndexLock &);
+    IndexLock &operator=(const IndexLock &);
+
+public:
+    IndexLock(const void *owner);
+    ~IndexLock();
+};
+
+} // namespace libdap
+
+#endif // _index_lock_h
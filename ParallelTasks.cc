@@ -0,0 +1,318 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <pthread.h>
+
+#include <deque>
+#include <exception>
+#include <map>
+
+#include "ParallelTasks.h"
+#include "BaseType.h"
+#include "Error.h"
+#include "InternalErr.h"
+#include "D4ParseError.h"
+#include "DDXExceptions.h"
+
+#include "debug.h"
+
+using namespace std;
+
+namespace libdap {
+
+static pthread_once_t pool_instance_control = PTHREAD_ONCE_INIT;
+
+/**
+ * The threads that help ParallelTasks::run(). A run() that can use more
+ * than one thread queues one job entry for each helper it wants; an idle
+ * thread takes an entry and runs tasks for that ParallelTasks until none
+ * are left. Threads are started when a run() asks for more helpers than
+ * there are threads and wait for work until the process exits, so the one
+ * pool is never deleted.
+ */
+class ParallelTasks::Pool {
+private:
+    pthread_mutex_t d_mutex;
+    pthread_cond_t d_work;          // a job entry was queued
+    pthread_cond_t d_done;          // a helper finished with a job
+
+    deque<ParallelTasks *> d_jobs;
+    unsigned int d_num_threads;
+
+    static Pool *d_instance;
+
+    static void initialize_instance() { d_instance = new Pool; }
+
+    static void *worker(void *arg);
+
+    Pool() : d_num_threads(0) {
+        pthread_mutex_init(&d_mutex, 0);
+        pthread_cond_init(&d_work, 0);
+        pthread_cond_init(&d_done, 0);
+    }
+
+public:
+    static Pool *the_pool() {
+        pthread_once(&pool_instance_control, initialize_instance);
+        return d_instance;
+    }
+
+    void help(ParallelTasks *job, unsigned int num_helpers);
+    void finish(ParallelTasks *job);
+};
+
+ParallelTasks::Pool *ParallelTasks::Pool::d_instance = 0;
+
+void *ParallelTasks::Pool::worker(void *arg)
+{
+    Pool *pool = static_cast<Pool*>(arg);
+
+    pthread_mutex_lock(&pool->d_mutex);
+    while (true) {
+        while (pool->d_jobs.empty())
+            pthread_cond_wait(&pool->d_work, &pool->d_mutex);
+
+        ParallelTasks *job = pool->d_jobs.front();
+        pool->d_jobs.pop_front();
+        ++job->d_helpers;
+        pthread_mutex_unlock(&pool->d_mutex);
+
+        job->m_run_tasks();
+
+        pthread_mutex_lock(&pool->d_mutex);
+        --job->d_helpers;
+        pthread_cond_broadcast(&pool->d_done);
+    }
+
+    return 0;
+}
+
+// Queue 'num_helpers' entries for 'job', starting threads if there are
+// fewer than that. If a thread cannot be started, the job gets fewer helpers.
+void ParallelTasks::Pool::help(ParallelTasks *job, unsigned int num_helpers)
+{
+    pthread_mutex_lock(&d_mutex);
+
+    while (d_num_threads < num_helpers) {
+        pthread_t thread;
+        if (pthread_create(&thread, 0, worker, this) != 0) {
+            DBG(cerr << "ParallelTasks::Pool::help: could not start a thread" << endl);
+            break;
+        }
+        pthread_detach(thread);
+        ++d_num_threads;
+    }
+
+    for (unsigned int i = 0; i < num_helpers && i < d_num_threads; ++i)
+        d_jobs.push_back(job);
+
+    pthread_cond_broadcast(&d_work);
+    pthread_mutex_unlock(&d_mutex);
+}
+
+// Called once every task of 'job' has been claimed. Drop the entries no
+// thread took and wait for the helpers still running one of its tasks.
+void ParallelTasks::Pool::finish(ParallelTasks *job)
+{
+    pthread_mutex_lock(&d_mutex);
+
+    for (deque<ParallelTasks*>::iterator i = d_jobs.begin(); i != d_jobs.end();) {
+        if (*i == job)
+            i = d_jobs.erase(i);
+        else
+            ++i;
+    }
+
+    while (job->d_helpers > 0)
+        pthread_cond_wait(&d_done, &d_mutex);
+
+    pthread_mutex_unlock(&d_mutex);
+}
+
+// Copy an Error, keeping its type if it is one of the subclasses libdap throws
+static Error *copy_error(const Error &e)
+{
+    if (const InternalErr *ie = dynamic_cast<const InternalErr*>(&e))
+        return new InternalErr(*ie);
+    if (const D4ParseError *pe = dynamic_cast<const D4ParseError*>(&e))
+        return new D4ParseError(*pe);
+    if (const DDXParseFailed *pf = dynamic_cast<const DDXParseFailed*>(&e))
+        return new DDXParseFailed(*pf);
+
+    return new Error(e);
+}
+
+// Throw a copy of 'e' if it is a T
+template<class T>
+static void throw_as(const Error *e)
+{
+    if (const T *t = dynamic_cast<const T*>(e))
+        throw T(*t);
+}
+
+// Private. Run tasks until there are none left. Each task is claimed by
+// exactly one thread and its error, if any, is recorded in its own slot in
+// d_errors, so no lock is needed.
+void ParallelTasks::m_run_tasks()
+{
+    unsigned int i;
+    while ((i = __sync_fetch_and_add(&d_next_task, 1)) < d_num_tasks) {
+        try {
+            run_task(i);
+        }
+        catch (Error &e) {
+            d_errors[i].kind = task_error::dap_error;
+            d_errors[i].error = copy_error(e);
+        }
+        catch (std::exception &e) {
+            d_errors[i].kind = task_error::other_error;
+            d_errors[i].msg = e.what();
+        }
+        catch (...) {
+            d_errors[i].kind = task_error::other_error;
+            d_errors[i].msg = "Unknown exception.";
+        }
+    }
+}
+
+// Private. Delete the errors recorded by the last call to run()
+void ParallelTasks::m_clear_errors()
+{
+    for (vector<task_error>::iterator i = d_errors.begin(), e = d_errors.end(); i != e; ++i)
+        delete i->error;
+    d_errors.clear();
+}
+
+/**
+ * @brief Run tasks 0 to \e num_tasks - 1.
+ *
+ * The calling thread runs tasks too, so at most \e num_threads - 1 threads
+ * from the pool help. If the pool cannot start enough threads, or its
+ * threads are busy with other calls to run(), the tasks are run by the
+ * threads that are available.
+ *
+ * @param num_tasks The number of tasks
+ * @param num_threads Use at most this many threads; 0 and 1 run the tasks
+ * one after the other using the calling thread.
+ * @exception Error if a task throws.
+ */
+void ParallelTasks::run(unsigned int num_tasks, unsigned int num_threads)
+{
+    m_clear_errors();
+    d_num_tasks = num_tasks;
+    d_next_task = 0;
+    d_errors.resize(num_tasks);
+
+    if (num_threads > num_tasks)
+        num_threads = num_tasks;
+
+    if (num_threads > 1) {
+        Pool *pool = Pool::the_pool();
+        pool->help(this, num_threads - 1);
+        m_run_tasks();
+        pool->finish(this);
+    }
+    else {
+        m_run_tasks();
+    }
+
+    for (unsigned int i = 0; i < num_tasks; ++i) {
+        switch (d_errors[i].kind) {
+        case task_error::dap_error: {
+            const Error *e = d_errors[i].error;
+            throw_as<InternalErr>(e);
+            throw_as<D4ParseError>(e);
+            throw_as<DDXParseFailed>(e);
+            throw Error(*e);
+        }
+        case task_error::other_error:
+            throw InternalErr(__FILE__, __LINE__, d_errors[i].msg);
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Group values so that no two groups use the same variable.
+ *
+ * Variables are compared using the top-level variable that holds them, so
+ * two fields of one Structure are treated as the same variable. Values in
+ * different groups can be computed at the same time; those in a group must
+ * be computed one after the other.
+ *
+ * @param vars The variables used to compute each value
+ * @param groups Value-result parameter; the indexes of the values in each
+ * group. Groups are listed in the order of their first value and the values
+ * of a group are in order.
+ */
+void ParallelTasks::independent_groups(const vector<vector<BaseType *> > &vars, vector<vector<unsigned int> > &groups)
+{
+    // Union-find over the values; values that use the same top-level
+    // variable are merged.
+    vector<unsigned int> parent(vars.size());
+    for (unsigned int i = 0; i < vars.size(); ++i)
+        parent[i] = i;
+
+    map<BaseType*, unsigned int> first_use;
+    for (unsigned int i = 0; i < vars.size(); ++i) {
+        for (vector<BaseType*>::const_iterator v = vars[i].begin(), e = vars[i].end(); v != e; ++v) {
+            BaseType *top = *v;
+            while (top->get_parent() && top->get_parent()->type() != dods_group_c)
+                top = top->get_parent();
+
+            map<BaseType*, unsigned int>::iterator f = first_use.find(top);
+            if (f == first_use.end()) {
+                first_use[top] = i;
+                continue;
+            }
+
+            unsigned int a = f->second, b = i;
+            while (parent[a] != a) a = parent[a];
+            while (parent[b] != b) b = parent[b];
+            // Keep the smaller index as the root so groups stay ordered
+            if (a < b)
+                parent[b] = a;
+            else if (b < a)
+                parent[a] = b;
+        }
+    }
+
+    groups.clear();
+    vector<int> group_of(vars.size(), -1);
+    for (unsigned int i = 0; i < vars.size(); ++i) {
+        unsigned int root = i;
+        while (parent[root] != root) root = parent[root];
+
+        if (group_of[root] == -1) {
+            group_of[root] = groups.size();
+            groups.push_back(vector<unsigned int>());
+        }
+        groups[group_of[root]].push_back(i);
+    }
+}
+
+} // namespace libdap
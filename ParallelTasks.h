@@ -0,0 +1,96 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#ifndef _parallel_tasks_h
+#define _parallel_tasks_h 1
+
+#include <string>
+#include <vector>
+
+namespace libdap {
+
+class BaseType;
+class Error;
+
+/**
+ * @brief Run a set of independent tasks using a small number of threads.
+ *
+ * Specialize run_task() and call run(). Each task is run exactly once, but
+ * in no particular order and, when more than one thread is used, on any of
+ * the threads (including the caller's). run() returns once every task has
+ * finished. If any of the tasks throw, run() throws the exception thrown by
+ * the task with the smallest index once they have all finished. Error and
+ * the subclasses libdap throws (InternalErr, D4ParseError and
+ * DDXParseFailed) keep their type; other exceptions are rethrown as
+ * InternalErr.
+ *
+ * The threads come from a pool that is shared by all the instances of this
+ * class and grows to the largest number of threads run() has been asked to
+ * use. The threads are started the first time they are needed and are then
+ * reused, so run() can be called often without starting threads.
+ *
+ * Used to evaluate the server functions in a constraint expression in
+ * parallel.
+ */
+class ParallelTasks {
+private:
+    struct task_error {
+        enum { none, dap_error, other_error } kind;
+        Error *error;       // a copy of the Error the task threw
+        std::string msg;
+
+        task_error() : kind(none), error(0) { }
+    };
+
+    class Pool;     // defined in ParallelTasks.cc
+
+    unsigned int d_num_tasks;
+    unsigned int d_next_task;
+    unsigned int d_helpers;     // pool threads running tasks; locked by the pool
+
+    std::vector<task_error> d_errors;
+
+    void m_run_tasks();
+    void m_clear_errors();
+
+    ParallelTasks(const ParallelTasks &);
+    ParallelTasks &operator=(const ParallelTasks &);
+
+protected:
+    /// Run task \e i; called once for each task
+    virtual void run_task(unsigned int i) = 0;
+
+public:
+    ParallelTasks() : d_num_tasks(0), d_next_task(0), d_helpers(0) { }
+    virtual ~ParallelTasks() { m_clear_errors(); }
+
+    void run(unsigned int num_tasks, unsigned int num_threads);
+
+    static void independent_groups(const std::vector<std::vector<BaseType *> > &vars,
+        std::vector<std::vector<unsigned int> > &groups);
+};
+
+} // namespace libdap
+
+#endif // _parallel_tasks_h
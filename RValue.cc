@@ -179,5 +179,21 @@ rvalue::bvalue(DDS &dds)
     }
 }
 
+/** Append the variables (and constants) this rvalue uses, including those
+    passed to a function, to \e vars. The rvalue is not evaluated.
+
+    @param vars Value-result parameter */
+void
+rvalue::variables(vector<BaseType *> &vars) const
+{
+    if (d_value)
+        vars.push_back(d_value);
+
+    if (d_args) {
+        for (Args_citer i = d_args->begin(); i != d_args->end(); ++i)
+            (*i)->variables(vars);
+    }
+}
+
 } // namespace libdap
 
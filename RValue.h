@@ -62,6 +62,8 @@ public:
     std::string value_name();
 
     BaseType *bvalue(DDS &dds);
+
+    void variables(std::vector<BaseType *> &vars) const;
 };
 
 // This type def must come after the class definition above. It is used in
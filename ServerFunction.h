@@ -57,6 +57,8 @@ private:
 
     D4Function d_d4_function;
 
+    bool d_pure;
+
 public:
     ServerFunction();
     ServerFunction(std::string name, std::string version, std::string description, std::string usage,
@@ -88,6 +90,15 @@ public:
 	std::string getVersion(){ return version; }
 	void setVersion(const std::string &ver){ version = ver; }
 
+	/**
+	 * A function is pure when its result depends only on its arguments
+	 * and calling it has no side effects. A pure DAP4 function that is
+	 * called more than once with the same arguments in one expression is
+	 * evaluated once. Functions are not pure unless they say so.
+	 */
+	bool isPure() { return d_pure; }
+	void setPure(bool pure) { d_pure = pure; }
+
 	/**
 	 * If you are writing a function that can only operate on a particular kind of data, or one that relies on the presence
 	 * of particular metadata, then you might override this method in order to stop the server from
@@ -72,9 +72,116 @@ void ServerFunctionsList::delete_instance() {
 }
 
 /**
- * Private method insures that nobody can try to delete the singleton class.
+ * An open-addressing hash table that holds, for each function name, the
+ * first function of each kind (boolean, BaseType, projection and DAP4) in
+ * the list, and the names of all the functions in list order. It is never
+ * modified once built.
  */
+struct ServerFunctionsList::FunctionTable {
+    struct entry {
+        string name;
+        unsigned long hash;
+        bool_func bool_f;
+        btp_func btp_f;
+        proj_func proj_f;
+        D4Function d4_f;
+        bool d4_pure;   // d4_f was declared pure
+
+        entry() : name(""), hash(0), bool_f(0), btp_f(0), proj_f(0), d4_f(0), d4_pure(false) {}
+    };
+
+    vector<entry> d_entries;    // empty slots have an empty name
+    unsigned long d_mask;
+    vector<string> d_names;     // one per function, as getFunctionNames() returns them
+
+    static unsigned long hash(const string &name) {
+        // FNV-1a
+        unsigned long h = 2166136261UL;
+        for (string::const_iterator i = name.begin(), e = name.end(); i != e; ++i) {
+            h ^= static_cast<unsigned char>(*i);
+            h *= 16777619UL;
+        }
+        return h;
+    }
 
+    FunctionTable(const multimap<string, ServerFunction *> &list) : d_mask(0) {
+        // Keep the table at most half full
+        unsigned long size = 8;
+        while (size < 2 * list.size())
+            size *= 2;
+        d_entries.resize(size);
+        d_mask = size - 1;
+
+        // The multimap holds functions with the same name in the order they
+        // were added; use the first of each kind, as a search of the list would.
+        for (SFLCIter i = list.begin(), e = list.end(); i != e; ++i) {
+            entry &slot = d_entries[index(i->first)];
+            if (slot.name.empty()) {
+                slot.name = i->first;
+                slot.hash = hash(i->first);
+            }
+
+            ServerFunction *func = i->second;
+            d_names.push_back(func->getName());
+            if (!slot.bool_f) slot.bool_f = func->get_bool_func();
+            if (!slot.btp_f) slot.btp_f = func->get_btp_func();
+            if (!slot.proj_f) slot.proj_f = func->get_proj_func();
+            if (!slot.d4_f) {
+                slot.d4_f = func->get_d4_function();
+                slot.d4_pure = slot.d4_f && func->isPure();
+            }
+        }
+    }
+
+    // Return the index of the slot that holds 'name' or of the empty slot
+    // where it belongs
+    unsigned long index(const string &name) const {
+        unsigned long h = hash(name);
+        for (unsigned long i = h & d_mask;; i = (i + 1) & d_mask) {
+            const entry &slot = d_entries[i];
+            if (slot.name.empty() || (slot.hash == h && slot.name == name))
+                return i;
+        }
+    }
+
+    const entry *find(const string &name) const {
+        const entry &slot = d_entries[index(name)];
+        return slot.name.empty() ? 0 : &slot;
+    }
+};
+
+/**
+ * Counts a lookup in progress for as long as it is in scope. A table that
+ * add_function() replaced can only be in use while the count is not zero.
+ */
+class ServerFunctionsList::TableReader {
+private:
+    const ServerFunctionsList &d_list;
+    const FunctionTable *d_table;
+
+public:
+    TableReader(const ServerFunctionsList &list) : d_list(list), d_table(0) {
+        __sync_add_and_fetch(&d_list.d_readers, 1);
+        d_table = d_list.m_table();
+    }
+
+    ~TableReader() {
+        __sync_sub_and_fetch(&d_list.d_readers, 1);
+    }
+
+    const FunctionTable *operator->() const { return d_table; }
+};
+
+ServerFunctionsList::ServerFunctionsList() : d_table(0), d_readers(0)
+{
+    pthread_mutex_init(&d_mutex, 0);
+    d_table = new FunctionTable(d_func_list);
+}
+
+/**
+ * Private method insures that nobody can try to delete the singleton class.
+ * FunctionTable must be complete here so the tables can be deleted.
+ */
 ServerFunctionsList::~ServerFunctionsList() {
     SFLIter fit;
     for(fit=d_func_list.begin(); fit!=d_func_list.end() ; fit++){
@@ -83,6 +190,19 @@ ServerFunctionsList::~ServerFunctionsList() {
         delete func;
     }
     d_func_list.clear();
+
+    delete d_table;
+    for (vector<FunctionTable*>::iterator i = d_old_tables.begin(), e = d_old_tables.end(); i != e; ++i)
+        delete *i;
+
+    pthread_mutex_destroy(&d_mutex);
+}
+
+// Read the current table. The builtin is a full barrier, so the table's
+// contents are visible once its address is.
+const ServerFunctionsList::FunctionTable *ServerFunctionsList::m_table() const
+{
+    return __sync_fetch_and_add(const_cast<FunctionTable**>(&d_table), 0);
 }
 
 ServerFunctionsList * ServerFunctionsList::TheList() {
@@ -103,7 +223,28 @@ ServerFunctionsList * ServerFunctionsList::TheList() {
 void ServerFunctionsList::add_function(ServerFunction *func )
 {
     DBG(cerr << "ServerFunctionsList::add_function() - Adding ServerFunction " << func->getName() << endl);
+
+    pthread_mutex_lock(&d_mutex);
+
     d_func_list.insert(std::make_pair(func->getName(),func));
+
+    // Build a new lookup table and swap it in; readers holding the old one
+    // may keep using it, so it is kept until no lookup is in progress.
+    FunctionTable *table = new FunctionTable(d_func_list);
+    d_old_tables.push_back(d_table);
+    __sync_synchronize();   // the new table is complete before it is published
+    d_table = table;
+
+    // A lookup that starts after this reads the new table, so if none is in
+    // progress now, none can be using a replaced table. The builtin is a full
+    // barrier, so the new table is published before the count is read.
+    if (__sync_fetch_and_add(&d_readers, 0) == 0) {
+        for (vector<FunctionTable*>::iterator i = d_old_tables.begin(), e = d_old_tables.end(); i != e; ++i)
+            delete *i;
+        d_old_tables.clear();
+    }
+
+    pthread_mutex_unlock(&d_mutex);
 }
 
 /**
@@ -128,16 +269,11 @@ void ServerFunctionsList::add_function(ServerFunction *func )
  */
 bool ServerFunctionsList::find_function(const std::string &name, bool_func *f) const
 {
-    if (d_func_list.empty())
-        return false;
-
-    std::pair <SFLCIter, SFLCIter> ret;
-    ret = d_func_list.equal_range(name);
-    for (SFLCIter it = ret.first; it != ret.second; ++it) {
-        if (name == it->first && (*f = it->second->get_bool_func())){
-            DBG(cerr << "ServerFunctionsList::find_function() - Found boolean function " << it->second->getName() << endl);
-            return true;
-        }
+    TableReader table(*this);
+    const FunctionTable::entry *entry = table->find(name);
+    if (entry && (*f = entry->bool_f)) {
+        DBG(cerr << "ServerFunctionsList::find_function() - Found boolean function " << name << endl);
+        return true;
     }
 
     return false;
@@ -165,17 +301,11 @@ bool ServerFunctionsList::find_function(const std::string &name, bool_func *f) c
  */
 bool ServerFunctionsList::find_function(const string &name, btp_func *f) const
 {
-    if (d_func_list.empty())
-        return false;
-    DBG(cerr << "ServerFunctionsList::find_function() - Looking for ServerFunction '" << name << "'" << endl);
-
-    std::pair <SFLCIter, SFLCIter> ret;
-    ret = d_func_list.equal_range(name);
-    for (SFLCIter it = ret.first; it != ret.second; ++it) {
-        if (name == it->first && (*f = it->second->get_btp_func())){
-            DBG(cerr << "ServerFunctionsList::find_function() - Found basetype function " << it->second->getName() << endl);
-            return true;
-        }
+    TableReader table(*this);
+    const FunctionTable::entry *entry = table->find(name);
+    if (entry && (*f = entry->btp_f)) {
+        DBG(cerr << "ServerFunctionsList::find_function() - Found basetype function " << name << endl);
+        return true;
     }
 
     return false;
@@ -203,16 +333,11 @@ bool ServerFunctionsList::find_function(const string &name, btp_func *f) const
  */
 bool ServerFunctionsList::find_function(const string &name, proj_func *f) const
 {
-    if (d_func_list.empty())
-        return false;
-
-    std::pair <SFLCIter, SFLCIter> ret;
-    ret = d_func_list.equal_range(name);
-    for (SFLCIter it = ret.first; it != ret.second; ++it) {
-        if (name == it->first && (*f = it->second->get_proj_func())){
-            DBG(cerr << "ServerFunctionsList::find_function() - Found projection function " << it->second->getName() << endl);
-           return true;
-        }
+    TableReader table(*this);
+    const FunctionTable::entry *entry = table->find(name);
+    if (entry && (*f = entry->proj_f)) {
+        DBG(cerr << "ServerFunctionsList::find_function() - Found projection function " << name << endl);
+        return true;
     }
 
     return false;
@@ -227,21 +352,32 @@ bool ServerFunctionsList::find_function(const string &name, proj_func *f) const
  */
 bool ServerFunctionsList::find_function(const string &name, D4Function *f) const
 {
-    if (d_func_list.empty())
-        return false;
-
-    std::pair <SFLCIter, SFLCIter> ret;
-    ret = d_func_list.equal_range(name);
-    for (SFLCIter it = ret.first; it != ret.second; ++it) {
-        if (name == it->first && (*f = it->second->get_d4_function())) {
-            return true;
-        }
+    TableReader table(*this);
+    const FunctionTable::entry *entry = table->find(name);
+    if (entry && (*f = entry->d4_f)) {
+        return true;
     }
 
     return false;
 }
 
-/** @brief Returns an iterator pointing to the first key pair in the ServerFunctionList. */
+/**
+ * @brief Is the DAP4 function with this name pure?
+ *
+ * @param name The function's name
+ * @return True if find_function(name, D4Function*) finds a function and
+ * that function's ServerFunction was declared pure.
+ * @see ServerFunction::setPure()
+ */
+bool ServerFunctionsList::is_pure(const string &name) const
+{
+    TableReader table(*this);
+    const FunctionTable::entry *entry = table->find(name);
+    return entry && entry->d4_pure;
+}
+
+/** @brief Returns an iterator pointing to the first key pair in the ServerFunctionList.
+ * The list is not locked; see the class description. */
 ServerFunctionsList::SFLIter ServerFunctionsList::begin()
 {
     return d_func_list.begin();
@@ -264,12 +400,17 @@ ServerFunction *ServerFunctionsList::getFunction(SFLIter it)
     return (*it).second;
 }
 
+/**
+ * @brief Append the names of the functions in the list to \e names
+ *
+ * This reads the current lookup table, not the list, so it is safe to call
+ * while another thread adds a function.
+ *
+ * @param names Value-result parameter; one name per function, in list order
+ */
 void ServerFunctionsList::getFunctionNames(vector<string> *names){
-	SFLIter fit;
-    for(fit = d_func_list.begin(); fit != d_func_list.end(); fit++) {
-        ServerFunction *func = fit->second;
-        names->push_back(func->getName());
-    }
+    TableReader table(*this);
+    names->insert(names->end(), table->d_names.begin(), table->d_names.end());
 }
 
 } // namespace libdap
@@ -30,8 +30,11 @@
 #ifndef I_ServerFunctionsList_h
 #define I_ServerFunctionsList_h 1
 
+#include <pthread.h>
+
 #include <map>
 #include <string>
+#include <vector>
 
 #include <expr.h>
 #include <D4Function.h>
@@ -43,11 +46,38 @@ namespace libdap {
 class ServerFunctionsListUnitTest;
 class ConstraintEvaluator;
 
+/**
+ * The list of server functions. Functions are added when modules are
+ * loaded and then looked up (by name) for every functional CE.
+ *
+ * The find_function() methods do not lock; they search an immutable hash
+ * table built from the list. Each call to add_function() builds a new
+ * table and publishes it atomically, so lookups may run in many threads
+ * while a function is added. A replaced table is deleted by a later call to
+ * add_function() made when no lookup is in progress.
+ *
+ * getFunctionNames() reads the same tables and is also safe to call while
+ * functions are added. The iterators returned by begin() and end() refer to
+ * the list itself and are not locked; use them only when no thread can call
+ * add_function().
+ */
 class ServerFunctionsList {
 private:
     static ServerFunctionsList * d_instance;
     std::multimap<std::string, ServerFunction *> d_func_list;
 
+    struct FunctionTable;   // defined in ServerFunctionsList.cc
+
+    class TableReader;      // defined in ServerFunctionsList.cc
+
+    FunctionTable *d_table;                     // read without locking
+    std::vector<FunctionTable *> d_old_tables;  // replaced by add_function()
+    mutable unsigned long d_readers;            // lookups in progress
+
+    pthread_mutex_t d_mutex;    // serializes add_function()
+
+    const FunctionTable *m_table() const;
+
     static void initialize_instance();
     static void delete_instance();
 
@@ -56,7 +86,7 @@ private:
     friend class ServerFunctionsListUnitTest;
 
 protected:
-    ServerFunctionsList() {}
+    ServerFunctionsList();
 
 public:
     // Added typedefs to reduce clutter jhrg 3/12/14
@@ -72,6 +102,8 @@ public:
     virtual bool find_function(const std::string &name, proj_func *f) const;
     virtual bool find_function(const std::string &name, D4Function *f) const;
 
+    bool is_pure(const std::string &name) const;
+
     SFLIter begin();
     SFLIter end();
     ServerFunction *getFunction(SFLIter it);
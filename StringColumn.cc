@@ -0,0 +1,160 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include "StringColumn.h"
+
+using namespace std;
+
+namespace libdap {
+
+/**
+ * Append a string to the column.
+ *
+ * @param s The characters of the string; need not be null terminated
+ * @param len The number of characters in \e s
+ */
+void StringColumn::push_back(const char *s, uint64_t len)
+{
+    d_starts.push_back(d_chars.size());
+    d_lengths.push_back(len);
+    d_chars.insert(d_chars.end(), s, s + len);
+}
+
+/**
+ * Replace the value of string i. If \e i is past the end of the column,
+ * the column is first extended with empty strings.
+ *
+ * The other strings are not moved. The new value is written in place of
+ * the old one when it fits, or when string i is the last in the buffer;
+ * otherwise it is appended to the buffer.
+ *
+ * @param i The index of the string
+ * @param s The new value
+ */
+void StringColumn::set(unsigned int i, const string &s)
+{
+    if (i >= size()) {
+        resize(i);
+        push_back(s);
+        return;
+    }
+
+    uint64_t old_len = d_lengths[i];
+    uint64_t new_len = s.length();
+
+    if (new_len <= old_len) {
+        d_unused += old_len - new_len;
+    }
+    else if (d_starts[i] + old_len == d_chars.size()) {
+        d_chars.resize(d_starts[i] + new_len);
+    }
+    else {
+        d_unused += old_len;
+        d_starts[i] = d_chars.size();
+        d_chars.resize(d_chars.size() + new_len);
+    }
+
+    if (new_len > 0)
+        s.copy(&d_chars[0] + d_starts[i], new_len);
+    d_lengths[i] = new_len;
+
+    if (d_unused > d_chars.size() / 2)
+        m_compact();
+}
+
+/**
+ * Move the strings so that they are stored end to end, in order, and free
+ * the space no string uses.
+ */
+void StringColumn::m_compact()
+{
+    vector<char> chars;
+    chars.reserve(d_chars.size() - d_unused);
+    for (unsigned int i = 0, e = size(); i < e; ++i) {
+        const char *c = data(i);
+        uint64_t start = chars.size();
+        chars.insert(chars.end(), c, c + d_lengths[i]);
+        d_starts[i] = start;
+    }
+
+    d_chars.swap(chars);
+    d_unused = 0;
+}
+
+/**
+ * Allocate space for \e num strings and \e bytes characters.
+ *
+ * @param num The number of strings
+ * @param bytes The total number of characters; zero by default
+ */
+void StringColumn::reserve(unsigned int num, uint64_t bytes)
+{
+    d_starts.reserve(num);
+    d_lengths.reserve(num);
+    if (bytes > 0)
+        d_chars.reserve(bytes);
+}
+
+/**
+ * Change the number of strings in the column. New strings are empty;
+ * strings past the new end of the column are removed.
+ *
+ * @param num The new number of strings
+ */
+void StringColumn::resize(unsigned int num)
+{
+    if (num < size()) {
+        for (unsigned int i = num, e = size(); i < e; ++i)
+            d_unused += d_lengths[i];
+        d_starts.resize(num);
+        d_lengths.resize(num);
+        m_compact();
+    }
+    else {
+        d_starts.resize(num, d_chars.size());
+        d_lengths.resize(num, 0);
+    }
+}
+
+/// Remove all of the strings; the memory used by the column is kept for reuse
+void StringColumn::clear()
+{
+    d_chars.clear();
+    d_starts.clear();
+    d_lengths.clear();
+    d_unused = 0;
+}
+
+/// Remove all of the strings and free the memory used by the column
+void StringColumn::release()
+{
+    vector<char>().swap(d_chars);
+    vector<uint64_t>().swap(d_starts);
+    vector<uint64_t>().swap(d_lengths);
+    d_unused = 0;
+}
+
+} // namespace libdap
@@ -0,0 +1,103 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#ifndef _string_column_h
+#define _string_column_h 1
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace libdap {
+
+/**
+ * @brief Compact storage for the values of an array of strings.
+ *
+ * The characters of every string are stored end to end in one buffer and
+ * two more buffers hold the start and length of each string. A column of N
+ * strings uses three allocations instead of the N (one per std::string) a
+ * vector<string> needs once the strings are longer than the library's
+ * small-string limit.
+ *
+ * Strings are normally added in order using push_back(). Replacing a
+ * string using set() does not move the other strings: a value that fits in
+ * the old one's place is written there and a longer value is appended to
+ * the buffer. The space this leaves unused is reclaimed once it is more
+ * than half of the buffer, so set() takes amortized time proportional to
+ * the length of the new value.
+ */
+class StringColumn {
+private:
+    std::vector<char> d_chars;
+
+    // String i is the d_lengths[i] characters at d_starts[i] in d_chars.
+    std::vector<uint64_t> d_starts;
+    std::vector<uint64_t> d_lengths;
+
+    // The number of characters in d_chars that no string uses
+    uint64_t d_unused;
+
+    void m_compact();
+
+public:
+    StringColumn() : d_chars(), d_starts(), d_lengths(), d_unused(0) { }
+
+    /// @return The number of strings in the column
+    unsigned int size() const { return d_starts.size(); }
+
+    bool empty() const { return d_starts.empty(); }
+
+    /// @return The number of characters used by all of the strings
+    uint64_t bytes() const { return d_chars.size() - d_unused; }
+
+    /// @return A pointer to the characters of string i; not null terminated
+    const char *data(unsigned int i) const {
+        return d_chars.empty() ? "" : &d_chars[0] + d_starts[i];
+    }
+
+    /// @return The length of string i
+    uint64_t length(unsigned int i) const { return d_lengths[i]; }
+
+    /// Copy string i into \e s, reusing the storage already held by \e s
+    void get(unsigned int i, std::string &s) const { s.assign(data(i), length(i)); }
+
+    /// @return A copy of string i
+    std::string get(unsigned int i) const { return std::string(data(i), length(i)); }
+
+    void push_back(const char *s, uint64_t len);
+    void push_back(const std::string &s) { push_back(s.data(), s.length()); }
+
+    void set(unsigned int i, const std::string &s);
+
+    void reserve(unsigned int num, uint64_t bytes = 0);
+    void resize(unsigned int num);
+
+    void clear();
+    void release();
+};
+
+} // namespace libdap
+
+#endif // _string_column_h
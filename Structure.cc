@@ -392,6 +392,7 @@ Structure::del_var(const string &n)
         if ((*i)->name() == n) {
             BaseType *bt = *i ;
             d_vars.erase(i) ;
+            names_changed();
             delete bt ; bt = 0;
             return;
         }
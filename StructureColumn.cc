@@ -0,0 +1,331 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <cstring>
+
+#include "Byte.h"
+#include "Int8.h"
+#include "Int16.h"
+#include "UInt16.h"
+#include "Int32.h"
+#include "UInt32.h"
+#include "Int64.h"
+#include "UInt64.h"
+#include "Float32.h"
+#include "Float64.h"
+#include "Str.h"
+#include "Constructor.h"
+
+#include "StructureColumn.h"
+#include "InternalErr.h"
+
+using namespace std;
+
+namespace libdap {
+
+// The number of bytes used to store a scalar of type t or zero if values of
+// type t are not stored in the record.
+static unsigned int
+field_width(Type t)
+{
+    switch (t) {
+    case dods_byte_c:
+    case dods_char_c:
+    case dods_int8_c:
+    case dods_uint8_c:
+        return 1;
+
+    case dods_int16_c:
+    case dods_uint16_c:
+        return 2;
+
+    case dods_int32_c:
+    case dods_uint32_c:
+    case dods_float32_c:
+        return 4;
+
+    case dods_int64_c:
+    case dods_uint64_c:
+    case dods_float64_c:
+        return 8;
+
+    default:
+        return 0;
+    }
+}
+
+// Copy the value of the scalar variable bt to/from the record storage at p
+template <class T, class V>
+static void
+load_value(BaseType *bt, const char *p)
+{
+    V v;
+    memcpy(&v, p, sizeof(V));
+    static_cast<T*>(bt)->set_value(v);
+}
+
+template <class T, class V>
+static void
+store_value(BaseType *bt, char *p)
+{
+    V v = static_cast<T*>(bt)->value();
+    memcpy(p, &v, sizeof(V));
+}
+
+/**
+ * Can the values of an array of \e proto be held by a StructureColumn?
+ * This is true when \e proto is a Structure and all of its variables are
+ * numbers, strings or Structures that themselves can be held.
+ *
+ * @param proto The array's element prototype
+ * @return True if the values can be held, false otherwise
+ */
+bool
+StructureColumn::is_supported(BaseType *proto)
+{
+    if (!proto || proto->type() != dods_structure_c)
+        return false;
+
+    Constructor *c = dynamic_cast<Constructor*>(proto);
+    if (!c)
+        return false;
+
+    for (Constructor::Vars_iter i = c->var_begin(), e = c->var_end(); i != e; ++i) {
+        Type t = (*i)->type();
+        if (t == dods_str_c || t == dods_url_c || field_width(t) > 0)
+            continue;
+        if (!is_supported(*i))
+            return false;
+    }
+
+    return true;
+}
+
+void
+StructureColumn::m_add_fields(Constructor *c)
+{
+    for (Constructor::Vars_iter i = c->var_begin(), e = c->var_end(); i != e; ++i) {
+        Type t = (*i)->type();
+        if (t == dods_structure_c) {
+            m_add_fields(static_cast<Constructor*>(*i));
+        }
+        else if (t == dods_str_c || t == dods_url_c) {
+            d_fields.push_back(Field(t, d_num_strings++));
+        }
+        else {
+            d_fields.push_back(Field(t, d_record_size));
+            d_record_size += field_width(t);
+        }
+    }
+}
+
+/**
+ * Set the layout of the column using the element prototype. This removes
+ * any values already in the column.
+ *
+ * @param proto The element prototype; must be supported
+ * @exception InternalErr if the values of \e proto cannot be held
+ * @see is_supported()
+ */
+void
+StructureColumn::set_layout(BaseType *proto)
+{
+    if (!is_supported(proto))
+        throw InternalErr(__FILE__, __LINE__, "StructureColumn: The values of '" + proto->name() + "' cannot be stored in a column.");
+
+    clear();
+
+    d_fields.clear();
+    d_record_size = 0;
+    d_num_strings = 0;
+    m_add_fields(static_cast<Constructor*>(proto));
+}
+
+void
+StructureColumn::m_get(unsigned int i, Constructor *c, unsigned int &field) const
+{
+    const char *record = d_record_size > 0 ? &d_records[0] + i * d_record_size : 0;
+    string value;
+
+    for (Constructor::Vars_iter v = c->var_begin(), e = c->var_end(); v != e; ++v) {
+        if ((*v)->type() == dods_structure_c) {
+            m_get(i, static_cast<Constructor*>(*v), field);
+            continue;
+        }
+
+        if (field >= d_fields.size() || d_fields[field].type != (*v)->type())
+            throw InternalErr(__FILE__, __LINE__, "StructureColumn: The Structure does not match the column layout.");
+
+        const Field &f = d_fields[field++];
+        switch (f.type) {
+        case dods_byte_c:
+        case dods_char_c:
+        case dods_uint8_c: load_value<Byte, dods_byte>(*v, record + f.offset); break;
+        case dods_int8_c: load_value<Int8, dods_int8>(*v, record + f.offset); break;
+        case dods_int16_c: load_value<Int16, dods_int16>(*v, record + f.offset); break;
+        case dods_uint16_c: load_value<UInt16, dods_uint16>(*v, record + f.offset); break;
+        case dods_int32_c: load_value<Int32, dods_int32>(*v, record + f.offset); break;
+        case dods_uint32_c: load_value<UInt32, dods_uint32>(*v, record + f.offset); break;
+        case dods_int64_c: load_value<Int64, dods_int64>(*v, record + f.offset); break;
+        case dods_uint64_c: load_value<UInt64, dods_uint64>(*v, record + f.offset); break;
+        case dods_float32_c: load_value<Float32, dods_float32>(*v, record + f.offset); break;
+        case dods_float64_c: load_value<Float64, dods_float64>(*v, record + f.offset); break;
+
+        case dods_str_c:
+        case dods_url_c:
+            d_strings.get(i * d_num_strings + f.offset, value);
+            static_cast<Str*>(*v)->set_value(value);
+            break;
+
+        default:
+            throw InternalErr(__FILE__, __LINE__, "StructureColumn: Unexpected type.");
+        }
+    }
+}
+
+/**
+ * Copy the values of element \e i into the variables of \e proto.
+ *
+ * @param i The element
+ * @param proto Load the values into this Structure; marked as read
+ */
+void
+StructureColumn::get(unsigned int i, BaseType *proto) const
+{
+    if (i >= d_size)
+        throw InternalErr(__FILE__, __LINE__, "StructureColumn: Index out of range.");
+
+    unsigned int field = 0;
+    m_get(i, static_cast<Constructor*>(proto), field);
+    if (field != d_fields.size())
+        throw InternalErr(__FILE__, __LINE__, "StructureColumn: The Structure does not match the column layout.");
+
+    proto->set_read_p(true);
+}
+
+void
+StructureColumn::m_set(unsigned int i, Constructor *c, unsigned int &field)
+{
+    char *record = d_record_size > 0 ? &d_records[0] + i * d_record_size : 0;
+
+    for (Constructor::Vars_iter v = c->var_begin(), e = c->var_end(); v != e; ++v) {
+        if ((*v)->type() == dods_structure_c) {
+            m_set(i, static_cast<Constructor*>(*v), field);
+            continue;
+        }
+
+        if (field >= d_fields.size() || d_fields[field].type != (*v)->type())
+            throw InternalErr(__FILE__, __LINE__, "StructureColumn: The Structure does not match the column layout.");
+
+        const Field &f = d_fields[field++];
+        switch (f.type) {
+        case dods_byte_c:
+        case dods_char_c:
+        case dods_uint8_c: store_value<Byte, dods_byte>(*v, record + f.offset); break;
+        case dods_int8_c: store_value<Int8, dods_int8>(*v, record + f.offset); break;
+        case dods_int16_c: store_value<Int16, dods_int16>(*v, record + f.offset); break;
+        case dods_uint16_c: store_value<UInt16, dods_uint16>(*v, record + f.offset); break;
+        case dods_int32_c: store_value<Int32, dods_int32>(*v, record + f.offset); break;
+        case dods_uint32_c: store_value<UInt32, dods_uint32>(*v, record + f.offset); break;
+        case dods_int64_c: store_value<Int64, dods_int64>(*v, record + f.offset); break;
+        case dods_uint64_c: store_value<UInt64, dods_uint64>(*v, record + f.offset); break;
+        case dods_float32_c: store_value<Float32, dods_float32>(*v, record + f.offset); break;
+        case dods_float64_c: store_value<Float64, dods_float64>(*v, record + f.offset); break;
+
+        case dods_str_c:
+        case dods_url_c: {
+            unsigned int s = i * d_num_strings + f.offset;
+            // Appending in order avoids moving the strings that follow
+            if (s == d_strings.size())
+                d_strings.push_back(static_cast<Str*>(*v)->value());
+            else
+                d_strings.set(s, static_cast<Str*>(*v)->value());
+            break;
+        }
+
+        default:
+            throw InternalErr(__FILE__, __LINE__, "StructureColumn: Unexpected type.");
+        }
+    }
+}
+
+/**
+ * Copy the values of the variables in \e proto into element \e i. If \e i
+ * is past the end of the column, the column is first extended; the new
+ * elements hold zeros and empty strings.
+ *
+ * @param i The element
+ * @param proto Copy the values of this Structure
+ */
+void
+StructureColumn::set(unsigned int i, BaseType *proto)
+{
+    if (i >= d_size) {
+        d_records.resize((i + 1) * d_record_size);
+        d_strings.resize(i * d_num_strings);
+        d_size = i + 1;
+    }
+
+    unsigned int field = 0;
+    m_set(i, static_cast<Constructor*>(proto), field);
+    if (field != d_fields.size())
+        throw InternalErr(__FILE__, __LINE__, "StructureColumn: The Structure does not match the column layout.");
+}
+
+/// Append the values of the variables in \e proto to the column
+void
+StructureColumn::push_back(BaseType *proto)
+{
+    set(d_size, proto);
+}
+
+/// Allocate space for the numbers of \e num elements
+void
+StructureColumn::reserve(unsigned int num)
+{
+    d_records.reserve(num * d_record_size);
+    d_strings.reserve(num * d_num_strings);
+}
+
+/// Remove all of the values; the layout and memory are kept for reuse
+void
+StructureColumn::clear()
+{
+    d_size = 0;
+    d_records.clear();
+    d_strings.clear();
+}
+
+/// Remove all of the values and free the memory used by the column
+void
+StructureColumn::release()
+{
+    d_size = 0;
+    vector<char>().swap(d_records);
+    d_strings.release();
+}
+
+} // namespace libdap
@@ -0,0 +1,101 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#ifndef _structure_column_h
+#define _structure_column_h 1
+
+#include <vector>
+
+#include "Type.h"
+#include "StringColumn.h"
+
+namespace libdap {
+
+class BaseType;
+class Constructor;
+
+/**
+ * @brief Compact storage for the values of an array of Structures.
+ *
+ * An Array of Structure normally holds one copy of the element prototype
+ * for each element, each a complete tree of variables with names and
+ * attributes. When the Structure holds only scalar values (numbers,
+ * strings and Structures made of those), this class can hold the values of
+ * all of the elements instead: the numbers of each element are stored in
+ * a fixed-size record and the strings of all the elements are stored in a
+ * StringColumn. The one prototype is used to describe every element; the
+ * values of element i are copied into it using get() and copied out of it
+ * using set() or push_back().
+ *
+ * The leaf variables of the Structure are visited depth-first, so get()
+ * and set() must be given a Structure with the same layout as the one
+ * passed to set_layout().
+ */
+class StructureColumn {
+private:
+    struct Field {
+        Type type;
+        // byte offset in the record for numbers; string number for strings
+        unsigned int offset;
+
+        Field(Type t, unsigned int o) : type(t), offset(o) { }
+    };
+
+    std::vector<Field> d_fields;
+    unsigned int d_record_size; // the number of bytes of numbers per element
+    unsigned int d_num_strings; // the number of strings per element
+
+    unsigned int d_size;        // the number of elements
+    std::vector<char> d_records;
+    StringColumn d_strings;     // d_num_strings values for each element
+
+    void m_add_fields(Constructor *c);
+    void m_get(unsigned int i, Constructor *c, unsigned int &field) const;
+    void m_set(unsigned int i, Constructor *c, unsigned int &field);
+
+public:
+    StructureColumn() : d_fields(), d_record_size(0), d_num_strings(0), d_size(0), d_records(), d_strings() { }
+
+    static bool is_supported(BaseType *proto);
+
+    void set_layout(BaseType *proto);
+
+    /// @return The number of elements in the column
+    unsigned int size() const { return d_size; }
+
+    bool empty() const { return d_size == 0; }
+
+    void get(unsigned int i, BaseType *proto) const;
+    void set(unsigned int i, BaseType *proto);
+    void push_back(BaseType *proto);
+
+    void reserve(unsigned int num);
+
+    void clear();
+    void release();
+};
+
+} // namespace libdap
+
+#endif // _structure_column_h
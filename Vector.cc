@@ -107,8 +107,13 @@ void Vector::m_duplicate(const Vector & v)
         }
     }
 
+    // Values of Structures held in a column are copied using the column
+    d_struct_column = v.d_struct_column;
+
     // copy the strings. This copies the values.
+    d_str_column = v.d_str_column;
     d_str = v.d_str;
+    d_str_unpacked = v.d_str_unpacked;
 
     // copy numeric values if there are any.
     d_buf = 0; // init to null
@@ -116,6 +121,7 @@ void Vector::m_duplicate(const Vector & v)
         val2buf(v.d_buf); // store v's value in this's _BUF.
 
     d_capacity = v.d_capacity;
+    d_chunk_size = v.d_chunk_size;
 }
 
 /**
@@ -230,6 +236,114 @@ void Vector::m_set_cardinal_values_internal(const CardType* fromArray, int numEl
     set_read_p(true);
 }
 
+/** @return The number of strings held by a Vector of Str or Url */
+unsigned int Vector::m_str_size() const
+{
+    return d_str_unpacked ? d_str.size() : d_str_column.size();
+}
+
+/** Copy the ith string held by a Vector of Str or Url to \e s */
+void Vector::m_str_value(unsigned int i, string &s) const
+{
+    if (d_str_unpacked)
+        s = d_str[i];
+    else
+        d_str_column.get(i, s);
+}
+
+/** If get_str() was used to access the strings, move them back to the
+ packed storage. Call this before modifying or making bulk use of the
+ values of a Str or Url Vector. */
+void Vector::m_pack_str()
+{
+    if (!d_str_unpacked)
+        return;
+
+    d_str_column.clear();
+    for (vector<string>::iterator i = d_str.begin(), e = d_str.end(); i != e; ++i)
+        d_str_column.push_back(*i);
+
+    vector<string>().swap(d_str);
+    d_str_unpacked = false;
+}
+
+/** Remove all strings, keeping the packed storage for reuse */
+void Vector::m_clear_str()
+{
+    if (d_str_unpacked) {
+        vector<string>().swap(d_str);
+        d_str_unpacked = false;
+    }
+
+    d_str_column.clear();
+}
+
+/** Can the values of this Vector be held in d_struct_column? True for
+ arrays of Structures that contain only scalars and Structures of scalars.
+ @see StructureColumn::is_supported() */
+bool Vector::m_use_struct_column() const
+{
+    return d_proto && d_proto->type() == dods_structure_c && StructureColumn::is_supported(d_proto);
+}
+
+/** Copy the values of \e val into element \e i of d_struct_column instead
+ of storing a copy of \e val. This is done only when \e val holds values
+ and no element of this Vector is held as an object.
+
+ @return True if the value was stored, false if the caller must store a
+ copy of \e val in d_compound_buf. */
+bool Vector::m_set_struct_column_value(unsigned int i, BaseType *val)
+{
+    if (i >= static_cast<unsigned int>(d_length) || !val || !val->read_p() || val->type() != dods_structure_c)
+        return false;
+
+    if (d_struct_column.empty()) {
+        if (!m_use_struct_column() || !StructureColumn::is_supported(val))
+            return false;
+
+        for (vector<BaseType*>::iterator b = d_compound_buf.begin(), e = d_compound_buf.end(); b != e; ++b)
+            if (*b)
+                return false;
+
+        d_struct_column.set_layout(d_proto);
+    }
+
+    d_struct_column.set(i, val);
+    return true;
+}
+
+/** Delete the objects held in d_compound_buf and empty it */
+void Vector::m_delete_compound_buf()
+{
+    for (unsigned int i = 0; i < d_compound_buf.size(); ++i) {
+        delete d_compound_buf[i];
+        d_compound_buf[i] = 0;
+    }
+
+    d_compound_buf.resize(0);
+}
+
+/** Make an object for each of the values held in d_struct_column and store
+ them in d_compound_buf. Called before code that needs the elements of an
+ array of Structures as individual objects. */
+void Vector::m_expand_struct_column()
+{
+    if (d_struct_column.empty())
+        return;
+
+    unsigned int num = d_struct_column.size();
+    if (d_compound_buf.size() < num)
+        vec_resize(num);
+
+    for (unsigned int i = 0; i < num; ++i) {
+        delete d_compound_buf[i];
+        d_compound_buf[i] = d_proto->ptr_duplicate();
+        d_struct_column.get(i, d_compound_buf[i]);
+    }
+
+    d_struct_column.release();
+}
+
 /** The Vector constructor requires the name of the variable to be
  created, and a pointer to an object of the type the Vector is to
  hold.  The name may be omitted, which will create a nameless
@@ -246,7 +360,7 @@ void Vector::m_set_cardinal_values_internal(const CardType* fromArray, int numEl
  @see Type
  @brief The Vector constructor.  */
 Vector::Vector(const string & n, BaseType * v, const Type & t, bool is_dap4 /* default:false */) :
-    BaseType(n, t, is_dap4), d_length(-1), d_proto(0), d_buf(0), d_compound_buf(0), d_capacity(0)
+    BaseType(n, t, is_dap4), d_length(-1), d_proto(0), d_buf(0), d_str_unpacked(false), d_compound_buf(0), d_capacity(0), d_chunk_size(0)
 {
     if (v)
         add_var(v);
@@ -275,7 +389,7 @@ Vector::Vector(const string & n, BaseType * v, const Type & t, bool is_dap4 /* d
  @see Type
  @brief The Vector constructor.  */
 Vector::Vector(const string & n, const string &d, BaseType * v, const Type & t, bool is_dap4 /* default:false */) :
-    BaseType(n, d, t, is_dap4), d_length(-1), d_proto(0), d_buf(0), d_compound_buf(0), d_capacity(0)
+    BaseType(n, d, t, is_dap4), d_length(-1), d_proto(0), d_buf(0), d_str_unpacked(false), d_compound_buf(0), d_capacity(0), d_chunk_size(0)
 {
     if (v)
         add_var(v);
@@ -486,6 +600,14 @@ BaseType *Vector::var(const string & n, btp_stack & s)
  the value of the indicated element. The BaseType pointer is locally
  maintained and should not be deleted or referenced. Extract the value
  right after the method returns.
+
+ @note For arrays of numbers and strings, every call returns the same
+ object (the template variable) loaded with the ith value. Changes made
+ through the returned pointer are not stored in the array (use set_vec()
+ for that) and pointers returned for different elements are the same
+ pointer. For arrays of Structures, each element is a distinct object held
+ by the array; when the values are held in a column, the first call makes
+ those objects (see get_compound_buf()).
  @see BaseType::var */
 BaseType *Vector::var(unsigned int i)
 {
@@ -511,13 +633,21 @@ BaseType *Vector::var(unsigned int i)
             return d_proto;
 
         case dods_str_c:
-        case dods_url_c:
-            d_proto->val2buf(&d_str[i]);
+        case dods_url_c: {
+            string value;
+            m_str_value(i, value);
+            d_proto->val2buf(&value);
             return d_proto;
+        }
+
+        case dods_structure_c:
+            // Callers may keep and change several elements at once, so
+            // elements held in a column are made into objects first
+            m_expand_struct_column();
+            return d_compound_buf[i];
 
         case dods_opaque_c:
         case dods_array_c:
-        case dods_structure_c:
         case dods_sequence_c:
         case dods_grid_c:
             return d_compound_buf[i];
@@ -541,6 +671,15 @@ unsigned int Vector::width(bool constrained) const
     return length() * d_proto->width(constrained);
 }
 
+/** @brief Returns the width of the data, in bytes, as a 64-bit value.
+    @see BaseType::width_ll() */
+int64_t Vector::width_ll(bool constrained) const
+{
+	assert(d_proto);
+
+    return (int64_t) length() * d_proto->width_ll(constrained);
+}
+
 /** Returns the number of elements in the vector. Note that some
  child classes of Vector use the length of -1 as a flag value.
 
@@ -554,9 +693,118 @@ int Vector::length() const
  any new space. */
 void Vector::set_length(int l)
 {
+    if (d_length != l)
+        sizes_changed();
     d_length = l;
 }
 
+/** @brief Read part of the data for this Vector.
+
+ Handlers that can produce the values of a large array a block at a time
+ should specialize this method and set the variable's chunk size using
+ set_chunk_size(). When the chunk size is not zero, serialize() and
+ intern_data() call this method instead of read() for Vectors of the
+ cardinal types, asking for at most get_chunk_size() elements per call.
+ Each block is written to the Marshaller as soon as it has been read, so
+ the memory used to serialize an array is bounded by the chunk size and not
+ by the size of the array.
+
+ An implementation must write \e count values, using the local machine's
+ representation, to the front of the buffer returned by get_buf(). That
+ buffer is allocated by the caller and holds at least get_chunk_size()
+ elements. Elements are numbered in row-major order of the constrained
+ Vector; for a constrained Array, \e start == 0 is the first element
+ selected by the constraint.
+
+ @note Vectors of Str, Url and the constructor types are always read
+ using read().
+
+ @param start The index of the first element to read.
+ @param count The number of elements to read.
+ @exception InternalErr Thrown by this default implementation. */
+void Vector::read_chunk(unsigned int /*start*/, unsigned int /*count*/)
+{
+    throw InternalErr(__FILE__, __LINE__, "Unimplemented Vector::read_chunk() method called for the variable named: " + name());
+}
+
+/** @return True if this Vector's values should be read using read_chunk() */
+bool Vector::m_use_chunked_read()
+{
+    return d_chunk_size > 0 && !read_p() && m_is_cardinal_type();
+}
+
+/**
+ * Read the values of this Vector using read_chunk() and send each block
+ * using the Marshaller's put_vector_start(), put_vector_part() and
+ * put_vector_end() methods. Only one block is held in memory at a time and
+ * it is released before this method returns; the read_p property is not set.
+ *
+ * @param m Write the values using this Marshaller
+ */
+void Vector::m_serialize_chunks(Marshaller &m)
+{
+    unsigned int num = length();
+    unsigned int width = d_proto->width();
+
+    // read_chunk() writes its values to d_buf
+    m_create_cardinal_data_buffer_for_type(std::min(num, d_chunk_size));
+
+    try {
+        m.put_vector_start(num);
+
+        for (unsigned int start = 0; start < num; start += d_chunk_size) {
+            unsigned int count = std::min(d_chunk_size, num - start);
+            read_chunk(start, count);
+            m.put_vector_part(d_buf, count, width, d_proto->type());
+        }
+
+        m.put_vector_end();
+    }
+    catch (...) {
+        m_delete_cardinal_data_buffer();
+        throw;
+    }
+
+    m_delete_cardinal_data_buffer();
+}
+
+/**
+ * Read all of the values of this Vector using read_chunk() so that they
+ * can be accessed as if read() had been called. Used by intern_data().
+ */
+void Vector::m_intern_chunks()
+{
+    unsigned int num = length();
+    unsigned int width = d_proto->width();
+
+    if (length() <= 0) {
+        set_read_p(true);
+        return;
+    }
+
+    m_create_cardinal_data_buffer_for_type(std::min(num, d_chunk_size));
+    char *values = new char[num * width];
+
+    try {
+        for (unsigned int start = 0; start < num; start += d_chunk_size) {
+            unsigned int count = std::min(d_chunk_size, num - start);
+            read_chunk(start, count);
+            memcpy(values + start * width, d_buf, count * width);
+        }
+    }
+    catch (...) {
+        delete[] values;
+        m_delete_cardinal_data_buffer();
+        throw;
+    }
+
+    m_delete_cardinal_data_buffer();
+    d_buf = values;
+    d_capacity = num;
+
+    set_read_p(true);
+}
+
 /** Resizes a Vector.  If the input length is greater than the
  current length of the Vector, new memory is allocated (the
  Vector moved if necessary), and the new entries are appended to
@@ -597,7 +845,9 @@ void Vector::vec_resize(int l)
 void Vector::intern_data(ConstraintEvaluator &eval, DDS &dds)
 {
     DBG(cerr << "Vector::intern_data: " << name() << endl);
-    if (!read_p())
+    if (m_use_chunked_read())
+        m_intern_chunks();
+    else if (!read_p())
         read(); // read() throws Error and InternalErr
 
     // length() is not capacity; it must be set explicitly in read().
@@ -617,7 +867,7 @@ void Vector::intern_data(ConstraintEvaluator &eval, DDS &dds)
 
         case dods_str_c:
         case dods_url_c:
-            // For these cases, read() will put the data into d_str[],
+            // For these cases, read() will put the data into the string storage,
         	// which is also what we need.
             break;
 
@@ -632,6 +882,10 @@ void Vector::intern_data(ConstraintEvaluator &eval, DDS &dds)
             // For these cases, we need to call read() for each of the 'num'
             // elements in the 'd_compound_buf[]' array of BaseType object pointers.
             //
+            // Values held in a column have already been read.
+            if (!d_struct_column.empty())
+                break;
+
             // I changed the test here from '... = 0' to '... < num' to accommodate
             // the case where the array is zero-length.
             if (d_compound_buf.capacity() < (unsigned)num)
@@ -667,12 +921,20 @@ bool Vector::serialize(ConstraintEvaluator & eval, DDS & dds, Marshaller &m, boo
     // information that the client depends on. jhrg 2/17/16
     if (length() == 0)
         set_read_p(true);
-    else if (!read_p())
+
+    // Vectors read using read_chunk() are read as they are serialized
+    bool chunked = m_use_chunked_read();
+    if (!read_p() && !chunked)
         read(); // read() throws Error and InternalErr
 
     if (ce_eval && !eval.eval_selection(dds, dataset()))
         return true;
 
+    if (chunked) {
+        m_serialize_chunks(m);
+        return true;
+    }
+
     // length() is not capacity; it must be set explicitly in read().
     int num = length();
 
@@ -696,17 +958,23 @@ bool Vector::serialize(ConstraintEvaluator & eval, DDS & dds, Marshaller &m, boo
             break;
 
         case dods_str_c:
-        case dods_url_c:
-            if (d_str.capacity() == 0)
-                throw InternalErr(__FILE__, __LINE__, "The capacity of the string vector is 0");
+        case dods_url_c: {
+            m_pack_str();
+            if (d_str_column.size() < (unsigned int)num)
+                throw InternalErr(__FILE__, __LINE__, "The string vector holds fewer values than the length of the array");
 
             m.put_int(num);
 
-            for (int i = 0; i < num; ++i)
-                m.put_str(d_str[i]);
+            // Reuse one string so that sending a value does not allocate memory
+            string value;
+            for (int i = 0; i < num; ++i) {
+                d_str_column.get(i, value);
+                m.put_str(value);
+            }
 
             status = true;
             break;
+        }
 
         case dods_array_c:
         case dods_structure_c:
@@ -714,11 +982,20 @@ bool Vector::serialize(ConstraintEvaluator & eval, DDS & dds, Marshaller &m, boo
         case dods_grid_c:
             //Jose Garcia
             // Not setting the capacity of d_compound_buf is an internal error.
-            if (d_compound_buf.capacity() == 0)
+            if (d_compound_buf.capacity() == 0 && d_struct_column.empty())
                 throw InternalErr(__FILE__, __LINE__, "The capacity of *this* vector is 0.");
 
             m.put_int(num);
             status = true;
+            if (!d_struct_column.empty()) {
+                // Load each value into the prototype and send it
+                for (int i = 0; i < num && status; ++i) {
+                    d_struct_column.get(i, d_proto);
+                    status = status && d_proto->serialize(eval, dds, m, false);
+                }
+                break;
+            }
+
             for (int i = 0; i < num && status; ++i)
                 status = status && d_compound_buf[i]->serialize(eval, dds, m, false);
 
@@ -811,14 +1088,18 @@ bool Vector::deserialize(UnMarshaller &um, DDS * dds, bool reuse)
             if (num != (unsigned int) length())
                 throw InternalErr(__FILE__, __LINE__, "The client sent declarations and data with mismatched sizes.");
 
-            d_str.resize((num > 0) ? num : 0); // Fill with NULLs
+            m_clear_str();
+            d_str_column.reserve(num);
             d_capacity = num; // capacity is number of strings we can fit.
 
-            for (i = 0; i < num; ++i) {
+            {
+                // Read each value into the same string and then append it to
+                // the packed storage; this avoids an allocation per value.
                 string str;
-                um.get_str(str);
-                d_str[i] = str;
-
+                for (i = 0; i < num; ++i) {
+                    um.get_str(str);
+                    d_str_column.push_back(str);
+                }
             }
 
             break;
@@ -839,6 +1120,22 @@ bool Vector::deserialize(UnMarshaller &um, DDS * dds, bool reuse)
             if (num != (unsigned int) length())
                 throw InternalErr(__FILE__, __LINE__, "The client sent declarations and data with mismatched sizes.");
 
+            if (m_use_struct_column()) {
+                // Read each value into the prototype and copy it to the column
+                // instead of making an object for each element.
+                m_delete_compound_buf();
+                d_struct_column.set_layout(d_proto);
+                d_struct_column.reserve(num);
+                d_capacity = num;
+
+                for (i = 0; i < num; ++i) {
+                    d_proto->deserialize(um, dds);
+                    d_struct_column.push_back(d_proto);
+                }
+
+                break;
+            }
+
             vec_resize(num);
 
             for (i = 0; i < num; ++i) {
@@ -880,8 +1177,9 @@ void Vector::compute_checksum(Crc32 &checksum)
 
         case dods_str_c:
         case dods_url_c:
+            m_pack_str();
         	for (int64_t i = 0, e = length(); i < e; ++i)
-        		checksum.AddData(reinterpret_cast<const uint8_t*>(d_str[i].data()), d_str[i].length());
+        		checksum.AddData(reinterpret_cast<const uint8_t*>(d_str_column.data(i)), d_str_column.length(i));
             break;
 
         case dods_opaque_c:
@@ -899,7 +1197,9 @@ void Vector::compute_checksum(Crc32 &checksum)
 
 void Vector::intern_data(/*Crc32 &checksum, DMR &dmr, ConstraintEvaluator &eval*/)
 {
-    if (!read_p())
+    if (m_use_chunked_read())
+        m_intern_chunks();
+    else if (!read_p())
         read(); // read() throws Error and InternalErr
 
     switch (d_proto->type()) {
@@ -931,6 +1231,10 @@ void Vector::intern_data(/*Crc32 &checksum, DMR &dmr, ConstraintEvaluator &eval*
         case dods_sequence_c:
             // Modified the assert here from '... != 0' to '... >= length())
             // to accommodate the case of a zero-length array. jhrg 1/28/16
+            // Values held in a column have already been read.
+            if (!d_struct_column.empty())
+                break;
+
             assert(d_compound_buf.capacity() >= (unsigned)length());
 
             for (int i = 0, e = length(); i < e; ++i)
@@ -947,7 +1251,9 @@ void Vector::intern_data(/*Crc32 &checksum, DMR &dmr, ConstraintEvaluator &eval*
 void
 Vector::serialize(D4StreamMarshaller &m, DMR &dmr, bool filter /*= false*/)
 {
-    if (!read_p())
+    // Vectors read using read_chunk() are read as they are serialized
+    bool chunked = m_use_chunked_read();
+    if (!read_p() && !chunked)
         read(); // read() throws Error and InternalErr
 #if 0
     if (filter && !eval.eval_selection(dmr, dataset()))
@@ -961,6 +1267,11 @@ Vector::serialize(D4StreamMarshaller &m, DMR &dmr, bool filter /*= false*/)
     if (num == 0)
         return;
 
+    if (chunked) {
+        m_serialize_chunks(m);
+        return;
+    }
+
     switch (d_proto->type()) {
         case dods_byte_c:
         case dods_char_c:
@@ -994,13 +1305,18 @@ Vector::serialize(D4StreamMarshaller &m, DMR &dmr, bool filter /*= false*/)
             break;
 
         case dods_str_c:
-        case dods_url_c:
-            assert((int64_t)d_str.capacity() >= num);
+        case dods_url_c: {
+            m_pack_str();
+            assert((int64_t)d_str_column.size() >= num);
 
-            for (int64_t i = 0; i < num; ++i)
-                m.put_str(d_str[i]);
+            string value;
+            for (int64_t i = 0; i < num; ++i) {
+                d_str_column.get(i, value);
+                m.put_str(value);
+            }
 
             break;
+        }
 
         case dods_array_c:
         	throw InternalErr(__FILE__, __LINE__, "Array of Array not allowed.");
@@ -1008,6 +1324,15 @@ Vector::serialize(D4StreamMarshaller &m, DMR &dmr, bool filter /*= false*/)
         case dods_opaque_c:
         case dods_structure_c:
         case dods_sequence_c:
+            if (!d_struct_column.empty()) {
+                // Load each value into the prototype and send it
+                for (int64_t i = 0; i < num; ++i) {
+                    d_struct_column.get(i, d_proto);
+                    d_proto->serialize(m, dmr, filter);
+                }
+                break;
+            }
+
             assert(d_compound_buf.capacity() >= 0);
 
             for (int64_t i = 0; i < num; ++i) {
@@ -1080,11 +1405,14 @@ Vector::deserialize(D4StreamUnMarshaller &um, DMR &dmr)
         case dods_str_c:
         case dods_url_c: {
         	int64_t len = length();
-            d_str.resize((len > 0) ? len : 0); // Fill with NULLs
+            m_clear_str();
+            d_str_column.reserve((len > 0) ? len : 0);
             d_capacity = len; // capacity is number of strings we can fit.
 
+            string str;
             for (int64_t i = 0; i < len; ++i) {
-                um.get_str(d_str[i]);
+                um.get_str(str);
+                d_str_column.push_back(str);
             }
 
             break;
@@ -1096,6 +1424,21 @@ Vector::deserialize(D4StreamUnMarshaller &um, DMR &dmr)
         case dods_opaque_c:
         case dods_structure_c:
         case dods_sequence_c: {
+            if (m_use_struct_column()) {
+                // See Vector::deserialize(UnMarshaller &, DDS *, bool)
+                m_delete_compound_buf();
+                d_struct_column.set_layout(d_proto);
+                d_struct_column.reserve(length());
+                d_capacity = length();
+
+                for (int64_t i = 0, end = length(); i < end; ++i) {
+                    d_proto->deserialize(um, dmr);
+                    d_struct_column.push_back(d_proto);
+                }
+
+                break;
+            }
+
             vec_resize(length());
 
             for (int64_t i = 0, end = length(); i < end; ++i) {
@@ -1190,12 +1533,13 @@ unsigned int Vector::val2buf(void *val, bool reuse)
         case dods_str_c:
         case dods_url_c:
             // Assume val points to an array of C++ string objects. Copy
-            // them into the vector<string> field of this object.
+            // them into the packed string storage of this object.
             // Note: d_length is the number of elements in the Vector
-            d_str.resize(d_length);
+            m_clear_str();
+            d_str_column.reserve(d_length);
             d_capacity = d_length;
             for (int i = 0; i < d_length; ++i)
-                d_str[i] = *(static_cast<string *> (val) + i);
+                d_str_column.push_back(*(static_cast<string *> (val) + i));
 
             break;
 
@@ -1285,13 +1629,13 @@ unsigned int Vector::buf2val(void **val)
 
         case dods_str_c:
         case dods_url_c: {
-        	if (d_str.empty())
+        	if (m_str_size() == 0)
         		throw InternalErr(__FILE__, __LINE__, "Vector::buf2val: Logic error: called when string data buffer was empty!");
             if (!*val)
                 *val = new string[d_length];
 
             for (int i = 0; i < d_length; ++i)
-                *(static_cast<string *> (*val) + i) = d_str[i];
+                m_str_value(i, *(static_cast<string *> (*val) + i));
 
             return width();
         }
@@ -1312,7 +1656,10 @@ unsigned int Vector::buf2val(void **val)
  members of Vector containing simple types.
 
  @note This method copies \e val; the caller is responsible for deleting
- instance passed as the actual parameter.
+ instance passed as the actual parameter. For an array of simple Structures
+ whose elements have not been made into objects, only the values of \e val
+ are copied, into a column; var() and get_compound_buf() make objects from
+ them when they are needed.
 
  @brief Sets element <i>i</i> to value <i>val</i>.
  @return void
@@ -1325,7 +1672,11 @@ unsigned int Vector::buf2val(void **val)
  @see Vector::buf2val */
 void Vector::set_vec(unsigned int i, BaseType * val)
 {
-	Vector::set_vec_nocopy(i, val->ptr_duplicate());
+    // Arrays of simple Structures store the values of val, not a copy of it
+    if (m_set_struct_column_value(i, val))
+        return;
+
+    Vector::set_vec_nocopy(i, val->ptr_duplicate());
 }
 
 /**
@@ -1360,10 +1711,18 @@ void Vector::set_vec_nocopy(unsigned int i, BaseType * val)
     // blocks of memory on successive calls, which has the strange affect of erasing
     // values already in the vector in the parts just added.
     // jhrg 5/18/17
+    // This Vector is about to hold objects, so the values in the column must be
+    // objects too. The object made here for element i has not been seen by
+    // any caller, so it is freed when val replaces it.
+    bool expanded = !d_struct_column.empty();
+    m_expand_struct_column();
+
     if (i >= d_compound_buf.size()) {
         vec_resize(d_compound_buf.size() + 100);
     }
 
+    if (expanded && d_compound_buf[i] != val)
+        delete d_compound_buf[i];
     d_compound_buf[i] = val;
 }
 
@@ -1383,14 +1742,12 @@ void Vector::clear_local_data()
         d_buf = 0;
     }
 
-    for (unsigned int i = 0; i < d_compound_buf.size(); ++i) {
-        delete d_compound_buf[i];
-        d_compound_buf[i] = 0;
-    }
-
     // Force memory to be reclaimed.
-    d_compound_buf.resize(0);
-    d_str.resize(0);
+    m_delete_compound_buf();
+    d_struct_column.release();
+    vector<string>().swap(d_str);
+    d_str_unpacked = false;
+    d_str_column.release();
 
     d_capacity = 0;
     set_read_p(false);
@@ -1401,7 +1758,7 @@ void Vector::clear_local_data()
  * elements of its data type that it can currently hold (i.e. not bytes).
  * For example, this could be
  * the size of the _buf array in bytes / sizeof(T) for the cardinal
- * types T, or the capacity of the d_str vector if T is string or url type.
+ * types T, or the number of strings that can be stored if T is string or url type.
  */
 unsigned int Vector::get_value_capacity() const
 {
@@ -1444,9 +1801,10 @@ void Vector::reserve_value_capacity(unsigned int numElements)
 
         case dods_str_c:
         case dods_url_c:
-            // Make sure the d_str has enough room for all the strings.
+            // Make sure there's enough room for all the strings.
             // Technically not needed, but it will speed things up for large arrays.
-            d_str.reserve(numElements);
+            m_pack_str();
+            d_str_column.reserve(numElements);
             d_capacity = numElements;
             break;
 
@@ -1581,12 +1939,16 @@ Vector::set_value_slice_from_row_major_vector(const Vector& rowMajorDataC, unsig
 		}
 
 		case dods_str_c:
-		case dods_url_c:
+		case dods_url_c: {
 			// Strings need to be copied directly
+			m_pack_str();
+			string value;
 			for (unsigned int i = 0; i < static_cast<unsigned int>(rowMajorData.length()); ++i) {
-				d_str[startElement + i] = rowMajorData.d_str[i];
+				rowMajorData.m_str_value(i, value);
+				d_str_column.set(startElement + i, value);
 			}
 			break;
+		}
 
 		case dods_array_c:
         case dods_opaque_c:
@@ -1720,10 +2082,11 @@ bool Vector::set_value(dods_float64 *val, int sz)
 bool Vector::set_value(string *val, int sz)
 {
     if ((var()->type() == dods_str_c || var()->type() == dods_url_c) && val) {
-        d_str.resize(sz);
+        m_clear_str();
+        d_str_column.reserve(sz);
         d_capacity = sz;
         for (int t = 0; t < sz; t++) {
-            d_str[t] = val[t];
+            d_str_column.push_back(val[t]);
         }
         set_length(sz);
         set_read_p(true);
@@ -1786,10 +2149,11 @@ bool Vector::set_value(vector<dods_float64> &val, int sz)
 bool Vector::set_value(vector<string> &val, int sz)
 {
     if (var()->type() == dods_str_c || var()->type() == dods_url_c) {
-        d_str.resize(sz);
+        m_clear_str();
+        d_str_column.reserve(sz);
         d_capacity = sz;
         for (int t = 0; t < sz; t++) {
-            d_str[t] = val[t];
+            d_str_column.push_back(val[t]);
         }
         set_length(sz);
         set_read_p(true);
@@ -1885,7 +2249,7 @@ void Vector::value(vector<unsigned int> *subsetIndex, vector<string> &b) const
                         "outside the bounds of the internal storage [ length()= " << length() << " ] name: '" << name() << "'. ";
                 throw Error(s.str());
             }
-            b[i] = d_str[currentIndex];
+            m_str_value(currentIndex, b[i]);
         }
     }
 }
@@ -1926,8 +2290,58 @@ template void Vector::value(dods_float64 *v) const;
 /** @brief Get a copy of the data held by this variable. */
 void Vector::value(vector<string> &b) const
 {
-    if (d_proto->type() == dods_str_c || d_proto->type() == dods_url_c)
-        b = d_str;
+    if (d_proto->type() == dods_str_c || d_proto->type() == dods_url_c) {
+        if (d_str_unpacked) {
+            b = d_str;
+        }
+        else {
+            b.resize(d_str_column.size());
+            for (unsigned int i = 0, e = d_str_column.size(); i < e; ++i)
+                d_str_column.get(i, b[i]);
+        }
+    }
+}
+
+/**
+ * Provide access to internal data by reference. Callers cannot delete this
+ * but can pass them to other methods.
+ *
+ * @note The values of arrays of simple Structures may be stored in a compact
+ * form; in that case this method makes an object for each element.
+ *
+ * @return A reference to a vector of BaseType pointers. Treat with care; never
+ * delete these!
+ */
+vector<BaseType*> &Vector::get_compound_buf()
+{
+    m_expand_struct_column();
+    return d_compound_buf;
+}
+
+/**
+ * Provide access to internal string data by reference. Callers cannot delete this
+ * but can pass them to other methods.
+ *
+ * @note The values of Str and Url Vectors are stored in a packed form; this
+ * method copies them to a vector<string> the first time it is called. The
+ * Vector moves the strings (including any changes made using the returned
+ * reference) back to the packed form when it next needs them, so the
+ * reference should not be used after calling other methods of this Vector.
+ *
+ * @return A reference to a vector of strings
+ */
+vector<string> &Vector::get_str()
+{
+    if (!d_str_unpacked) {
+        d_str.resize(d_str_column.size());
+        for (unsigned int i = 0, e = d_str_column.size(); i < e; ++i)
+            d_str_column.get(i, d_str[i]);
+
+        d_str_column.release();
+        d_str_unpacked = true;
+    }
+
+    return d_str;
 }
 
 /** Allocate memory and copy data into the new buffer. Return the new
@@ -2063,11 +2477,15 @@ void Vector::dump(ostream &strm) const
         else
             strm << DapIndent::LMarg << "vec[" << i << "] is null" << endl;
     }
+    if (!d_struct_column.empty())
+        strm << DapIndent::LMarg << "structure values in column: " << d_struct_column.size() << endl;
     DapIndent::UnIndent();
     strm << DapIndent::LMarg << "strings:" << endl;
     DapIndent::Indent();
-    for (unsigned i = 0; i < d_str.size(); i++) {
-        strm << DapIndent::LMarg << d_str[i] << endl;
+    string value;
+    for (unsigned i = 0; i < m_str_size(); i++) {
+        m_str_value(i, value);
+        strm << DapIndent::LMarg << value << endl;
     }
     DapIndent::UnIndent();
     if (d_buf) {
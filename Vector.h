@@ -47,6 +47,14 @@
 #include "ConstraintEvaluator.h"
 #endif
 
+#ifndef _string_column_h
+#include "StringColumn.h"
+#endif
+
+#ifndef _structure_column_h
+#include "StructureColumn.h"
+#endif
+
 class Crc32;
 
 namespace libdap
@@ -85,14 +93,25 @@ private:
 
     // _buf was a pointer to void; delete[] complained. 6/4/2001 jhrg
     char *d_buf;   		// storage for cardinal data
-    vector<string> d_str;		// special storage for strings. jhrg 2/11/05
+    StringColumn d_str_column;	// packed storage for Str and Url values
+    // Unpacked copy of the strings made by get_str(). While d_str_unpacked
+    // is true, d_str (not d_str_column) holds the values.
+    vector<string> d_str;
+    bool d_str_unpacked;
     vector<BaseType *> d_compound_buf; 	// storage for data in compound types (e.g., Structure)
+    // Values of arrays of Structures made of scalars. When not empty, these are
+    // the values of the Vector and d_compound_buf holds no objects.
+    StructureColumn d_struct_column;
 
     // the number of elements we have allocated memory to store.
     // This should be either the sizeof(buf)/width(bool constrained = false) for cardinal data
     // or the capacity of d_str for strings or capacity of _vec.
     unsigned int d_capacity;
 
+    // the maximum number of elements read_chunk() is asked to produce at one
+    // time. Zero (the default) means the whole array is read using read().
+    unsigned int d_chunk_size;
+
     friend class MarshallerTest;
 
     /*
@@ -107,6 +126,16 @@ private:
     template <typename T> bool set_value_worker(T *v, int sz);
     template <typename T> bool set_value_worker(vector<T> &v, int sz);
 
+    unsigned int m_str_size() const;
+    void m_str_value(unsigned int i, string &s) const;
+    void m_pack_str();
+    void m_clear_str();
+
+    bool m_use_struct_column() const;
+    bool m_set_struct_column_value(unsigned int i, BaseType *val);
+    void m_expand_struct_column();
+    void m_delete_compound_buf();
+
 protected:
     // This function copies the private members of Vector.
     void m_duplicate(const Vector &v);
@@ -117,6 +146,10 @@ protected:
 
     template <class CardType> void m_set_cardinal_values_internal(const CardType* fromArray, int numElts);
 
+    bool m_use_chunked_read();
+    void m_serialize_chunks(Marshaller &m);
+    void m_intern_chunks();
+
 public:
     Vector(const string &n, BaseType *v, const Type &t, bool is_dap4 = false);
     Vector(const string &n, const string &d, BaseType *v, const Type &t, bool is_dap4 = false);
@@ -139,26 +172,9 @@ public:
         return d_buf;
     }
 
-    /**
-     * Provide access to internal string data by reference. Callers cannot delete this
-     * but can pass them to other methods.
-     *
-     * @return A reference to a vector of strings
-     */
-    vector<string> &get_str() {
-        return d_str;
-    }
+    vector<string> &get_str();
 
-    /**
-     * Provide access to internal data by reference. Callers cannot delete this
-     * but can pass them to other methods.
-     *
-     * @return A reference to a vector of BaseType pointers. Treat with care; never
-     * delete these!
-     */
-    vector<BaseType*> &get_compound_buf() {
-        return d_compound_buf;
-    }
+    vector<BaseType*> &get_compound_buf();
 
 #if 0
     virtual bool is_dap2_only_type();
@@ -175,11 +191,22 @@ public:
     virtual void set_read_p(bool state);
 
     virtual unsigned int width(bool constrained = false) const;
+    virtual int64_t width_ll(bool constrained = false) const;
 
     virtual int length() const;
 
     virtual void set_length(int l);
 
+    /**
+     * The number of elements read_chunk() should produce at one time. When
+     * this is zero (the default) the Vector's data are read in one piece
+     * using read().
+     */
+    virtual unsigned int get_chunk_size() const { return d_chunk_size; }
+    virtual void set_chunk_size(unsigned int n) { d_chunk_size = n; }
+
+    virtual void read_chunk(unsigned int start, unsigned int count);
+
     // DAP2
     virtual void intern_data(ConstraintEvaluator &eval, DDS &dds);
     virtual bool serialize(ConstraintEvaluator &eval, DDS &dds, Marshaller &m, bool ce_eval = true);
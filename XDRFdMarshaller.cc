@@ -0,0 +1,364 @@
+// XDRFdMarshaller.cc
+
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+#include "XDRFdMarshaller.h"
+
+#include "Vector.h"
+#include "InternalErr.h"
+#include "DapIndent.h"
+
+using namespace std;
+
+namespace libdap {
+
+// XDR pads opaque data and strings to a multiple of four bytes
+static inline unsigned int xdr_pad(unsigned int len)
+{
+    return (4 - (len & 0x03)) & 0x03;
+}
+
+/** Build an instance of XDRFdMarshaller that writes to a file descriptor.
+ *
+ * @param fd Write to this file descriptor. It is not closed by this object.
+ * @param buf_size The size of the buffer used to collect encoded values
+ */
+XDRFdMarshaller::XDRFdMarshaller(int fd, unsigned int buf_size) :
+    d_fd(fd), d_buf(max(buf_size, 8U)), d_pos(0), d_partial_put_byte_count(0)
+{
+}
+
+XDRFdMarshaller::XDRFdMarshaller() :
+    Marshaller(), d_fd(-1), d_pos(0), d_partial_put_byte_count(0)
+{
+    throw InternalErr( __FILE__, __LINE__, "Default constructor not implemented.");
+}
+
+XDRFdMarshaller::XDRFdMarshaller(const XDRFdMarshaller &m) :
+    Marshaller(m), d_fd(-1), d_pos(0), d_partial_put_byte_count(0)
+{
+    throw InternalErr( __FILE__, __LINE__, "Copy constructor not implemented.");
+}
+
+XDRFdMarshaller &
+XDRFdMarshaller::operator=(const XDRFdMarshaller &)
+{
+    throw InternalErr( __FILE__, __LINE__, "Copy operator not implemented.");
+}
+
+XDRFdMarshaller::~XDRFdMarshaller()
+{
+    try {
+        flush();
+    }
+    catch (...) {
+        // The error cannot be reported here; call flush() to see it.
+    }
+}
+
+/**
+ * Write all of the data referenced by iov, calling writev() again when only
+ * part of the data are written.
+ */
+void XDRFdMarshaller::m_writev(struct iovec *iov, int iovcnt)
+{
+    while (iovcnt > 0) {
+        if (iov->iov_len == 0) {
+            ++iov;
+            --iovcnt;
+            continue;
+        }
+
+        ssize_t n = writev(d_fd, iov, iovcnt);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw Error(string("Network I/O Error. Could not send data: ") + strerror(errno));
+
+        while (iovcnt > 0 && (size_t) n >= iov->iov_len) {
+            n -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + n;
+            iov->iov_len -= n;
+        }
+    }
+}
+
+/**
+ * Get room for len more bytes in the buffer, writing the buffer first if
+ * needed; len must not be larger than the buffer.
+ *
+ * @return A pointer to the len bytes.
+ */
+char *XDRFdMarshaller::m_reserve(unsigned int len)
+{
+    if (d_buf.size() - d_pos < len)
+        flush();
+
+    char *p = &d_buf[d_pos];
+    d_pos += len;
+    return p;
+}
+
+void XDRFdMarshaller::m_put_word(uint32_t val)
+{
+    uint32_t word = htonl(val);
+    memcpy(m_reserve(sizeof(word)), &word, sizeof(word));
+}
+
+// Data too large for the buffer are written with it, not copied into it.
+void XDRFdMarshaller::m_put_bytes(const char *val, unsigned int len)
+{
+    if (len <= d_buf.size() - d_pos) {
+        memcpy(&d_buf[d_pos], val, len);
+        d_pos += len;
+    }
+    else if (len < d_buf.size()) {
+        flush();
+        memcpy(&d_buf[0], val, len);
+        d_pos = len;
+    }
+    else {
+        struct iovec iov[2];
+        iov[0].iov_base = &d_buf[0];
+        iov[0].iov_len = d_pos;
+        iov[1].iov_base = const_cast<char*>(val);
+        iov[1].iov_len = len;
+
+        m_writev(iov, 2);
+        d_pos = 0;
+    }
+}
+
+void XDRFdMarshaller::m_put_pad(unsigned int len)
+{
+    if (len > 0)
+        memset(m_reserve(len), 0, len);
+}
+
+/**
+ * Encode the values of an array in blocks that fill the buffer.
+ *
+ * @param val The values
+ * @param num The number of values
+ * @param width The width of each value; 2, 4 or 8
+ * @param type The DAP2 type of the values
+ */
+void XDRFdMarshaller::m_put_array(const char *val, unsigned int num, int width, Type type)
+{
+    unsigned int xdr_width = width < 4 ? 4 : width;
+
+    while (num > 0) {
+        unsigned int n = min(num, (unsigned int) (d_buf.size() - d_pos) / xdr_width);
+        if (n == 0) {
+            flush();
+            continue;
+        }
+
+        XDRUtils::encode_array(val, n, width, type, &d_buf[d_pos]);
+
+        d_pos += n * xdr_width;
+        val += n * width;
+        num -= n;
+    }
+}
+
+/**
+ * Write the values held in the buffer.
+ */
+void XDRFdMarshaller::flush()
+{
+    if (d_pos == 0)
+        return;
+
+    struct iovec iov;
+    iov.iov_base = &d_buf[0];
+    iov.iov_len = d_pos;
+
+    // Reset first so an error is not reported again by the destructor
+    d_pos = 0;
+    m_writev(&iov, 1);
+}
+
+void XDRFdMarshaller::put_byte(dods_byte val)
+{
+    // xdr_char() sends the value as a C char, which may be signed
+    m_put_word((uint32_t) (int32_t) (char) val);
+}
+
+void XDRFdMarshaller::put_int16(dods_int16 val)
+{
+    m_put_word((uint32_t) (int32_t) val);
+}
+
+void XDRFdMarshaller::put_int32(dods_int32 val)
+{
+    m_put_word((uint32_t) val);
+}
+
+void XDRFdMarshaller::put_float32(dods_float32 val)
+{
+    uint32_t word;
+    memcpy(&word, &val, sizeof(word));
+    m_put_word(word);
+}
+
+void XDRFdMarshaller::put_float64(dods_float64 val)
+{
+    XDRUtils::encode_array((char *) &val, 1, sizeof(dods_float64), dods_float64_c, m_reserve(sizeof(dods_float64)));
+}
+
+void XDRFdMarshaller::put_uint16(dods_uint16 val)
+{
+    m_put_word((uint32_t) val);
+}
+
+void XDRFdMarshaller::put_uint32(dods_uint32 val)
+{
+    m_put_word((uint32_t) val);
+}
+
+void XDRFdMarshaller::put_str(const string &val)
+{
+    m_put_word(val.length());
+    m_put_bytes(val.data(), val.length());
+    m_put_pad(xdr_pad(val.length()));
+}
+
+void XDRFdMarshaller::put_url(const string &val)
+{
+    put_str(val);
+}
+
+void XDRFdMarshaller::put_opaque(char *val, unsigned int len)
+{
+    m_put_bytes(val, len);
+    m_put_pad(xdr_pad(len));
+}
+
+void XDRFdMarshaller::put_int(int val)
+{
+    m_put_word((uint32_t) val);
+}
+
+void XDRFdMarshaller::put_vector(char *val, int num, Vector &)
+{
+    if (!val) throw InternalErr(__FILE__, __LINE__, "Buffer pointer is not set.");
+
+    // The number of elements, then the values as sent by xdr_bytes()
+    put_int(num);
+    put_int(num);
+
+    put_opaque(val, num);
+}
+
+void XDRFdMarshaller::put_vector(char *val, int num, int width, Vector &vec)
+{
+    if (!val && num > 0) throw InternalErr(__FILE__, __LINE__, "Buffer pointer is not set.");
+
+    // The number of elements, then the values as sent by xdr_array()
+    put_int(num);
+    put_int(num);
+
+    m_put_array(val, num, width, vec.var()->type());
+}
+
+/**
+ * Prepare to send a single array/vector using a series of 'put' calls.
+ *
+ * @param num The number of elements in the Array/Vector
+ * @see put_vector_part()
+ * @see put_vector_end()
+ */
+void XDRFdMarshaller::put_vector_start(int num)
+{
+    put_int(num);
+    put_int(num);
+
+    d_partial_put_byte_count = 0;
+}
+
+/**
+ * Write num values for an Array/Vector.
+ *
+ * @param val The values to write
+ * @param num the number of values to write
+ * @param width The width of the values
+ * @param type The DAP2 type of the values.
+ *
+ * @see put_vector_start()
+ * @see put_vector_end()
+ */
+void XDRFdMarshaller::put_vector_part(char *val, unsigned int num, int width, Type type)
+{
+    if (width == 1) {
+        // Bytes are not padded until the whole vector has been written;
+        // see put_vector_end().
+        m_put_bytes(val, num);
+        d_partial_put_byte_count += num;
+    }
+    else {
+        m_put_array(val, num, width, type);
+    }
+}
+
+/**
+ * Close a vector when its values are written using put_vector_part().
+ *
+ * @see put_vector_start()
+ * @see put_vector_part()
+ */
+void XDRFdMarshaller::put_vector_end()
+{
+    m_put_pad(xdr_pad(d_partial_put_byte_count));
+
+    d_partial_put_byte_count = 0;
+}
+
+void XDRFdMarshaller::dump(ostream &strm) const
+{
+    strm << DapIndent::LMarg << "XDRFdMarshaller::dump - (" << (void *) this << ")" << endl;
+    DapIndent::Indent();
+    strm << DapIndent::LMarg << "file descriptor: " << d_fd << endl;
+    strm << DapIndent::LMarg << "buffered bytes: " << d_pos << endl;
+    DapIndent::UnIndent();
+}
+
+} // namespace libdap
@@ -0,0 +1,113 @@
+// XDRFdMarshaller.h
+
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#ifndef I_XDRFdMarshaller_h
+#define I_XDRFdMarshaller_h 1
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "Marshaller.h"
+#include "XDRUtils.h"
+
+struct iovec;
+
+namespace libdap {
+
+// The default size of the buffer used to collect encoded values
+#define XDR_FD_BUFF_SIZE (64 * 1024)
+
+/** @brief marshaller that serializes dap data objects to a file descriptor
+ * using XDR
+ *
+ * The response is the same as the one written by XDRFileMarshaller and
+ * XDRStreamMarshaller, but values are encoded into a buffer of
+ * XDR_FD_BUFF_SIZE bytes that is written using write(2) only when it is
+ * full. Arrays are encoded in blocks that fill the buffer. Byte arrays and
+ * strings too large for the buffer are not copied; they are written with
+ * the buffered data in one writev(2) call.
+ *
+ * Call flush() once the response is complete; the destructor also flushes
+ * the buffer, but cannot report errors.
+ */
+class XDRFdMarshaller: public Marshaller {
+private:
+    int d_fd;
+
+    std::vector<char> d_buf;
+    unsigned int d_pos;     // bytes of d_buf waiting to be written
+
+    unsigned int d_partial_put_byte_count;
+
+    XDRFdMarshaller();
+    XDRFdMarshaller(const XDRFdMarshaller &m);
+    XDRFdMarshaller & operator=(const XDRFdMarshaller &);
+
+    char *m_reserve(unsigned int len);
+    void m_writev(struct iovec *iov, int iovcnt);
+
+    void m_put_word(uint32_t val);
+    void m_put_bytes(const char *val, unsigned int len);
+    void m_put_pad(unsigned int len);
+    void m_put_array(const char *val, unsigned int num, int width, Type type);
+
+public:
+    XDRFdMarshaller(int fd, unsigned int buf_size = XDR_FD_BUFF_SIZE);
+    virtual ~XDRFdMarshaller();
+
+    void flush();
+
+    virtual void put_byte(dods_byte val);
+
+    virtual void put_int16(dods_int16 val);
+    virtual void put_int32(dods_int32 val);
+
+    virtual void put_float32(dods_float32 val);
+    virtual void put_float64(dods_float64 val);
+
+    virtual void put_uint16(dods_uint16 val);
+    virtual void put_uint32(dods_uint32 val);
+
+    virtual void put_str(const string &val);
+    virtual void put_url(const string &val);
+
+    virtual void put_opaque(char *val, unsigned int len);
+    virtual void put_int(int val);
+
+    virtual void put_vector(char *val, int num, Vector &vec);
+    virtual void put_vector(char *val, int num, int width, Vector &vec);
+
+    virtual void put_vector_start(int num);
+    virtual void put_vector_part(char *val, unsigned int num, int width, Type type);
+    virtual void put_vector_end();
+
+    virtual void dump(ostream &strm) const;
+};
+
+} // namespace libdap
+
+#endif // I_XDRFdMarshaller_h
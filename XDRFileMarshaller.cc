@@ -55,19 +55,19 @@
 namespace libdap {
 
 XDRFileMarshaller::XDRFileMarshaller(FILE *out) :
-    _sink(0)//, d_out(out)
+    _sink(0), d_out(out), d_partial_put_byte_count(0)
 {
     _sink = new_xdrstdio(out, XDR_ENCODE);
 }
 
 XDRFileMarshaller::XDRFileMarshaller() :
-    Marshaller(), _sink(0)//, d_out(0)
+    Marshaller(), _sink(0), d_out(0), d_partial_put_byte_count(0)
 {
     throw InternalErr( __FILE__, __LINE__, "Default constructor not implemented.");
 }
 
 XDRFileMarshaller::XDRFileMarshaller(const XDRFileMarshaller &m) :
-    Marshaller(m), _sink(0)//, d_out(0)
+    Marshaller(m), _sink(0), d_out(0), d_partial_put_byte_count(0)
 {
     throw InternalErr( __FILE__, __LINE__, "Copy constructor not implemented.");
 }
@@ -179,6 +179,72 @@ void XDRFileMarshaller::put_vector(char *val, int num, int width, Vector &vec)
     }
 }
 
+/**
+ * Prepare to send a single array/vector using a series of 'put' calls.
+ *
+ * @param num The number of elements in the Array/Vector
+ * @see put_vector_part()
+ * @see put_vector_end()
+ */
+void XDRFileMarshaller::put_vector_start(int num)
+{
+    put_int(num);
+    put_int(num);
+
+    d_partial_put_byte_count = 0;
+}
+
+/**
+ * Write num values for an Array/Vector.
+ *
+ * @param val The values to write
+ * @param num the number of values to write
+ * @param width The width of the values
+ * @param type The DAP2 type of the values.
+ *
+ * @see put_vector_start()
+ * @see put_vector_end()
+ */
+void XDRFileMarshaller::put_vector_part(char *val, unsigned int num, int width, Type type)
+{
+    if (width == 1) {
+        // Bytes are not padded until the whole vector has been written;
+        // see put_vector_end().
+        if (fwrite(val, 1, num, d_out) != num)
+            throw Error("Network I/O Error. Could not send part of byte vector data");
+
+        d_partial_put_byte_count += num;
+    }
+    else {
+        xdrproc_t coder = XDRUtils::xdr_coder(type);
+        for (unsigned int i = 0; i < num; ++i) {
+            if (!coder(_sink, val + i * width))
+                throw Error("Network I/O Error. Could not send part of vector data");
+        }
+    }
+}
+
+/**
+ * Close a vector when its values are written using put_vector_part().
+ *
+ * @see put_vector_start()
+ * @see put_vector_part()
+ */
+void XDRFileMarshaller::put_vector_end()
+{
+    // Note that the XDR standard pads values to 4 byte boundaries.
+    unsigned int mod_4 = d_partial_put_byte_count & 0x03;
+    unsigned int pad = (mod_4 == 0) ? 0 : 4 - mod_4;
+
+    if (pad) {
+        const char padding[4] = { 0, 0, 0, 0 };
+        if (fwrite(padding, 1, pad, d_out) != pad)
+            throw Error("Network I/O Error. Could not send vector data padding");
+    }
+
+    d_partial_put_byte_count = 0;
+}
+
 void XDRFileMarshaller::dump(ostream &strm) const
 {
     strm << DapIndent::LMarg << "XDRFileMarshaller::dump - (" << (void *) this << ")" << endl;
@@ -48,6 +48,9 @@ namespace libdap {
 class XDRFileMarshaller: public Marshaller {
 private:
     XDR * _sink;
+    FILE * d_out;
+
+    unsigned int d_partial_put_byte_count;
 
     XDRFileMarshaller();
     XDRFileMarshaller(const XDRFileMarshaller &m);
@@ -76,6 +79,10 @@ public:
     virtual void put_vector(char *val, int num, Vector &vec);
     virtual void put_vector(char *val, int num, int width, Vector &vec);
 
+    virtual void put_vector_start(int num);
+    virtual void put_vector_part(char *val, unsigned int num, int width, Type type);
+    virtual void put_vector_end();
+
     virtual void dump(ostream &strm) const;
 };
 
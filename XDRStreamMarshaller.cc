@@ -38,7 +38,10 @@
 #include <pthread.h>
 #endif
 
+#include <arpa/inet.h>
+
 #include <cassert>
+#include <cstring>
 
 #include <iostream>
 #include <sstream>
@@ -65,7 +68,6 @@ using namespace std;
 
 namespace libdap {
 
-char *XDRStreamMarshaller::d_buf = 0;
 static const int XDR_DAP_BUFF_SIZE=256;
 
 
@@ -78,9 +80,9 @@ static const int XDR_DAP_BUFF_SIZE=256;
  * @param write_data If true, write data values. True by default
  */
 XDRStreamMarshaller::XDRStreamMarshaller(ostream &out) :
-    d_out(out), d_partial_put_byte_count(0), tm(0)
+    d_buf(0), d_out(out), d_partial_put_byte_count(0), tm(0)
 {
-    if (!d_buf) d_buf = (char *) malloc(XDR_DAP_BUFF_SIZE);
+    d_buf = (char *) malloc(XDR_DAP_BUFF_SIZE);
     if (!d_buf) throw Error(internal_error, "Failed to allocate memory for data serialization.");
 
     xdrmem_create(&d_sink, d_buf, XDR_DAP_BUFF_SIZE, XDR_ENCODE);
@@ -98,6 +100,7 @@ XDRStreamMarshaller::~XDRStreamMarshaller()
     delete tm;
 #endif
     xdr_destroy(&d_sink);
+    free(d_buf);
 }
 
 void XDRStreamMarshaller::put_byte(dods_byte val)
@@ -466,41 +469,27 @@ void XDRStreamMarshaller::put_vector(char *val, unsigned int num, int width, Typ
     int size = (num * use_width) + 4;
 
     // allocate enough memory for the elements
-    //vector<char> vec_buf(size);
     char *vec_buf = new char[size];
-    XDR vec_sink;
     try {
-        xdrmem_create(&vec_sink, vec_buf, size, XDR_ENCODE);
-
-        // set the position of the sink to 0, we're starting at the beginning
-        if (!xdr_setpos(&vec_sink, 0))
-            throw Error("Network I/O Error. Could not send vector data - unable to set stream position.");
-
-        // write the array to the buffer
-        if (!xdr_array(&vec_sink, (char **) &val, (unsigned int *) &num, size, width, XDRUtils::xdr_coder(type)))
-            throw Error("Network I/O Error(2). Could not send vector data - unable to encode.");
-
-        // how much was written to the buffer
-        unsigned int bytes_written = xdr_getpos(&vec_sink);
-        if (!bytes_written)
-            throw Error("Network I/O Error. Could not send vector data - unable to get stream position.");
-
-#ifdef USE_POSIX_THREADS
-        Locker lock(tm->get_mutex(), tm->get_cond(), tm->get_child_thread_count());
-        tm->increment_child_thread_count();
-        tm->start_thread(MarshallerThread::write_thread, d_out, vec_buf, bytes_written);
-        xdr_destroy(&vec_sink);
-#else
-        d_out.write(vec_buf, bytes_written);
-        xdr_destroy(&vec_sink);
-        delete [] vec_buf;
-#endif
+        // XDR arrays start with the number of elements; the values are
+        // encoded in bulk, as xdr_array() would encode them one at a time.
+        uint32_t count = htonl(num);
+        memcpy(vec_buf, &count, sizeof(uint32_t));
+        XDRUtils::encode_array(val, num, width, type, vec_buf + 4);
     }
     catch (...) {
-        xdr_destroy(&vec_sink);
         delete [] vec_buf;
         throw;
     }
+
+#ifdef USE_POSIX_THREADS
+    Locker lock(tm->get_mutex(), tm->get_cond(), tm->get_child_thread_count());
+    tm->increment_child_thread_count();
+    tm->start_thread(MarshallerThread::write_thread, d_out, vec_buf, size);
+#else
+    d_out.write(vec_buf, size);
+    delete [] vec_buf;
+#endif
 }
 
 /**
@@ -570,49 +559,36 @@ void XDRStreamMarshaller::put_vector_part(char *val, unsigned int num, int width
         // element, then add 4 bytes for the (int) number of elements
         int size = (num * use_width) + 4;
 
-        // allocate enough memory for the elements
-        //vector<char> vec_buf(size);
+        // allocate enough memory for the elements; the first four bytes
+        // are not sent
         char *vec_buf = new char[size];
-        XDR vec_sink;
         try {
-            xdrmem_create(&vec_sink, vec_buf, size, XDR_ENCODE);
-
-            // set the position of the sink to 0, we're starting at the beginning
-            if (!xdr_setpos(&vec_sink, 0))
-                throw Error("Network I/O Error. Could not send vector data - unable to set stream position.");
-
-            // write the array to the buffer
-            if (!xdr_array(&vec_sink, (char **) &val, (unsigned int *) &num, size, width, XDRUtils::xdr_coder(type)))
-                throw Error("Network I/O Error(2). Could not send vector data -unable to encode data.");
+            XDRUtils::encode_array(val, num, width, type, vec_buf + 4);
+        }
+        catch (...) {
+            delete [] vec_buf;
+            throw;
+        }
 
 #ifdef USE_POSIX_THREADS
-            Locker lock(tm->get_mutex(), tm->get_cond(), tm->get_child_thread_count());
-            tm->increment_child_thread_count();
+        Locker lock(tm->get_mutex(), tm->get_cond(), tm->get_child_thread_count());
+        tm->increment_child_thread_count();
 
-            // Increment the element count so we can figure out about the padding in put_vector_last()
-            d_partial_put_byte_count += (size - 4);
-            tm->start_thread(MarshallerThread::write_thread_part, d_out, vec_buf, size - 4);
-            xdr_destroy(&vec_sink);
+        // Increment the element count so we can figure out about the padding in put_vector_last()
+        d_partial_put_byte_count += (size - 4);
+        tm->start_thread(MarshallerThread::write_thread_part, d_out, vec_buf, size - 4);
 #else
-            // write that much out to the output stream, skipping the length data that
-            // XDR writes since we have already written the length info using put_vector_start()
-            d_out.write(vec_buf + 4, size - 4);
-
-            if (d_out.fail())
-                throw Error ("Network I/O Error. Could not send part of vector data");
+        // write that much out to the output stream, skipping the length data
+        // since we have already written the length info using put_vector_start()
+        d_out.write(vec_buf + 4, size - 4);
+        delete [] vec_buf;
 
-            // Now increment the element count so we can figure out about the padding in put_vector_last()
-            d_partial_put_byte_count += (size - 4);
+        if (d_out.fail())
+            throw Error ("Network I/O Error. Could not send part of vector data");
 
-            xdr_destroy(&vec_sink);
-            delete [] vec_buf;
+        // Now increment the element count so we can figure out about the padding in put_vector_last()
+        d_partial_put_byte_count += (size - 4);
 #endif
-        }
-        catch (...) {
-            xdr_destroy(&vec_sink);
-            delete [] vec_buf;
-            throw;
-        }
     }
 }
 
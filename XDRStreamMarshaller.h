@@ -53,7 +53,9 @@ class MarshallerThread;
  */
 class XDRStreamMarshaller: public Marshaller {
 private:
-    static char * d_buf;
+    // Each instance has its own encode buffer so that responses can be
+    // serialized by several threads at once.
+    char *d_buf;
     XDR d_sink;
     ostream & d_out;
 
@@ -33,6 +33,7 @@
 #include "XDRStreamUnMarshaller.h"
 
 #include <cstring> // for memcpy
+#include <limits>
 #include <string>
 #include <sstream>
 
@@ -48,13 +49,10 @@
 
 namespace libdap {
 
-char *XDRStreamUnMarshaller::d_buf = 0;
-
 XDRStreamUnMarshaller::XDRStreamUnMarshaller(istream &in) : /*&d_source( 0 ),*/
-        d_in(in)
+        d_in(in), d_buf(0)
 {
-    if (!d_buf)
-        d_buf = (char *) malloc(XDR_DAP_BUFF_SIZE);
+    d_buf = (char *) malloc(XDR_DAP_BUFF_SIZE);
     if (!d_buf)
         throw Error(internal_error, "Failed to allocate memory for data serialization.");
 
@@ -63,13 +61,13 @@ XDRStreamUnMarshaller::XDRStreamUnMarshaller(istream &in) : /*&d_source( 0 ),*/
 }
 
 XDRStreamUnMarshaller::XDRStreamUnMarshaller() :
-        UnMarshaller(), /*&d_source( 0 ),*/d_in(cin)
+        UnMarshaller(), /*&d_source( 0 ),*/d_in(cin), d_buf(0)
 {
     throw InternalErr(__FILE__, __LINE__, "Default constructor not implemented.");
 }
 
 XDRStreamUnMarshaller::XDRStreamUnMarshaller(const XDRStreamUnMarshaller &um) :
-        UnMarshaller(um), /*&d_source( 0 ),*/d_in(cin)
+        UnMarshaller(um), /*&d_source( 0 ),*/d_in(cin), d_buf(0)
 {
     throw InternalErr(__FILE__, __LINE__, "Copy constructor not implemented.");
 }
@@ -84,6 +82,7 @@ XDRStreamUnMarshaller::~XDRStreamUnMarshaller()
 {
     xdr_destroy( &d_source );
     //&d_source = 0;
+    free(d_buf);
 }
 
 void XDRStreamUnMarshaller::get_byte(dods_byte &val)
@@ -291,44 +290,56 @@ void XDRStreamUnMarshaller::get_vector(char **val, unsigned int &num, int width,
     get_vector(val, num, width, vec.var()->type());
 }
 
-void XDRStreamUnMarshaller::get_vector(char **val, unsigned int &num, int width, Type type)
+void XDRStreamUnMarshaller::get_vector(char **val, unsigned int &num, int width, Type)
 {
     int i;
-    get_int(i); // This leaves the XDR encoded value in d_buf; used later
+    get_int(i); // The element count written by xdr_array()
     DBG(std::cerr << "i: " << i << std::endl);
 
-    width += width & 3;
-    DBG(std::cerr << "width: " << width << std::endl);
+    if (i < 0)
+        throw Error("Network I/O Error. Could not read array data - bad element count.");
 
-    int size = i * width; // + 4; // '+ 4' to hold the int already read
+    // Like xdr_array(), don't read more values than a given buffer holds
+    if (*val && (unsigned int) i > num)
+        throw Error("Network I/O Error. Could not read array data - more elements than expected.");
 
-    // Must address the case where the string is larger than the buffer
-    if (size > XDR_DAP_BUFF_SIZE) {
-    	vector<char> buf(size+4);
-        XDR source;
-        xdrmem_create(&source, &buf[0], size + 4, XDR_DECODE);
-        DBG(cerr << "size: " << size << endl);
-        memcpy(&buf[0], d_buf, 4);
+    // 16-bit values are sent as 32-bit values
+    size_t xdr_width = (width < 4) ? 4 : width;
+    DBG(std::cerr << "width: " << width << ", xdr width: " << xdr_width << std::endl);
 
-        d_in.read(&buf[0] + 4, size); // +4 for the int already read
-        DBG(cerr << "bytes read: " << d_in.gcount() << endl);
+    if (width <= 0 || (size_t) i > numeric_limits<size_t>::max() / xdr_width)
+        throw Error("Network I/O Error. Could not read array data - array too large.");
 
-        xdr_setpos(&source, 0);
-        if (!xdr_array(&source, val, &num, DODS_MAX_ARRAY, width, XDRUtils::xdr_coder(type))) {
-            xdr_destroy( &source );
+    size_t size = i * xdr_width;
+
+    // Like xdr_array(), allocate memory for the values if none was given
+    if (!*val) {
+        *val = (char *) malloc((size_t) i * width);
+        if (!*val)
+            throw Error("Network I/O Error. Could not read array data - out of memory.");
+    }
+
+    num = i;
+
+    // The values are decoded in bulk, in place when the encoded values are
+    // the same size as the values.
+    if (xdr_width == (size_t) width) {
+        d_in.read(*val, size);
+        if (d_in.fail())
             throw Error("Network I/O Error. Could not read array data.");
-        }
 
-        xdr_destroy( &source );
+        XDRUtils::decode_array(*val, num, width, *val);
     }
     else {
-        d_in.read(d_buf + 4, size);
-        DBG(cerr << "bytes read (2): " << d_in.gcount() << endl);
-
-        xdr_setpos( &d_source, 0);
-        if (!xdr_array(&d_source, val, &num, DODS_MAX_ARRAY, width, XDRUtils::xdr_coder(type)))
+        vector<char> buf(size);
+        d_in.read(&buf[0], size);
+        if (d_in.fail())
             throw Error("Network I/O Error. Could not read array data.");
+
+        XDRUtils::decode_array(&buf[0], num, width, *val);
     }
+
+    DBG(cerr << "bytes read: " << d_in.gcount() << endl);
 }
 
 void XDRStreamUnMarshaller::dump(ostream &strm) const
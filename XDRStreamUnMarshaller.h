@@ -54,7 +54,7 @@ class XDRStreamUnMarshaller : public UnMarshaller
 private:
     XDR 			d_source ;
     istream &		d_in;
-    static char *	d_buf;
+    char *		d_buf;	// per-instance so threads can each use one
 
     				XDRStreamUnMarshaller() ;
     				XDRStreamUnMarshaller( const XDRStreamUnMarshaller &um ) ;
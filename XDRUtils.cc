@@ -32,7 +32,15 @@
 
 #include "config.h"
 
+#include <stdint.h>
+#include <cstring>
+
+#if !WORDS_BIGENDIAN
+#include <byteswap.h>
+#endif
+
 #include "XDRUtils.h"
+#include "InternalErr.h"
 #include "debug.h"
 #include "Str.h"
 
@@ -171,5 +179,138 @@ XDRUtils::xdr_coder(const Type &t)
     return NULL;
 }
 
-} // namespace libdap
+// Load and store values without assuming the memory is aligned; these
+// compile to single moves.
+template<typename T>
+static inline T load(const char *p)
+{
+    T v;
+    memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+template<typename T>
+static inline void store(char *p, T v)
+{
+    memcpy(p, &v, sizeof(T));
+}
+
+// XDR uses big-endian byte order; these swap to and from it on little-endian
+// hosts. Written as simple loops over these, the byte swaps are vectorized
+// by the compiler.
+static inline uint32_t xdr_order_32(uint32_t v)
+{
+#if WORDS_BIGENDIAN
+    return v;
+#else
+    return bswap_32(v);
+#endif
+}
 
+static inline uint64_t xdr_order_64(uint64_t v)
+{
+#if WORDS_BIGENDIAN
+    return v;
+#else
+    return bswap_64(v);
+#endif
+}
+
+/** Encode an array of cardinal values the way xdr_array() does using the
+    function returned by xdr_coder(), without calling a function for each
+    element. The element count that xdr_array() writes before the values is
+    not written.
+
+    16-bit values are sent as 32-bit values (sign extended for Int16);
+    32-bit and 64-bit values are sent in big-endian byte order. On a
+    big-endian host the 32 and 64-bit values are just copied.
+
+    @param val The values
+    @param num The number of values
+    @param width The size of each value in memory; 2, 4 or 8
+    @param type The type of the values; used to tell Int16 from UInt16
+    @param dest Write the encoded values here; there must be room for num
+    times 4 bytes for 16-bit values and num times width bytes otherwise.
+    For 32 and 64-bit values \e dest may be \e val.
+    @exception InternalErr if width is not 2, 4 or 8. */
+void
+XDRUtils::encode_array(const char *val, unsigned int num, int width, Type type, char *dest)
+{
+    switch (width) {
+    case 2:
+        if (type == dods_int16_c) {
+            for (unsigned int i = 0; i < num; ++i)
+                store<uint32_t>(dest + 4 * i, xdr_order_32((uint32_t) (int32_t) load<int16_t>(val + 2 * i)));
+        }
+        else {
+            for (unsigned int i = 0; i < num; ++i)
+                store<uint32_t>(dest + 4 * i, xdr_order_32((uint32_t) load<uint16_t>(val + 2 * i)));
+        }
+        break;
+
+    case 4:
+#if WORDS_BIGENDIAN
+        memmove(dest, val, num * 4);
+#else
+        for (unsigned int i = 0; i < num; ++i)
+            store<uint32_t>(dest + 4 * i, xdr_order_32(load<uint32_t>(val + 4 * i)));
+#endif
+        break;
+
+    case 8:
+#if WORDS_BIGENDIAN
+        memmove(dest, val, num * 8);
+#else
+        for (unsigned int i = 0; i < num; ++i)
+            store<uint64_t>(dest + 8 * i, xdr_order_64(load<uint64_t>(val + 8 * i)));
+#endif
+        break;
+
+    default:
+        throw InternalErr(__FILE__, __LINE__, "Cannot encode an array of values this size.");
+    }
+}
+
+/** Decode an array of cardinal values encoded by encode_array() or by
+    xdr_array(). The element count must already have been read.
+
+    @param src The encoded values
+    @param num The number of values
+    @param width The size of each value in memory; 2, 4 or 8
+    @param val Write the values here. For 32 and 64-bit values this may be
+    \e src.
+    @exception InternalErr if width is not 2, 4 or 8. */
+void
+XDRUtils::decode_array(const char *src, unsigned int num, int width, char *val)
+{
+    switch (width) {
+    case 2:
+        // The value is in the low 16 bits of the 32-bit word
+        for (unsigned int i = 0; i < num; ++i)
+            store<uint16_t>(val + 2 * i, (uint16_t) xdr_order_32(load<uint32_t>(src + 4 * i)));
+        break;
+
+    case 4:
+#if WORDS_BIGENDIAN
+        memmove(val, src, num * 4);
+#else
+        for (unsigned int i = 0; i < num; ++i)
+            store<uint32_t>(val + 4 * i, xdr_order_32(load<uint32_t>(src + 4 * i)));
+#endif
+        break;
+
+    case 8:
+#if WORDS_BIGENDIAN
+        memmove(val, src, num * 8);
+#else
+        for (unsigned int i = 0; i < num; ++i)
+            store<uint64_t>(val + 8 * i, xdr_order_64(load<uint64_t>(src + 8 * i)));
+#endif
+        break;
+
+    default:
+        throw InternalErr(__FILE__, __LINE__, "Cannot decode an array of values this size.");
+    }
+}
+
+} // namespace libdap
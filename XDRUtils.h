@@ -63,6 +63,10 @@ public:
     // of things (e.g., xdr_array()). Each leaf class's constructor must set
     // this.
     static xdrproc_t		xdr_coder( const Type &t ) ;
+
+    // Encode and decode whole arrays of cardinal types without xdr_array()
+    static void encode_array(const char *val, unsigned int num, int width, Type type, char *dest);
+    static void decode_array(const char *src, unsigned int num, int width, char *val);
 } ;
 
 } // namespace libdap
@@ -92,16 +92,14 @@ using namespace libdap ;
 
 #define YYERROR_VERBOSE 0
 
-int ce_exprlex(void);           /* the scanner; see expr.lex */
-
 // NB: never pass a variable name or other string from the CE to these functions.
 // Only string literals are allowed. This is to prevent information in the CE that
 // could be an attack from being transferred to the error response and then
 // rendered/run by a browser (an XSS attack). jhrg 4/14/20
 void ce_exprerror(const string &s);
-// Some automatic invocations of yyerror pass ce_parser_arg. It is ignored in this
-// function, however. jhrg 4/14/20
-void ce_exprerror(ce_parser_arg *arg, const string &s);
+// Some automatic invocations of yyerror pass ce_parser_arg and the scanner. They
+// are ignored in this function, however. jhrg 4/14/20
+void ce_exprerror(ce_parser_arg *arg, void *scanner, const string &s);
 void no_such_ident(const string &thing);
 
 void no_such_func();
@@ -146,7 +144,12 @@ rvalue *build_constant_array(vector<t> *values, DDS *dds);
 
 %require "2.4"
 
+// The parser and the scanner (see ce_expr.lex) are reentrant; the scanner's
+// state is passed to the parser along with the ConstraintEvaluator and DDS.
+%define api.pure
 %parse-param {ce_parser_arg *arg}
+%parse-param {void *scanner}
+%lex-param {void *scanner}
 %define api.prefix {ce_expr}
 // %name-prefix "ce_expr"
 %defines
@@ -243,9 +246,8 @@ rvalue *build_constant_array(vector<t> *values, DDS *dds);
 %type <float64_values> fast_float64_arg_list
 
 %code {
-/* This global is used by the rule 'arg_length_hint' so that the hint can
-   be used during the parent rule's parse. See fast_int32_arg_list. */
-unsigned long arg_length_hint_value = 0;
+/* The scanner; see ce_expr.lex */
+int ce_exprlex(CE_EXPRSTYPE *lvalp, void *scanner);
 }
 
 %%
@@ -320,8 +322,8 @@ proj_clause: name
 }
 ;
 
-/* The value parsed by arg_length_hint is stored in a global variable by that rule
-   so that it can be used during the parse of fast_byte_arg_list. */
+/* The value parsed by arg_length_hint is stored in the parser's argument by that
+   rule so that it can be used during the parse of fast_byte_arg_list. */
 
 /* return a rvalue */
 array_const_special_form: SCAN_HASH_BYTE '(' arg_length_hint ':' fast_byte_arg_list ')'
@@ -373,15 +375,16 @@ array_const_special_form: SCAN_HASH_FLOAT64 '(' arg_length_hint ':' fast_float64
 }
 ;
 
-/* Here the arg length hint is stored in a global so it can be used by the
-   function that allocates the vector. The value is passed to vector::reserve(). */
+/* Here the arg length hint is stored in the parser's argument so it can be used
+   by the function that allocates the vector. The value is passed to
+   vector::reserve(). */
 
 arg_length_hint: SCAN_WORD
 {
     if (!check_int32($1))
         throw Error(malformed_expr, "$<type>(hint, value, ...) special form expected hint to be an integer");
 
-    arg_length_hint_value = atoi($1);
+    arg->set_arg_length_hint(atoi($1));
     $$ = true;
 }
 ;
@@ -389,7 +392,7 @@ arg_length_hint: SCAN_WORD
 /* return an int_arg_list (a std::vector<int>*) */
 fast_byte_arg_list: fast_byte_arg
 {
-    $$ = make_fast_arg_list<byte_arg_list, dods_byte>(arg_length_hint_value, $1);
+    $$ = make_fast_arg_list<byte_arg_list, dods_byte>(arg->get_arg_length_hint(), $1);
 }
 | fast_byte_arg_list ',' fast_byte_arg
 {
@@ -408,7 +411,7 @@ fast_byte_arg: SCAN_WORD
 /* return an int_arg_list (a std::vector<int>*) */
 fast_int16_arg_list: fast_int16_arg
 {
-    $$ = make_fast_arg_list<int16_arg_list, dods_int16>(arg_length_hint_value, $1);
+    $$ = make_fast_arg_list<int16_arg_list, dods_int16>(arg->get_arg_length_hint(), $1);
 }
 | fast_int16_arg_list ',' fast_int16_arg
 {
@@ -427,7 +430,7 @@ fast_int16_arg: SCAN_WORD
 /* return an int_arg_list (a std::vector<int>*) */
 fast_uint16_arg_list: fast_uint16_arg
 {
-    $$ = make_fast_arg_list<uint16_arg_list, dods_uint16>(arg_length_hint_value, $1);
+    $$ = make_fast_arg_list<uint16_arg_list, dods_uint16>(arg->get_arg_length_hint(), $1);
 }
 | fast_uint16_arg_list ',' fast_uint16_arg
 {
@@ -446,7 +449,7 @@ fast_uint16_arg: SCAN_WORD
 /* return an int_arg_list (a std::vector<int>*) */
 fast_int32_arg_list: fast_int32_arg
 {
-    $$ = make_fast_arg_list<int32_arg_list, dods_int32>(arg_length_hint_value, $1);
+    $$ = make_fast_arg_list<int32_arg_list, dods_int32>(arg->get_arg_length_hint(), $1);
 }
 | fast_int32_arg_list ',' fast_int32_arg
 {
@@ -465,7 +468,7 @@ fast_int32_arg: SCAN_WORD
 /* return an int_arg_list (a std::vector<int>*) */
 fast_uint32_arg_list: fast_uint32_arg
 {
-    $$ = make_fast_arg_list<uint32_arg_list, dods_uint32>(arg_length_hint_value, $1);
+    $$ = make_fast_arg_list<uint32_arg_list, dods_uint32>(arg->get_arg_length_hint(), $1);
 }
 | fast_uint32_arg_list ',' fast_uint32_arg
 {
@@ -484,7 +487,7 @@ fast_uint32_arg: SCAN_WORD
 /* return an int_arg_list (a std::vector<int>*) */
 fast_float32_arg_list: fast_float32_arg
 {
-    $$ = make_fast_arg_list<float32_arg_list, dods_float32>(arg_length_hint_value, $1);
+    $$ = make_fast_arg_list<float32_arg_list, dods_float32>(arg->get_arg_length_hint(), $1);
 }
 | fast_float32_arg_list ',' fast_float32_arg
 {
@@ -503,7 +506,7 @@ fast_float32_arg: SCAN_WORD
 /* return an int_arg_list (a std::vector<int>*) */
 fast_float64_arg_list: fast_float64_arg
 {
-    $$ = make_fast_arg_list<float64_arg_list, dods_float64>(arg_length_hint_value, $1);
+    $$ = make_fast_arg_list<float64_arg_list, dods_float64>(arg->get_arg_length_hint(), $1);
 }
 | fast_float64_arg_list ',' fast_float64_arg
 {
@@ -925,7 +928,7 @@ ce_exprerror(const string &s)
     throw Error(malformed_expr, string("Constraint expression parse error: ").append(s));
 }
 
-void ce_exprerror(ce_parser_arg *, const string &s)
+void ce_exprerror(ce_parser_arg *, void *, const string &s)
 {
     throw Error(malformed_expr, string("Constraint expression parse error: ").append(s));
 }
@@ -1462,10 +1465,11 @@ rvalue *build_constant_array(vector<t> *values, DDS *dds)
     delete values;
     array->set_read_p(true);
 
-    static unsigned long counter = 1;
+    // Shared by the parsers running in different threads
+    static unsigned long counter = 0;
     string name;
     do {
-        name = "g" + long_to_string(counter++);
+        name = "g" + long_to_string(__sync_add_and_fetch(&counter, 1));
     } while (dds->var(name));
     array->set_name(name);
 
@@ -9,10 +9,12 @@ struct ce_parser_arg
 {
     ConstraintEvaluator *eval;
     DDS *dds;
+    // Set by the rule 'arg_length_hint' for the array special form
+    unsigned long arg_length_hint;
 
-    ce_parser_arg() : eval(0), dds(0)
+    ce_parser_arg() : eval(0), dds(0), arg_length_hint(0)
     {}
-    ce_parser_arg(ConstraintEvaluator *e, DDS *d) : eval(e), dds(d)
+    ce_parser_arg(ConstraintEvaluator *e, DDS *d) : eval(e), dds(d), arg_length_hint(0)
     {}
     virtual ~ce_parser_arg()
     {}
@@ -34,6 +36,15 @@ struct ce_parser_arg
     {
         dds = obj;
     }
+
+    unsigned long get_arg_length_hint()
+    {
+        return arg_length_hint;
+    }
+    void set_arg_length_hint(unsigned long hint)
+    {
+        arg_length_hint = hint;
+    }
 };
 
 } // namespace libdap
@@ -0,0 +1,388 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <arpa/inet.h>
+
+#include <cstring>
+
+#if HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+#if HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#include "chunked_codec.h"
+
+using namespace std;
+
+namespace libdap {
+
+/**
+ * @brief Can chunks be compressed (and decompressed) using this codec?
+ * @param codec The codec
+ * @return True if this build of the library supports the codec
+ */
+bool chunk_codec_available(chunk_codec codec)
+{
+    switch (codec) {
+    case chunk_codec_none:
+        return true;
+    case chunk_codec_zlib:
+#if HAVE_LIBZ
+        return true;
+#else
+        return false;
+#endif
+    case chunk_codec_lz4:
+#if HAVE_LZ4
+        return true;
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Compress the body of a chunk
+ *
+ * The compressed body written to \e dest starts with the size of the
+ * uncompressed data, in network byte order.
+ *
+ * @param codec Use this codec
+ * @param level The compression level; -1 for the codec's default. Only
+ * zlib uses this.
+ * @param src The chunk body
+ * @param src_len The number of bytes in \e src
+ * @param dest Value-result parameter; the compressed body. Resized as needed.
+ * @return The size of the compressed body, or zero if the codec is not
+ * available or the compressed body is not smaller than \e src_len.
+ */
+uint32_t chunk_compress(chunk_codec codec, int level, const char *src, uint32_t src_len, vector<char> &dest)
+{
+    uint32_t size = htonl(src_len);
+    uint32_t compressed_len = 0;
+
+    switch (codec) {
+#if HAVE_LIBZ
+    case chunk_codec_zlib: {
+        uLongf len = compressBound(src_len);
+        dest.resize(sizeof(uint32_t) + len);
+        if (compress2(reinterpret_cast<Bytef*>(&dest[sizeof(uint32_t)]), &len,
+            reinterpret_cast<const Bytef*>(src), src_len, level) != Z_OK)
+            return 0;
+        compressed_len = len;
+        break;
+    }
+#endif
+#if HAVE_LZ4
+    case chunk_codec_lz4: {
+        int len = LZ4_compressBound(src_len);
+        dest.resize(sizeof(uint32_t) + len);
+        len = LZ4_compress_default(src, &dest[sizeof(uint32_t)], src_len, len);
+        if (len <= 0)
+            return 0;
+        compressed_len = len;
+        break;
+    }
+#endif
+    default:
+        return 0;
+    }
+
+    if (sizeof(uint32_t) + compressed_len >= src_len)
+        return 0;
+
+    memcpy(&dest[0], &size, sizeof(uint32_t));
+    return sizeof(uint32_t) + compressed_len;
+}
+
+/**
+ * @brief The size of a compressed chunk's body once it is decompressed
+ * @param src The compressed chunk body
+ * @param src_len The number of bytes in \e src
+ * @return The uncompressed size, or zero if \e src is too short.
+ */
+uint32_t chunk_uncompressed_size(const char *src, uint32_t src_len)
+{
+    if (src_len < sizeof(uint32_t))
+        return 0;
+
+    uint32_t size;
+    memcpy(&size, src, sizeof(uint32_t));
+    return ntohl(size);
+}
+
+/**
+ * @brief Decompress the body of a chunk
+ *
+ * @param header The chunk header, in host byte order; the codec bits are
+ * used to choose the codec
+ * @param src The compressed chunk body
+ * @param src_len The number of bytes in \e src
+ * @param dest Write the uncompressed data here
+ * @param dest_len The size of \e dest; must equal the uncompressed size
+ * @return True if the data were decompressed, false otherwise.
+ */
+bool chunk_decompress(uint32_t header, const char *src, uint32_t src_len, char *dest, uint32_t dest_len)
+{
+    if (src_len < sizeof(uint32_t) || chunk_uncompressed_size(src, src_len) != dest_len)
+        return false;
+
+    src += sizeof(uint32_t);
+    src_len -= sizeof(uint32_t);
+
+    switch (header & CHUNK_CODEC_MASK) {
+#if HAVE_LIBZ
+    case CHUNK_ZLIB: {
+        uLongf len = dest_len;
+        return uncompress(reinterpret_cast<Bytef*>(dest), &len, reinterpret_cast<const Bytef*>(src), src_len) == Z_OK
+            && len == dest_len;
+    }
+#endif
+#if HAVE_LZ4
+    case CHUNK_LZ4:
+        return LZ4_decompress_safe(src, dest, src_len, dest_len) == (int) dest_len;
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Decompress the body of a chunk
+ * @param header The chunk header, in host byte order
+ * @param src The compressed chunk body
+ * @param src_len The number of bytes in \e src
+ * @param dest Value-result parameter; the uncompressed data. Resized to fit.
+ * @return True if the data were decompressed, false otherwise.
+ */
+bool chunk_decompress(uint32_t header, const char *src, uint32_t src_len, vector<char> &dest)
+{
+    uint32_t len = chunk_uncompressed_size(src, src_len);
+    if (len == 0 || len > CHUNK_SIZE_MAX)
+        return false;
+
+    dest.resize(len);
+    return chunk_decompress(header, src, src_len, &dest[0], len);
+}
+
+/**
+ * @brief Did the client say it can read chunks that use this feature?
+ *
+ * @param features The value of the CHUNK_FEATURES_HEADER request header, a
+ * comma separated list; empty if the request did not have the header
+ * @param feature The feature, e.g., CHUNK_FEATURE_FILTERED
+ * @return True if \c feature is in the list
+ */
+bool chunk_feature_accepted(const string &features, const string &feature)
+{
+    string::size_type pos = 0;
+    while (pos <= features.length()) {
+        string::size_type end = features.find(',', pos);
+        if (end == string::npos)
+            end = features.length();
+
+        string::size_type first = features.find_first_not_of(" \t", pos);
+        string::size_type last = features.find_last_not_of(" \t", end == 0 ? 0 : end - 1);
+        if (first < end && last != string::npos && last >= first
+            && features.compare(first, last - first + 1, feature) == 0)
+            return true;
+
+        pos = end + 1;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Can chunks sent to this client be compressed with this codec?
+ *
+ * @param features The value of the CHUNK_FEATURES_HEADER request header
+ * @param codec The codec
+ * @return True if \e codec is chunk_codec_none, or if this build of the
+ * library supports \e codec and the client listed it (CHUNK_FEATURE_ZLIB
+ * or CHUNK_FEATURE_LZ4).
+ */
+bool chunk_codec_accepted(const string &features, chunk_codec codec)
+{
+    switch (codec) {
+    case chunk_codec_none:
+        return true;
+    case chunk_codec_zlib:
+        return chunk_codec_available(codec) && chunk_feature_accepted(features, CHUNK_FEATURE_ZLIB);
+    case chunk_codec_lz4:
+        return chunk_codec_available(codec) && chunk_feature_accepted(features, CHUNK_FEATURE_LZ4);
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief The features a client using this library can read
+ *
+ * D4StreamUnMarshaller reads filtered arrays and chunked_istream
+ * decompresses chunks using the codecs this build supports.
+ *
+ * @return The value for the CHUNK_FEATURES_HEADER request header
+ */
+string chunk_client_features()
+{
+    string features = CHUNK_FEATURE_FILTERED;
+    if (chunk_codec_available(chunk_codec_zlib))
+        features.append(",").append(CHUNK_FEATURE_ZLIB);
+    if (chunk_codec_available(chunk_codec_lz4))
+        features.append(",").append(CHUNK_FEATURE_LZ4);
+
+    return features;
+}
+
+// Apply the delta filter (if 'delta') and then the shuffle filter (if
+// 'shuffle') in one pass over the values. The buffers need not be aligned
+// for T, so the values are copied in and out using memcpy.
+template<typename T>
+static void encode_values(const char *src, char *dest, int64_t num, bool delta, bool shuffle)
+{
+    T prev = 0;
+    for (int64_t i = 0; i < num; ++i) {
+        T in;
+        memcpy(&in, src + i * sizeof(T), sizeof(T));
+        T v = delta ? (T) (in - prev) : in;
+        prev = in;
+        if (shuffle) {
+            const char *b = reinterpret_cast<const char*>(&v);
+            for (unsigned int j = 0; j < sizeof(T); ++j)
+                dest[j * num + i] = b[j];
+        }
+        else {
+            memcpy(dest + i * sizeof(T), &v, sizeof(T));
+        }
+    }
+}
+
+template<typename T>
+static void undelta_values(char *buf, int64_t num)
+{
+    if (num < 2)
+        return;
+
+    T prev;
+    memcpy(&prev, buf, sizeof(T));
+    for (int64_t i = 1; i < num; ++i) {
+        T v;
+        memcpy(&v, buf + i * sizeof(T), sizeof(T));
+        prev = (T) (v + prev);
+        memcpy(buf + i * sizeof(T), &prev, sizeof(T));
+    }
+}
+
+/**
+ * @brief Apply pre-filters to an array of values
+ *
+ * The delta filter treats the values as unsigned integers and uses modular
+ * arithmetic, so it is lossless for any type, including floating point.
+ *
+ * @param src The values
+ * @param dest Write the filtered values here; the same size as \e src and
+ * not the same memory.
+ * @param num_elem The number of values
+ * @param width The size of a value. The filters are only applied when this
+ * is 2, 4 or 8; otherwise the values are copied as is.
+ * @param filters Zero or more vector_filter values ORed together
+ */
+void vector_filter_encode(const char *src, char *dest, int64_t num_elem, int width, unsigned int filters)
+{
+    bool delta = filters & vector_filter_delta;
+    bool shuffle = filters & vector_filter_shuffle;
+
+    if (!delta && !shuffle) {
+        memcpy(dest, src, num_elem * width);
+        return;
+    }
+
+    switch (width) {
+    case 2:
+        encode_values<uint16_t>(src, dest, num_elem, delta, shuffle);
+        break;
+    case 4:
+        encode_values<uint32_t>(src, dest, num_elem, delta, shuffle);
+        break;
+    case 8:
+        encode_values<uint64_t>(src, dest, num_elem, delta, shuffle);
+        break;
+    default:
+        memcpy(dest, src, num_elem * width);
+        break;
+    }
+}
+
+/**
+ * @brief Undo the shuffle filter
+ * @param buf The shuffled values; replaced by the values
+ * @param num_elem The number of values
+ * @param width The size of a value
+ */
+void vector_unshuffle(char *buf, int64_t num_elem, int width)
+{
+    if (num_elem < 2 || width < 2)
+        return;
+
+    vector<char> shuffled(buf, buf + num_elem * width);
+    for (int j = 0; j < width; ++j) {
+        const char *plane = &shuffled[j * num_elem];
+        for (int64_t i = 0; i < num_elem; ++i)
+            buf[i * width + j] = plane[i];
+    }
+}
+
+/**
+ * @brief Undo the delta filter
+ * The values must be in this host's byte order.
+ * @param buf The differences; replaced by the values
+ * @param num_elem The number of values
+ * @param width The size of a value; 2, 4 or 8
+ */
+void vector_undelta(char *buf, int64_t num_elem, int width)
+{
+    switch (width) {
+    case 2:
+        undelta_values<uint16_t>(buf, num_elem);
+        break;
+    case 4:
+        undelta_values<uint32_t>(buf, num_elem);
+        break;
+    case 8:
+        undelta_values<uint64_t>(buf, num_elem);
+        break;
+    default:
+        break;
+    }
+}
+
+} // namespace libdap
@@ -0,0 +1,83 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#ifndef _chunked_codec_h
+#define _chunked_codec_h
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "chunked_stream.h"
+
+namespace libdap {
+
+/**
+ * The codecs that can be used to compress the body of a DAP4 chunk. The
+ * values are the bits set in the chunk header.
+ */
+enum chunk_codec {
+    chunk_codec_none = 0,
+    chunk_codec_zlib = CHUNK_ZLIB,
+    chunk_codec_lz4 = CHUNK_LZ4
+};
+
+// Don't try to compress chunk bodies smaller than this
+#define CHUNK_MIN_COMPRESS 64
+
+bool chunk_codec_available(chunk_codec codec);
+
+uint32_t chunk_compress(chunk_codec codec, int level, const char *src, uint32_t src_len, std::vector<char> &dest);
+bool chunk_decompress(uint32_t header, const char *src, uint32_t src_len, std::vector<char> &dest);
+bool chunk_decompress(uint32_t header, const char *src, uint32_t src_len, char *dest, uint32_t dest_len);
+
+uint32_t chunk_uncompressed_size(const char *src, uint32_t src_len);
+
+/**
+ * Pre-filters for arrays of 2, 4 or 8 byte values. They make the data
+ * compress better: 'delta' replaces each value with its difference from the
+ * value before it and 'shuffle' groups the first bytes of all the values,
+ * then the second bytes, and so on. When both are used, delta is applied
+ * first. The values are a bit mask.
+ */
+enum vector_filter {
+    vector_filter_none = 0,
+    vector_filter_shuffle = 1,
+    vector_filter_delta = 2
+};
+
+#define VECTOR_FILTER_MASK 0x03
+
+bool chunk_feature_accepted(const std::string &features, const std::string &feature);
+bool chunk_codec_accepted(const std::string &features, chunk_codec codec);
+std::string chunk_client_features();
+
+void vector_filter_encode(const char *src, char *dest, int64_t num_elem, int width, unsigned int filters);
+void vector_unshuffle(char *buf, int64_t num_elem, int width);
+void vector_undelta(char *buf, int64_t num_elem, int width);
+
+} // namespace libdap
+
+#endif // _chunked_codec_h
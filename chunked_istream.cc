@@ -29,12 +29,16 @@
 
 #include <stdint.h>
 #include <arpa/inet.h>
+#include <pthread.h>
 
+#include <algorithm>
 #include <cstring>
+#include <deque>
 #include <vector>
 
 #include "chunked_stream.h"
 #include "chunked_istream.h"
+#include "chunked_codec.h"
 
 #include "Error.h"
 
@@ -72,108 +76,456 @@ namespace libdap {
  */
 
 /**
- * @brief Insert new characters into the buffer
- * This specialization of underflow is called when the gptr() is advanced to
- * the end of the input buffer. At that point it calls the underlying I/O stream
- * to read the next chunk of data and transfers the data read to the internal
- * buffer. If an error is found, EOF is returned. If an END chunk with zero
- * bytes is found, an EOF is returned.
- * @return The character at the gptr() or EOF
+ * @brief State shared by a chunked_inbuf and its read-ahead thread
+ *
+ * The thread reads whole chunks from the underlying stream and queues them
+ * in \c ready; the chunked_inbuf takes them from the queue. The buffer of
+ * the chunk the chunked_inbuf is using is \c current. Chunks that have been
+ * used are kept in \c free_chunks so their memory can be reused.
  */
-std::streambuf::int_type
-chunked_inbuf::underflow()
-{
-    DBG(cerr << "underflow..." << endl);
-    DBG2(cerr << "eback(): " << (void*)eback() << ", gptr(): " << (void*)(gptr()-eback()) << ", egptr(): " << (void*)(egptr()-eback()) << endl);
+struct chunked_read_ahead {
+	struct chunk {
+		uint32_t header;		// in host byte order
+		std::vector<char> data;
+	};
+
+	std::istream &is;
+	unsigned int depth;		// The most chunks in 'ready'
+
+	// The rest of a chunk that was started before the thread was
+	uint32_t first_left;
+	bool first_end;
+
+	std::deque<chunk*> ready;
+	std::vector<chunk*> free_chunks;
+	chunk *current;
+
+	bool stop;				// Set to stop the thread
+	bool done;				// Set by the thread when it stops
+
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t ready_cond;	// signaled when a chunk is added to 'ready' or 'done' is set
+	pthread_cond_t space_cond;	// signaled when a chunk is removed from 'ready' or 'stop' is set
+
+	chunked_read_ahead(std::istream &s, unsigned int d, uint32_t left, bool end) :
+		is(s), depth(d), first_left(left), first_end(end), current(0), stop(false), done(false) {
+		pthread_mutex_init(&mutex, 0);
+		pthread_cond_init(&ready_cond, 0);
+		pthread_cond_init(&space_cond, 0);
+	}
 
-	// return the next character; uflow() increments the puffer pointer.
-	if (gptr() < egptr())
-		return traits_type::to_int_type(*gptr());
+	~chunked_read_ahead() {
+		for (std::deque<chunk*>::iterator i = ready.begin(), e = ready.end(); i != e; ++i)
+			delete *i;
+		for (std::vector<chunk*>::iterator i = free_chunks.begin(), e = free_chunks.end(); i != e; ++i)
+			delete *i;
+		delete current;
+
+		pthread_cond_destroy(&space_cond);
+		pthread_cond_destroy(&ready_cond);
+		pthread_mutex_destroy(&mutex);
+	}
+
+	std::vector<char> uncompressed;	// Used by the thread
 
-	// gptr() == egptr() so read more data from the underlying input source.
+	bool m_read_chunk(chunk *c, bool first);
+	void m_decompress(chunk *c);
+};
 
-	// To read data from the chunked stream, first read the header
+/**
+ * @brief Read one chunk from the underlying stream
+ * Called only by the read-ahead thread.
+ * @return False if nothing (or only part of a chunk) could be read
+ */
+bool
+chunked_read_ahead::m_read_chunk(chunk *c, bool first)
+{
 	uint32_t header;
-	d_is.read((char *) &header, 4);
+	if (first) {
+		header = first_left | (first_end ? CHUNK_END : CHUNK_DATA);
+	}
+	else {
+		is.read((char *) &header, 4);
+		if (is.eof() || is.bad()) return false;
+		header = ntohl(header);
+	}
 
-	// When the endian nature of the server is encoded in the chunk header, the header is
-	// sent using network byte order
-	header = ntohl(header);
+	uint32_t chunk_size = header & CHUNK_SIZE_MASK;
+	c->header = header;
+	c->data.resize(chunk_size);
+	if (chunk_size > 0) {
+		is.read(&c->data[0], chunk_size);
+		if (is.bad() || (uint32_t) is.gcount() != chunk_size) {
+			c->data.resize(is.bad() ? 0 : is.gcount());
+			return false;
+		}
+	}
 
-	// There are two 'EOF' cases: One where the END chunk is zero bytes and one where
-	// it holds data. In the latter case, bytes those will be read and moved into the
-	// buffer. Once those data are consumed, we'll be back here again and this read()
-	// will return EOF. See below for the other case...
-	if (d_is.eof()) return traits_type::eof();
+	return true;
+}
 
-	// (header & CHUNK_LITTLE_ENDIAN) --> is the sender little endian
-	if (!d_set_twiddle) {
-	    d_twiddle_bytes = (is_host_big_endian() == (header & CHUNK_LITTLE_ENDIAN));
-	    d_set_twiddle = true;
+/**
+ * @brief Decompress a compressed chunk
+ * Replace the body of a compressed chunk with the uncompressed data and
+ * fix its header. If the chunk cannot be decompressed, it becomes an
+ * error chunk. Called only by the read-ahead thread.
+ */
+void
+chunked_read_ahead::m_decompress(chunk *c)
+{
+	if (!(c->header & CHUNK_CODEC_MASK) || (c->header & CHUNK_TYPE_MASK) == CHUNK_ERR)
+		return;
+
+	if (c->data.empty() || !chunk_decompress(c->header, &c->data[0], c->data.size(), uncompressed)) {
+		std::string msg = "Could not decompress a chunk.";
+		c->data.assign(msg.begin(), msg.end());
+		c->header = CHUNK_ERR | msg.size();
+		return;
 	}
 
-	uint32_t chunk_size = header & CHUNK_SIZE_MASK;
+	c->data.swap(uncompressed);
+	c->header = (c->header & ~(CHUNK_CODEC_MASK | CHUNK_SIZE_MASK)) | c->data.size();
+}
 
-	DBG(cerr << "underflow: chunk size from header: " << chunk_size << endl);
-	DBG(cerr << "underflow: chunk type from header: " << hex << (header & CHUNK_TYPE_MASK) << endl);
-	DBG(cerr << "underflow: chunk byte order from header: " << hex << (header & CHUNK_BIG_ENDIAN) << endl);
+static void *
+read_chunks(void *arg)
+{
+	chunked_read_ahead *ra = static_cast<chunked_read_ahead*>(arg);
+	bool first = ra->first_left > 0;
+
+	while (true) {
+		pthread_mutex_lock(&ra->mutex);
+		while (ra->ready.size() >= ra->depth && !ra->stop)
+			pthread_cond_wait(&ra->space_cond, &ra->mutex);
+		if (ra->stop) {
+			pthread_mutex_unlock(&ra->mutex);
+			break;
+		}
 
-	// Handle the case where the buffer is not big enough to hold the incoming chunk
-	if (chunk_size > d_buf_size) {
-		d_buf_size = chunk_size;
-		m_buffer_alloc();
+		chunked_read_ahead::chunk *c;
+		if (ra->free_chunks.empty()) {
+			c = new chunked_read_ahead::chunk;
+		}
+		else {
+			c = ra->free_chunks.back();
+			ra->free_chunks.pop_back();
+		}
+		pthread_mutex_unlock(&ra->mutex);
+
+		bool ok;
+		try {
+			ok = ra->m_read_chunk(c, first);
+			// Decompress here, while the caller is using the previous chunk
+			if (ok) ra->m_decompress(c);
+		}
+		catch (...) {
+			ok = false;
+		}
+		first = false;
+
+		// A partial chunk is passed on so the reader sees what was sent
+		if (!ok && c->data.empty()) {
+			delete c;
+			break;
+		}
+
+		pthread_mutex_lock(&ra->mutex);
+		ra->ready.push_back(c);
+		pthread_cond_signal(&ra->ready_cond);
+		pthread_mutex_unlock(&ra->mutex);
+
+		// Stop after the END or ERROR chunk; there's nothing more to read
+		if (!ok || (c->header & CHUNK_TYPE_MASK) != CHUNK_DATA)
+			break;
 	}
 
-	// If the END chunk has zero bytes, return EOF. See above for more information
-	if (chunk_size == 0 && (header & CHUNK_TYPE_MASK) == CHUNK_END) return traits_type::eof();
+	pthread_mutex_lock(&ra->mutex);
+	ra->done = true;
+	pthread_cond_broadcast(&ra->ready_cond);
+	pthread_mutex_unlock(&ra->mutex);
 
-	// Read the chunk's data
-	d_is.read(d_buffer, chunk_size);
-	DBG2(cerr << "underflow: size read: " << d_is.gcount() << ", eof: " << d_is.eof() << ", bad: " << d_is.bad() << endl);
-	if (d_is.bad()) return traits_type::eof();
+	return 0;
+}
 
-	DBG2(cerr << "eback(): " << (void*)eback() << ", gptr(): " << (void*)(gptr()-eback()) << ", egptr(): " << (void*)(egptr()-eback()) << endl);
-	setg(d_buffer, 						// beginning of put back area
-			d_buffer,                	// read position (gptr() == eback())
-			d_buffer + chunk_size);  	// end of buffer (egptr()) chunk_size == d_is.gcount() unless there's an error
+chunked_inbuf::~chunked_inbuf()
+{
+	m_stop_read_ahead();
 
-	DBG2(cerr << "eback(): " << (void*)eback() << ", gptr(): " << (void*)(gptr()-eback()) << ", egptr(): " << (void*)(egptr()-eback()) << endl);
+	delete[] d_buffer;
+}
+
+/**
+ * @brief Read the following chunks using a second thread
+ *
+ * Start a thread that reads chunks from the underlying stream and holds
+ * up to \c depth of them for this object. If part of the current chunk
+ * has not been read yet, the thread reads that first. If the thread cannot
+ * be started, chunks are read as before.
+ *
+ * @param depth The number of chunks to read ahead
+ */
+void
+chunked_inbuf::start_read_ahead(unsigned int depth)
+{
+	if (d_read_ahead) return;
+
+	chunked_read_ahead *ra = new chunked_read_ahead(d_is, std::max(depth, 1U), d_chunk_left, d_end_chunk);
+	if (pthread_create(&ra->thread, 0, read_chunks, ra) != 0) {
+		DBG(cerr << "chunked_inbuf::start_read_ahead: could not start a thread" << endl);
+		delete ra;
+		return;
+	}
+
+	d_read_ahead = ra;
+	d_chunk_left = 0;
+}
+
+/**
+ * @brief Stop the read-ahead thread
+ * The thread stops once the chunk it is reading (if any) has been read. The
+ * read is not interrupted, so if it is blocked waiting for data this waits
+ * too, until the read returns.
+ */
+void
+chunked_inbuf::m_stop_read_ahead()
+{
+	if (!d_read_ahead) return;
+
+	pthread_mutex_lock(&d_read_ahead->mutex);
+	d_read_ahead->stop = true;
+	pthread_cond_broadcast(&d_read_ahead->space_cond);
+	pthread_mutex_unlock(&d_read_ahead->mutex);
+
+	pthread_join(d_read_ahead->thread, 0);
+
+	setg(d_buffer, d_buffer, d_buffer);
+
+	delete d_read_ahead;
+	d_read_ahead = 0;
+}
+
+/**
+ * @brief Get the next chunk from the read-ahead thread
+ * Wait for the next chunk and make its data the contents of the buffer. The
+ * data of the previous chunk are released.
+ * @param header Value-result parameter; the chunk's header
+ * @return False if there are no more chunks
+ */
+bool
+chunked_inbuf::m_next_read_ahead_chunk(uint32_t &header)
+{
+	chunked_read_ahead *ra = d_read_ahead;
+
+	pthread_mutex_lock(&ra->mutex);
+
+	if (ra->current) {
+		ra->free_chunks.push_back(ra->current);
+		ra->current = 0;
+	}
+
+	while (ra->ready.empty() && !ra->done)
+		pthread_cond_wait(&ra->ready_cond, &ra->mutex);
+
+	if (ra->ready.empty()) {
+		pthread_mutex_unlock(&ra->mutex);
+		setg(d_buffer, d_buffer, d_buffer);
+		return false;
+	}
+
+	ra->current = ra->ready.front();
+	ra->ready.pop_front();
+	pthread_cond_signal(&ra->space_cond);
+
+	pthread_mutex_unlock(&ra->mutex);
+
+	header = ra->current->header;
+	char *data = ra->current->data.empty() ? d_buffer : &ra->current->data[0];
+	setg(data, data, data + ra->current->data.size());
+
+	return true;
+}
+
+/**
+ * @brief Read the next chunk header
+ * Read a chunk header and record the size and type of the chunk. The chunk's
+ * data are not read, unless the chunk is compressed; then the data are read
+ * and decompressed into the buffer. If the chunk is an error chunk, the error
+ * message is read and saved.
+ * @return The number of (uncompressed) bytes in the chunk, or EOF at the end
+ * of the underlying stream or when an error chunk is found.
+ */
+std::streambuf::int_type
+chunked_inbuf::m_read_header()
+{
+	uint32_t header;
+	if (d_read_ahead) {
+		// The chunk's data are in the buffer once this returns
+		if (!m_next_read_ahead_chunk(header)) return traits_type::eof();
+	}
+	else {
+		d_is.read((char *) &header, 4);
+
+		// When the endian nature of the server is encoded in the chunk header, the header is
+		// sent using network byte order
+		header = ntohl(header);
+
+		// There are two 'EOF' cases: One where the END chunk is zero bytes and one where
+		// it holds data. In the latter case, those bytes will be read by the caller. Once
+		// those data are consumed, we'll be back here again and this read() will return
+		// EOF. The callers handle the zero byte END chunk.
+		if (d_is.eof()) return traits_type::eof();
+	}
+
+	// (header & CHUNK_LITTLE_ENDIAN) --> is the sender little endian
+	if (!d_set_twiddle) {
+		d_twiddle_bytes = (is_host_big_endian() == (header & CHUNK_LITTLE_ENDIAN));
+		d_filtered = header & CHUNK_FILTERED;
+		d_set_twiddle = true;
+	}
+
+	uint32_t chunk_size = header & CHUNK_SIZE_MASK;
+
+	DBG(cerr << "m_read_header: chunk size from header: " << chunk_size << endl);
+	DBG(cerr << "m_read_header: chunk type from header: " << hex << (header & CHUNK_TYPE_MASK) << endl);
+	DBG(cerr << "m_read_header: chunk byte order from header: " << hex << (header & CHUNK_BIG_ENDIAN) << endl);
 
 	switch (header & CHUNK_TYPE_MASK) {
 	case CHUNK_END:
-		DBG2(cerr << "Found end chunk" << endl);
-		return traits_type::to_int_type(*gptr());
+		d_end_chunk = true;
+		break;
+
 	case CHUNK_DATA:
-		return traits_type::to_int_type(*gptr());
+		d_end_chunk = false;
+		break;
 
-	case CHUNK_ERR:
-		// this is pretty much the end of the show... Assume the buffer/chunk holds
-		// the error message text.
+	case CHUNK_ERR: {
+		// this is pretty much the end of the show... Note that d_buffer is not
+		// used to avoid calling resize if it is too small to hold the error message.
 		d_error = true;
-		d_error_message = string(d_buffer, chunk_size);
+		if (d_read_ahead) {
+			d_error_message = string(gptr(), egptr());
+		}
+		else {
+			std::vector<char> message(chunk_size);
+			if (chunk_size > 0) d_is.read(&message[0], chunk_size);
+			d_error_message = string(message.begin(), message.end());
+		}
+		// leave the buffer and gptr(), ..., in a consistent state (empty)
+		setg(d_buffer, d_buffer, d_buffer);
 		return traits_type::eof();
+	}
+
 	default:
 		d_error = true;
 		d_error_message = "Failed to read known chunk header type.";
 		return traits_type::eof();
 	}
+
+	// With read-ahead, the whole chunk is already in the buffer (and
+	// it has been decompressed)
+	if (d_read_ahead) {
+		d_chunk_left = 0;
+		return traits_type::not_eof(chunk_size);
+	}
+
+	// A compressed chunk is read whole and decompressed into the buffer
+	if (header & CHUNK_CODEC_MASK) {
+		d_compressed.resize(chunk_size);
+		if (chunk_size > 0) d_is.read(&d_compressed[0], chunk_size);
+		if (d_is.bad()) return traits_type::eof();
+
+		uint32_t size = chunk_size > 0 ? chunk_uncompressed_size(&d_compressed[0], chunk_size) : 0;
+		if (size > CHUNK_SIZE_MAX) size = 0;
+		if (size > d_buf_size) {
+			d_buf_size = size;
+			m_buffer_alloc();
+		}
+
+		if (size == 0 || !chunk_decompress(header, &d_compressed[0], chunk_size, d_buffer, size)) {
+			d_error = true;
+			d_error_message = "Could not decompress a chunk.";
+			setg(d_buffer, d_buffer, d_buffer);
+			return traits_type::eof();
+		}
+
+		setg(d_buffer, d_buffer, d_buffer + size);
+		d_chunk_left = 0;
+		return traits_type::not_eof(size);
+	}
+
+	d_chunk_left = chunk_size;
+	return traits_type::not_eof(chunk_size);
+}
+
+/**
+ * @brief Insert new characters into the buffer
+ * This specialization of underflow is called when the gptr() is advanced to
+ * the end of the input buffer. At that point it calls the underlying I/O stream
+ * to read more of the current chunk (or the next chunk) and transfers the data
+ * read to the internal buffer. If an error is found, EOF is returned. If an END
+ * chunk with zero bytes is found, an EOF is returned.
+ * @return The character at the gptr() or EOF
+ */
+std::streambuf::int_type
+chunked_inbuf::underflow()
+{
+    DBG(cerr << "underflow..." << endl);
+    DBG2(cerr << "eback(): " << (void*)eback() << ", gptr(): " << (void*)(gptr()-eback()) << ", egptr(): " << (void*)(egptr()-eback()) << endl);
+
+	// return the next character; uflow() increments the puffer pointer.
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	// gptr() == egptr() so read more data from the underlying input source. If
+	// the current chunk has been read, get the next one, skipping any zero length
+	// data chunks.
+	while (d_chunk_left == 0) {
+		int_type chunk_size = m_read_header();
+		if (chunk_size == traits_type::eof()) return traits_type::eof();
+
+		// If the END chunk has zero bytes, return EOF.
+		if (chunk_size == 0 && d_end_chunk) return traits_type::eof();
+
+		// With read-ahead or compression, the chunk's data are now in the buffer
+		if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+	}
+
+	// Read the chunk's data; no more than fits in the buffer.
+	uint32_t bytes = std::min(d_chunk_left, d_buf_size);
+	d_is.read(d_buffer, bytes);
+	DBG2(cerr << "underflow: size read: " << d_is.gcount() << ", eof: " << d_is.eof() << ", bad: " << d_is.bad() << endl);
+	if (d_is.bad()) return traits_type::eof();
+
+	d_chunk_left -= bytes;
+
+	setg(d_buffer, 						// beginning of put back area
+			d_buffer,                	// read position (gptr() == eback())
+			d_buffer + bytes);  		// end of buffer (egptr())
+
+	DBG2(cerr << "eback(): " << (void*)eback() << ", gptr(): " << (void*)(gptr()-eback()) << ", egptr(): " << (void*)(egptr()-eback()) << endl);
+
+	return traits_type::to_int_type(*gptr());
 }
 
 /**
  * @brief Read a block of data
  * This specialization of xsgetn() reads \c num bytes and puts them in \c s
- * first reading from the internal beffer and then from the stream. Any
- * characters read from the last chunk that won't fit in to \c s are put
- * in the buffer, otherwise all data are read directly into \c s, bypassing
- * the internal buffer (and the extra copy operation that would imply). If
- * the END chunk is found EOF is not returned and the final read of the
- * underlying stream is not made; the next call to read(), get(), ..., will
- * return EOF.
+ * first reading from the internal buffer and then from the stream. Data are
+ * read from the chunks directly into \c s, bypassing the internal buffer (and
+ * the extra copy operation that would imply); a read can cross any number of
+ * chunk boundaries. When \c s is filled part way through a chunk, the rest of
+ * that chunk is left in the underlying stream for the next read. If the END
+ * chunk is found, EOF is not returned and the final read of the underlying
+ * stream is not made; the next call to read(), get(), ..., will return EOF.
+ *
+ * This is the method used by istream::read(), so D4StreamUnMarshaller reads
+ * the values of an array directly into the array's buffer.
+ *
  * @param s Address of a buffer to hold the data
  * @param num Number of bytes to read
- * @return NUmber of bytes actually transferred into \c s. Note that this
- * number does not include the bytes read from the last chunk that won't
- * fit into \c s so this will never return a number greater than num.
+ * @return Number of bytes actually transferred into \c s or EOF if an error
+ * chunk was found. This will never return a number greater than num.
  */
 std::streamsize
 chunked_inbuf::xsgetn(char* s, std::streamsize num)
@@ -189,7 +541,7 @@ chunked_inbuf::xsgetn(char* s, std::streamsize num)
 	}
 
 	// else they asked for more
-	uint32_t bytes_left_to_read = num;
+	std::streamsize bytes_left_to_read = num;
 
 	// are there any bytes in the buffer? if so grab them first
 	if (gptr() < egptr()) {
@@ -200,121 +552,49 @@ chunked_inbuf::xsgetn(char* s, std::streamsize num)
 		bytes_left_to_read -= bytes_to_transfer;
 	}
 
-	// We need to get more bytes from the underlying stream; at this
-	// point the internal buffer is empty.
-
-	// read the remaining bytes to transfer, a chunk at a time,
-	// and put any leftover stuff in the buffer.
-
-	// note that when the code is here, gptr() == egptr(), so the
-	// next call to read() will fall through the previous tests and
-	// read at least one chunk here.
-	bool done = false;
-    while (!done) {
-        // Get a chunk header
-        uint32_t header;
-        d_is.read((char *) &header, 4);
-
-        header = ntohl(header);
-
-        // There are two EOF cases: One where the END chunk is zero bytes and one where
-        // it holds data. In the latter case, those will be read and moved into the
-        // buffer. Once those data are consumed, we'll be back here again and this read()
-        // will return EOF. See below for the other case...
-        if (d_is.eof()) return traits_type::eof();
-
-        // (header & CHUNK_LITTLE_ENDIAN) --> is the sender little endian
-        if (!d_set_twiddle) {
-            d_twiddle_bytes = (is_host_big_endian() == (header & CHUNK_LITTLE_ENDIAN));
-            d_set_twiddle = true;
-        }
-
-	    uint32_t chunk_size = header & CHUNK_SIZE_MASK;
-		DBG(cerr << "xsgetn: chunk size from header: " << chunk_size << endl);
-		DBG(cerr << "xsgetn: chunk type from header: " << hex << (header & CHUNK_TYPE_MASK) << endl);
-		DBG(cerr << "xsgetn: chunk byte order from header: " << hex << (header & CHUNK_BIG_ENDIAN) << endl);
-
-		// handle error chunks here
-	    if ((header & CHUNK_TYPE_MASK) == CHUNK_ERR) {
-			d_error = true;
-			// Note that d_buffer is not used to avoid calling resize if it is too
-			// small to hold the error message. At this point, there's not much reason
-			// to optimize transport efficiency, however.
-			std::vector<char> message(chunk_size);
-			d_is.read(&message[0], chunk_size);
-			d_error_message = string(&message[0], chunk_size);
-			// leave the buffer and gptr(), ..., in a consistent state (empty)
-			setg(d_buffer, d_buffer, d_buffer);
-	    }
-	    // And zero-length END chunks here.
-	    else if (chunk_size == 0 && (header & CHUNK_TYPE_MASK) == CHUNK_END) {
-	    	return traits_type::not_eof(num-bytes_left_to_read);
-	    }
-	    // The next case is complicated because we read some data from the current
-	    // chunk into 's' an some into the internal buffer.
-	    else if (chunk_size > bytes_left_to_read) {
-			d_is.read(s, bytes_left_to_read);
-			if (d_is.bad()) return traits_type::eof();
-
-			// Now slurp up the remain part of the chunk and store it in the buffer
-			uint32_t bytes_leftover = chunk_size - bytes_left_to_read;
-			// expand the internal buffer if needed
-		    if (bytes_leftover > d_buf_size) {
-		        d_buf_size = chunk_size;
-		        m_buffer_alloc();
-		    }
-		    // read the remain stuff in to d_buffer
-			d_is.read(d_buffer, bytes_leftover);
-			if (d_is.bad()) return traits_type::eof();
+	// The internal buffer is empty; read the rest of the bytes from the
+	// current chunk and then from the following chunks.
+	while (bytes_left_to_read > 0) {
+		if (d_chunk_left == 0 && gptr() == egptr()) {
+			int_type chunk_size = m_read_header();
+			if (chunk_size == traits_type::eof()) {
+				// At the end of the stream, return what was read; EOF
+				// signals an error chunk.
+				if (d_error) return traits_type::eof();
+				break;
+			}
 
-			setg(d_buffer, 										// beginning of put back area
-				 d_buffer,                						// read position (gptr() == eback())
-				 d_buffer + bytes_leftover /*d_is.gcount()*/); 	// end of buffer (egptr())
+			// And zero-length END chunks here.
+			if (chunk_size == 0 && d_end_chunk) break;
+		}
 
-			bytes_left_to_read = 0 /* -= d_is.gcount()*/;
+		if (gptr() < egptr()) {
+			// With read-ahead or compression, the chunk's data are in the buffer
+			uint32_t bytes = (uint32_t) std::min(bytes_left_to_read, (std::streamsize) (egptr() - gptr()));
+			memcpy(s, gptr(), bytes);
+			gbump(bytes);
+			s += bytes;
+			bytes_left_to_read -= bytes;
 		}
-		else {
-			// expand the internal buffer if needed
-		    if (chunk_size > d_buf_size) {
-		        d_buf_size = chunk_size;
-		        m_buffer_alloc();
-		    }
-		    // If we get a chunk that's zero bytes, Don't call read()
-		    // to save the kernel context switch overhead.
-			if (chunk_size > 0) {
-				d_is.read(s, chunk_size);
-				if (d_is.bad()) return traits_type::eof();
-				bytes_left_to_read -= chunk_size /*d_is.gcount()*/;
-				s += chunk_size;
-			}
+		else if (d_chunk_left > 0) {
+			uint32_t bytes = (uint32_t) std::min(bytes_left_to_read, (std::streamsize) d_chunk_left);
+			d_is.read(s, bytes);
+			if (d_is.bad()) return traits_type::eof();
+			s += bytes;
+			bytes_left_to_read -= bytes;
+			d_chunk_left -= bytes;
 		}
 
-	    switch (header & CHUNK_TYPE_MASK) {
-	    case CHUNK_END:
+		// in this case bytes_left_to_read can be > 0 because we ran out of data
+		// before reading all the requested bytes. The next read() call will return
+		// eof; this call returns the number of bytes read and transferred to 's'.
+		if (d_chunk_left == 0 && gptr() == egptr() && d_end_chunk) {
 			DBG(cerr << "Found end chunk" << endl);
-	    	// in this case bytes_left_to_read can be > 0 because we ran out of data
-	    	// before reading all the requested bytes. The next read() call will return
-	    	// eof; this call returns the number of bytes read and transferred to 's'.
-	    	done = true;
-	    	break;
-
-	    case CHUNK_DATA:
-	    	done = bytes_left_to_read == 0;
-	        break;
-
-	    case CHUNK_ERR:
-			// this is pretty much the end of the show... The error message has
-	    	// already been read above
-			return traits_type::eof();
-
-	    default:
-			d_error = true;
-			d_error_message = "Failed to read known chunk header type.";
-			return traits_type::eof();
-	    }
+			break;
+		}
 	}
 
-	return traits_type::not_eof(num-bytes_left_to_read);
+	return traits_type::not_eof(num - bytes_left_to_read);
 }
 
 /**
@@ -323,8 +603,8 @@ chunked_inbuf::xsgetn(char* s, std::streamsize num)
  * hidden from the caller. This method provides a way to get one chunk
  * from the stream by forcing its read and returning the size. A subsequent
  * call to read() for that number of bytes will return all of the data in
- * the chunk. If there is any data in the chunk_inbuf object's buffer, it is
- * lost.
+ * the chunk. If there is any data in the chunk_inbuf object's buffer, or
+ * left unread in the current chunk, it is lost.
  *
  * @return The number of bytes read, which is exactly the size of the
  * next chunk in the stream. Returns EOF on error.
@@ -332,29 +612,25 @@ chunked_inbuf::xsgetn(char* s, std::streamsize num)
 std::streambuf::int_type
 chunked_inbuf::read_next_chunk()
 {
-	// To read data from the chunked stream, first read the header
-	uint32_t header;
-	d_is.read((char *) &header, 4);
+	// Skip whatever is left of the current chunk
+	if (d_chunk_left > 0) {
+		d_is.ignore(d_chunk_left);
+		d_chunk_left = 0;
+	}
 
-    header = ntohl(header);
+	setg(d_buffer, d_buffer, d_buffer);
 
-	// There are two 'EOF' cases: One where the END chunk is zero bytes and one where
-	// it holds data. In the latter case, bytes those will be read and moved into the
-	// buffer. Once those data are consumed, we'll be back here again and this read()
-	// will return EOF. See below for the other case...
-	if (d_is.eof()) return traits_type::eof();
+	int_type header_size = m_read_header();
+	if (header_size == traits_type::eof()) return traits_type::eof();
 
-    // (header & CHUNK_LITTLE_ENDIAN) --> is the sender little endian
-    if (!d_set_twiddle) {
-        d_twiddle_bytes = (is_host_big_endian() == (header & CHUNK_LITTLE_ENDIAN));
-        d_set_twiddle = true;
-    }
+	uint32_t chunk_size = header_size;
 
-	uint32_t chunk_size = header & CHUNK_SIZE_MASK;
+	// If the END chunk has zero bytes, return EOF.
+	if (chunk_size == 0 && d_end_chunk) return traits_type::eof();
 
-	DBG(cerr << "read_next_chunk: chunk size from header: " << chunk_size << endl);
-	DBG(cerr << "read_next_chunk: chunk type from header: " << hex << (header & CHUNK_TYPE_MASK) << endl);
-	DBG(cerr << "read_next_chunk: chunk byte order from header: " << hex << (header & CHUNK_BIG_ENDIAN) << endl);
+	// With read-ahead, or if the chunk was compressed, the chunk's data are
+	// already in the buffer
+	if (d_chunk_left == 0) return traits_type::not_eof(chunk_size);
 
 	// Handle the case where the buffer is not big enough to hold the incoming chunk
 	if (chunk_size > d_buf_size) {
@@ -362,41 +638,20 @@ chunked_inbuf::read_next_chunk()
 		m_buffer_alloc();
 	}
 
-	// If the END chunk has zero bytes, return EOF. See above for more information
-	if (chunk_size == 0 && (header & CHUNK_TYPE_MASK) == CHUNK_END) return traits_type::eof();
-
 	// Read the chunk's data
 	d_is.read(d_buffer, chunk_size);
 	DBG2(cerr << "read_next_chunk: size read: " << d_is.gcount() << ", eof: " << d_is.eof() << ", bad: " << d_is.bad() << endl);
 	if (d_is.bad()) return traits_type::eof();
 
-	DBG2(cerr << "eback(): " << (void*)eback() << ", gptr(): " << (void*)(gptr()-eback()) << ", egptr(): " << (void*)(egptr()-eback()) << endl);
+	d_chunk_left = 0;
+
 	setg(d_buffer, 						// beginning of put back area
 			d_buffer,                	// read position (gptr() == eback())
 			d_buffer + chunk_size);  	// end of buffer (egptr()) chunk_size == d_is.gcount() unless there's an error
 
 	DBG2(cerr << "eback(): " << (void*)eback() << ", gptr(): " << (void*)(gptr()-eback()) << ", egptr(): " << (void*)(egptr()-eback()) << endl);
 
-	switch (header & CHUNK_TYPE_MASK) {
-	case CHUNK_END:
-		DBG(cerr << "Found end chunk" << endl);
-		return traits_type::not_eof(chunk_size);
-
-	case CHUNK_DATA:
-		return traits_type::not_eof(chunk_size);
-
-	case CHUNK_ERR:
-		// this is pretty much the end of the show... Assume the buffer/chunk holds
-		// the error message text.
-		d_error = true;
-		d_error_message = string(d_buffer, chunk_size);
-		return traits_type::eof();
-
-	default:
-		d_error = true;
-		d_error_message = "Failed to read known chunk header type.";
-		return traits_type::eof();
-	}
+	return traits_type::not_eof(chunk_size);
 }
 
 }
@@ -36,9 +36,12 @@
 #include <istream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace libdap {
 
+struct chunked_read_ahead;
+
 class chunked_inbuf: public std::streambuf {
 private:
 	std::istream &d_is;
@@ -46,12 +49,22 @@ private:
 	uint32_t d_buf_size;	// Size of the data buffer
 	char *d_buffer;			// data buffer
 
+	uint32_t d_chunk_left;	// Bytes of the current chunk not yet read from d_is
+	bool d_end_chunk;		// Is the current chunk an END chunk?
+
+	// When not null, a thread reads chunks from d_is; see start_read_ahead()
+	chunked_read_ahead *d_read_ahead;
+
+	// Compressed chunk bodies are read here
+	std::vector<char> d_compressed;
+
 	// In the original implementation of this class, the byte order of the data stream
 	// was passed in via constructors. When BYTE_ORDER_PREFIX is defined that is the
 	// case. However, when it is not defined, the byte order is read from the chunk
 	// header's high order byte (in bit position 2 - see chunked_stream.h). jhrg 11/24/13
 
 	bool d_twiddle_bytes; 	// receiver-makes-right encoding (byte order)...
+	bool d_filtered;		// the data use the vector pre-filters; see CHUNK_FILTERED
 	bool d_set_twiddle;
 
 	// If an error chunk is read, save the message here
@@ -76,12 +89,15 @@ public:
 	/**
 	 * @brief Build a chunked input buffer.
 	 *
-	 * This reads from a chunked stream, extracting an entire chunk and storing it in a
-	 * buffer in one operation. If the chunked_inbuf reads a chunk header that indicates
-	 * the next chunk is going  be bigger than its current buffer size, the object will
-	 * make the buffer larger. This object support 128 characters of 'put back' space. Since
-	 * DAP4 uses receiver makes right, the buffer must be told if it should 'twiddle' the
-	 * header size information. In DAP4 the byte order is sent using a one-byte code _before_
+	 * This reads from a chunked stream. Large reads (e.g., istream::read()) copy
+	 * the chunk data directly to the caller's memory, crossing chunk boundaries as
+	 * needed; small reads fill the buffer with at most its size from the current
+	 * chunk. read_next_chunk() reads an entire chunk into the buffer; if the chunk
+	 * is bigger than the current buffer size, the object will make the buffer larger.
+	 * Compressed chunks (see chunked_codec.h) are read whole and decompressed into
+	 * the buffer. This object support 128 characters of 'put back' space. Since DAP4 uses receiver
+	 * makes right, the buffer must be told if it should 'twiddle' the header size
+	 * information. In DAP4 the byte order is sent using a one-byte code _before_
 	 * the chunked transmission starts.
 	 *
 	 * @note In the current implementation, the byte order of the sender is read from the
@@ -96,29 +112,38 @@ public:
 	 * send use a different byte-order. The sender's byte order must be sent out-of-band.
 	 */
     chunked_inbuf(std::istream &is, int size)
-        : d_is(is), d_buf_size(size), d_buffer(0), d_twiddle_bytes(false), d_set_twiddle(false), d_error(false) {
+        : d_is(is), d_buf_size(size), d_buffer(0), d_chunk_left(0), d_end_chunk(false), d_read_ahead(0),
+          d_twiddle_bytes(false), d_filtered(false), d_set_twiddle(false), d_error(false) {
         if (d_buf_size & CHUNK_TYPE_MASK)
             throw std::out_of_range("A chunked_outbuf (or chunked_ostream) was built using a buffer larger than 0x00ffffff");
 
         m_buffer_alloc();
     }
 
-	virtual ~chunked_inbuf() {
-		delete[] d_buffer;
-	}
+	virtual ~chunked_inbuf();
 
 	int_type read_next_chunk();
 
+	void start_read_ahead(unsigned int depth = 2);
+	/// @return True if a thread is reading chunks ahead of the caller
+	bool read_ahead() const { return d_read_ahead != 0; }
+
 	int bytes_in_buffer() const { return (egptr() - gptr()); }
 
 	// d_twiddle_bytes is false initially and is set to the correct value
 	// once the first chunk is read.
 	bool twiddle_bytes() const { return d_twiddle_bytes; }
+	// Like d_twiddle_bytes, set from the first chunk header
+	bool filtered() const { return d_filtered; }
 
 	bool error() const { return d_error; }
 	std::string error_message() const { return d_error_message; }
 
 protected:
+	int_type m_read_header();
+	bool m_next_read_ahead_chunk(uint32_t &header);
+	void m_stop_read_ahead();
+
 	virtual int_type underflow();
 
 	virtual std::streamsize xsgetn(char* s, std::streamsize num);
@@ -132,6 +157,27 @@ public:
 
 	int read_next_chunk() { return d_cbuf.read_next_chunk(); }
 
+	/**
+	 * @brief Read chunks using a second thread
+	 * Start a thread that reads the following chunks from the underlying stream
+	 * while the caller decodes the current one. This overlaps reading and
+	 * decoding only when reading the underlying stream can block, e.g., when it
+	 * reads from a socket or a pipe; it does not help when the response is
+	 * already in a file, as it is for responses read using HTTPConnect, which
+	 * stores the whole body before returning. Up to \c depth chunks are read
+	 * ahead. Reading ahead stops after an END or ERROR chunk.
+	 *
+	 * @note Once this is called, the underlying stream must not be used until
+	 * this stream is destroyed.
+	 * @note The destructor waits for the thread. If the thread is blocked
+	 * reading the underlying stream, the destructor returns only once that read
+	 * returns (data arrive, the stream ends or an error occurs). To avoid
+	 * waiting, make that read return first, e.g., by shutting down the socket.
+	 * @param depth The number of chunks to hold; 2 by default
+	 */
+	void start_read_ahead(unsigned int depth = 2) { d_cbuf.start_read_ahead(depth); }
+	bool read_ahead() const { return d_cbuf.read_ahead(); }
+
 	/**
 	 * How many bytes have been read from the stream and are now in the internal buffer?
 	 * @return Number of buffered bytes.
@@ -149,6 +195,15 @@ public:
 	 * although that can be inferred.
 	 */
 	bool twiddle_bytes() const { return d_cbuf.twiddle_bytes(); }
+
+	/**
+	 * Were the arrays in the data sent using the vector pre-filters? Like
+	 * twiddle_bytes(), this is only correct once the first chunk is read.
+	 * @return True if the D4StreamUnMarshaller reading this stream should
+	 * undo the filters; it uses this value itself.
+	 * @see CHUNK_FILTERED
+	 */
+	bool filtered() const { return d_cbuf.filtered(); }
 	bool error() const { return d_cbuf.error(); }
 	std::string error_message() const { return d_cbuf.error_message(); }
 };
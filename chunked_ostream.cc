@@ -28,11 +28,17 @@
 #include "config.h"
 
 #include <arpa/inet.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <string>
 #include <streambuf>
+#include <stdexcept>
 
 #include <cstring>
 
@@ -40,10 +46,180 @@
 
 #include "chunked_stream.h"
 #include "chunked_ostream.h"
+#include "chunked_codec.h"
 #include "debug.h"
 
 namespace libdap {
 
+/**
+ * @brief Write one chunk
+ *
+ * Write the chunk header, then \c buf_len bytes from \c buf and then
+ * \c data_len bytes from \c data. When writing to a file descriptor, this
+ * is done using one call to writev() (more if it writes only part of the
+ * chunk).
+ *
+ * @param header The chunk header, in network byte order
+ * @param buf The first part of the chunk body
+ * @param buf_len The number of bytes in \c buf
+ * @param data Optional second part of the chunk body
+ * @param data_len The number of bytes in \c data
+ * @return False if there was an error, true otherwise.
+ */
+bool
+chunked_outbuf::m_write_chunk(uint32_t header, const char *buf, uint32_t buf_len, const char *data, uint32_t data_len)
+{
+	if (d_filtered && (ntohl(header) & CHUNK_TYPE_MASK) != CHUNK_ERR)
+		header = htonl(ntohl(header) | CHUNK_FILTERED);
+
+	d_chunk_sent = true;
+
+	// Compress the body of DATA and END chunks. If that does not make the
+	// chunk smaller, send it as is.
+	if (d_codec != chunk_codec_none && buf_len + data_len >= CHUNK_MIN_COMPRESS
+		&& (ntohl(header) & CHUNK_TYPE_MASK) != CHUNK_ERR) {
+		const char *src = buf;
+		if (buf_len == 0) {
+			src = data;
+		}
+		else if (data_len > 0) {
+			d_contiguous.resize(buf_len + data_len);
+			memcpy(&d_contiguous[0], buf, buf_len);
+			memcpy(&d_contiguous[buf_len], data, data_len);
+			src = &d_contiguous[0];
+		}
+
+		uint32_t len = chunk_compress(d_codec, d_level, src, buf_len + data_len, d_compressed);
+		if (len > 0) {
+			header = htonl((ntohl(header) & ~CHUNK_SIZE_MASK) | d_codec | len);
+			buf = &d_compressed[0];
+			buf_len = len;
+			data = 0;
+			data_len = 0;
+		}
+	}
+
+	if (d_os) {
+		d_os->write((const char *)&header, sizeof(uint32_t));
+		if (buf_len > 0) d_os->write(buf, buf_len);
+		if (data_len > 0) d_os->write(data, data_len);
+		return !(d_os->eof() || d_os->bad());
+	}
+
+	struct iovec iov[3];
+	iov[0].iov_base = (char *)&header;
+	iov[0].iov_len = sizeof(uint32_t);
+	iov[1].iov_base = const_cast<char *>(buf);
+	iov[1].iov_len = buf_len;
+	iov[2].iov_base = const_cast<char *>(data);
+	iov[2].iov_len = data_len;
+
+	struct iovec *v = iov;
+	int count = 3;
+	while (count > 0) {
+		ssize_t written = writev(d_fd, v, count);
+		if (written < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+
+		// Skip past what was written; writev() may stop part way.
+		while (count > 0 && (size_t)written >= v->iov_len) {
+			written -= v->iov_len;
+			++v;
+			--count;
+		}
+		if (count > 0) {
+			v->iov_base = (char *)v->iov_base + written;
+			v->iov_len -= written;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Grow the buffer after a full chunk was sent
+ *
+ * Double the size of the buffer, up to the maximum buffer size. This is
+ * only done when the buffer is empty, so no data are copied.
+ */
+void
+chunked_outbuf::m_grow()
+{
+	if (d_buf_size >= d_max_buf_size || pptr() != pbase())
+		return;
+
+	unsigned int size = std::min(d_buf_size * 2, d_max_buf_size);
+
+	DBG(cerr << "In chunked_outbuf::m_grow: new size: " << size << endl);
+
+	char *buffer = new char[size];
+	delete[] d_buffer;
+	d_buffer = buffer;
+	d_buf_size = size;
+
+	setp(d_buffer, d_buffer + (d_buf_size - 1));
+}
+
+/**
+ * @brief Set the size the buffer can grow to
+ *
+ * @param max_buf_size The new maximum size. If this is less than the
+ * current buffer size, the buffer stays at its current size.
+ * @exception std::out_of_range if \c max_buf_size is more than 0x00ffffff
+ */
+void
+chunked_outbuf::set_max_buf_size(unsigned int max_buf_size)
+{
+	if (max_buf_size > CHUNK_SIZE_MAX)
+		throw std::out_of_range("The maximum size of a chunked_outbuf (or chunked_ostream) buffer is 0x00ffffff");
+
+	d_max_buf_size = std::max(max_buf_size, d_buf_size);
+}
+
+/**
+ * @brief Compress the chunks sent from now on
+ *
+ * @param codec Compress DATA and END chunks with this codec;
+ * chunk_codec_none turns compression off
+ * @param level The compression level, -1 for the codec's default
+ * @return False if the codec is not available, in which case chunks are
+ * not compressed.
+ */
+bool
+chunked_outbuf::set_compression(chunk_codec codec, int level)
+{
+	if (!chunk_codec_available(codec)) {
+		d_codec = chunk_codec_none;
+		return false;
+	}
+
+	d_codec = codec;
+	d_level = level;
+	return true;
+}
+
+/**
+ * @brief Mark the DATA and END chunks as holding filtered arrays
+ *
+ * The receiver takes the CHUNK_FILTERED bit from the first chunk, so the
+ * bit cannot be changed once a chunk has been sent.
+ *
+ * @param filtered True to set the CHUNK_FILTERED bit
+ * @return True if the chunks are marked as asked, false if a chunk has
+ * already been sent with a different mark.
+ */
+bool
+chunked_outbuf::set_filtered(bool filtered)
+{
+	if (d_chunk_sent)
+		return d_filtered == filtered;
+
+	d_filtered = filtered;
+	return true;
+}
+
 // flush the characters in the buffer
 /**
  * @brief Write out the contents of the buffer as a chunk.
@@ -81,12 +257,7 @@ chunked_outbuf::data_chunk()
 	// network byte order for the header
 	header = htonl(header);
 
-	d_os.write((const char *)&header, sizeof(int32_t));
-
-	// Should bad() throw an error?
-	// Are these functions fast or would the bits be faster?
-	d_os.write(d_buffer, num);
-	if (d_os.eof() || d_os.bad())
+	if (!m_write_chunk(header, d_buffer, num))
 		return traits_type::eof();
 
 	pbump(-num);
@@ -127,12 +298,7 @@ chunked_outbuf::end_chunk()
     // Write out the CHUNK_END header with the byte count.
 	// This should be called infrequently, so it's probably not worth
 	// optimizing away chunk_header
-	d_os.write((const char *)&header, sizeof(uint32_t));
-
-	// Should bad() throw an error?
-	// Are these functions fast or would the bits be faster?
-	d_os.write(d_buffer, num);
-	if (d_os.eof() || d_os.bad())
+	if (!m_write_chunk(header, d_buffer, num))
 		return traits_type::eof();
 
 	pbump(-num);
@@ -174,12 +340,7 @@ chunked_outbuf::err_chunk(const std::string &m)
     // Write out the CHUNK_END header with the byte count.
 	// This should be called infrequently, so it's probably not worth
 	// optimizing away chunk_header
-	d_os.write((const char *)&header, sizeof(uint32_t));
-
-	// Should bad() throw an error?
-	// Are these functions fast or would the bits be faster?
-	d_os.write(msg.data(), msg.length());
-	if (d_os.eof() || d_os.bad())
+	if (!m_write_chunk(header, msg.data(), msg.length()))
 		return traits_type::eof();
 
 	// Reset the buffer pointer, effectively ignoring what's in there now
@@ -219,6 +380,9 @@ chunked_outbuf::overflow(int c)
 		return traits_type::eof();
 	}
 
+	// A full chunk was sent; use bigger chunks if that's allowed
+	m_grow();
+
 	return traits_type::not_eof(c);
 }
 
@@ -278,33 +442,35 @@ chunked_outbuf::xsputn(const char *s, std::streamsize num)
     // network byte order for the header
     header = htonl(header);
 
-	d_os.write((const char *)&header, sizeof(int32_t));	// Data chunk's CHUNK_TYPE is 0x00000000
-
 	// Reset the pptr() and epptr() now in case of an error exit. See the 'if'
 	// at the end of this for the only code from here down that will modify the
 	// pptr() value.
 	setp(d_buffer, d_buffer + (d_buf_size - 1));
 
-	d_os.write(d_buffer, bytes_in_buffer);
-	if (d_os.eof() || d_os.bad())
-		return traits_type::not_eof(0);
-
+	// Data chunk's CHUNK_TYPE is 0x00000000
 	int bytes_to_fill_out_buffer =  d_buf_size - bytes_in_buffer;
-	d_os.write(s, bytes_to_fill_out_buffer);
-	if (d_os.eof() || d_os.bad())
+	if (!m_write_chunk(header, d_buffer, bytes_in_buffer, s, bytes_to_fill_out_buffer))
 		return traits_type::not_eof(0);
 	s += bytes_to_fill_out_buffer;
 	uint32_t bytes_still_to_send = num - bytes_to_fill_out_buffer;
 
+	// The buffer is empty, so it can grow if the chunk size is adaptive
+	m_grow();
+
 	// Now send all the remaining data in s until the amount remaining doesn't
 	// fill a complete chunk and buffer those data.
 	while (bytes_still_to_send >= d_buf_size) {
-		// This is header for  a chunk of d_buf_size bytes; the size was set above
-		d_os.write((const char *) &header, sizeof(int32_t));
-		d_os.write(s, d_buf_size);
-		if (d_os.eof() || d_os.bad()) return traits_type::not_eof(0);
+		// This is header for a chunk of d_buf_size bytes; the size changes
+		// as the buffer grows
+		header = d_buf_size;
+		if (!d_big_endian) header |= CHUNK_LITTLE_ENDIAN;
+		header = htonl(header);
+
+		if (!m_write_chunk(header, s, d_buf_size)) return traits_type::not_eof(0);
 		s += d_buf_size;
 		bytes_still_to_send -= d_buf_size;
+
+		m_grow();
 	}
 
 	if (bytes_still_to_send > 0) {
@@ -30,9 +30,14 @@
 
 #include "chunked_stream.h"
 
+#include <stdint.h>
+
 #include <streambuf>
 #include <ostream>
 #include <stdexcept>      // std::out_of_range
+#include <vector>
+
+#include "chunked_codec.h"
 
 #include "util.h"
 
@@ -49,26 +54,85 @@ class chunked_ostream;
  * data, end and error, indicated by the code values 0x00, 0x01 and 0x02.
  * The size of a chunk is limited to 2^24 data bytes + 4 bytes for the
  * chunk header.
+ *
+ * The chunks can be written to a std::ostream or to a file descriptor
+ * (e.g., a socket). When a file descriptor is used, each chunk is written
+ * with one writev() call that sends the chunk header, the buffered bytes
+ * and the caller's bytes without copying them into one buffer.
+ *
+ * The chunk size can be adaptive: When a maximum buffer size larger than
+ * the initial size is given, the buffer doubles in size each time a full
+ * chunk is sent until it reaches the maximum. A response can start with
+ * small chunks (e.g., the DMR) and move to large chunks for the bulk of
+ * its data. Flushing the stream sends a (short) chunk but does not change
+ * the buffer size.
  */
 class chunked_outbuf: public std::streambuf {
 	friend class chunked_ostream;
 protected:
-	std::ostream &d_os;			// Write stuff here
+	std::ostream *d_os;			// Write stuff here, or to d_fd if null
+	int d_fd;
 	unsigned int d_buf_size; 	// Size of the data buffer
+	unsigned int d_max_buf_size;	// The buffer can grow to this size
 	char *d_buffer;				// Data buffer
 	bool d_big_endian;
 
-public:
-	chunked_outbuf(std::ostream &os, unsigned int buf_size) : d_os(os), d_buf_size(buf_size), d_buffer(0) {
+	chunk_codec d_codec;		// Compress DATA and END chunks with this
+	int d_level;
+	bool d_filtered;			// Mark DATA and END chunks with CHUNK_FILTERED
+	bool d_chunk_sent;			// True once the first chunk has been written
+	std::vector<char> d_compressed;
+	std::vector<char> d_contiguous;
+
+	void m_init() {
 		if (d_buf_size & CHUNK_TYPE_MASK)
 			throw std::out_of_range("A chunked_outbuf (or chunked_ostream) was built using a buffer larger than 0x00ffffff");
 
+		if (d_max_buf_size < d_buf_size)
+			d_max_buf_size = d_buf_size;
+		else if (d_max_buf_size > CHUNK_SIZE_MAX)
+			throw std::out_of_range("A chunked_outbuf (or chunked_ostream) was built using a maximum buffer size larger than 0x00ffffff");
+
 		d_big_endian = is_host_big_endian();
-		d_buffer = new char[buf_size];
+		d_codec = chunk_codec_none;
+		d_level = -1;
+		d_filtered = false;
+		d_chunk_sent = false;
+		d_buffer = new char[d_buf_size];
 		// Trick: making the pointers think the buffer is one char smaller than it
 		// really is ensures that overflow() will be called when there's space for
 		// one more character.
-		setp(d_buffer, d_buffer + (buf_size - 1));
+		setp(d_buffer, d_buffer + (d_buf_size - 1));
+	}
+
+	bool m_write_chunk(uint32_t header, const char *buf, uint32_t buf_len, const char *data = 0,
+		uint32_t data_len = 0);
+
+	void m_grow();
+
+public:
+	/**
+	 * Write chunks to a std::ostream.
+	 * @param os Write to this stream
+	 * @param buf_size The size of the buffer in bytes.
+	 * @param max_buf_size Grow the buffer up to this size; the default (0)
+	 * keeps the buffer size fixed.
+	 */
+	chunked_outbuf(std::ostream &os, unsigned int buf_size, unsigned int max_buf_size = 0) :
+		d_os(&os), d_fd(-1), d_buf_size(buf_size), d_max_buf_size(max_buf_size), d_buffer(0) {
+		m_init();
+	}
+
+	/**
+	 * Write chunks to a file descriptor. The descriptor is not closed.
+	 * @param fd An open file descriptor
+	 * @param buf_size The size of the buffer in bytes.
+	 * @param max_buf_size Grow the buffer up to this size; the default (0)
+	 * keeps the buffer size fixed.
+	 */
+	chunked_outbuf(int fd, unsigned int buf_size, unsigned int max_buf_size = 0) :
+		d_os(0), d_fd(fd), d_buf_size(buf_size), d_max_buf_size(max_buf_size), d_buffer(0) {
+		m_init();
 	}
 
 	virtual ~chunked_outbuf() {
@@ -78,6 +142,19 @@ public:
 		delete[] d_buffer;
 	}
 
+	/// @return The size of the next full chunk
+	unsigned int get_buf_size() const { return d_buf_size; }
+	/// @return The largest size the buffer will grow to
+	unsigned int get_max_buf_size() const { return d_max_buf_size; }
+	void set_max_buf_size(unsigned int max_buf_size);
+
+	bool set_compression(chunk_codec codec, int level = -1);
+	/// @return The codec used to compress chunks
+	chunk_codec get_compression() const { return d_codec; }
+
+	bool set_filtered(bool filtered);
+	bool get_filtered() const { return d_filtered; }
+
 protected:
 	// data_chunk and end_chunk might not be needed because they
 	// are called via flush() and ~chunked_outbuf(), resp. jhrg 9/13/13
@@ -125,8 +202,75 @@ public:
 	 * Get a chunked_ostream with a buffer.
 	 * @note The buffer size must not be more than 2^24 bytes (0x00ffffff)
 	 * @param buf_size The size of the buffer in bytes.
+	 * @param max_buf_size If larger than buf_size, the buffer (and so the
+	 * chunks) grow up to this size as data are written. By default the
+	 * chunk size is fixed.
+	 */
+	chunked_ostream(std::ostream &os, unsigned int buf_size, unsigned int max_buf_size = 0) :
+		std::ostream(&d_cbuf), d_cbuf(os, buf_size, max_buf_size) { }
+
+	/**
+	 * Get a chunked_ostream that writes to a file descriptor (e.g., a socket).
+	 * Each chunk is sent using one writev() call. The file descriptor is not
+	 * closed by the stream.
+	 * @note The buffer size must not be more than 2^24 bytes (0x00ffffff)
+	 * @param fd The open file descriptor.
+	 * @param buf_size The size of the buffer in bytes.
+	 * @param max_buf_size If larger than buf_size, grow the buffer up to
+	 * this size.
+	 */
+	chunked_ostream(int fd, unsigned int buf_size, unsigned int max_buf_size = 0) :
+		std::ostream(&d_cbuf), d_cbuf(fd, buf_size, max_buf_size) { }
+
+	/**
+	 * @brief Set the largest chunk size for the rest of the response
+	 * Starting with the next full chunk, the chunk size doubles each time a
+	 * full chunk is sent until it reaches \c max_size. Use CHUNK_SIZE_MAX for
+	 * the largest chunks the protocol allows. A value smaller than the current
+	 * chunk size stops the growth.
+	 * @param max_size The maximum chunk size in bytes
+	 */
+	void set_max_chunk_size(unsigned int max_size) { d_cbuf.set_max_buf_size(max_size); }
+
+	/// @return The size of the next full data chunk
+	unsigned int get_chunk_size() const { return d_cbuf.get_buf_size(); }
+
+	/**
+	 * @brief Compress the following chunks
+	 * Compress the body of each DATA and END chunk sent from now on with
+	 * \c codec. A chunk is sent uncompressed when compression does not make it
+	 * smaller. Error chunks are never compressed. Only use this when the
+	 * receiver can decode compressed chunks (chunked_istream does so
+	 * transparently); a server should check the client's
+	 * CHUNK_FEATURES_HEADER using chunk_codec_accepted().
+	 * @param codec The codec; chunk_codec_none turns compression off
+	 * @param level The compression level for codecs that support it; -1 for
+	 * the codec's default
+	 * @return False if this build of the library does not support \c codec.
+	 * In that case, chunks are not compressed.
+	 */
+	bool set_compression(chunk_codec codec, int level = -1) { return d_cbuf.set_compression(codec, level); }
+	chunk_codec get_compression() const { return d_cbuf.get_compression(); }
+
+	/**
+	 * @brief Mark the following chunks as holding filtered arrays
+	 * Set the CHUNK_FILTERED bit in the header of the DATA and END chunks.
+	 * A D4StreamMarshaller writing to a stream with the bit set starts each
+	 * array of 2, 4 or 8 byte values with a filter byte, and a
+	 * D4StreamUnMarshaller reading a stream with the bit set reads it.
+	 *
+	 * The receiver uses the bit of the first chunk, so this must be called
+	 * before any chunk is sent. Readers that predate the bit do not know
+	 * to read the filter byte; only set it when the client said it can,
+	 * see CHUNK_FEATURES_HEADER.
+	 *
+	 * @param filtered True to set the bit
+	 * @return False if a chunk has already been sent and the bit differs;
+	 * in that case it is not changed.
+	 * @see D4StreamMarshaller::set_filters()
 	 */
-	chunked_ostream(std::ostream &os, unsigned int buf_size) : std::ostream(&d_cbuf), d_cbuf(os, buf_size) { }
+	bool set_filtered(bool filtered) { return d_cbuf.set_filtered(filtered); }
+	bool get_filtered() const { return d_cbuf.get_filtered(); }
 
 	/**
 	 * @brief Send an end chunk.
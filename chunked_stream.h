@@ -17,6 +17,33 @@
 // not the byte order of the chunk. The chunk is always in network byte order.
 #define CHUNK_LITTLE_ENDIAN  0x04000000
 
+// These bits indicate that the chunk body is compressed and with what codec.
+// A compressed body starts with the size of the uncompressed data (four
+// bytes, network byte order); the chunk size includes those four bytes.
+// Only DATA and END chunks are compressed. See chunked_codec.h
+#define CHUNK_ZLIB 0x10000000
+#define CHUNK_LZ4  0x20000000
+#define CHUNK_CODEC_MASK 0x30000000
+
+// This bit indicates that each array of 2, 4 or 8 byte values in the data
+// starts with a byte that names the pre-filters (shuffle, delta) applied to
+// the array's values before they were sent. See chunked_codec.h
+#define CHUNK_FILTERED 0x08000000
+
+// Readers that predate CHUNK_FILTERED ignore it (they mask the header using
+// CHUNK_TYPE_MASK) and then misread the filtered arrays. A client that can
+// read them lists CHUNK_FEATURE_FILTERED in this request header, and a
+// server should only set the bit for clients that do. See
+// chunk_feature_accepted() in chunked_codec.h
+#define CHUNK_FEATURES_HEADER "XDAP-Accept-Chunk-Features"
+#define CHUNK_FEATURE_FILTERED "filtered"
+
+// A client also lists the codecs it can decompress (CHUNK_ZLIB, CHUNK_LZ4)
+// in that header, and a server should only compress chunks using one of
+// them. See chunk_codec_accepted() in chunked_codec.h
+#define CHUNK_FEATURE_ZLIB "zlib"
+#define CHUNK_FEATURE_LZ4 "lz4"
+
 // Chunk type mask masks off the low bytes and the little endian bit.
 // The three chunk types (DATA, END and ERR) are mutually exclusive.
 #define CHUNK_TYPE_MASK 0x03000000
@@ -24,6 +51,11 @@
 
 #define CHUNK_SIZE 4096
 
+// The largest chunk body allowed by the protocol
+#define CHUNK_SIZE_MAX 0x00FFFFFF
+// A good upper limit for chunks that hold bulk (array) data
+#define BULK_CHUNK_SIZE 0x00400000
+
 #define BYTE_ORDER_PREFIX 0
 #define HEADER_IN_NETWORK_BYTE_ORDER 1
 
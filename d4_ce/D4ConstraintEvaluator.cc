@@ -25,6 +25,7 @@
 #include <string>
 #include <sstream>
 #include <iterator>
+#include <memory>
 
 //#define DODS_DEBUG
 
@@ -43,6 +44,7 @@
 
 #include "D4RValue.h"
 #include "D4FilterClause.h"
+#include "ConstraintPlan.h"
 
 #include "escaping.h"
 #include "parser.h"		// for get_ull()
@@ -56,10 +58,33 @@
 
 namespace libdap {
 
+/**
+ * Parse a DAP4 constraint expression and mark the DMR. Projections and
+ * slices are recorded in the ConstraintPlanCache and, when the same
+ * expression is used again with a DMR for the same dataset, the recorded
+ * changes are applied to the DMR without parsing the expression. An
+ * expression that includes a filter is always parsed.
+ *
+ * @param expr The constraint expression
+ * @return True if the expression was parsed
+ */
 bool D4ConstraintEvaluator::parse(const std::string &expr)
 {
     d_expr = expr;	// set for error messages. See the %initial-action section of .yy
 
+    // Filters are introduced by '|'; expressions with filters are not
+    // cached, so don't record the state of the DMR for them
+    bool cacheable = expr.find('|') == std::string::npos;
+
+    ConstraintPlanCache *cache = ConstraintPlanCache::TheCache();
+    std::auto_ptr<ConstraintState> before(0);
+    if (cacheable && cache->get_max_plans() > 0 && d_dmr) {
+        before.reset(new ConstraintState(*d_dmr));
+        if (cache->apply(expr, *before, &d_result)) return true;
+    }
+
+    d_filtered = false;
+
     std::istringstream iss(expr);
     D4CEScanner scanner(iss);
     D4CEParser parser(scanner, *this /* driver */);
@@ -69,7 +94,14 @@ bool D4ConstraintEvaluator::parse(const std::string &expr)
         parser.set_debug_stream(std::cerr);
     }
 
-    return parser.parse() == 0;
+    bool status = parser.parse() == 0;
+
+    if (status && before.get() && !d_filtered) {
+        ConstraintState after(*d_dmr);
+        cache->add(expr, *before, after, d_result);
+    }
+
+    return status;
 }
 
 /**
@@ -421,6 +453,8 @@ void D4ConstraintEvaluator::add_filter_clause(const std::string &op, const std::
             "One of the arguments in a filter expression must be a variable in a Sequence: "
                 + expr_msg(op, arg1, arg2));
 
+    d_filtered = true;
+
     // Now we know a1 XOR a2 is true
     if (a1) {
         s->clauses().add_clause(new D4FilterClause(get_op_code(op), new D4RValue(a1), D4RValueFactory(arg2)));
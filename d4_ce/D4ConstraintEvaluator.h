@@ -84,6 +84,9 @@ class D4ConstraintEvaluator {
 	bool d_result;
 	std::string d_expr;
 
+	// True if the parser added a filter clause; those CEs are not cached
+	bool d_filtered;
+
 	DMR *d_dmr;
 
 	std::vector<index> d_indexes;
@@ -118,8 +121,8 @@ class D4ConstraintEvaluator {
 	friend class D4CEParser;
 
 public:
-	D4ConstraintEvaluator() : d_trace_scanning(false), d_trace_parsing(false), d_result(false), d_expr(""), d_dmr(0) { }
-	D4ConstraintEvaluator(DMR *dmr) : d_trace_scanning(false), d_trace_parsing(false), d_result(false), d_expr(""), d_dmr(dmr) { }
+	D4ConstraintEvaluator() : d_trace_scanning(false), d_trace_parsing(false), d_result(false), d_expr(""), d_filtered(false), d_dmr(0) { }
+	D4ConstraintEvaluator(DMR *dmr) : d_trace_scanning(false), d_trace_parsing(false), d_result(false), d_expr(""), d_filtered(false), d_dmr(dmr) { }
 
 	virtual ~D4ConstraintEvaluator() { }
 
@@ -29,6 +29,7 @@
 #include <sstream>
 #include <iterator>
 #include <list>
+#include <map>
 #include <algorithm>
 
 //#define DODS_DEBUG
@@ -40,6 +41,7 @@
 #include "DMR.h"
 #include "D4Group.h"
 #include "D4RValue.h"
+#include "ParallelTasks.h"
 
 #include "BaseType.h"
 #include "Array.h"
@@ -79,6 +81,58 @@ bool D4FunctionEvaluator::parse(const std::string &expr)
     return parser.parse() == 0;
 }
 
+// Make repeated calls to pure functions in the expression use the value of
+// the first one. The tree of rvalues becomes a DAG where each distinct call
+// is made once; the arguments of a repeated call are never evaluated so they
+// are not visited. Other functions are called each time they appear.
+static void share_subexpressions(D4RValue *rv, std::map<std::string, D4RValue*> &calls)
+{
+    if (rv->get_kind() != D4RValue::function)
+        return;
+
+    if (rv->is_pure()) {
+        std::string key = rv->key();
+        std::map<std::string, D4RValue*>::iterator i = calls.find(key);
+        if (i != calls.end()) {
+            i->second->memoize();
+            rv->use_value_of(i->second);
+            return;
+        }
+
+        calls.insert(std::make_pair(key, rv));
+    }
+
+    D4RValueList *args = rv->get_args();
+    if (args) {
+        for (D4RValueList::iter a = args->begin(), e = args->end(); a != e; ++a)
+            share_subexpressions(*a, calls);
+    }
+}
+
+// Get the values of the rvalues in one group, in order, storing each at the
+// rvalue's index in d_values.
+class RValueTasks: public ParallelTasks {
+private:
+    D4RValueList &d_rvalues;
+    DMR &d_dmr;
+    const std::vector<std::vector<unsigned int> > &d_groups;
+    std::vector<BaseType*> &d_values;
+
+protected:
+    virtual void run_task(unsigned int g)
+    {
+        for (std::vector<unsigned int>::const_iterator i = d_groups[g].begin(), e = d_groups[g].end(); i != e; ++i)
+            d_values[*i] = d_rvalues.get_rvalue(*i)->value(d_dmr);
+    }
+
+public:
+    RValueTasks(D4RValueList &rvalues, DMR &dmr, const std::vector<std::vector<unsigned int> > &groups,
+        std::vector<BaseType*> &values) :
+        d_rvalues(rvalues), d_dmr(dmr), d_groups(groups), d_values(values)
+    {
+    }
+};
+
 /**
  * Evaluate the recently parsed function expression and put the resulting
  * rvalues (which return values packaged in libdap BaseType objects) into
@@ -103,6 +157,14 @@ bool D4FunctionEvaluator::parse(const std::string &expr)
  * @note Calling this method will delete the D4RValueList object built
  * by the parse() method.
  *
+ * @note A call to a pure function (see ServerFunction::setPure()) that is
+ * repeated in the expression, e.g., g(x) in f(g(x),g(x)), is evaluated once
+ * and its value is used each time it appears.
+ *
+ * @note If set_function_threads() was used to allow more than one thread,
+ * functions that do not use the same variables are evaluated in parallel;
+ * the results are still added in the order of the expression.
+ *
  * @param dmr Store the results here
  * @exception Throws Error if the evaluation fails.
  */
@@ -129,11 +191,43 @@ void D4FunctionEvaluator::eval(DMR *function_result)
 
     D4Group *root = function_result->root();	// Load everything in the root group
 
-    for (D4RValueList::iter i = d_result->begin(), e = d_result->end(); i != e; ++i) {
-        // Copy the BaseTypes; this means all of the function results can
-        // be deleted, which addresses the memory leak issue with function
-        // results. This should also copy the D4Dimensions. jhrg 3/17/14
-        root->add_var((*i)->value(*d_dmr));
+    std::map<std::string, D4RValue*> calls;
+    for (D4RValueList::iter i = d_result->begin(), e = d_result->end(); i != e; ++i)
+        share_subexpressions(*i, calls);
+
+    if (d_function_threads < 2 || d_result->size() < 2) {
+        for (D4RValueList::iter i = d_result->begin(), e = d_result->end(); i != e; ++i) {
+            // Copy the BaseTypes; this means all of the function results can
+            // be deleted, which addresses the memory leak issue with function
+            // results. This should also copy the D4Dimensions. jhrg 3/17/14
+            root->add_var((*i)->value(*d_dmr));
+        }
+    }
+    else {
+        // Evaluate the rvalues that use different variables in parallel,
+        // then add the results in the order of the expression.
+        std::vector<std::vector<BaseType*> > vars(d_result->size());
+        for (unsigned int i = 0; i < d_result->size(); ++i)
+            d_result->get_rvalue(i)->variables(vars[i]);
+
+        std::vector<std::vector<unsigned int> > groups;
+        ParallelTasks::independent_groups(vars, groups);
+
+        std::vector<BaseType*> values(d_result->size(), 0);
+        RValueTasks tasks(*d_result, *d_dmr, groups, values);
+        try {
+            tasks.run(groups.size(), d_function_threads);
+        }
+        catch (...) {
+            // Delete the function results made before the error
+            for (unsigned int i = 0; i < values.size(); ++i)
+                if (d_result->get_rvalue(i)->caller_owns_value())
+                    delete values[i];
+            throw;
+        }
+
+        for (std::vector<BaseType*>::iterator i = values.begin(), e = values.end(); i != e; ++i)
+            root->add_var(*i);
     }
 
     delete d_result;	// The parser/function allocates the BaseType*s that hold the results.
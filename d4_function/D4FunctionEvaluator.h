@@ -60,6 +60,8 @@ class D4FunctionEvaluator
 
     unsigned long long d_arg_length_hint;
 
+    unsigned int d_function_threads;
+
     // d_expr should be set by parse! Its value is used by the parser right before
     // the actual parsing operation starts. jhrg 11/26/13
     std::string *expression()
@@ -87,12 +89,12 @@ class D4FunctionEvaluator
 public:
     D4FunctionEvaluator() :
             d_trace_scanning(false), d_trace_parsing(false), d_expr(""), d_dmr(0), d_sf_list(0), d_result(0), d_arg_length_hint(
-                    0)
+                    0), d_function_threads(1)
     {
     }
     D4FunctionEvaluator(DMR *dmr, ServerFunctionsList *sf_list) :
             d_trace_scanning(false), d_trace_parsing(false), d_expr(""), d_dmr(dmr), d_sf_list(sf_list), d_result(0), d_arg_length_hint(
-                    0)
+                    0), d_function_threads(1)
     {
     }
 
@@ -144,6 +146,22 @@ public:
         d_arg_length_hint = alh;
     }
 
+    /** @return The maximum number of threads eval() can use */
+    unsigned int get_function_threads() const
+    {
+        return d_function_threads;
+    }
+    /**
+     * Let eval() use up to \e num_threads threads. Function calls that do
+     * not use the same variables are then evaluated in parallel, so only use
+     * this when the functions, and the read() methods of the variables they
+     * use, are reentrant. The default is one thread.
+     */
+    void set_function_threads(unsigned int num_threads)
+    {
+        d_function_threads = num_threads;
+    }
+
     DMR *dmr() const
     {
         return d_dmr;
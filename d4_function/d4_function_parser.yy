@@ -103,7 +103,7 @@ namespace libdap {
 %type <D4RValue*> arg "argument"
 %type <D4RValue*> function "function"
 
-%type <D4Function> fname "function name"
+%type <std::string> fname "function name"
 %type <D4RValue*> variable_or_constant "variable or constant"
 %type <D4RValue*> array_constant "array constant"
 
@@ -174,7 +174,10 @@ functions : function
                     
 function : fname "(" args ")" 
 { 
-    $$ = new D4RValue($1, $3); // Build a D4RValue from a D4Function pointer and a D4RValueList 
+    D4Function f = 0;
+    evaluator.sf_list()->find_function($1, &f); // fname checked that it is registered
+    $$ = new D4RValue(f, $3); // Build a D4RValue from a D4Function pointer and a D4RValueList 
+    $$->set_pure(evaluator.sf_list()->is_pure($1));
 } 
 ;
 
@@ -186,7 +189,7 @@ fname: WORD
         throw Error(malformed_expr, "'" + $1 + "' is not a registered DAP4 server function.");
     }
 
-    $$ = f;
+    $$ = $1;
 }        
 ;
 
@@ -0,0 +1,483 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+#include "deflate_ostream.h"
+#include "InternalErr.h"
+
+#include "debug.h"
+
+using namespace std;
+
+namespace libdap {
+
+// The size of the deflate window; each block is compressed using this
+// much of the data before it as a dictionary.
+static const unsigned int dict_size = 32 * 1024;
+
+/**
+ * A block of data and, once it is compressed, the compressed block. The
+ * dictionary for the block is stored just before its data.
+ */
+struct deflate_outbuf::block {
+    vector<char> input;     // the dictionary, then the data
+    unsigned int dict_len;
+    unsigned int len;
+    bool last;              // the end of the stream
+    bool done;              // 'output', 'check' and 'error' are set
+
+    vector<char> output;
+    uint32_t check;
+    string error;
+
+    block(unsigned int block_size) :
+        input(dict_size + block_size), dict_len(0), len(0), last(false), done(false), check(0) { }
+};
+
+/**
+ * @brief Build a deflate_outbuf
+ *
+ * The threads that compress the blocks are started here and run until the
+ * buffer is destroyed.
+ *
+ * @param os Write the compressed data here
+ * @param format Write a gzip or zlib stream
+ * @param level The zlib compression level, -1 for the zlib default
+ * @param num_threads The number of threads to use; zero is the same as one.
+ * @param block_size Compress the data in blocks of this size
+ * @exception InternalErr if the library was built without zlib
+ */
+deflate_outbuf::deflate_outbuf(ostream &os, deflate_format format, int level, unsigned int num_threads,
+    unsigned int block_size) :
+    d_os(os), d_format(format), d_level(level), d_block_size(max(block_size, 1U)), d_current(0),
+    d_max_pending(1), d_stop(false), d_header_sent(false), d_finished(false),
+    d_check(format == deflate_gzip ? 0 : 1), d_total(0)
+{
+    if (!available())
+        throw InternalErr(__FILE__, __LINE__, "This version of libdap was built without zlib.");
+
+    pthread_mutex_init(&d_mutex, 0);
+    pthread_cond_init(&d_work, 0);
+    pthread_cond_init(&d_done, 0);
+
+    // With one thread the blocks are compressed by the caller. If fewer
+    // threads can be started than were asked for, use the ones that were.
+    if (num_threads > 1) {
+        for (unsigned int i = 0; i < num_threads; ++i) {
+            pthread_t thread;
+            if (pthread_create(&thread, 0, worker, this) != 0)
+                break;
+            d_threads.push_back(thread);
+        }
+        // Let the threads work on the next blocks while the oldest is written
+        d_max_pending = 2 * d_threads.size();
+    }
+
+    d_current = m_new_block();
+    setp(&d_current->input[0], &d_current->input[0] + d_block_size);
+}
+
+deflate_outbuf::~deflate_outbuf()
+{
+    finish();
+    m_stop_threads();
+
+    delete d_current;
+    for (deque<block*>::iterator i = d_pending.begin(), e = d_pending.end(); i != e; ++i)
+        delete *i;
+    for (vector<block*>::iterator i = d_free.begin(), e = d_free.end(); i != e; ++i)
+        delete *i;
+
+    pthread_cond_destroy(&d_done);
+    pthread_cond_destroy(&d_work);
+    pthread_mutex_destroy(&d_mutex);
+}
+
+// Compress queued blocks until the buffer is destroyed.
+void *deflate_outbuf::worker(void *arg)
+{
+    deflate_outbuf *buf = static_cast<deflate_outbuf*>(arg);
+
+    pthread_mutex_lock(&buf->d_mutex);
+    while (true) {
+        while (!buf->d_stop && buf->d_queue.empty())
+            pthread_cond_wait(&buf->d_work, &buf->d_mutex);
+        if (buf->d_stop)
+            break;
+
+        block *b = buf->d_queue.front();
+        buf->d_queue.pop_front();
+
+        pthread_mutex_unlock(&buf->d_mutex);
+        buf->m_compress_block(b);
+        pthread_mutex_lock(&buf->d_mutex);
+
+        b->done = true;
+        pthread_cond_broadcast(&buf->d_done);
+    }
+    pthread_mutex_unlock(&buf->d_mutex);
+
+    return 0;
+}
+
+// Stop the threads; blocks that are still queued are not compressed.
+void deflate_outbuf::m_stop_threads()
+{
+    pthread_mutex_lock(&d_mutex);
+    d_stop = true;
+    d_queue.clear();
+    pthread_cond_broadcast(&d_work);
+    pthread_mutex_unlock(&d_mutex);
+
+    for (vector<pthread_t>::iterator i = d_threads.begin(), e = d_threads.end(); i != e; ++i)
+        pthread_join(*i, 0);
+    d_threads.clear();
+}
+
+// Get an empty block, reusing one that has been written if possible.
+deflate_outbuf::block *deflate_outbuf::m_new_block()
+{
+    if (d_free.empty())
+        return new block(d_block_size);
+
+    block *b = d_free.back();
+    d_free.pop_back();
+
+    b->dict_len = 0;
+    b->len = 0;
+    b->last = false;
+    b->done = false;
+    b->error.clear();
+
+    return b;
+}
+
+/**
+ * @brief Compress one block
+ *
+ * Each block is a raw deflate stream that uses the data before it as a
+ * dictionary. All but the last block end with a sync flush, which ends the
+ * block on a byte boundary so that the blocks can be concatenated. This
+ * runs without the mutex and so reads only the block and the settings
+ * that do not change; errors are stored in the block.
+ *
+ * @param b The block
+ */
+void deflate_outbuf::m_compress_block(block *b)
+{
+#if HAVE_LIBZ
+    const char *data = &b->input[b->dict_len];
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    // A negative window size makes a raw deflate stream (no header or trailer)
+    if (deflateInit2(&strm, d_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        b->error = "Could not initialize zlib.";
+        return;
+    }
+
+    if (b->dict_len > 0)
+        deflateSetDictionary(&strm, reinterpret_cast<const Bytef*>(&b->input[0]), b->dict_len);
+
+    vector<char> &out = b->output;
+    out.resize(deflateBound(&strm, b->len) + 16);
+
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    strm.avail_in = b->len;
+    strm.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    strm.avail_out = out.size();
+
+    int flush = b->last ? Z_FINISH : Z_SYNC_FLUSH;
+    while (true) {
+        int status = deflate(&strm, flush);
+        if (status == Z_STREAM_ERROR) {
+            deflateEnd(&strm);
+            b->error = "Could not compress the response.";
+            return;
+        }
+
+        if (b->last ? status == Z_STREAM_END : (strm.avail_in == 0 && strm.avail_out > 0))
+            break;
+
+        // Out of space; this should not happen given deflateBound()
+        size_t used = out.size() - strm.avail_out;
+        out.resize(out.size() * 2);
+        strm.next_out = reinterpret_cast<Bytef*>(&out[used]);
+        strm.avail_out = out.size() - used;
+    }
+
+    out.resize(out.size() - strm.avail_out);
+    deflateEnd(&strm);
+
+    if (d_format == deflate_gzip)
+        b->check = crc32(0, reinterpret_cast<const Bytef*>(data), b->len);
+    else
+        b->check = adler32(1, reinterpret_cast<const Bytef*>(data), b->len);
+#else
+    b->error = "This version of libdap was built without zlib.";
+#endif
+}
+
+/// @return True if the library was built with zlib
+bool deflate_outbuf::available()
+{
+#if HAVE_LIBZ
+    return true;
+#else
+    return false;
+#endif
+}
+
+void deflate_outbuf::m_write_header()
+{
+    if (d_format == deflate_gzip) {
+        // ID1, ID2, CM (deflate), FLG, MTIME (4), XFL, OS (unix)
+        const char header[10] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 3 };
+        d_os.write(header, sizeof(header));
+    }
+    else {
+        // CMF: deflate with a 32K window. FLG: the compression level and a
+        // check value.
+        unsigned int cmf = 0x78;
+        unsigned int flevel = (d_level == 1) ? 0 : (d_level >= 2 && d_level <= 5) ? 1 : (d_level >= 7) ? 3 : 2;
+        unsigned int flg = flevel << 6;
+        flg += 31 - (cmf * 256 + flg) % 31;
+        char header[2] = { (char) cmf, (char) flg };
+        d_os.write(header, sizeof(header));
+    }
+
+    d_header_sent = true;
+}
+
+void deflate_outbuf::m_write_trailer()
+{
+    char trailer[8];
+    if (d_format == deflate_gzip) {
+        // CRC32 and ISIZE, both little endian
+        uint32_t size = (uint32_t) d_total;
+        for (int i = 0; i < 4; ++i) {
+            trailer[i] = (char) (d_check >> (8 * i));
+            trailer[4 + i] = (char) (size >> (8 * i));
+        }
+        d_os.write(trailer, 8);
+    }
+    else {
+        // ADLER32, big endian
+        for (int i = 0; i < 4; ++i)
+            trailer[i] = (char) (d_check >> (8 * (3 - i)));
+        d_os.write(trailer, 4);
+    }
+}
+
+/**
+ * @brief Send the block being filled to be compressed
+ *
+ * The last 32KB of its data are copied to the next block as that block's
+ * dictionary. Blocks that have been compressed are written.
+ *
+ * @param last If true, this is the end of the compressed stream
+ */
+void deflate_outbuf::m_submit(bool last)
+{
+    if (!d_header_sent)
+        m_write_header();
+
+    block *b = d_current;
+    b->len = pptr() - pbase();
+    b->last = last;
+
+    // An empty block is only needed to end the stream
+    if (b->len == 0 && !last) {
+        m_write_blocks(false);
+        return;
+    }
+
+    if (!last) {
+        d_current = m_new_block();
+        unsigned int keep = min(dict_size, b->dict_len + b->len);
+        memcpy(&d_current->input[0], &b->input[b->dict_len + b->len - keep], keep);
+        d_current->dict_len = keep;
+        setp(&d_current->input[keep], &d_current->input[keep] + d_block_size);
+    }
+    else {
+        d_current = 0;
+        setp(0, 0);
+    }
+
+    if (d_threads.empty()) {
+        m_compress_block(b);
+        b->done = true;
+        d_pending.push_back(b);
+    }
+    else {
+        pthread_mutex_lock(&d_mutex);
+        d_pending.push_back(b);
+        d_queue.push_back(b);
+        pthread_cond_signal(&d_work);
+        pthread_mutex_unlock(&d_mutex);
+    }
+
+    m_write_blocks(last);
+}
+
+/**
+ * @brief Write the compressed blocks, in order
+ *
+ * @param all If true, wait for and write all the blocks; otherwise write
+ * the blocks that are done and wait only if too many are pending.
+ * @exception InternalErr if a block could not be compressed
+ */
+void deflate_outbuf::m_write_blocks(bool all)
+{
+    pthread_mutex_lock(&d_mutex);
+    while (!d_pending.empty()) {
+        block *b = d_pending.front();
+        if (!b->done) {
+            if (!all && d_pending.size() < d_max_pending)
+                break;
+            pthread_cond_wait(&d_done, &d_mutex);
+            continue;
+        }
+
+        d_pending.pop_front();
+        pthread_mutex_unlock(&d_mutex);
+
+        if (!b->error.empty()) {
+            string msg = b->error;
+            d_free.push_back(b);
+            throw InternalErr(__FILE__, __LINE__, msg);
+        }
+
+        d_os.write(&b->output[0], b->output.size());
+#if HAVE_LIBZ
+        if (d_format == deflate_gzip)
+            d_check = crc32_combine(d_check, b->check, b->len);
+        else
+            d_check = adler32_combine(d_check, b->check, b->len);
+#endif
+        d_total += b->len;
+        d_free.push_back(b);
+
+        pthread_mutex_lock(&d_mutex);
+    }
+    pthread_mutex_unlock(&d_mutex);
+}
+
+/**
+ * @brief Compress the remaining data and write the trailer
+ * @return False if there was an error
+ */
+bool deflate_outbuf::finish()
+{
+    if (d_finished) return true;
+    d_finished = true;
+
+    try {
+        m_submit(true);
+        m_write_trailer();
+        d_os.flush();
+    }
+    catch (...) {
+        return false;
+    }
+
+    // Any more data are an error
+    setp(0, 0);
+
+    return !d_os.bad();
+}
+
+// The buffer is full; compress it and then add 'c'
+std::streambuf::int_type deflate_outbuf::overflow(int c)
+{
+    if (d_finished) return traits_type::eof();
+
+    try {
+        m_submit(false);
+    }
+    catch (...) {
+        return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+}
+
+std::streamsize deflate_outbuf::xsputn(const char *s, std::streamsize num)
+{
+    if (d_finished) return 0;
+
+    std::streamsize left = num;
+    while (left > 0) {
+        std::streamsize space = epptr() - pptr();
+        if (space == 0) {
+            try {
+                m_submit(false);
+            }
+            catch (...) {
+                return num - left;
+            }
+            continue;
+        }
+
+        std::streamsize n = min(space, left);
+        memcpy(pptr(), s, n);
+        pbump(n);
+        s += n;
+        left -= n;
+    }
+
+    return num;
+}
+
+// Compress and send the data written so far; the stream is not finished.
+int deflate_outbuf::sync()
+{
+    if (d_finished) return 0;
+
+    try {
+        m_submit(false);
+        m_write_blocks(true);
+    }
+    catch (...) {
+        return -1;
+    }
+
+    d_os.flush();
+    return d_os.bad() ? -1 : 0;
+}
+
+} // namespace libdap
@@ -0,0 +1,168 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#ifndef _deflate_ostream_h
+#define _deflate_ostream_h
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <deque>
+#include <streambuf>
+#include <ostream>
+#include <vector>
+
+namespace libdap {
+
+/// The formats a deflate_ostream can write
+enum deflate_format {
+    deflate_gzip,   // RFC 1952; HTTP Content-Encoding 'gzip'
+    deflate_zlib    // RFC 1950; HTTP Content-Encoding 'deflate'
+};
+
+// The default size of the blocks compressed by the threads
+#define DEFLATE_BLOCK_SIZE (128 * 1024)
+
+// The default number of threads that compress a stream. A server compresses
+// many responses at once, so this is kept small.
+#define DEFLATE_THREADS 2
+
+/**
+ * @brief output buffer for a deflate_ostream
+ *
+ * Data are collected in blocks of block_size bytes. Each full block is
+ * handed to a pool of threads, in the style of pigz, while the next block
+ * is filled; the compressed blocks are written in order. The threads are
+ * started when the buffer is made and are used for all of its blocks. Each
+ * block is compressed using the last 32KB of the data before it as a
+ * dictionary and ends on a byte boundary, so the blocks together make one
+ * deflate stream and compress nearly as well as when a single thread is
+ * used. The checksums of the blocks are combined to get the checksum of the
+ * whole stream. With one thread, blocks are compressed as they fill, by the
+ * thread that writes to the stream.
+ *
+ * The gzip or zlib trailer is written by finish() or by the destructor.
+ */
+class deflate_outbuf: public std::streambuf {
+private:
+    struct block;   // defined in deflate_ostream.cc
+
+    std::ostream &d_os;
+    deflate_format d_format;
+    int d_level;
+    unsigned int d_block_size;
+
+    block *d_current;               // the block being filled
+    std::deque<block *> d_pending;  // compressed or being compressed; in order
+    std::deque<block *> d_queue;    // waiting for a thread
+    std::vector<block *> d_free;    // blocks that can be reused
+    unsigned int d_max_pending;     // then wait for the oldest block
+
+    std::vector<pthread_t> d_threads;
+    pthread_mutex_t d_mutex;
+    pthread_cond_t d_work;          // a block was queued or d_stop was set
+    pthread_cond_t d_done;          // a block was compressed
+    bool d_stop;
+
+    bool d_header_sent;
+    bool d_finished;
+    uint32_t d_check;       // crc32 or adler32 of the data compressed so far
+    uint64_t d_total;       // bytes compressed so far
+
+    static void *worker(void *arg);
+
+    block *m_new_block();
+    void m_compress_block(block *b);
+    void m_submit(bool last);
+    void m_write_blocks(bool all);
+    void m_stop_threads();
+    void m_write_header();
+    void m_write_trailer();
+
+    deflate_outbuf(const deflate_outbuf &);
+    deflate_outbuf &operator=(const deflate_outbuf &);
+
+protected:
+    virtual int_type overflow(int c);
+    virtual std::streamsize xsputn(const char *s, std::streamsize num);
+    virtual int sync();
+
+public:
+    deflate_outbuf(std::ostream &os, deflate_format format, int level, unsigned int num_threads,
+        unsigned int block_size);
+    virtual ~deflate_outbuf();
+
+    bool finish();
+
+    static bool available();
+};
+
+/**
+ * @brief A C++ stream that compresses data using more than one thread
+ *
+ * Data written to the stream are compressed and written to another stream
+ * as a standard gzip (or zlib) stream; any gzip decoder can read it. The
+ * compression is done by \c num_threads threads, in the style of pigz; the
+ * threads are started once, when the stream is made.
+ *
+ * Calling flush() compresses and sends the data written so far; the
+ * compressed stream is finished when the stream is destroyed or finish()
+ * is called.
+ *
+ * @see deflate_outbuf
+ */
+class deflate_ostream: public std::ostream {
+protected:
+    deflate_outbuf d_dbuf;
+
+public:
+    /**
+     * @brief Compress data written to this stream and write them to \c os
+     * @param os Write the compressed data here
+     * @param format Write a gzip or zlib stream
+     * @param level The zlib compression level, -1 for the zlib default
+     * @param num_threads The number of threads to use; zero is the same
+     * as one.
+     * @param block_size Compress the data in blocks of this size
+     * @exception InternalErr if this build of the library does not include
+     * zlib.
+     */
+    deflate_ostream(std::ostream &os, deflate_format format = deflate_gzip, int level = -1,
+        unsigned int num_threads = DEFLATE_THREADS, unsigned int block_size = DEFLATE_BLOCK_SIZE) :
+        std::ostream(&d_dbuf), d_dbuf(os, format, level, num_threads, block_size) { }
+
+    /**
+     * @brief Compress the remaining data and write the trailer
+     * Data written after this are ignored.
+     * @return False if there was an error
+     */
+    bool finish() { return d_dbuf.finish(); }
+
+    /// @return True if the library was built with zlib
+    static bool available() { return deflate_outbuf::available(); }
+};
+
+} // namespace libdap
+
+#endif // _deflate_ostream_h
@@ -58,7 +58,7 @@ fdoutbuf::~fdoutbuf()
 int fdoutbuf::flushBuffer()
 {
 	int num = pptr() - pbase();
-	if (write(1, buffer, num) != num) {
+	if (write(fd, buffer, num) != num) {
 		return EOF;
 	}
 	pbump(-num);
@@ -94,6 +94,10 @@ int fdoutbuf::sync()
 /** write multiple characters */
 std::streamsize fdoutbuf::xsputn(const char *s, std::streamsize num)
 {
+	// Characters already in the buffer go first
+	if (flushBuffer() == EOF) {
+		return 0;
+	}
 	return write(fd, s, num);
 }
 
@@ -58,6 +58,9 @@ public:
 	fdoutbuf(int _fd, bool _close);
 	virtual ~fdoutbuf();
 
+	/** @return The file descriptor this buffer writes to */
+	int get_fd() const { return fd; }
+
 protected:
 	int flushBuffer();
 
@@ -36,6 +36,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <functional>
 
 #include <Array.h>
 #include <Grid.h>
@@ -45,8 +46,8 @@
 #include <debug.h>
 
 #include "GSEClause.h"
+#include "MapStatsCache.h"
 #include "parser.h"
-#include "gse.tab.hh"
 
 using namespace std;
 using namespace libdap;
@@ -79,6 +80,128 @@ compare(T elem, relop op, double value)
     }
 }
 
+static bool
+is_ordering_op(relop op)
+{
+    return op == dods_greater_op || op == dods_greater_equal_op || op == dods_less_op || op == dods_less_equal_op;
+}
+
+// For an ordered map and an ordering operator, is the comparison false for
+// the first elements and true for the rest (and not the other way around)?
+static bool
+becomes_true(map_order order, relop op)
+{
+    return (order == map_increasing) == (op == dods_greater_op || op == dods_greater_equal_op);
+}
+
+// Return the index of the first element in [i, end] for which the comparison
+// is true, or i if i > end, or end + 1 if there is none. The relational
+// operator is a template parameter so the switch is not in the loop.
+template<class V, class Op>
+static int
+scan_forward(const V &vals, int i, int end, Op op, double value)
+{
+    while (i <= end && !op(vals[i], value))
+        i++;
+    return i;
+}
+
+// Return the index of the last element in [0, i] for which the comparison
+// is true, or -1 if there is none.
+template<class V, class Op>
+static int
+scan_backward(const V &vals, int i, Op op, double value)
+{
+    while (i >= 0 && !op(vals[i], value))
+        i--;
+    return i;
+}
+
+// Return the index of the first element in [start, end) for which the
+// comparison is not 'first', or end if there is none. The comparison must be
+// 'first' for all the elements before that one and not for those after it.
+template<class V>
+static int
+partition_point(const V &vals, int start, int end, relop op, double value, bool first)
+{
+    while (start < end) {
+        int mid = start + (end - start) / 2;
+        if (compare(vals[mid], op, value) == first)
+            start = mid + 1;
+        else
+            end = mid;
+    }
+    return start;
+}
+
+// Same as scan_forward(), but uses bisection for an ordered map.
+template<class V>
+static int
+first_match(const V &vals, int start, int end, relop op, double value, map_order order)
+{
+    if (start > end)
+        return start;
+
+    if (order != map_unordered && is_ordering_op(op)) {
+        if (becomes_true(order, op))
+            return partition_point(vals, start, end + 1, op, value, false);
+        else
+            return compare(vals[start], op, value) ? start : end + 1;
+    }
+
+    switch (op) {
+    case dods_greater_op:
+        return scan_forward(vals, start, end, std::greater<double>(), value);
+    case dods_greater_equal_op:
+        return scan_forward(vals, start, end, std::greater_equal<double>(), value);
+    case dods_less_op:
+        return scan_forward(vals, start, end, std::less<double>(), value);
+    case dods_less_equal_op:
+        return scan_forward(vals, start, end, std::less_equal<double>(), value);
+    case dods_equal_op:
+        return scan_forward(vals, start, end, std::equal_to<double>(), value);
+    case dods_not_equal_op:
+        return scan_forward(vals, start, end, std::not_equal_to<double>(), value);
+    default:
+        compare(vals[start], op, value);    // throws
+        return start;
+    }
+}
+
+// Same as scan_backward(), but uses bisection for an ordered map.
+template<class V>
+static int
+last_match(const V &vals, int end, relop op, double value, map_order order)
+{
+    if (end < 0)
+        return end;
+
+    if (order != map_unordered && is_ordering_op(op)) {
+        if (becomes_true(order, op))
+            return compare(vals[end], op, value) ? end : -1;
+        else
+            return partition_point(vals, 0, end + 1, op, value, true) - 1;
+    }
+
+    switch (op) {
+    case dods_greater_op:
+        return scan_backward(vals, end, std::greater<double>(), value);
+    case dods_greater_equal_op:
+        return scan_backward(vals, end, std::greater_equal<double>(), value);
+    case dods_less_op:
+        return scan_backward(vals, end, std::less<double>(), value);
+    case dods_less_equal_op:
+        return scan_backward(vals, end, std::less_equal<double>(), value);
+    case dods_equal_op:
+        return scan_backward(vals, end, std::equal_to<double>(), value);
+    case dods_not_equal_op:
+        return scan_backward(vals, end, std::not_equal_to<double>(), value);
+    default:
+        compare(vals[end], op, value);      // throws
+        return end;
+    }
+}
+
 // These values are used in error messages, hence the strings.
 template<class T>
 void
@@ -94,57 +217,95 @@ GSEClause::set_map_min_max_value(T min, T max)
     d_map_max_value = oss2.str();
 }
 
-// Read the map array, scan, set start and stop.
+// Compute the statistics of a map in one pass.
 template<class T>
-void
-GSEClause::set_start_stop()
+static map_stats
+compute_map_stats(const T *vals, int length, Type type)
 {
-    T *vals = new T[d_map->length()];
-    d_map->value(vals);
+    map_stats stats;
+    stats.type = type;
+    stats.length = length;
+
+    if (length == 0)
+        return stats;
+
+    stats.min = stats.max = vals[0];
+
+    // NaN fails both of these tests, so a map with a NaN is unordered.
+    bool increasing = true, decreasing = true;
+    for (int i = 1; i < length; ++i) {
+        increasing = increasing && vals[i - 1] <= vals[i];
+        decreasing = decreasing && vals[i - 1] >= vals[i];
+
+        if (vals[i] < stats.min) stats.min = vals[i];
+        if (vals[i] > stats.max) stats.max = vals[i];
+    }
+
+    stats.order = increasing ? map_increasing : (decreasing ? map_decreasing : map_unordered);
 
+    return stats;
+}
+
+// Set start and stop using the map values 'vals'.
+template<class T, class V>
+void
+GSEClause::set_start_stop(const V &vals, map_order order)
+{
     // Set the map's max and min values for use in error messages (it's a lot
     // easier to do here, now, than later... 9/20/2001 jhrg)
-    set_map_min_max_value<T>(vals[d_start], vals[d_stop]);
+    set_map_min_max_value<T>(static_cast<T>(vals[d_start]), static_cast<T>(vals[d_stop]));
 
     // Starting at the current start point in the map (initially index position
     // zero), scan forward until the comparison is true. Set the new value
     // of d_start to that location. Note that each clause applies to exactly
     // one map. The 'i <= end' test keeps us from setting start _past_ the
     // end ;-)
-    int i = d_start;
     int end = d_stop;
-    while (i <= end && !compare<T>(vals[i], d_op1, d_value1))
-        i++;
-
-    d_start = i;
+    d_start = first_match(vals, d_start, end, d_op1, d_value1, order);
 
     // Now scan backward from the end. We scan all the way to the actual start
     // although it would probably work to stop at 'i >= d_start'.
-    i = end;
-    while (i >= 0 && !compare<T>(vals[i], d_op1, d_value1))
-        i--;
-    d_stop = i;
+    d_stop = last_match(vals, end, d_op1, d_value1, order);
 
     // Every clause must have one operator but the second is optional since
     // the more complex form of a clause is optional. That is, the above two
     // loops took care of constraints like 'x < 7' but we need the following
     // for ones like '3 < x < 7'.
     if (d_op2 != dods_nop_op) {
-        int i = d_start;
         int end = d_stop;
-        while (i <= end && !compare<T>(vals[i], d_op2, d_value2))
-            i++;
+        d_start = first_match(vals, d_start, end, d_op2, d_value2, order);
+        d_stop = last_match(vals, end, d_op2, d_value2, order);
+    }
+}
 
-        d_start = i;
+// Scan the map array, set start and stop.
+//
+// The map's values are used where the map holds them, without a copy. The
+// statistics of each map are cached (see MapStatsCache); the key identifies
+// the dataset's file and its size and modification time, so a cached entry
+// describes the values read from the same file and is used without looking
+// at the values again. An ordered map is then searched by bisection.
+template<class T>
+void
+GSEClause::set_start_stop()
+{
+    int length = d_map->length();
+    Type type = d_map->var()->type();
 
-        i = end;
-        while (i >= 0 && !compare<T>(vals[i], d_op2, d_value2))
-            i--;
+    const T *vals = reinterpret_cast<const T*>(d_map->get_buf());
+    if (length > 0 && !vals)
+        throw InternalErr(__FILE__, __LINE__, "The map vector '" + d_map->name() + "' has no values.");
 
-        d_stop = i;
+    MapStatsCache *cache = MapStatsCache::TheCache();
+    string key = MapStatsCache::key(d_map);
+
+    map_stats stats;
+    if (!(cache->find(key, stats) && stats.type == type && stats.length == length)) {
+        stats = compute_map_stats(vals, length, type);
+        cache->add(key, stats);
     }
-    
-    delete[] vals;
+
+    set_start_stop<T>(vals, stats.order);
 }
 
 void
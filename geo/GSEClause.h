@@ -37,6 +37,8 @@
 #include <string>
 #include <sstream>
 
+#include "MapStatsCache.h"
+
 #if 0
 #include <BaseType.h>
 #include <Array.h>
@@ -91,6 +93,7 @@ private:
     GSEClause &operator=(GSEClause &rhs); // Hide
 
     template<class T> void set_start_stop();
+    template<class T, class V> void set_start_stop(const V &vals, map_order order);
     template<class T> void set_map_min_max_value(T min, T max);
 
     void compute_indices();
@@ -0,0 +1,202 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <sys/stat.h>
+
+#include <cstdlib>
+#include <sstream>
+
+#include <Array.h>
+#include <debug.h>
+
+#include "MapStatsCache.h"
+
+using namespace std;
+using namespace libdap;
+
+namespace functions {
+
+MapStatsCache *MapStatsCache::d_instance = 0;
+
+static pthread_once_t MapStatsCache_instance_control = PTHREAD_ONCE_INIT;
+
+// The largest number of maps described; when the cache is full it is emptied.
+static const unsigned int default_max_entries = 1024;
+
+void MapStatsCache::initialize_instance()
+{
+    if (d_instance == 0) {
+        DBG(cerr << "MapStatsCache::initialize_instance() - Creating singleton MapStatsCache instance." << endl);
+        d_instance = new MapStatsCache;
+#if HAVE_ATEXIT
+        atexit(delete_instance);
+#endif
+    }
+}
+
+void MapStatsCache::delete_instance()
+{
+    delete d_instance;
+    d_instance = 0;
+}
+
+MapStatsCache::MapStatsCache() : d_max_entries(default_max_entries)
+{
+    pthread_mutex_init(&d_mutex, 0);
+}
+
+MapStatsCache::~MapStatsCache()
+{
+    pthread_mutex_destroy(&d_mutex);
+}
+
+/// @return The single instance of the cache
+MapStatsCache *MapStatsCache::TheCache()
+{
+    pthread_once(&MapStatsCache_instance_control, initialize_instance);
+    return d_instance;
+}
+
+/**
+ * Build the key for a map vector.
+ *
+ * The key holds the dataset's name, the file's device, inode, size and
+ * modification time, the map's fully qualified name and the map's
+ * constraint. When the dataset's file changes, its maps get new keys, so an
+ * entry found using this key describes the values read now.
+ *
+ * @param map The map
+ * @return The key, or the empty string if the map's dataset is not known or
+ * is not a file, in which case it should not be cached.
+ */
+string MapStatsCache::key(Array *map)
+{
+    if (map->dataset().empty())
+        return "";
+
+    struct stat st;
+    if (stat(map->dataset().c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+        return "";
+
+    ostringstream oss;
+    oss << map->dataset() << "#" << st.st_dev << ":" << st.st_ino << ":" << st.st_size << ":" << st.st_mtime
+        << "#" << map->FQN();
+
+    Array::Dim_iter d = map->dim_begin();
+    if (d != map->dim_end())
+        oss << "[" << map->dimension_start(d) << ":" << map->dimension_stride(d) << ":" << map->dimension_stop(d) << "]";
+
+    return oss.str();
+}
+
+/**
+ * Look for the statistics of a map.
+ *
+ * @param key The key for the map; see key()
+ * @param stats Value-result parameter
+ * @return True if the map was found, false otherwise
+ */
+bool MapStatsCache::find(const string &key, map_stats &stats) const
+{
+    if (key.empty()) return false;
+
+    pthread_mutex_lock(&d_mutex);
+
+    StatsMap::const_iterator i = d_stats.find(key);
+    bool found = i != d_stats.end();
+    if (found) stats = i->second;
+
+    pthread_mutex_unlock(&d_mutex);
+
+    return found;
+}
+
+/**
+ * Add, or replace, the statistics of a map.
+ *
+ * @param key The key for the map; see key()
+ * @param stats The statistics
+ */
+void MapStatsCache::add(const string &key, const map_stats &stats)
+{
+    if (key.empty()) return;
+
+    pthread_mutex_lock(&d_mutex);
+
+    if (d_stats.size() >= d_max_entries && d_stats.find(key) == d_stats.end()) d_stats.clear();
+
+    if (d_max_entries > 0) d_stats[key] = stats;
+
+    pthread_mutex_unlock(&d_mutex);
+}
+
+/// Remove the statistics of one map
+void MapStatsCache::remove(const string &key)
+{
+    pthread_mutex_lock(&d_mutex);
+    d_stats.erase(key);
+    pthread_mutex_unlock(&d_mutex);
+}
+
+/// Remove all of the entries
+void MapStatsCache::clear()
+{
+    pthread_mutex_lock(&d_mutex);
+    d_stats.clear();
+    pthread_mutex_unlock(&d_mutex);
+}
+
+/// @return The number of maps in the cache
+unsigned int MapStatsCache::size() const
+{
+    pthread_mutex_lock(&d_mutex);
+    unsigned int size = d_stats.size();
+    pthread_mutex_unlock(&d_mutex);
+    return size;
+}
+
+unsigned int MapStatsCache::get_max_entries() const
+{
+    pthread_mutex_lock(&d_mutex);
+    unsigned int max_entries = d_max_entries;
+    pthread_mutex_unlock(&d_mutex);
+    return max_entries;
+}
+
+/**
+ * Set the largest number of maps the cache will describe. Use zero to turn
+ * the cache off.
+ * @param max_entries The number of maps
+ */
+void MapStatsCache::set_max_entries(unsigned int max_entries)
+{
+    pthread_mutex_lock(&d_mutex);
+    d_max_entries = max_entries;
+    if (d_stats.size() > d_max_entries) d_stats.clear();
+    pthread_mutex_unlock(&d_mutex);
+}
+
+} // namespace functions
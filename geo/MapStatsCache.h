@@ -0,0 +1,113 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#ifndef _map_stats_cache_h
+#define _map_stats_cache_h 1
+
+#include <pthread.h>
+
+#include <map>
+#include <string>
+
+#include <Type.h>
+
+namespace libdap {
+class Array;
+}
+
+namespace functions {
+
+/// Are the values of a map vector in order?
+enum map_order {
+    map_unordered,
+    map_increasing,     ///< Non-decreasing
+    map_decreasing      ///< Non-increasing
+};
+
+/**
+ * @brief Facts about the values of a Grid's map vector.
+ */
+struct map_stats {
+    libdap::Type type;
+    int length;
+
+    double min, max;
+    map_order order;
+
+    map_stats() : type(libdap::dods_null_c), length(0), min(0), max(0), order(map_unordered) { }
+};
+
+/**
+ * @brief A process-wide cache of map_stats.
+ *
+ * Entries are found using the dataset's file and the fully qualified name
+ * of the map (see key()), so the statistics computed for one request are
+ * used by the next request for the same, unchanged, dataset. GSEClause uses
+ * an entry it finds without looking at the map's values. Maps of datasets
+ * that are not files are not cached. When a file changes, the entries for
+ * its old contents are no longer found; they are freed when the cache is
+ * full or by remove() and clear().
+ *
+ * All of the methods are MT-safe.
+ */
+class MapStatsCache {
+private:
+    static MapStatsCache *d_instance;
+
+    typedef std::map<std::string, map_stats> StatsMap;
+
+    StatsMap d_stats;
+    unsigned int d_max_entries;
+
+    mutable pthread_mutex_t d_mutex;
+
+    static void initialize_instance();
+    static void delete_instance();
+
+    MapStatsCache();
+    virtual ~MapStatsCache();
+
+    MapStatsCache(const MapStatsCache &);
+    MapStatsCache &operator=(const MapStatsCache &);
+
+public:
+    static MapStatsCache *TheCache();
+
+    static std::string key(libdap::Array *map);
+
+    bool find(const std::string &key, map_stats &stats) const;
+    void add(const std::string &key, const map_stats &stats);
+    void remove(const std::string &key);
+
+    void clear();
+
+    unsigned int size() const;
+
+    unsigned int get_max_entries() const;
+    void set_max_entries(unsigned int max_entries);
+};
+
+} // namespace functions
+
+#endif // _map_stats_cache_h
@@ -41,12 +41,13 @@
 
 using namespace libdap;
 
-int gse_parse(functions::gse_arg *arg);
-void gse_restart(FILE * in);
+int gse_parse(functions::gse_arg *arg, void *scanner);
+int gse_lex_init(void **scanner);
+int gse_lex_destroy(void *scanner);
 
 // Glue routines declared in gse.lex
-void gse_delete_buffer(void *buffer);
-void *gse_string(const char *yy_str);
+void gse_delete_buffer(void *buffer, void *scanner);
+void *gse_string(const char *yy_str, void *scanner);
 
 namespace functions {
 
@@ -122,13 +123,28 @@ bool is_geo_grid(Grid *grid)
 }
 #endif
 
+// The scanner and parser are reentrant, so this can be called by several
+// threads at once (e.g., when function calls are evaluated in parallel).
 void parse_gse_expression(gse_arg *arg, BaseType *expr)
 {
-    gse_restart(0); // Restart the scanner.
-    void *cls = gse_string(extract_string_argument(expr).c_str());
-    // gse_switch_to_buffer(cls); // Get set to scan the string.
-    bool status = gse_parse(arg) == 0;
-    gse_delete_buffer(cls);
+    void *scanner = 0;
+    if (gse_lex_init(&scanner) != 0)
+        throw InternalErr(__FILE__, __LINE__, "Could not make the grid selection scanner.");
+
+    void *cls = gse_string(extract_string_argument(expr).c_str(), scanner);
+    bool status;
+    try {
+        status = gse_parse(arg, scanner) == 0;
+    }
+    catch (...) {
+        gse_delete_buffer(cls, scanner);
+        gse_lex_destroy(scanner);
+        throw;
+    }
+
+    gse_delete_buffer(cls, scanner);
+    gse_lex_destroy(scanner);
+
     if (!status)
         throw Error(malformed_expr, "Error parsing grid selection.");
 }
@@ -28,14 +28,18 @@
 */ 
 
 /*
-  Scanner for grid selection sub-expressions. The scanner is not reentrant,
-  but can share a name space with other scanners.
+  Scanner for grid selection sub-expressions. The scanner is reentrant; all
+  of its state is held by the yyscan_t made by gse_lex_init(), so the grid()
+  function can parse selections in several threads at the same time. It is
+  used with the pure parser built from gse.yy, which passes the semantic
+  value to the scanner (see the bison-bridge option).
 
    Note:
-   1) The `defines' file gse.tab.h is built using `bison -d'.
-   2) Define YY_DECL such that the scanner is called `gse_lex'.
-   3) When bison builds the gse.tab.h file, it uses `gse_' instead
-   of `yy' for variable name prefixes (e.g., yylval --> gse_lval).
+   1) The `defines' file gse.tab.hh is built using `bison -d'.
+   2) The scanner is called `gse_lex' and takes a pointer to the semantic
+   value and the scanner state.
+   3) Bison uses the `gse_' prefix, so the semantic value type is
+   GSE_STYPE; flex expects it to be called YYSTYPE.
 
    1/13/99 jhrg
 */
@@ -49,11 +53,6 @@
 
 #include "Error.h"
 
-#ifndef YY_PROTO
-#define YY_PROTO(proto) proto
-#endif
-
-#define YY_DECL int gse_lex YY_PROTO(( void ))
 #define ID_MAX 256
 #define YY_NO_UNPUT 1
 #define YY_NO_INPUT 1
@@ -61,21 +60,25 @@
 /* The call to yy_fatal_error() suppresses a warning message. jhrg 8/20/13 */
 #define YY_FATAL_ERROR(msg) {\
     throw(Error(string("Error scanning grid constraint expression text: ") + string(msg)));\
-    yy_fatal_error("never called");\
+    yy_fatal_error("never called", yyscanner);\
 }
 
 #include "gse.tab.hh"
 
+#define YYSTYPE GSE_STYPE
+
 using namespace std;
 using namespace libdap;
 
-static void store_int32();
-static void store_float64();
-static void store_id();
-static void store_op(int op);
+static void store_int32(YYSTYPE *lval, const char *text);
+static void store_float64(YYSTYPE *lval, const char *text);
+static void store_id(YYSTYPE *lval, const char *text);
+static void store_op(YYSTYPE *lval, int op);
 
 %}
 
+%option reentrant
+%option bison-bridge
 %option noyywrap
 %option nounput
 %option 8bit
@@ -108,17 +111,17 @@ NEVER		[^a-zA-Z0-9_/%.#:+\-,]
 
 %%
 
-{SCAN_INT}	store_int32(); return SCAN_INT;
-{SCAN_FLOAT}	store_float64(); return SCAN_FLOAT;
+{SCAN_INT}	store_int32(yylval, yytext); return SCAN_INT;
+{SCAN_FLOAT}	store_float64(yylval, yytext); return SCAN_FLOAT;
 
-{SCAN_WORD}	store_id(); return SCAN_WORD;
+{SCAN_WORD}	store_id(yylval, yytext); return SCAN_WORD;
 
-{SCAN_EQUAL}	store_op(SCAN_EQUAL); return SCAN_EQUAL;
-{SCAN_NOT_EQUAL} store_op(SCAN_NOT_EQUAL); return SCAN_NOT_EQUAL;
-{SCAN_GREATER}	store_op(SCAN_GREATER); return SCAN_GREATER;
-{SCAN_GREATER_EQL} store_op(SCAN_GREATER_EQL); return SCAN_GREATER_EQL;
-{SCAN_LESS}	store_op(SCAN_LESS); return SCAN_LESS;
-{SCAN_LESS_EQL}	store_op(SCAN_LESS_EQL); return SCAN_LESS_EQL;
+{SCAN_EQUAL}	store_op(yylval, SCAN_EQUAL); return SCAN_EQUAL;
+{SCAN_NOT_EQUAL} store_op(yylval, SCAN_NOT_EQUAL); return SCAN_NOT_EQUAL;
+{SCAN_GREATER}	store_op(yylval, SCAN_GREATER); return SCAN_GREATER;
+{SCAN_GREATER_EQL} store_op(yylval, SCAN_GREATER_EQL); return SCAN_GREATER_EQL;
+{SCAN_LESS}	store_op(yylval, SCAN_LESS); return SCAN_LESS;
+{SCAN_LESS_EQL}	store_op(yylval, SCAN_LESS_EQL); return SCAN_LESS_EQL;
 
 %%
 
@@ -126,51 +129,52 @@ NEVER		[^a-zA-Z0-9_/%.#:+\-,]
 // header gse.tab.h nor is YY_BUFFER_STATE. Including these here allows them
 // to see the type definitions in lex.gse.c (where YY_BUFFER_STATE is
 // defined) and allows callers to declare them (since callers outside of this
-// file cannot declare YY_BUFFER_STATE variable).
+// file cannot declare YY_BUFFER_STATE variable). The scanner state passed
+// to these is made by gse_lex_init() and freed by gse_lex_destroy().
 
 void *
-gse_string(const char *str)
+gse_string(const char *str, void *scanner)
 {
-    return (void *)gse__scan_string(str);
+    return (void *)gse__scan_string(str, scanner);
 }
 
 void
-gse_switch_to_buffer(void *buf)
+gse_switch_to_buffer(void *buf, void *scanner)
 {
-    gse__switch_to_buffer((YY_BUFFER_STATE)buf);
+    gse__switch_to_buffer((YY_BUFFER_STATE)buf, scanner);
 }
 
 void
-gse_delete_buffer(void *buf)
+gse_delete_buffer(void *buf, void *scanner)
 {
-    gse__delete_buffer((YY_BUFFER_STATE)buf);
+    gse__delete_buffer((YY_BUFFER_STATE)buf, scanner);
 }
 
 // Note that the grid() CE function only deals with numeric maps (8/28/2001
 // jhrg) and that all comparisons are done using doubles. 
 
 static void
-store_int32()
+store_int32(YYSTYPE *lval, const char *text)
 {
-    gse_lval.val = atof(yytext);
+    lval->val = atof(text);
 }
 
 static void
-store_float64()
+store_float64(YYSTYPE *lval, const char *text)
 {
-    gse_lval.val = atof(yytext);
+    lval->val = atof(text);
 }
 
 static void
-store_id()
+store_id(YYSTYPE *lval, const char *text)
 {
-    strncpy(gse_lval.id, yytext, ID_MAX-1);
-    gse_lval.id[ID_MAX-1] = '\0';
+    strncpy(lval->id, text, ID_MAX-1);
+    lval->id[ID_MAX-1] = '\0';
 }
 
 static void
-store_op(int op)
+store_op(YYSTYPE *lval, int op)
 {
-    gse_lval.op = op;
+    lval->op = op;
 }
 
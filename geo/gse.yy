@@ -58,8 +58,8 @@ using namespace functions;
 
 %code {
 
-int gse_lex(void);
-void gse_error(gse_arg *arg, const char *str);
+int gse_lex(YYSTYPE *lvalp, void *scanner);
+void gse_error(gse_arg *arg, void *scanner, const char *str);
 GSEClause *build_gse_clause(gse_arg *arg, char id[ID_MAX], int op, double val);
 GSEClause *build_rev_gse_clause(gse_arg *arg, char id[ID_MAX], int op,
 				double val);
@@ -69,10 +69,16 @@ build_dual_gse_clause(gse_arg *arg, char id[ID_MAX], int op1, double val1,
 
 } // code
 
-%require "2.4"
+%require "3.0"
 
+// The parser and the scanner (see gse.ll) are reentrant; the scanner's state
+// is passed to the parser along with the gse_arg.
+%define api.pure
 %parse-param {gse_arg *arg}
-%name-prefix "gse_"
+%parse-param {void *scanner}
+%lex-param {void *scanner}
+%define api.prefix {gse_}
+// %name-prefix "gse_"
 %defines
 %debug
 %verbose
@@ -143,7 +149,7 @@ relop:	SCAN_EQUAL
 %%
 
 void
-gse_error(gse_arg *, const char *)
+gse_error(gse_arg *, void *, const char *)
 {
     throw Error(
 "An expression passed to the grid() function could not be parsed.\n\
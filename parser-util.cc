@@ -35,6 +35,8 @@
 
 #include "config.h"
 
+#include <pthread.h>
+
 #include <cerrno>
 #include <cassert>
 #include <cstring>
@@ -52,6 +54,7 @@ double w32strtod(const char *, char **);
 #endif
 
 #include "Error.h"
+#include "InternalErr.h"
 #include "debug.h"
 #include "parser.h"             // defines constants such as ID_MAX
 #include "dods-limits.h"
@@ -86,6 +89,38 @@ double w32strtod(const char *val, char **ptr)
 
 namespace libdap {
 
+// One lock for each of the grammars in parser_lock::grammar. They are
+// recursive because a server function may parse a CE while another CE is
+// being parsed.
+static pthread_mutex_t parser_mutex[parser_lock::error_grammar + 1];
+static pthread_once_t parser_mutex_control = PTHREAD_ONCE_INIT;
+
+static void initialize_parser_mutexes()
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+
+    for (int i = 0; i <= parser_lock::error_grammar; ++i)
+        pthread_mutex_init(&parser_mutex[i], &attr);
+
+    pthread_mutexattr_destroy(&attr);
+}
+
+parser_lock::parser_lock(grammar g) : d_grammar(g)
+{
+    pthread_once(&parser_mutex_control, initialize_parser_mutexes);
+
+    int status = pthread_mutex_lock(&parser_mutex[d_grammar]);
+    if (status != 0)
+        throw InternalErr(__FILE__, __LINE__, "Could not lock the parser mutex.");
+}
+
+parser_lock::~parser_lock()
+{
+    pthread_mutex_unlock(&parser_mutex[d_grammar]);
+}
+
 // Deprecated, but still used by the HDF4 EOS server code.
 void
 parse_error(parser_arg * arg, const char *msg, const int line_num,
@@ -133,6 +133,42 @@ void parse_error(const string &msg, const int line_num,
                  const char *context = 0);
 //@}
 
+/** The scanners and parsers built by flex and bison for the DAS, DDS and
+    Error grammars keep their state in global variables, so only one thread
+    at a time can use each of them. An instance of <tt>parser_lock</tt>
+    holds the lock for one grammar until it is destroyed; DAS::parse(),
+    DDS::parse() and Error::parse() use it so that callers do not need to
+    serialize parsing themselves. Different grammars can be used by
+    different threads at the same time. The locks are recursive.
+
+    @note The DAP2 constraint expression scanner and parser (ce_expr.lex and
+    ce_expr.yy) and the grid() selection expression scanner and parser
+    (geo/gse.ll and geo/gse.yy) are reentrant and do not need this lock;
+    neither do the DAP4 parsers (D4ParserSax2 and the D4ConstraintEvaluator
+    and D4FunctionEvaluator scanners and parsers), which keep their state in
+    the parser objects.
+
+    @brief Serialize the use of one of the DAP2 parsers. */
+class parser_lock
+{
+public:
+    enum grammar {
+        das_grammar,
+        dds_grammar,
+        error_grammar
+    };
+
+    parser_lock(grammar g);
+    ~parser_lock();
+
+private:
+    grammar d_grammar;
+
+    parser_lock();
+    parser_lock(const parser_lock &);
+    parser_lock &operator=(const parser_lock &);
+};
+
 } // namespace libdap
 
 #include "parser-util.h"
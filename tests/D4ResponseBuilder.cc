@@ -130,8 +130,8 @@ void D4ResponseBuilder::send_dap(ostream &out, DMR &dmr, bool with_mime_headers,
 		// Set up the alarm.
 		establish_timeout(out);
 
-		if (dmr.response_limit() != 0 && dmr.request_size(true) > dmr.response_limit()) {
-			string msg = "The Request for " + long_to_string(dmr.request_size(true) / 1024)
+		if (dmr.too_big()) {
+			string msg = "The Request for " + long_to_string(dmr.request_size_kb(true) / 1024)
 					+ "MB is too large; requests for this user are limited to "
 					+ long_to_string(dmr.response_limit() / 1024) + "MB.";
 			throw Error(msg);
@@ -146,8 +146,9 @@ void D4ResponseBuilder::send_dap(ostream &out, DMR &dmr, bool with_mime_headers,
 
 	    // now make the chunked output stream; set the size to be at least chunk_size
 	    // but make sure that the whole of the xml plus the CRLF can fit in the first
-	    // chunk. (+2 for the CRLF bytes).
-	    chunked_ostream cos(out, max((unsigned int)CHUNK_SIZE, xml.get_doc_size()+2));
+	    // chunk. (+2 for the CRLF bytes). The chunks grow as the data are sent, up
+	    // to BULK_CHUNK_SIZE bytes.
+	    chunked_ostream cos(out, max((unsigned int)CHUNK_SIZE, xml.get_doc_size()+2), BULK_CHUNK_SIZE);
 
 	    // using flush means that the DMR and CRLF are in the first chunk.
 	    cos << xml.get_doc() << CRLF << flush;
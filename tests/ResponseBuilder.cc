@@ -504,8 +504,8 @@ void ResponseBuilder::send_data(ostream &data_stream, DDS &dds, ConstraintEvalua
 
         fdds->tag_nested_sequences(); // Tag Sequences as Parent or Leaf node.
 
-        if (fdds->get_response_limit() != 0 && fdds->get_request_size(true) > fdds->get_response_limit()) {
-            string msg = "The Request for " + long_to_string(dds.get_request_size(true) / 1024)
+        if (fdds->too_big()) {
+            string msg = "The Request for " + long_to_string(fdds->get_request_size_kb(true))
                     + "KB is too large; requests for this user are limited to "
                     + long_to_string(dds.get_response_limit() / 1024) + "KB.";
             throw Error(msg);
@@ -527,8 +527,8 @@ void ResponseBuilder::send_data(ostream &data_stream, DDS &dds, ConstraintEvalua
 
 	dds.tag_nested_sequences(); // Tag Sequences as Parent or Leaf node.
 
-	if (dds.get_response_limit() != 0 && dds.get_request_size(true) > dds.get_response_limit()) {
-		string msg = "The Request for " + long_to_string(dds.get_request_size(true) / 1024)
+	if (dds.too_big()) {
+		string msg = "The Request for " + long_to_string(dds.get_request_size_kb(true))
 				+ "KB is too large; requests for this user are limited to "
 				+ long_to_string(dds.get_response_limit() / 1024) + "KB.";
 		throw Error(msg);
@@ -87,6 +87,7 @@ int test_variable_sleep_interval = 0;   // Used in Test* classes for testing
 
 void test_scanner(const string & str);
 void test_scanner(bool show_prompt);
+void test_scanner(bool show_prompt, void *scanner);
 void test_parser(ConstraintEvaluator & eval, DDS & table,
                  const string & dds_name, string constraint);
 bool read_table(DDS & table, const string & name, bool print);
@@ -96,14 +97,15 @@ void constrained_trans(const string & dds_name, const bool constraint_expr,
 void intern_data_test(const string & dds_name, const bool constraint_expr,
                  const string & ce, const bool series_values);
 
-int ce_exprlex();               // exprlex() uses the global ce_exprlval
-// int ce_exprparse(void *arg);
-void ce_exprrestart(FILE * in);
+// The scanner is reentrant; see ce_expr.lex
+int ce_exprlex(CE_EXPRSTYPE *lvalp, void *scanner);
+int ce_exprlex_init(void **scanner);
+int ce_exprlex_destroy(void *scanner);
 
-// Glue routines declared in expr.lex
-void ce_expr_switch_to_buffer(void *new_buffer);
-void ce_expr_delete_buffer(void *buffer);
-void *ce_expr_string(const char *yy_str);
+// Glue routines declared in ce_expr.lex
+void ce_expr_switch_to_buffer(void *new_buffer, void *scanner);
+void ce_expr_delete_buffer(void *buffer, void *scanner);
+void *ce_expr_string(const char *yy_str, void *scanner);
 
 extern int ce_exprdebug;
 
@@ -278,22 +280,36 @@ int main(int argc, char *argv[])
 
 void test_scanner(const string & str)
 {
-    ce_exprrestart(0);
-    void *buffer = ce_expr_string(str.c_str());
-    ce_expr_switch_to_buffer(buffer);
+    void *scanner;
+    ce_exprlex_init(&scanner);
+    void *buffer = ce_expr_string(str.c_str(), scanner);
+    ce_expr_switch_to_buffer(buffer, scanner);
 
-    test_scanner(false);
+    test_scanner(false, scanner);
 
-    ce_expr_delete_buffer(buffer);
+    ce_expr_delete_buffer(buffer, scanner);
+    ce_exprlex_destroy(scanner);
 }
 
+// Read the tokens from stdin
 void test_scanner(bool show_prompt)
+{
+    void *scanner;
+    ce_exprlex_init(&scanner);
+
+    test_scanner(show_prompt, scanner);
+
+    ce_exprlex_destroy(scanner);
+}
+
+void test_scanner(bool show_prompt, void *scanner)
 {
     if (show_prompt)
         cout << prompt;
 
+    CE_EXPRSTYPE ce_exprlval;
     int tok;
-    while ((tok = ce_exprlex())) {
+    while ((tok = ce_exprlex(&ce_exprlval, scanner))) {
         switch (tok) {
         case SCAN_WORD:
             cout << "WORD: " << ce_exprlval.id << endl;
@@ -28,14 +28,25 @@
 
 #include <cstring>
 #include <string>
+#include <sstream>
+#include <memory>
 
 #include "GNURegex.h"
 
 #include "Array.h"
 #include "Int16.h"
+#include "Float64.h"
 #include "Str.h"
 #include "Structure.h"
 #include "D4Dimensions.h"
+#include "DDS.h"
+#include "DMR.h"
+#include "BaseTypeFactory.h"
+#include "ConstraintEvaluator.h"
+#include "XDRStreamMarshaller.h"
+#include "D4StreamMarshaller.h"
+#include "XDRStreamUnMarshaller.h"
+#include "D4StreamUnMarshaller.h"
 
 #include "debug.h"
 #include "GetOpt.h"
@@ -47,6 +58,25 @@ static bool debug = false;
 
 namespace libdap {
 
+// An Array of Int16 whose values (0, 1, 2, ...) are produced by read_chunk().
+class ChunkedInt16Array: public Array {
+public:
+    int d_chunks_read;
+
+    ChunkedInt16Array(const string &n, BaseType *v) : Array(n, v), d_chunks_read(0) { }
+
+    virtual BaseType *ptr_duplicate() { return new ChunkedInt16Array(*this); }
+
+    virtual void read_chunk(unsigned int start, unsigned int count)
+    {
+        CPPUNIT_ASSERT(count <= get_chunk_size());
+        dods_int16 *buf = reinterpret_cast<dods_int16*>(get_buf());
+        for (unsigned int i = 0; i < count; ++i)
+            buf[i] = start + i;
+        ++d_chunks_read;
+    }
+};
+
 class ArrayTest: public TestFixture {
 private:
     Array *d_cardinal, *d_string, *d_structure;
@@ -150,6 +180,15 @@ public:
     CPPUNIT_TEST (duplicate_cardinal_test);
     CPPUNIT_TEST (duplicate_string_test);
     CPPUNIT_TEST (duplicate_structure_test);
+    CPPUNIT_TEST (chunked_serialize_test);
+    CPPUNIT_TEST (chunked_d4_serialize_test);
+    CPPUNIT_TEST (chunked_intern_data_test);
+    CPPUNIT_TEST (get_str_test);
+    CPPUNIT_TEST (string_serialize_test);
+    CPPUNIT_TEST (structure_column_serialize_test);
+    CPPUNIT_TEST (structure_column_d4_serialize_test);
+    CPPUNIT_TEST (structure_column_compound_buf_test);
+    CPPUNIT_TEST (structure_column_var_test);
 
     CPPUNIT_TEST_SUITE_END();
 
@@ -336,6 +375,327 @@ public:
         b2 = 0;
     }
 
+    // A chunked array must serialize exactly as one read using read().
+    void chunked_serialize_test()
+    {
+        Int16 i16("Int16");
+        ChunkedInt16Array chunked("Array_of_Int16", &i16);
+        chunked.append_dim(10, "dimension");
+        chunked.set_chunk_size(3);
+
+        Array whole("Array_of_Int16", &i16);
+        whole.append_dim(10, "dimension");
+        dods_int16 buffer[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        whole.val2buf(buffer);
+        whole.set_read_p(true);
+
+        BaseTypeFactory factory;
+        DDS dds(&factory, "dds");
+        ConstraintEvaluator eval;
+
+        ostringstream chunked_oss;
+        {
+            XDRStreamMarshaller m(chunked_oss);
+            chunked.serialize(eval, dds, m, false);
+        }
+        ostringstream whole_oss;
+        {
+            XDRStreamMarshaller m(whole_oss);
+            whole.serialize(eval, dds, m, false);
+        }
+
+        CPPUNIT_ASSERT(chunked.d_chunks_read == 4);
+        CPPUNIT_ASSERT(!chunked.read_p());
+        CPPUNIT_ASSERT(chunked.get_buf() == 0);
+        CPPUNIT_ASSERT(chunked_oss.str() == whole_oss.str());
+    }
+
+    void chunked_d4_serialize_test()
+    {
+        Int16 i16("Int16");
+        ChunkedInt16Array chunked("Array_of_Int16", &i16);
+        chunked.append_dim(10, "dimension");
+        chunked.set_chunk_size(4);
+
+        DMR dmr;
+        ostringstream oss;
+        {
+            // The marshaller may write using a child thread; its dtor waits for that
+            D4StreamMarshaller m(oss);
+            chunked.serialize(m, dmr);
+        }
+
+        CPPUNIT_ASSERT(chunked.d_chunks_read == 3);
+        string data = oss.str();
+        CPPUNIT_ASSERT(data.length() == 10 * sizeof(dods_int16));
+        const dods_int16 *values = reinterpret_cast<const dods_int16*>(data.data());
+        for (int i = 0; i < 10; ++i)
+            CPPUNIT_ASSERT(values[i] == i);
+    }
+
+    void chunked_intern_data_test()
+    {
+        Int16 i16("Int16");
+        ChunkedInt16Array chunked("Array_of_Int16", &i16);
+        chunked.append_dim(10, "dimension");
+        chunked.set_chunk_size(8);
+
+        chunked.intern_data();
+
+        CPPUNIT_ASSERT(chunked.d_chunks_read == 2);
+        CPPUNIT_ASSERT(chunked.read_p());
+        dods_int16 values[10];
+        chunked.value(values);
+        for (int i = 0; i < 10; ++i)
+            CPPUNIT_ASSERT(values[i] == i);
+    }
+
+    // Changes made using the reference returned by get_str() must be seen
+    // by the other methods.
+    void get_str_test()
+    {
+        vector<string> &strs = d_string->get_str();
+        CPPUNIT_ASSERT(strs.size() == 4);
+        CPPUNIT_ASSERT(strs[2] == svalues[2]);
+        strs[2] = "A much longer replacement for the third string";
+
+        vector<string> values;
+        d_string->value(values);
+        CPPUNIT_ASSERT(values.size() == 4);
+        CPPUNIT_ASSERT(values[1] == svalues[1]);
+        CPPUNIT_ASSERT(values[2] == "A much longer replacement for the third string");
+
+        Array a = *d_string;
+        a.value(values);
+        CPPUNIT_ASSERT(values[2] == "A much longer replacement for the third string");
+
+        d_string->reserve_value_capacity();
+        d_string->value(values);
+        CPPUNIT_ASSERT(values[2] == "A much longer replacement for the third string");
+        CPPUNIT_ASSERT(values[3] == svalues[3]);
+    }
+
+    void string_serialize_test()
+    {
+        BaseTypeFactory factory;
+        DDS dds(&factory, "dds");
+        ConstraintEvaluator eval;
+
+        d_string->set_read_p(true);
+        ostringstream oss;
+        {
+            XDRStreamMarshaller m(oss);
+            d_string->serialize(eval, dds, m, false);
+        }
+
+        Str s("Str");
+        Array result("Array_of_String", &s);
+        result.append_dim(4, "dimension");
+        istringstream iss(oss.str());
+        XDRStreamUnMarshaller um(iss);
+        result.deserialize(um, &dds);
+
+        vector<string> values;
+        result.value(values);
+        CPPUNIT_ASSERT(values.size() == 4);
+        for (int i = 0; i < 4; ++i)
+            CPPUNIT_ASSERT(values[i] == svalues[i]);
+    }
+
+    // Make a Structure { Int16 i; Str s; Structure { Float64 f; } inner; }
+    Structure *make_struct(const string &name)
+    {
+        Structure *s = new Structure(name);
+        Int16 i("i");
+        s->add_var(&i);
+        Str str("s");
+        s->add_var(&str);
+        Structure inner("inner");
+        Float64 f("f");
+        inner.add_var(&f);
+        s->add_var(&inner);
+        return s;
+    }
+
+    void set_struct_values(Structure *s, int n)
+    {
+        static_cast<Int16*>(s->var("i"))->set_value(n);
+        ostringstream oss;
+        oss << "element " << n;
+        static_cast<Str*>(s->var("s"))->set_value(oss.str());
+        static_cast<Float64*>(s->var("inner.f"))->set_value(n / 2.0);
+        s->set_read_p(true);
+    }
+
+    void check_struct_values(BaseType *btp, int n)
+    {
+        Structure *s = dynamic_cast<Structure*>(btp);
+        CPPUNIT_ASSERT(s);
+        CPPUNIT_ASSERT(static_cast<Int16*>(s->var("i"))->value() == n);
+        ostringstream oss;
+        oss << "element " << n;
+        CPPUNIT_ASSERT(static_cast<Str*>(s->var("s"))->value() == oss.str());
+        CPPUNIT_ASSERT(static_cast<Float64*>(s->var("inner.f"))->value() == n / 2.0);
+    }
+
+    // Arrays of simple Structures built using set_vec() hold only the values
+    // of the elements; they must serialize exactly like arrays of objects.
+    void structure_column_serialize_test()
+    {
+        const int num = 5;
+        auto_ptr<Structure> proto(make_struct("s"));
+        Array column("a", proto.get());
+        column.append_dim(num, "dimension");
+        Array objects("a", proto.get());
+        objects.append_dim(num, "dimension");
+        for (int i = 0; i < num; ++i) {
+            set_struct_values(proto.get(), i);
+            column.set_vec(i, proto.get());
+
+            Structure *s = make_struct("s");
+            set_struct_values(s, i);
+            objects.set_vec_nocopy(i, s);
+        }
+        column.set_read_p(true);
+        column.set_send_p(true);
+        objects.set_read_p(true);
+        objects.set_send_p(true);
+
+        BaseTypeFactory factory;
+        DDS dds(&factory, "dds");
+        ConstraintEvaluator eval;
+
+        ostringstream column_oss;
+        {
+            XDRStreamMarshaller m(column_oss);
+            column.serialize(eval, dds, m, false);
+        }
+        ostringstream objects_oss;
+        {
+            XDRStreamMarshaller m(objects_oss);
+            objects.serialize(eval, dds, m, false);
+        }
+        CPPUNIT_ASSERT(column_oss.str() == objects_oss.str());
+
+        for (int i = 0; i < num; ++i)
+            check_struct_values(column.var(i), i);
+
+        Array result("a", proto.get());
+        result.append_dim(num, "dimension");
+        istringstream iss(column_oss.str());
+        XDRStreamUnMarshaller um(iss);
+        result.deserialize(um, &dds);
+
+        for (int i = 0; i < num; ++i)
+            check_struct_values(result.var(i), i);
+
+        Array copy = result;
+        for (int i = 0; i < num; ++i)
+            check_struct_values(copy.var(i), i);
+    }
+
+    void structure_column_d4_serialize_test()
+    {
+        const int num = 5;
+        auto_ptr<Structure> proto(make_struct("s"));
+        Array a("a", proto.get(), true);
+        a.append_dim(num, "dimension");
+        for (int i = 0; i < num; ++i) {
+            set_struct_values(proto.get(), i);
+            a.set_vec(i, proto.get());
+        }
+        a.set_read_p(true);
+        a.set_send_p(true);
+
+        DMR dmr;
+        ostringstream oss;
+        {
+            D4StreamMarshaller m(oss);
+            a.serialize(m, dmr);
+        }
+
+        Array result("a", proto.get(), true);
+        result.append_dim(num, "dimension");
+        istringstream iss(oss.str());
+        D4StreamUnMarshaller um(iss, 0);
+        result.deserialize(um, dmr);
+
+        for (int i = 0; i < num; ++i)
+            check_struct_values(result.var(i), i);
+    }
+
+    // get_compound_buf() makes an object for each element held in a column
+    void structure_column_compound_buf_test()
+    {
+        const int num = 3;
+        auto_ptr<Structure> proto(make_struct("s"));
+        Array a("a", proto.get());
+        a.append_dim(num, "dimension");
+        for (int i = 0; i < num; ++i) {
+            set_struct_values(proto.get(), i);
+            a.set_vec(i, proto.get());
+        }
+
+        vector<BaseType*> &elements = a.get_compound_buf();
+        CPPUNIT_ASSERT(elements.size() >= (unsigned int)num);
+        for (int i = 0; i < num; ++i) {
+            CPPUNIT_ASSERT(elements[i] == a.var(i));
+            check_struct_values(elements[i], i);
+        }
+
+        // Once the elements are objects, set_vec() stores copies
+        set_struct_values(proto.get(), 7);
+        a.set_vec(1, proto.get());
+        CPPUNIT_ASSERT(a.var(1) != a.var(2));
+        check_struct_values(a.var(1), 7);
+        check_struct_values(a.var(2), 2);
+    }
+
+    // Elements held in a column are distinct objects once var() returns them
+    void structure_column_var_test()
+    {
+        const int num = 3;
+        auto_ptr<Structure> proto(make_struct("s"));
+        Array a("a", proto.get());
+        a.append_dim(num, "dimension");
+        for (int i = 0; i < num; ++i) {
+            set_struct_values(proto.get(), i);
+            a.set_vec(i, proto.get());
+        }
+
+        BaseType *first = a.var(0);
+        BaseType *second = a.var(1);
+        CPPUNIT_ASSERT(first != second);
+        check_struct_values(first, 0);
+        check_struct_values(second, 1);
+
+        // Changes made through either pointer are kept
+        set_struct_values(static_cast<Structure*>(first), 5);
+        set_struct_values(static_cast<Structure*>(second), 6);
+        check_struct_values(a.var(0), 5);
+        check_struct_values(a.var(1), 6);
+        check_struct_values(a.var(2), 2);
+
+        // The column is not used once elements are objects
+        set_struct_values(proto.get(), 8);
+        a.set_vec(2, proto.get());
+        check_struct_values(a.var(2), 8);
+        CPPUNIT_ASSERT(a.var(0) == first);
+
+        // set_vec_nocopy() takes the place of an element that was not seen
+        Array b("b", proto.get());
+        b.append_dim(num, "dimension");
+        for (int i = 0; i < num; ++i) {
+            set_struct_values(proto.get(), i);
+            b.set_vec(i, proto.get());
+        }
+        Structure *s = make_struct("s");
+        set_struct_values(s, 9);
+        b.set_vec_nocopy(1, s);
+        CPPUNIT_ASSERT(b.var(1) == s);
+        check_struct_values(b.var(0), 0);
+    }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION (ArrayTest);
@@ -151,6 +151,11 @@ public:
     CPPUNIT_TEST (append_attr_vector_test);
     CPPUNIT_TEST (print_xml_test);
     CPPUNIT_TEST (print_simple_test);
+    CPPUNIT_TEST (binary_attr_test);
+    CPPUNIT_TEST (binary_attr_copy_test);
+    CPPUNIT_TEST (binary_attr_values_test);
+    CPPUNIT_TEST (binary_attr_append_test);
+    CPPUNIT_TEST (large_table_find_test);
 
     CPPUNIT_TEST_SUITE_END();
 
@@ -469,7 +474,169 @@ String longer%20name \"second test\";";
         CPPUNIT_ASSERT(buf.str().find("String type \"cars\";") != string::npos);        
         ifs.close();
     }
-    
+
+    void binary_attr_test()
+    {
+        dods_int16 shorts[] = { -1, 2, 300 };
+        dods_float64 doubles[] = { 3.5, 1.0e-3 };
+        AttrTable at;
+        CPPUNIT_ASSERT(at.append_attr("shorts", shorts, 3) == 3);
+        CPPUNIT_ASSERT(at.append_attr("doubles", doubles, 2) == 2);
+
+        CPPUNIT_ASSERT(at.get_type("shorts") == "Int16");
+        CPPUNIT_ASSERT(at.get_attr_num("shorts") == 3);
+        CPPUNIT_ASSERT(at.get_attr("shorts", 0) == "-1");
+        CPPUNIT_ASSERT(at.get_attr("shorts", 2) == "300");
+        CPPUNIT_ASSERT(at.get_attr("doubles", 1) == "0.001");
+
+        ostringstream oss;
+        at.print(oss);
+        DBG(cerr << oss.str() << endl);
+        CPPUNIT_ASSERT(oss.str().find("Int16 shorts -1, 2, 300;") != string::npos);
+        CPPUNIT_ASSERT(oss.str().find("Float64 doubles 3.5, 0.001;") != string::npos);
+
+        vector<string> *sv = at.get_attr_vector("shorts");
+        CPPUNIT_ASSERT(sv && sv->size() == 3);
+        CPPUNIT_ASSERT((*sv)[1] == "2");
+
+        at.del_attr("doubles", 0);
+        CPPUNIT_ASSERT(at.get_attr_num("doubles") == 1);
+        CPPUNIT_ASSERT(at.get_attr("doubles") == "0.001");
+
+        // Removing the last value removes the attribute
+        at.del_attr("doubles", 0);
+        CPPUNIT_ASSERT(at.simple_find("doubles") == at.attr_end());
+        oss.str("");
+        at.print(oss);
+        CPPUNIT_ASSERT(oss.str().find("doubles") == string::npos);
+    }
+
+    void binary_attr_copy_test()
+    {
+        dods_uint32 values[] = { 1, 2, 4000000000U };
+        AttrTable at;
+        at.append_attr("values", values, 3);
+
+        AttrTable copy(at);
+        CPPUNIT_ASSERT(copy.get_attr_num("values") == 3);
+        CPPUNIT_ASSERT(copy.get_attr("values", 2) == "4000000000");
+        CPPUNIT_ASSERT(at.get_attr("values", 2) == "4000000000");
+    }
+
+    void binary_attr_values_test()
+    {
+        dods_float32 floats[] = { 1.5, -2.0 };
+        AttrTable at;
+        at.append_attr("floats", floats, 2);
+
+        vector<dods_float32> fv;
+        at.get_attr_values(at.simple_find("floats"), fv);
+        CPPUNIT_ASSERT(fv.size() == 2 && fv[0] == 1.5 && fv[1] == -2.0);
+
+        vector<dods_int32> iv;
+        at.get_attr_values(at.simple_find("floats"), iv);
+        CPPUNIT_ASSERT(iv.size() == 2 && iv[1] == -2);
+
+        // Values held as strings are parsed
+        at.append_attr("size", "Int32", "7");
+        at.append_attr("size", "Int32", "42");
+        at.get_attr_values(at.simple_find("size"), iv);
+        CPPUNIT_ASSERT(iv.size() == 2 && iv[0] == 7 && iv[1] == 42);
+
+        at.append_attr("name", "String", "\"x\"");
+        try {
+            at.get_attr_values(at.simple_find("name"), iv);
+            CPPUNIT_FAIL("Expected an Error for a String attribute");
+        }
+        catch (Error &e) {
+            DBG(cerr << e.get_error_message() << endl);
+        }
+    }
+
+    void binary_attr_append_test()
+    {
+        dods_byte bytes[] = { 1, 255 };
+        AttrTable at;
+        at.append_attr("bytes", bytes, 2);
+        at.append_attr("bytes", bytes, 1);
+        CPPUNIT_ASSERT(at.get_attr_num("bytes") == 3);
+
+        // Adding no values to an attribute is allowed, creating an
+        // attribute without values is not
+        CPPUNIT_ASSERT(at.append_attr("bytes", bytes, 0) == 3);
+        try {
+            at.append_attr("no_bytes", bytes, 0);
+            CPPUNIT_FAIL("Expected an Error for an attribute without values");
+        }
+        catch (Error &e) {
+            DBG(cerr << e.get_error_message() << endl);
+        }
+        CPPUNIT_ASSERT(at.simple_find("no_bytes") == at.attr_end());
+        CPPUNIT_ASSERT(at.get_attr("bytes", 1) == "255");
+        CPPUNIT_ASSERT(at.get_attr("bytes", 2) == "1");
+
+        // Adding a string value converts the binary values to strings
+        at.append_attr("bytes", "Byte", "7");
+        CPPUNIT_ASSERT(at.get_attr_num("bytes") == 4);
+        at.append_attr("bytes", bytes, 1);
+        CPPUNIT_ASSERT(at.get_attr_num("bytes") == 5);
+        CPPUNIT_ASSERT(at.get_attr("bytes", 3) == "7");
+        CPPUNIT_ASSERT(at.get_attr("bytes", 4) == "1");
+
+        dods_int16 shorts[] = { 1 };
+        try {
+            at.append_attr("bytes", shorts, 1);
+            CPPUNIT_FAIL("Expected an Error for a type mismatch");
+        }
+        catch (Error &e) {
+            DBG(cerr << e.get_error_message() << endl);
+        }
+    }
+
+    // Tables this large use an index to find attributes by name
+    void large_table_find_test()
+    {
+        AttrTable at;
+        for (int i = 0; i < 100; ++i) {
+            ostringstream name;
+            name << "attr_" << i;
+            at.append_attr(name.str(), "Int32", "1");
+        }
+        AttrTable *c = at.append_container("cont");
+        c->append_attr("inner", "String", "\"x\"");
+        at.append_attr("attr_7", "Int32", "2");
+
+        CPPUNIT_ASSERT(at.get_size() == 101);
+        CPPUNIT_ASSERT(at.get_attr_num("attr_7") == 2);
+        CPPUNIT_ASSERT(at.get_attr("attr_99") == "1");
+        CPPUNIT_ASSERT(at.simple_find("attr_100") == at.attr_end());
+        CPPUNIT_ASSERT(at.find_container("cont") == c);
+        CPPUNIT_ASSERT(at.find_container("attr_3") == 0);
+
+        AttrTable::Attr_iter loc;
+        CPPUNIT_ASSERT(at.recurrsive_find("inner", &loc) == c);
+        CPPUNIT_ASSERT(c->get_name(loc) == "inner");
+        CPPUNIT_ASSERT(at.recurrsive_find("attr_50", &loc) == &at);
+        CPPUNIT_ASSERT(at.get_name(loc) == "attr_50");
+
+        // Deleting an entry moves the ones that follow it
+        at.del_attr("attr_0");
+        CPPUNIT_ASSERT(at.get_size() == 100);
+        CPPUNIT_ASSERT(at.simple_find("attr_0") == at.attr_end());
+        CPPUNIT_ASSERT(at.get_name(at.simple_find("attr_1")) == "attr_1");
+        CPPUNIT_ASSERT(at.get_attr_table("cont") == c);
+
+        at.append_attr("attr_0", "Int32", "3");
+        CPPUNIT_ASSERT(at.get_name(at.get_attr_iter(at.get_size() - 1)) == "attr_0");
+        CPPUNIT_ASSERT(at.get_attr("attr_0") == "3");
+
+        AttrTable copy(at);
+        CPPUNIT_ASSERT(copy.get_attr("attr_0") == "3");
+        CPPUNIT_ASSERT(copy.get_attr("attr_42") == "1");
+        CPPUNIT_ASSERT(copy.find_container("cont") != c);
+        CPPUNIT_ASSERT(copy.find_container("cont")->get_attr("inner") == "\"x\"");
+    }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION (AttrTableTest);
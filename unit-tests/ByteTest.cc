@@ -128,6 +128,7 @@ public:
     CPPUNIT_TEST(basetype_FQN_test);
     CPPUNIT_TEST(basetype_print_decl_test);
     CPPUNIT_TEST(set_attributes_test);
+    CPPUNIT_TEST(shared_attributes_test);
 
     CPPUNIT_TEST_SUITE_END();
 
@@ -382,6 +383,44 @@ public:
         CPPUNIT_ASSERT(a2->find("first")->name() == "first");
     }
 
+    // Copies share attributes until one of them changes them
+    void shared_attributes_test()
+    {
+        D4Attribute first("first", attr_byte_c);
+        first.add_value("1");
+        D4Attribute second("second", attr_byte_c);
+        second.add_value("2");
+
+        tb1->get_attr_table().append_attr("units", "String", "m");
+        tb1->attributes()->add_attribute(&first);
+
+        BaseType *copy = tb1->ptr_duplicate();
+        CPPUNIT_ASSERT(copy->get_attr_table().get_attr("units") == "m");
+        CPPUNIT_ASSERT(copy->attributes()->find("first"));
+
+        copy->get_attr_table().append_attr("scale", "Float64", "2");
+        copy->attributes()->add_attribute(&second);
+        CPPUNIT_ASSERT(copy->get_attr_table().get_attr("scale") == "2");
+        CPPUNIT_ASSERT(tb1->get_attr_table().get_attr("scale") == "");
+        CPPUNIT_ASSERT(copy->attributes()->find("second"));
+        CPPUNIT_ASSERT(!tb1->attributes()->find("second"));
+
+        // The copy's attributes outlive the original's owner
+        delete copy;
+        CPPUNIT_ASSERT(tb1->attributes()->find("first"));
+
+        // Moving attributes from one variable to another, as the DMR parser does
+        Byte b("b");
+        b.set_attributes_nocopy(tb1->attributes());
+        tb1->set_attributes_nocopy(0);
+        CPPUNIT_ASSERT(b.attributes()->find("first"));
+        CPPUNIT_ASSERT(!tb1->attributes()->find("first"));
+
+        // Replacing the attributes deletes the old ones
+        b.set_attributes_nocopy(new D4Attributes);
+        CPPUNIT_ASSERT(!b.attributes()->find("first"));
+    }
+
     
 };
 
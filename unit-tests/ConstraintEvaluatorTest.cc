@@ -0,0 +1,321 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <vector>
+
+#include "Int32.h"
+#include "Structure.h"
+#include "DDS.h"
+#include "BaseTypeFactory.h"
+#include "ConstraintEvaluator.h"
+#include "Clause.h"
+#include "ParallelTasks.h"
+#include "Error.h"
+#include "InternalErr.h"
+
+#include "debug.h"
+#include "GetOpt.h"
+
+using namespace CppUnit;
+using namespace std;
+
+static bool debug = false;
+
+#undef DBG
+#define DBG(x) do { if (debug) {x;} } while(false)
+
+namespace libdap {
+
+// Return a new Int32 named '<arg>_2' holding twice the value of the argument
+static void double_it(int argc, BaseType *argv[], DDS &, BaseType **btpp)
+{
+    if (argc != 1)
+        throw Error(malformed_expr, "double_it() takes one argument.");
+
+    Int32 *arg = static_cast<Int32*>(argv[0]);
+    if (arg->value() < 0)
+        throw Error(malformed_expr, "Negative argument: " + arg->name());
+
+    Int32 *result = new Int32(arg->name() + "_2");
+    result->set_value(arg->value() * 2);
+    *btpp = result;
+}
+
+// Count the tasks run; task 3 throws InternalErr and task 5 throws Error
+class CountingTasks: public ParallelTasks {
+public:
+    unsigned int d_count;
+
+    CountingTasks() : d_count(0) { }
+
+protected:
+    virtual void run_task(unsigned int i)
+    {
+        __sync_add_and_fetch(&d_count, 1);
+        if (i == 3)
+            throw InternalErr(__FILE__, __LINE__, "Task 3");
+        if (i == 5)
+            throw Error(no_such_variable, "Task 5");
+    }
+};
+
+class ConstraintEvaluatorTest: public TestFixture {
+private:
+    BaseTypeFactory d_factory;
+    DDS *d_dds;
+
+    Int32 *make_int(const string &name, dods_int32 value)
+    {
+        Int32 *i = new Int32(name);
+        i->set_value(value);
+        return i;
+    }
+
+    void append_double_it(ConstraintEvaluator &ce, const string &name)
+    {
+        ce.append_clause(double_it, make_rvalue_list(new rvalue(d_dds->var(name))));
+    }
+
+    // f(a), f(b), f(a), f(c), f(s.x), f(s.y)
+    void append_clauses(ConstraintEvaluator &ce)
+    {
+        append_double_it(ce, "a");
+        append_double_it(ce, "b");
+        append_double_it(ce, "a");
+        append_double_it(ce, "c");
+        append_double_it(ce, "s.x");
+        append_double_it(ce, "s.y");
+    }
+
+public:
+    ConstraintEvaluatorTest() : d_dds(0)
+    {
+    }
+
+    void setUp()
+    {
+        d_dds = new DDS(&d_factory, "ce_test");
+        d_dds->add_var_nocopy(make_int("a", 1));
+        d_dds->add_var_nocopy(make_int("b", 2));
+        d_dds->add_var_nocopy(make_int("c", 3));
+
+        Structure *s = new Structure("s");
+        s->add_var_nocopy(make_int("x", 4));
+        s->add_var_nocopy(make_int("y", 5));
+        d_dds->add_var_nocopy(s);
+    }
+
+    void tearDown()
+    {
+        delete d_dds;
+        d_dds = 0;
+    }
+
+    CPPUNIT_TEST_SUITE( ConstraintEvaluatorTest );
+
+    CPPUNIT_TEST(independent_groups_test);
+    CPPUNIT_TEST(eval_function_clauses_test);
+    CPPUNIT_TEST(parallel_function_clauses_test);
+    CPPUNIT_TEST(parallel_function_error_test);
+    CPPUNIT_TEST(parallel_tasks_error_type_test);
+
+    CPPUNIT_TEST_SUITE_END();
+
+    void independent_groups_test()
+    {
+        ConstraintEvaluator ce;
+        append_clauses(ce);
+
+        vector<vector<BaseType*> > vars;
+        for (ConstraintEvaluator::Clause_iter i = ce.clause_begin(); i != ce.clause_end(); ++i) {
+            vars.push_back(vector<BaseType*>());
+            (*i)->variables(vars.back());
+        }
+
+        vector<vector<unsigned int> > groups;
+        ParallelTasks::independent_groups(vars, groups);
+
+        // f(a) twice, f(b), f(c) and the two fields of s
+        CPPUNIT_ASSERT_EQUAL((size_t)4, groups.size());
+        CPPUNIT_ASSERT_EQUAL((size_t)2, groups[0].size());
+        CPPUNIT_ASSERT_EQUAL(0U, groups[0][0]);
+        CPPUNIT_ASSERT_EQUAL(2U, groups[0][1]);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, groups[1].size());
+        CPPUNIT_ASSERT_EQUAL(1U, groups[1][0]);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, groups[2].size());
+        CPPUNIT_ASSERT_EQUAL(3U, groups[2][0]);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, groups[3].size());
+        CPPUNIT_ASSERT_EQUAL(4U, groups[3][0]);
+        CPPUNIT_ASSERT_EQUAL(5U, groups[3][1]);
+    }
+
+    void check_result(DDS *fdds)
+    {
+        const char *names[] = { "a_2", "b_2", "a_2", "c_2", "x_2", "y_2" };
+        const dods_int32 values[] = { 2, 4, 2, 6, 8, 10 };
+
+        CPPUNIT_ASSERT_EQUAL(6, fdds->num_var());
+        for (int i = 0; i < 6; ++i) {
+            Int32 *result = static_cast<Int32*>(fdds->get_var_index(i));
+            DBG(cerr << result->name() << ": " << result->value() << endl);
+            CPPUNIT_ASSERT_EQUAL(string(names[i]), result->name());
+            CPPUNIT_ASSERT_EQUAL(values[i], result->value());
+        }
+    }
+
+    void eval_function_clauses_test()
+    {
+        ConstraintEvaluator ce;
+        CPPUNIT_ASSERT_EQUAL(1U, ce.get_function_threads());
+        append_clauses(ce);
+
+        DDS *fdds = ce.eval_function_clauses(*d_dds);
+        check_result(fdds);
+        delete fdds;
+    }
+
+    void parallel_function_clauses_test()
+    {
+        ConstraintEvaluator ce;
+        ce.set_function_threads(4);
+        append_clauses(ce);
+
+        // The results must be in the order of the clauses, every time
+        for (int i = 0; i < 20; ++i) {
+            DDS *fdds = ce.eval_function_clauses(*d_dds);
+            check_result(fdds);
+            delete fdds;
+        }
+    }
+
+    void parallel_function_error_test()
+    {
+        static_cast<Int32*>(d_dds->var("c"))->set_value(-1);
+        static_cast<Int32*>(d_dds->var("s.y"))->set_value(-1);
+
+        ConstraintEvaluator ce;
+        ce.set_function_threads(4);
+        append_clauses(ce);
+
+        try {
+            DDS *fdds = ce.eval_function_clauses(*d_dds);
+            delete fdds;
+            CPPUNIT_FAIL("Expected an Error");
+        }
+        catch (Error &e) {
+            // The error from the first clause that failed
+            DBG(cerr << e.get_error_message() << endl);
+            CPPUNIT_ASSERT_EQUAL(string("Negative argument: c"), e.get_error_message());
+        }
+    }
+
+    // The pool's threads are reused by each call to run() and the error
+    // keeps its type and code
+    void parallel_tasks_error_type_test()
+    {
+        CountingTasks tasks;
+        for (int i = 0; i < 50; ++i) {
+            try {
+                tasks.run(8, 4);
+                CPPUNIT_FAIL("Expected an InternalErr");
+            }
+            catch (InternalErr &e) {
+                CPPUNIT_ASSERT_EQUAL(internal_error, e.get_error_code());
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(400U, tasks.d_count);
+
+        try {
+            tasks.run(3, 4);
+        }
+        catch (Error &e) {
+            CPPUNIT_FAIL("Unexpected error: " + e.get_error_message());
+        }
+
+        try {
+            tasks.run(8, 1);
+            CPPUNIT_FAIL("Expected an InternalErr");
+        }
+        catch (InternalErr &e) {
+            CPPUNIT_ASSERT(e.get_error_message().find("Task 3") != string::npos);
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (ConstraintEvaluatorTest);
+
+} // namespace libdap
+
+int main(int argc, char *argv[])
+{
+    GetOpt getopt(argc, argv, "dh");
+    int option_char;
+
+    while ((option_char = getopt()) != -1)
+        switch (option_char) {
+        case 'd':
+            debug = 1;  // debug is a static global
+            break;
+
+        case 'h': {     // help - show test names
+            cerr << "Usage: ConstraintEvaluatorTest has the following tests:" << endl;
+            const std::vector<Test*> &tests = libdap::ConstraintEvaluatorTest::suite()->getTests();
+            unsigned int prefix_len = libdap::ConstraintEvaluatorTest::suite()->getName().append("::").length();
+            for (std::vector<Test*>::const_iterator i = tests.begin(), e = tests.end(); i != e; ++i) {
+                cerr << (*i)->getName().replace(0, prefix_len, "") << endl;
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+
+    CppUnit::TextTestRunner runner;
+    runner.addTest(CppUnit::TestFactoryRegistry::getRegistry().makeTest());
+
+    bool wasSuccessful = true;
+    string test = "";
+    int i = getopt.optind;
+    if (i == argc) {
+        // run them all
+        wasSuccessful = runner.run("");
+    }
+    else {
+        for (; i < argc; ++i) {
+            if (debug) cerr << "Running " << argv[i] << endl;
+            test = libdap::ConstraintEvaluatorTest::suite()->getName().append("::").append(argv[i]);
+            wasSuccessful = wasSuccessful && runner.run(test);
+        }
+    }
+
+    return wasSuccessful ? 0 : 1;
+}
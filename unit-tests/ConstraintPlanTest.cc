@@ -0,0 +1,454 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+#include "Int32.h"
+#include "Float64.h"
+#include "Array.h"
+#include "Structure.h"
+#include "Sequence.h"
+#include "DDS.h"
+#include "DMR.h"
+#include "D4Group.h"
+#include "D4Dimensions.h"
+#include "BaseTypeFactory.h"
+#include "D4BaseTypeFactory.h"
+
+#include "ConstraintPlan.h"
+
+#include "debug.h"
+#include "GetOpt.h"
+
+using namespace CppUnit;
+using namespace std;
+
+static bool debug = false;
+
+#undef DBG
+#define DBG(x) do { if (debug) {x;} } while(false)
+
+namespace libdap {
+
+// Counts the calls to its specialized set_send_p()
+class CountingInt32: public Int32 {
+public:
+    int d_calls;
+
+    CountingInt32(const string &n) : Int32(n), d_calls(0) { }
+    CountingInt32(const CountingInt32 &rhs) : Int32(rhs), d_calls(0) { }
+
+    virtual BaseType *ptr_duplicate() { return new CountingInt32(*this); }
+
+    virtual void set_send_p(bool state)
+    {
+        ++d_calls;
+        Int32::set_send_p(state);
+    }
+};
+
+// Counts the calls to its specialized add_constraint()
+class CountingArray: public Array {
+public:
+    int d_calls;
+
+    CountingArray(const string &n, BaseType *v) : Array(n, v), d_calls(0) { }
+    CountingArray(const CountingArray &rhs) : Array(rhs), d_calls(0) { }
+
+    virtual BaseType *ptr_duplicate() { return new CountingArray(*this); }
+
+    virtual void add_constraint(Dim_iter i, int start, int stride, int stop)
+    {
+        ++d_calls;
+        Array::add_constraint(i, start, stride, stop);
+    }
+};
+
+class ConstraintPlanTest: public TestFixture {
+private:
+    BaseTypeFactory d_factory;
+    D4BaseTypeFactory d_d4_factory;
+
+    DDS *make_dds()
+    {
+        DDS *dds = new DDS(&d_factory, "plan_test");
+
+        dds->add_var_nocopy(new Int32("i"));
+
+        Array *a = new Array("a", new Float64("a"));
+        a->append_dim(10, "x");
+        a->append_dim(20, "y");
+        dds->add_var_nocopy(a);
+
+        Structure *s = new Structure("s");
+        s->add_var_nocopy(new Int32("j"));
+        Array *b = new Array("b", new Int32("b"));
+        b->append_dim(5);
+        s->add_var_nocopy(b);
+        dds->add_var_nocopy(s);
+
+        Sequence *q = new Sequence("q");
+        q->add_var_nocopy(new Int32("k"));
+        dds->add_var_nocopy(q);
+
+        return dds;
+    }
+
+    // The effect of parsing 'a[2:2:8][0:9],s.j,q.k[1:3]'
+    void constrain(DDS &dds)
+    {
+        Array *a = static_cast<Array*>(dds.var("a"));
+        a->set_send_p(true);
+        a->add_constraint(a->dim_begin(), 2, 2, 8);
+        a->add_constraint(a->dim_begin() + 1, 0, 1, 9);
+
+        dds.mark("s.j", true);
+
+        dds.mark("q.k", true);
+        static_cast<Sequence*>(dds.var("q"))->set_row_number_constraint(1, 3);
+    }
+
+    DMR *make_dmr()
+    {
+        DMR *dmr = new DMR(&d_d4_factory, "plan_test");
+
+        D4Group *root = dmr->root();
+        D4Dimension *lat = new D4Dimension("lat", 10);
+        root->dims()->add_dim_nocopy(lat);
+
+        Array *a = static_cast<Array*>(d_d4_factory.NewVariable(dods_array_c, "a"));
+        a->add_var_nocopy(d_d4_factory.NewVariable(dods_float64_c, "a"));
+        a->append_dim(lat);
+        a->append_dim(4, "t");
+        root->add_var_nocopy(a);
+
+        root->add_var_nocopy(d_d4_factory.NewVariable(dods_int32_c, "i"));
+
+        return dmr;
+    }
+
+public:
+    ConstraintPlanTest()
+    {
+    }
+
+    ~ConstraintPlanTest()
+    {
+    }
+
+    void setUp()
+    {
+        ConstraintPlanCache::TheCache()->clear();
+    }
+
+    void tearDown()
+    {
+        ConstraintPlanCache::TheCache()->clear();
+        ConstraintPlanCache::TheCache()->set_max_plans(1024);
+    }
+
+    CPPUNIT_TEST_SUITE (ConstraintPlanTest);
+
+    CPPUNIT_TEST (signature_test);
+    CPPUNIT_TEST (dds_plan_test);
+    CPPUNIT_TEST (dmr_plan_test);
+    CPPUNIT_TEST (cache_test);
+    CPPUNIT_TEST (structure_change_test);
+    CPPUNIT_TEST (specialized_type_test);
+    CPPUNIT_TEST (specialized_array_test);
+    CPPUNIT_TEST (matches_test);
+
+    CPPUNIT_TEST_SUITE_END();
+
+    void signature_test()
+    {
+        auto_ptr<DDS> dds1(make_dds());
+        auto_ptr<DDS> dds2(make_dds());
+
+        ConstraintState s1(*dds1);
+        ConstraintState s2(*dds2);
+        CPPUNIT_ASSERT(s1.structure() == s2.structure());
+        CPPUNIT_ASSERT(s1.signature() == s2.signature());
+
+        constrain(*dds1);
+        ConstraintState s3(*dds1);
+        CPPUNIT_ASSERT(s3.structure() == s1.structure());
+        CPPUNIT_ASSERT(s3.signature() != s1.signature());
+
+        dds2->var("s")->set_name("t");
+        ConstraintState s4(*dds2);
+        CPPUNIT_ASSERT(s4.structure() != s1.structure());
+    }
+
+    void dds_plan_test()
+    {
+        auto_ptr<DDS> dds1(make_dds());
+        auto_ptr<DDS> dds2(make_dds());
+
+        ConstraintState before(*dds1);
+        constrain(*dds1);
+        ConstraintState after(*dds1);
+
+        ConstraintPlan plan(before, after);
+
+        ConstraintState target(*dds2);
+        plan.apply(target);
+        CPPUNIT_ASSERT(ConstraintState(*dds2).signature() == after.signature());
+
+        CPPUNIT_ASSERT(!dds2->var("i")->send_p());
+
+        Array *a = static_cast<Array*>(dds2->var("a"));
+        CPPUNIT_ASSERT(a->send_p());
+        CPPUNIT_ASSERT_EQUAL(2, a->dimension_start(a->dim_begin(), true));
+        CPPUNIT_ASSERT_EQUAL(8, a->dimension_stop(a->dim_begin(), true));
+        CPPUNIT_ASSERT_EQUAL(2, a->dimension_stride(a->dim_begin(), true));
+        CPPUNIT_ASSERT_EQUAL(9, a->dimension_stop(a->dim_begin() + 1, true));
+        CPPUNIT_ASSERT_EQUAL(40, a->length());
+
+        CPPUNIT_ASSERT(dds2->var("s")->send_p());
+        CPPUNIT_ASSERT(dds2->var("s.j")->send_p());
+        CPPUNIT_ASSERT(!dds2->var("s.b")->send_p());
+
+        Sequence *q = static_cast<Sequence*>(dds2->var("q"));
+        CPPUNIT_ASSERT(q->send_p());
+        CPPUNIT_ASSERT_EQUAL(1, q->get_starting_row_number());
+        CPPUNIT_ASSERT_EQUAL(3, q->get_ending_row_number());
+    }
+
+    void dmr_plan_test()
+    {
+        auto_ptr<DMR> dmr1(make_dmr());
+        auto_ptr<DMR> dmr2(make_dmr());
+
+        ConstraintState before(*dmr1);
+        CPPUNIT_ASSERT(before.signature() == ConstraintState(*dmr2).signature());
+
+        // The effect of parsing '[lat=0:4];a[][1]'
+        D4Dimension *lat = dmr1->root()->find_dim("lat");
+        lat->set_constraint(0, 1, 4);
+        Array *a = static_cast<Array*>(dmr1->root()->var("a"));
+        a->set_send_p(true);
+        dmr1->root()->BaseType::set_send_p(true);
+        a->add_constraint(a->dim_begin(), lat);
+        a->add_constraint(a->dim_begin() + 1, 1, 1, 1);
+
+        ConstraintState after(*dmr1);
+        ConstraintPlan plan(before, after);
+
+        ConstraintState target(*dmr2);
+        plan.apply(target);
+        CPPUNIT_ASSERT(ConstraintState(*dmr2).signature() == after.signature());
+
+        D4Dimension *lat2 = dmr2->root()->find_dim("lat");
+        CPPUNIT_ASSERT(lat2 != lat);
+        CPPUNIT_ASSERT(lat2->constrained());
+        CPPUNIT_ASSERT(lat2->c_stop() == 4);
+        CPPUNIT_ASSERT(lat2->used_by_projected_var());
+
+        Array *a2 = static_cast<Array*>(dmr2->root()->var("a"));
+        CPPUNIT_ASSERT(a2->send_p());
+        CPPUNIT_ASSERT(dmr2->root()->send_p());
+        CPPUNIT_ASSERT_EQUAL(5, a2->length());
+        CPPUNIT_ASSERT(!dmr2->root()->var("i")->send_p());
+    }
+
+    void cache_test()
+    {
+        ConstraintPlanCache *cache = ConstraintPlanCache::TheCache();
+
+        auto_ptr<DDS> dds1(make_dds());
+        ConstraintState before(*dds1);
+        constrain(*dds1);
+        ConstraintState after(*dds1);
+        cache->add("a[2:2:8][0:9],s.j,q.k[1:3]", before, after);
+        CPPUNIT_ASSERT_EQUAL(1U, cache->size());
+
+        auto_ptr<DDS> dds2(make_dds());
+        ConstraintState target(*dds2);
+        CPPUNIT_ASSERT(!cache->apply("a,s.j,q.k[1:3]", target));
+        CPPUNIT_ASSERT(cache->apply("a[2:2:8][0:9],s.j,q.k[1:3]", target));
+        CPPUNIT_ASSERT(dds2->var("s.j")->send_p());
+        CPPUNIT_ASSERT_EQUAL(1UL, cache->hits());
+        CPPUNIT_ASSERT_EQUAL(1UL, cache->misses());
+
+        // dds2 is now constrained, so its signature no longer matches
+        ConstraintState constrained(*dds2);
+        CPPUNIT_ASSERT(!cache->apply("a[2:2:8][0:9],s.j,q.k[1:3]", constrained));
+
+        // A different dataset
+        auto_ptr<DMR> dmr(make_dmr());
+        ConstraintState other(*dmr);
+        CPPUNIT_ASSERT(!cache->apply("a[2:2:8][0:9],s.j,q.k[1:3]", other));
+
+        cache->set_max_plans(0);
+        CPPUNIT_ASSERT_EQUAL(0U, cache->size());
+        cache->add("a[2:2:8][0:9],s.j,q.k[1:3]", before, after);
+        CPPUNIT_ASSERT_EQUAL(0U, cache->size());
+    }
+
+    void structure_change_test()
+    {
+        auto_ptr<DDS> dds1(make_dds());
+        ConstraintState before(*dds1);
+        dds1->add_var_nocopy(new Int32("new_var"));
+        ConstraintState after(*dds1);
+
+        ConstraintPlanCache::TheCache()->add("#Int32(new_var:1)", before, after);
+        CPPUNIT_ASSERT_EQUAL(0U, ConstraintPlanCache::TheCache()->size());
+
+        CPPUNIT_ASSERT_THROW(ConstraintPlan(before, after), InternalErr);
+    }
+
+    // A plan uses the set_send_p() of the variables it changes and leaves
+    // the variables it does not change as they were
+    void specialized_type_test()
+    {
+        auto_ptr<DDS> dds1(make_dds());
+        auto_ptr<DDS> dds2(make_dds());
+        static_cast<Structure*>(dds1->var("s"))->add_var_nocopy(new CountingInt32("c"));
+        static_cast<Structure*>(dds2->var("s"))->add_var_nocopy(new CountingInt32("c"));
+
+        ConstraintState before(*dds1);
+        dds1->mark("s.c", true);
+        ConstraintState after(*dds1);
+        ConstraintPlan plan(before, after);
+
+        CountingInt32 *c = static_cast<CountingInt32*>(dds2->var("s.c"));
+        ConstraintState target(*dds2);
+        plan.apply(target);
+
+        CPPUNIT_ASSERT(ConstraintState(*dds2).signature() == after.signature());
+        CPPUNIT_ASSERT(c->send_p());
+        CPPUNIT_ASSERT(c->d_calls > 0);
+        CPPUNIT_ASSERT(dds2->var("s")->send_p());
+        CPPUNIT_ASSERT(!dds2->var("s.j")->send_p());
+        CPPUNIT_ASSERT(!dds2->var("s.b")->send_p());
+    }
+
+    // Array slices are set using add_constraint(), only for the dimensions
+    // the expression constrained
+    void specialized_array_test()
+    {
+        auto_ptr<DDS> dds1(make_dds());
+        auto_ptr<DDS> dds2(make_dds());
+        CountingArray c1("c", new Int32("c"));
+        c1.append_dim(10);
+        c1.append_dim(10);
+        dds1->add_var(&c1);
+        dds2->add_var(&c1);
+
+        ConstraintState before(*dds1);
+        CountingArray *c = static_cast<CountingArray*>(dds1->var("c"));
+        c->set_send_p(true);
+        c->add_constraint(c->dim_begin() + 1, 1, 1, 3);
+        ConstraintState after(*dds1);
+        ConstraintPlan plan(before, after);
+
+        c = static_cast<CountingArray*>(dds2->var("c"));
+        ConstraintState target(*dds2);
+        plan.apply(target);
+
+        CPPUNIT_ASSERT(ConstraintState(*dds2).signature() == after.signature());
+        CPPUNIT_ASSERT_EQUAL(1, c->d_calls);
+        CPPUNIT_ASSERT_EQUAL(30, c->length());
+    }
+
+    // A plan is only applied to a DDS in the state it was built from
+    void matches_test()
+    {
+        auto_ptr<DDS> dds1(make_dds());
+        ConstraintState before(*dds1);
+        constrain(*dds1);
+        ConstraintState after(*dds1);
+        ConstraintPlan plan(before, after);
+
+        auto_ptr<DDS> dds2(make_dds());
+        CPPUNIT_ASSERT(plan.matches(ConstraintState(*dds2)));
+
+        dds2->var("s.j")->set_name("jj");
+        ConstraintState renamed(*dds2);
+        CPPUNIT_ASSERT(!plan.matches(renamed));
+        CPPUNIT_ASSERT_THROW(plan.apply(renamed), InternalErr);
+
+        auto_ptr<DDS> dds3(make_dds());
+        static_cast<Array*>(dds3->var("a"))->add_constraint(static_cast<Array*>(dds3->var("a"))->dim_begin(), 0, 1, 4);
+        CPPUNIT_ASSERT(!plan.matches(ConstraintState(*dds3)));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (ConstraintPlanTest);
+
+} // namespace libdap
+
+int main(int argc, char *argv[])
+{
+    GetOpt getopt(argc, argv, "dh");
+    int option_char;
+
+    while ((option_char = getopt()) != -1)
+        switch (option_char) {
+        case 'd':
+            debug = 1;  // debug is a static global
+            break;
+
+        case 'h': {     // help - show test names
+            cerr << "Usage: ConstraintPlanTest has the following tests:" << endl;
+            const std::vector<Test*> &tests = libdap::ConstraintPlanTest::suite()->getTests();
+            unsigned int prefix_len = libdap::ConstraintPlanTest::suite()->getName().append("::").length();
+            for (std::vector<Test*>::const_iterator i = tests.begin(), e = tests.end(); i != e; ++i) {
+                cerr << (*i)->getName().replace(0, prefix_len, "") << endl;
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+
+    CppUnit::TextTestRunner runner;
+    runner.addTest(CppUnit::TestFactoryRegistry::getRegistry().makeTest());
+
+    bool wasSuccessful = true;
+    string test = "";
+    int i = getopt.optind;
+    if (i == argc) {
+        // run them all
+        wasSuccessful = runner.run("");
+    }
+    else {
+        for (; i < argc; ++i) {
+            if (debug) cerr << "Running " << argv[i] << endl;
+            test = libdap::ConstraintPlanTest::suite()->getName().append("::").append(argv[i]);
+            wasSuccessful = wasSuccessful && runner.run(test);
+        }
+    }
+
+    return wasSuccessful ? 0 : 1;
+}
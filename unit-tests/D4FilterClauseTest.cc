@@ -66,6 +66,20 @@ using namespace std;
 
 namespace libdap {
 
+static int num_calls = 0;
+
+// A D4Function that counts its calls and returns a copy of its argument
+static BaseType *count_calls(D4RValueList *args, DMR &dmr)
+{
+    ++num_calls;
+    return args->get_rvalue(0)->value(dmr)->ptr_duplicate();
+}
+
+static BaseType *other_function(D4RValueList *args, DMR &dmr)
+{
+    return args->get_rvalue(0)->value(dmr)->ptr_duplicate();
+}
+
 class D4FilterClauseTest: public TestFixture {
     // Build a DMR and build several D4RValue objects that reference its variables.
     // Then build several D4RValue objects that hold constants
@@ -547,6 +561,74 @@ public:
         }
     }
 
+    // D4RValue tests used by the function evaluator
+
+    void rvalue_key_test()
+    {
+        D4RValue f1(count_calls, new D4RValueList(new D4RValue(byte)));
+        D4RValue f2(count_calls, new D4RValueList(new D4RValue(byte)));
+        D4RValue f3(count_calls, new D4RValueList(new D4RValue(f32)));
+        D4RValue f4(other_function, new D4RValueList(new D4RValue(byte)));
+
+        DBG(cerr << "f1 key: " << f1.key() << endl);
+        CPPUNIT_ASSERT_EQUAL(f1.key(), f2.key());
+        CPPUNIT_ASSERT(f1.key() != f3.key());
+        CPPUNIT_ASSERT(f1.key() != f4.key());
+
+        D4RValue c1((long long) 17), c2((long long) 17), c3((long long) 18), c4(17.0);
+        CPPUNIT_ASSERT_EQUAL(c1.key(), c2.key());
+        CPPUNIT_ASSERT(c1.key() != c3.key());
+        CPPUNIT_ASSERT(c1.key() != c4.key());
+    }
+
+    void rvalue_memoize_test()
+    {
+        // f(g(byte), g(byte)) with the second g() sharing the first one's value
+        D4RValue *g1 = new D4RValue(count_calls, new D4RValueList(new D4RValue(byte)));
+        D4RValue *g2 = new D4RValue(count_calls, new D4RValueList(new D4RValue(byte)));
+        g1->set_pure(true);
+        g2->set_pure(true);
+        g1->memoize();
+        g2->use_value_of(g1);
+
+        D4RValueList *args = new D4RValueList(g1);
+        args->add_rvalue(g2);
+        D4RValue f(other_function, args);
+
+        // g1 owns the value it keeps and deletes it
+        num_calls = 0;
+        BaseType *value = g1->value(dmr);
+        CPPUNIT_ASSERT(!g1->caller_owns_value());
+        CPPUNIT_ASSERT_EQUAL(value, g2->value(dmr));
+        CPPUNIT_ASSERT(f.caller_owns_value());
+        BaseType *result = f.value(dmr);
+        delete result;
+        CPPUNIT_ASSERT_EQUAL(1, num_calls);
+
+        // A copy does not share values
+        D4RValue g3(*g2);
+        num_calls = 0;
+        delete g3.value(dmr);
+        CPPUNIT_ASSERT_EQUAL(1, num_calls);
+    }
+
+    void rvalue_not_pure_test()
+    {
+        // Functions that are not declared pure are called every time
+        D4RValue g1(count_calls, new D4RValueList(new D4RValue(byte)));
+        D4RValue g2(count_calls, new D4RValueList(new D4RValue(byte)));
+        g1.memoize();
+        g2.use_value_of(&g1);
+
+        num_calls = 0;
+        CPPUNIT_ASSERT(g1.caller_owns_value());
+        CPPUNIT_ASSERT(g2.caller_owns_value());
+        delete g1.value(dmr);
+        delete g2.value(dmr);
+        delete g1.value(dmr);
+        CPPUNIT_ASSERT_EQUAL(3, num_calls);
+    }
+
     CPPUNIT_TEST_SUITE (D4FilterClauseTest);
 
     CPPUNIT_TEST (Byte_and_long_long_test);
@@ -577,6 +659,10 @@ public:
     CPPUNIT_TEST (evaluation_order_test);
     CPPUNIT_TEST (evaluation_order_test_2);
 
+    CPPUNIT_TEST (rvalue_key_test);
+    CPPUNIT_TEST (rvalue_memoize_test);
+    CPPUNIT_TEST (rvalue_not_pure_test);
+
     CPPUNIT_TEST_SUITE_END();
 };
 
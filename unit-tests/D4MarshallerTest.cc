@@ -44,6 +44,8 @@
 #include <cstring>
 
 #include "D4StreamMarshaller.h"
+#include "D4StreamUnMarshaller.h"
+#include "chunked_codec.h"
 
 #include "GetOpt.h"
 #include "debug.h"
@@ -75,6 +77,9 @@ class D4MarshallerTest: public CppUnit::TestFixture {
     CPPUNIT_TEST (test_str);
     CPPUNIT_TEST (test_opaque);
     CPPUNIT_TEST (test_vector);
+    CPPUNIT_TEST (test_filtered_vector);
+    CPPUNIT_TEST (test_filtered_vector_parts);
+    CPPUNIT_TEST (test_filtered_vector_twiddle);
 
     CPPUNIT_TEST_SUITE_END( );
 
@@ -316,6 +321,125 @@ public:
             CPPUNIT_FAIL("Caught an exception.");
         }
     }
+    // The filters change the bytes sent but not the values read or the checksums
+    void test_filtered_vector()
+    {
+        vector<dods_int32> ints(10000);
+        vector<dods_float64> reals(10000);
+        vector<dods_int16> shorts(3);
+        for (int i = 0; i < 10000; ++i) {
+            ints[i] = 100000 - 3 * i;
+            reals[i] = 273.15 + i / 1000.0;
+        }
+        shorts[0] = -1; shorts[1] = 7; shorts[2] = -32768;
+
+        string plain_checksum;
+        {
+            ostringstream oss;
+            D4StreamMarshaller dsm(oss);
+            dsm.put_vector(reinterpret_cast<char*>(&ints[0]), ints.size(), sizeof(dods_int32));
+            dsm.put_vector_float64(reinterpret_cast<char*>(&reals[0]), reals.size());
+            plain_checksum = dsm.get_checksum();
+        }
+
+        unsigned int all_filters[] = { vector_filter_shuffle, vector_filter_delta,
+            vector_filter_shuffle | vector_filter_delta };
+        for (int f = 0; f < 3; ++f) {
+            ostringstream oss;
+            string checksum;
+            {
+                D4StreamMarshaller dsm(oss);
+                dsm.set_filters(all_filters[f]);
+                dsm.put_vector(reinterpret_cast<char*>(&ints[0]), ints.size(), sizeof(dods_int32));
+                dsm.put_vector_float64(reinterpret_cast<char*>(&reals[0]), reals.size());
+                checksum = dsm.get_checksum();
+                dsm.put_vector(reinterpret_cast<char*>(&shorts[0]), shorts.size(), sizeof(dods_int16));
+            }
+
+            CPPUNIT_ASSERT_EQUAL(plain_checksum, checksum);
+            // Three arrays, each with a filter byte
+            CPPUNIT_ASSERT_EQUAL(size_t(40000 + 80000 + 6 + 3), oss.str().size());
+
+            istringstream iss(oss.str());
+            D4StreamUnMarshaller dsum(iss, false);
+            dsum.set_filtered(true);
+
+            vector<dods_int32> ints2(ints.size());
+            vector<dods_float64> reals2(reals.size());
+            vector<dods_int16> shorts2(shorts.size());
+            dsum.get_vector(reinterpret_cast<char*>(&ints2[0]), ints2.size(), sizeof(dods_int32));
+            dsum.get_vector_float64(reinterpret_cast<char*>(&reals2[0]), reals2.size());
+            dsum.get_vector(reinterpret_cast<char*>(&shorts2[0]), shorts2.size(), sizeof(dods_int16));
+
+            CPPUNIT_ASSERT(ints == ints2);
+            CPPUNIT_ASSERT(reals == reals2);
+            CPPUNIT_ASSERT(shorts == shorts2);
+        }
+
+        ostringstream oss;
+        D4StreamMarshaller dsm(oss);
+        CPPUNIT_ASSERT_THROW(dsm.set_filters(4), InternalErr);
+    }
+
+    // An array sent in parts is read as one array
+    void test_filtered_vector_parts()
+    {
+        vector<dods_float32> vals(1000);
+        for (int i = 0; i < 1000; ++i)
+            vals[i] = i * 0.5;
+
+        ostringstream oss;
+        {
+            D4StreamMarshaller dsm(oss);
+            dsm.set_filters(vector_filter_shuffle | vector_filter_delta);
+            dsm.put_vector_start(vals.size());
+            for (int i = 0; i < 1000; i += 300)
+                dsm.put_vector_part(reinterpret_cast<char*>(&vals[i]), min(300, 1000 - i), sizeof(dods_float32),
+                    dods_float32_c);
+            dsm.put_vector_end();
+        }
+
+        CPPUNIT_ASSERT_EQUAL(size_t(4000 + 1), oss.str().size());
+
+        istringstream iss(oss.str());
+        D4StreamUnMarshaller dsum(iss, false);
+        dsum.set_filtered(true);
+        vector<dods_float32> vals2(vals.size());
+        dsum.get_vector_float32(reinterpret_cast<char*>(&vals2[0]), vals2.size());
+
+        CPPUNIT_ASSERT(vals == vals2);
+    }
+
+    // Filtered data from a host with the other byte order
+    void test_filtered_vector_twiddle()
+    {
+        vector<dods_uint32> vals(100);
+        for (int i = 0; i < 100; ++i)
+            vals[i] = 70000 + i * i;
+
+        // The sender computes the differences, which are then in its byte
+        // order, and shuffles them.
+        vector<dods_uint32> deltas(vals.size());
+        for (int i = 0; i < 100; ++i) {
+            dods_uint32 d = vals[i] - (i > 0 ? vals[i - 1] : 0);
+            deltas[i] = (d >> 24) | ((d >> 8) & 0xff00) | ((d << 8) & 0xff0000) | (d << 24);
+        }
+
+        string data(1, (char) (vector_filter_shuffle | vector_filter_delta));
+        vector<char> shuffled(deltas.size() * sizeof(dods_uint32));
+        vector_filter_encode(reinterpret_cast<char*>(&deltas[0]), &shuffled[0], deltas.size(), sizeof(dods_uint32),
+            vector_filter_shuffle);
+        data.append(shuffled.begin(), shuffled.end());
+
+        istringstream iss(data);
+        D4StreamUnMarshaller dsum(iss, true);
+        dsum.set_filtered(true);
+        vector<dods_uint32> vals2(vals.size());
+        dsum.get_vector(reinterpret_cast<char*>(&vals2[0]), vals2.size(), sizeof(dods_uint32));
+
+        CPPUNIT_ASSERT(vals == vals2);
+    }
+
 #if 0
     void test_varying_vector() {
         ostringstream oss;
@@ -152,6 +152,10 @@ public:
     CPPUNIT_TEST(get_das_test_5);
     CPPUNIT_TEST(get_das_test_6);
 
+    CPPUNIT_TEST(var_lookup_test);
+    CPPUNIT_TEST(var_lookup_copy_test);
+    CPPUNIT_TEST(get_request_size_kb_test);
+
     CPPUNIT_TEST_SUITE_END();
 
     void transfer_attributes_test_1()
@@ -216,6 +220,139 @@ public:
         }
     }
 
+    // Lookups use an index that must follow changes to the variables
+    void var_lookup_test()
+    {
+        Structure t("t");
+        t.add_var_nocopy(new Int32("y"));
+        Structure s("s");
+        for (int i = 0; i < 20; ++i) {
+            ostringstream name;
+            name << "f" << i;
+            s.add_var_nocopy(new Int32(name.str()));
+        }
+        s.add_var_nocopy(new Int32("x"));
+        s.add_var(&t);
+
+        dds1->add_var_nocopy(new Int32("a"));
+        dds1->add_var(&s);
+        dds1->add_var_nocopy(new Int32("x"));
+
+        // An exact match at the top level is found before a leaf match
+        BaseType *x = dds1->var("x");
+        CPPUNIT_ASSERT(x && x->get_parent() == 0);
+        CPPUNIT_ASSERT(dds1->var("s.x") && dds1->var("s.x") != x);
+        CPPUNIT_ASSERT(dds1->var("f19") && dds1->var("f19")->get_parent() == dds1->var("s"));
+        CPPUNIT_ASSERT(dds1->var("nothing") == 0);
+
+        BaseType::btp_stack stack;
+        BaseType *y = dds1->var("y", stack);
+        CPPUNIT_ASSERT(y && y->name() == "y");
+        CPPUNIT_ASSERT(stack.size() == 2);
+        CPPUNIT_ASSERT(stack.top()->name() == "s");
+        stack.pop();
+        CPPUNIT_ASSERT(stack.top()->name() == "t");
+
+        y->set_name("z");
+        CPPUNIT_ASSERT(dds1->var("y") == 0);
+        CPPUNIT_ASSERT(dds1->var("z") == y);
+
+        dds1->del_var("x");
+        CPPUNIT_ASSERT(dds1->var("x") == dds1->var("s.x"));
+
+        static_cast<Structure*>(dds1->var("s"))->del_var("f3");
+        CPPUNIT_ASSERT(dds1->var("f3") == 0);
+        CPPUNIT_ASSERT(dds1->var("f4") != 0);
+
+        dds1->add_var_nocopy(new Int32("b"));
+        CPPUNIT_ASSERT(dds1->var("b") != 0);
+
+        dds1->var("b")->set_name("c");
+        CPPUNIT_ASSERT(dds1->var("b") == 0);
+        CPPUNIT_ASSERT(dds1->var("c") != 0);
+
+        // Changes to variables held by another DDS do not make this index
+        // stale
+        unsigned long version = dds1->d_index_version;
+        dds2->add_var_nocopy(new Int32("d"));
+        dds2->var("d")->set_name("e");
+        Int32 orphan("orphan");
+        orphan.set_name("g");
+        CPPUNIT_ASSERT(dds1->var("c") != 0);
+        CPPUNIT_ASSERT(dds1->d_index_version == version);
+    }
+
+    void var_lookup_copy_test()
+    {
+        Structure s("s");
+        for (int i = 0; i < 20; ++i) {
+            ostringstream name;
+            name << "f" << i;
+            s.add_var_nocopy(new Int32(name.str()));
+        }
+        dds1->add_var(&s);
+        dds1->add_var_nocopy(new Int32("x"));
+        CPPUNIT_ASSERT(dds1->var("f3") != 0);
+
+        // Renaming a copy of a variable, or a variable in the copy, does not
+        // change the DDS that holds the original
+        unsigned long version = dds1->d_names_version;
+        BaseType *copy = dds1->var("s")->ptr_duplicate();
+        copy->set_name("copy");
+        copy->var("f3")->set_name("g3");
+        CPPUNIT_ASSERT(dds1->d_names_version == version);
+        CPPUNIT_ASSERT(copy->var("g3") != 0);
+        delete copy;
+        CPPUNIT_ASSERT(dds1->var("f3") != 0);
+
+        // Assigning to a variable is seen by the DDS or Structure that holds it
+        Int32 other("other");
+        *static_cast<Int32*>(dds1->var("x")) = other;
+        CPPUNIT_ASSERT(dds1->var("x") == 0);
+        CPPUNIT_ASSERT(dds1->var("other") != 0);
+
+        Int32 field("field");
+        *static_cast<Int32*>(dds1->var("f3")) = field;
+        CPPUNIT_ASSERT(dds1->var("f3") == 0);
+        CPPUNIT_ASSERT(dds1->var("s.field") != 0);
+        dds1->var("s.field")->set_name("f3");
+        CPPUNIT_ASSERT(dds1->var("s.f3") != 0);
+
+        // The variables in a copy of the DDS belong to the copy, and
+        // outlive the original
+        DDS *dds_copy = new DDS(*dds1);
+        delete dds1;
+        dds1 = 0;
+        dds_copy->var("f3")->set_name("h3");
+        CPPUNIT_ASSERT(dds_copy->var("f3") == 0);
+        CPPUNIT_ASSERT(dds_copy->var("s.h3") != 0);
+
+        // Moving a top-level variable into a Structure
+        Int32 *moved = new Int32("moved");
+        dds_copy->add_var_nocopy(moved);
+        CPPUNIT_ASSERT(dds_copy->var("moved") == moved);
+        version = dds_copy->d_names_version;
+        Structure t("t");
+        t.add_var_nocopy(moved);
+        CPPUNIT_ASSERT(dds_copy->d_names_version != version);
+        version = dds_copy->d_names_version;
+        moved->set_name("still_moved");
+        CPPUNIT_ASSERT(dds_copy->d_names_version == version);
+        CPPUNIT_ASSERT(t.var("still_moved") == moved);
+
+        // The Structure now owns the variable; take it out of the DDS
+        // without deleting it
+        for (DDS::Vars_iter i = dds_copy->var_begin(); i != dds_copy->var_end(); ++i) {
+            if (*i == moved) {
+                *i = new Int32("replacement");
+                break;
+            }
+        }
+        dds_copy->names_changed();
+        CPPUNIT_ASSERT(dds_copy->var("replacement") != 0);
+        delete dds_copy;
+    }
+
     void print_xml_test()
     {
         try {
@@ -500,6 +637,39 @@ public:
         CPPUNIT_ASSERT(dds2->get_request_size(false) == 3119424);
     }
 
+    // A 50000 x 50000 array of Float64 is far larger than 2GB
+    void get_request_size_kb_test()
+    {
+        Array a("a", new Float64("a"));
+        a.append_dim(50000, "x");
+        a.append_dim(50000, "y");
+        dds1->add_var(&a);
+        dds1->add_var_nocopy(new Int32("i"));
+
+        CPPUNIT_ASSERT(dds1->get_request_size_kb(false) == 19531250ULL);
+        CPPUNIT_ASSERT(dds1->get_request_size_kb(true) == 0);
+
+        dds1->mark_all(true);
+        CPPUNIT_ASSERT(dds1->get_request_size_kb(true) == 19531250ULL);
+
+        Array *ap = static_cast<Array*>(dds1->var("a"));
+        ap->add_constraint(ap->dim_begin(), 0, 1, 1023);
+        ap->add_constraint(ap->dim_begin() + 1, 0, 1, 127);
+        CPPUNIT_ASSERT(dds1->get_request_size_kb(true) == 1024);
+
+        dds1->set_response_limit(1025);
+        CPPUNIT_ASSERT(!dds1->too_big());
+        ap->add_constraint(ap->dim_begin() + 1, 0, 1, 130);
+        CPPUNIT_ASSERT(dds1->too_big());
+
+        // Changes to variables in another DDS do not reset the cache
+        unsigned long version = dds1->d_request_size_version[true];
+        dds2->add_var_nocopy(new Int32("j"));
+        dds2->mark_all(true);
+        CPPUNIT_ASSERT(dds1->too_big());
+        CPPUNIT_ASSERT(dds1->d_request_size_version[true] == version);
+    }
+
     void get_response_size_test_c2()
     {
         ConstraintEvaluator eval;
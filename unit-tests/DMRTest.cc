@@ -46,6 +46,7 @@
 
 #include "DDS.h"
 #include "DMR.h"
+#include "D4Group.h"
 #include "XMLWriter.h"
 #include "D4BaseTypeFactory.h"
 #include "D4ParserSax2.h"
@@ -174,9 +175,39 @@ CPPUNIT_TEST_SUITE (DMRTest);
     CPPUNIT_TEST(test_copy_ctor_3);
     CPPUNIT_TEST(test_copy_ctor_4);
 
+    CPPUNIT_TEST(test_request_size_kb);
+
     CPPUNIT_TEST_SUITE_END()
     ;
 
+    // The size is cached until a variable in the DMR changes
+    void test_request_size_kb()
+    {
+        D4BaseTypeFactory factory;
+        DMR dmr(&factory, "test");
+        Array *a = new Array("a", new Float64("a"), true);
+        a->append_dim(1024, "x");
+        dmr.root()->add_var_nocopy(a);
+
+        CPPUNIT_ASSERT(dmr.request_size_kb(false) == 8);
+        CPPUNIT_ASSERT(dmr.request_size_kb(true) == 0);
+
+        a->set_send_p(true);
+        CPPUNIT_ASSERT(dmr.request_size_kb(true) == 8);
+
+        a->add_constraint(a->dim_begin(), 0, 1, 511);
+        CPPUNIT_ASSERT(dmr.request_size_kb(true) == 4);
+
+        Array *b = new Array("b", new Float64("b"), true);
+        b->append_dim(2048, "x");
+        b->set_send_p(true);
+        dmr.root()->add_var_nocopy(b);
+        CPPUNIT_ASSERT(dmr.request_size_kb(true) == 20);
+
+        a->set_send_p(false);
+        CPPUNIT_ASSERT(dmr.request_size_kb(true) == 16);
+    }
+
     // Test a DDS with simple scalar types and no attributes
     void test_dmr_from_dds_1()
     {
@@ -37,11 +37,15 @@
 #include "DODSFilter.h"
 #include "DAS.h"
 #include "DDS.h"
+#include "ConstraintEvaluator.h"
 #include "GNURegex.h"
+#include "deflate_ostream.h"
+#include "GetOpt.h"
 #include "debug.h"
 
 #include "../tests/TestTypeFactory.h"
 #include "../tests/TestByte.h"
+#include "../tests/TestArray.h"
 
 #include <test_config.h>
 
@@ -49,10 +53,26 @@ using namespace CppUnit;
 using namespace std;
 using namespace libdap;
 
+static bool debug = false;
+
+#undef DBG
+#define DBG(x) do { if (debug) (x); } while(false);
+
 int test_variable_sleep_interval = 0;
 
 namespace libdap {
 
+// Replace the data values to show that the FILE methods use the ostream ones
+class ValuesFilter: public DODSFilter {
+protected:
+    virtual void serialize_data(DDS &, ConstraintEvaluator &, ostream &out, bool) const {
+        out << "values";
+    }
+
+public:
+    ValuesFilter(int argc, char *argv[]) : DODSFilter(argc, argv) { }
+};
+
 class DODSFilterTest: public TestFixture {
 private:
     DODSFilter *df, *df_conditional, *df1, *df2, *df3, *df4, *df5, *df6;
@@ -277,6 +297,99 @@ Date: .*\r\n\
         CPPUNIT_ASSERT(re_match(r2, oss.str()));
     }
 
+    void send_data_too_big_test() {
+        TestByte b("b");
+        TestArray big("big", &b);
+        big.append_dim(4096);
+        dds->add_var(&big);
+        dds->set_response_limit(1);
+
+        ConstraintEvaluator ce;
+        try {
+            df->send_data(*dds, ce, oss, "", true);
+            CPPUNIT_FAIL("send_data() should throw Error when the response is too big");
+        }
+        catch (Error &e) {
+            DBG(cerr << "Error: " << e.get_error_message() << endl);
+            CPPUNIT_ASSERT(e.get_error_message().find("too large") != string::npos);
+        }
+
+        // Nothing, not even the MIME headers, was sent
+        CPPUNIT_ASSERT(oss.str().empty());
+
+        dds->set_response_limit(8);
+        df->send_data(*dds, ce, oss, "", true);
+        CPPUNIT_ASSERT(!oss.str().empty());
+        oss.str("");
+    }
+
+    // -c compresses the data only when the server enabled compression
+    void compression_enabled_test() {
+        string test_file = (string) TEST_SRC_DIR + "/server-testsuite/bears.data";
+        char *argv_c[] = { (char*) "test_case", (char *) test_file.c_str(), (char*) "-c" };
+        DODSFilter dfc(3, argv_c);
+        CPPUNIT_ASSERT(dfc.get_compression_enabled() == false);
+
+        ConstraintEvaluator ce;
+        dfc.send_data(*dds, ce, oss, "", true);
+        DBG(cerr << "Plain: " << oss.str() << endl);
+        CPPUNIT_ASSERT(oss.str().find("Content-Encoding: gzip") == string::npos);
+        oss.str("");
+
+        if (deflate_ostream::available()) {
+            dfc.set_compression_enabled(true);
+            dfc.send_data(*dds, ce, oss, "", true);
+            CPPUNIT_ASSERT(oss.str().find("Content-Encoding: gzip") != string::npos);
+            oss.str("");
+        }
+    }
+
+    // Read what was written to a FILE
+    string file_contents(FILE *fp) {
+        fflush(fp);
+        rewind(fp);
+        string contents;
+        char buf[1024];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+            contents.append(buf, n);
+        return contents;
+    }
+
+    // The FILE method sends what the ostream method sends
+    void send_data_file_test() {
+        TestByte b("b");
+        TestArray big("big", &b);
+        big.append_dim(100000);
+        dds->add_var(&big);
+
+        ConstraintEvaluator ce;
+        df->send_data(*dds, ce, oss, "", false);
+
+        FILE *fp = tmpfile();
+        CPPUNIT_ASSERT(fp);
+        fputs("Before\n", fp);
+        df->send_data(*dds, ce, fp, "", false);
+        string contents = file_contents(fp);
+        fclose(fp);
+
+        DBG(cerr << "ostream: " << oss.str().size() << ", FILE: " << contents.size() << endl);
+        CPPUNIT_ASSERT(contents == "Before\n" + oss.str());
+        oss.str("");
+
+        string test_file = (string) TEST_SRC_DIR + "/server-testsuite/bears.data";
+        char *argv_v[] = { (char*) "test_case", (char *) test_file.c_str() };
+        ValuesFilter vf(2, argv_v);
+
+        fp = tmpfile();
+        CPPUNIT_ASSERT(fp);
+        vf.send_data(*dds, ce, fp, "", false);
+        contents = file_contents(fp);
+        fclose(fp);
+
+        CPPUNIT_ASSERT(contents.find("Data:\nvalues") != string::npos);
+    }
+
     void is_conditional_test() {
         CPPUNIT_ASSERT(df->is_conditional() == false);
         CPPUNIT_ASSERT(df3->is_conditional() == true);
@@ -324,6 +437,9 @@ CPPUNIT_TEST_SUITE( DODSFilterTest );
 
         CPPUNIT_TEST(send_das_test);
         CPPUNIT_TEST(send_dds_test);
+        CPPUNIT_TEST(send_data_too_big_test);
+        CPPUNIT_TEST(compression_enabled_test);
+        CPPUNIT_TEST(send_data_file_test);
 
         CPPUNIT_TEST(is_conditional_test);
         CPPUNIT_TEST(get_request_if_modified_since_test);
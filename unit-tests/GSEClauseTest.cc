@@ -0,0 +1,378 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Int32.h"
+#include "Float64.h"
+#include "Array.h"
+#include "Grid.h"
+
+#include "GSEClause.h"
+
+#include "debug.h"
+#include "GetOpt.h"
+
+using namespace CppUnit;
+using namespace std;
+using namespace libdap;
+
+static bool debug = false;
+
+#undef DBG
+#define DBG(x) do { if (debug) {x;} } while(false)
+
+namespace functions {
+
+static const relop all_ops[] = { dods_greater_op, dods_greater_equal_op, dods_less_op, dods_less_equal_op,
+    dods_equal_op, dods_not_equal_op };
+static const int num_ops = sizeof(all_ops) / sizeof(all_ops[0]);
+
+static bool old_compare(double elem, relop op, double value)
+{
+    switch (op) {
+    case dods_greater_op: return elem > value;
+    case dods_greater_equal_op: return elem >= value;
+    case dods_less_op: return elem < value;
+    case dods_less_equal_op: return elem <= value;
+    case dods_equal_op: return elem == value;
+    case dods_not_equal_op: return elem != value;
+    default: return false;
+    }
+}
+
+// The element by element scans GSEClause used before it bisected ordered
+// maps; the new code must give the same start and stop indices.
+static void old_scan(const vector<double> &vals, relop op, double value, int &start, int &stop)
+{
+    int i = start;
+    int end = stop;
+    while (i <= end && !old_compare(vals[i], op, value))
+        i++;
+    start = i;
+
+    i = end;
+    while (i >= 0 && !old_compare(vals[i], op, value))
+        i--;
+    stop = i;
+}
+
+class GSEClauseTest: public TestFixture {
+private:
+    // Build a grid with one map, 'x', that holds 'vals'. An Int32 map holds
+    // the values truncated to integers. When 'dataset' is not empty the
+    // map's statistics are cached using it.
+    Grid *make_grid(const vector<double> &vals, Type type, const string &dataset = "")
+    {
+        Grid *grid = new Grid("g");
+
+        Array *array = new Array("g", new Float64("g"));
+        array->append_dim(vals.size(), "x");
+        grid->add_var_nocopy(array, libdap::array);
+
+        Array *map;
+        if (type == dods_int32_c) {
+            map = new Array("x", dataset, new Int32("x", dataset));
+            vector<dods_int32> ints(vals.begin(), vals.end());
+            map->append_dim(vals.size(), "x");
+            map->set_value(ints, ints.size());
+        }
+        else {
+            map = new Array("x", dataset, new Float64("x", dataset));
+            vector<dods_float64> floats(vals.begin(), vals.end());
+            map->append_dim(vals.size(), "x");
+            map->set_value(floats, floats.size());
+        }
+        map->set_read_p(true);
+        grid->add_var_nocopy(map, libdap::maps);
+
+        return grid;
+    }
+
+    // Compare the indices GSEClause finds with those found by the old scans
+    // for one and two operator clauses using each operator and value.
+    void check_clauses(const vector<double> &vals, const vector<double> &values, Type type = dods_float64_c)
+    {
+        Grid *grid = make_grid(vals, type);
+
+        vector<double> map_vals(vals);
+        if (type == dods_int32_c)
+            for (vector<double>::iterator i = map_vals.begin(), e = map_vals.end(); i != e; ++i)
+                *i = (dods_int32) *i;
+
+        try {
+            for (vector<double>::const_iterator v1 = values.begin(), ve = values.end(); v1 != ve; ++v1) {
+                for (int o1 = 0; o1 < num_ops; ++o1) {
+                    int start = 0, stop = vals.size() - 1;
+                    old_scan(map_vals, all_ops[o1], *v1, start, stop);
+                    check_clause(new GSEClause(grid, "x", *v1, all_ops[o1]), start, stop);
+
+                    for (vector<double>::const_iterator v2 = values.begin(); v2 != ve; ++v2) {
+                        for (int o2 = 0; o2 < num_ops; ++o2) {
+                            int start2 = start, stop2 = stop;
+                            old_scan(map_vals, all_ops[o2], *v2, start2, stop2);
+                            check_clause(new GSEClause(grid, "x", *v1, all_ops[o1], *v2, all_ops[o2]), start2,
+                                stop2);
+                        }
+                    }
+                }
+            }
+        }
+        catch (...) {
+            delete grid;
+            throw;
+        }
+
+        delete grid;
+    }
+
+    void check_clause(GSEClause *clause, int start, int stop)
+    {
+        int clause_start = clause->get_start();
+        int clause_stop = clause->get_stop();
+
+        // The clause deletes its map, which belongs to the grid
+        clause->set_map(0);
+        delete clause;
+
+        DBG(cerr << "start: " << clause_start << " (" << start << "), stop: " << clause_stop << " (" << stop << ")" << endl);
+        CPPUNIT_ASSERT_EQUAL(start, clause_start);
+        CPPUNIT_ASSERT_EQUAL(stop, clause_stop);
+    }
+
+    // Values below, above, between and equal to those in 'vals'
+    static vector<double> test_values(const vector<double> &vals)
+    {
+        vector<double> values;
+        for (vector<double>::const_iterator i = vals.begin(), e = vals.end(); i != e; ++i) {
+            if (*i != *i) continue;
+            values.push_back(*i);
+            values.push_back(*i + 0.5);
+        }
+        sort(values.begin(), values.end());
+        values.erase(unique(values.begin(), values.end()), values.end());
+
+        vector<double> some;
+        for (unsigned int i = 0; i < values.size(); i += values.size() / 8 + 1)
+            some.push_back(values[i]);
+        some.push_back(values.front() - 1);
+        some.push_back(values.back() + 1);
+
+        return some;
+    }
+
+    static vector<double> random_values(int n, int range)
+    {
+        vector<double> vals(n);
+        for (int i = 0; i < n; ++i)
+            vals[i] = rand() % range;
+        return vals;
+    }
+
+public:
+    GSEClauseTest()
+    {
+    }
+    ~GSEClauseTest()
+    {
+    }
+
+    void setUp()
+    {
+        srand(17);
+    }
+
+    void tearDown()
+    {
+    }
+
+    CPPUNIT_TEST_SUITE (GSEClauseTest);
+
+    CPPUNIT_TEST (increasing_test);
+    CPPUNIT_TEST (decreasing_test);
+    CPPUNIT_TEST (constant_test);
+    CPPUNIT_TEST (unordered_test);
+    CPPUNIT_TEST (nan_test);
+    CPPUNIT_TEST (int32_test);
+    CPPUNIT_TEST (no_match_test);
+
+    CPPUNIT_TEST_SUITE_END();
+
+    void increasing_test()
+    {
+        for (int n = 1; n < 40; n += 7) {
+            vector<double> vals = random_values(n, 10);
+            sort(vals.begin(), vals.end());
+            check_clauses(vals, test_values(vals));
+        }
+    }
+
+    void decreasing_test()
+    {
+        for (int n = 1; n < 40; n += 7) {
+            vector<double> vals = random_values(n, 10);
+            sort(vals.begin(), vals.end(), greater<double>());
+            check_clauses(vals, test_values(vals));
+        }
+    }
+
+    void constant_test()
+    {
+        vector<double> vals(9, 3.0);
+        check_clauses(vals, test_values(vals));
+    }
+
+    void unordered_test()
+    {
+        for (int n = 2; n < 40; n += 7) {
+            vector<double> vals = random_values(n, 10);
+            check_clauses(vals, test_values(vals));
+        }
+    }
+
+    // A map with a NaN is not ordered; NaN fails every comparison but !=
+    void nan_test()
+    {
+        vector<double> vals;
+        for (int i = 0; i < 12; ++i)
+            vals.push_back(i);
+        vals[5] = NAN;
+        check_clauses(vals, test_values(vals));
+
+        vals[0] = NAN;
+        vals[5] = 5;
+        check_clauses(vals, test_values(vals));
+
+        vals[0] = 0;
+        vals[11] = NAN;
+        check_clauses(vals, test_values(vals));
+    }
+
+    // The values of an integer map are compared to a double
+    void int32_test()
+    {
+        vector<double> vals = random_values(30, 100);
+        sort(vals.begin(), vals.end());
+        check_clauses(vals, test_values(vals), dods_int32_c);
+
+        reverse(vals.begin(), vals.end());
+        check_clauses(vals, test_values(vals), dods_int32_c);
+    }
+
+    // When nothing matches, start is past stop and stop is -1
+    void no_match_test()
+    {
+        vector<double> vals;
+        for (int i = 0; i < 10; ++i)
+            vals.push_back(i);
+
+        Grid *grid = make_grid(vals, dods_float64_c);
+
+        GSEClause *clause = new GSEClause(grid, "x", 20, dods_greater_op);
+        int start = clause->get_start(), stop = clause->get_stop();
+        clause->set_map(0);
+        delete clause;
+        CPPUNIT_ASSERT_EQUAL(10, start);
+        CPPUNIT_ASSERT_EQUAL(-1, stop);
+
+        // The second operator is applied to [3, 9] going forward, but the
+        // backward scan goes back to the start of the map
+        clause = new GSEClause(grid, "x", 2, dods_greater_op, 1, dods_less_op);
+        start = clause->get_start(), stop = clause->get_stop();
+        clause->set_map(0);
+        delete clause;
+        CPPUNIT_ASSERT_EQUAL(10, start);
+        CPPUNIT_ASSERT_EQUAL(0, stop);
+
+        clause = new GSEClause(grid, "x", 4.5, dods_equal_op);
+        start = clause->get_start(), stop = clause->get_stop();
+        clause->set_map(0);
+        delete clause;
+        CPPUNIT_ASSERT_EQUAL(10, start);
+        CPPUNIT_ASSERT_EQUAL(-1, stop);
+
+        delete grid;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (GSEClauseTest);
+
+} // namespace functions
+
+int main(int argc, char *argv[])
+{
+    GetOpt getopt(argc, argv, "dh");
+    int option_char;
+
+    while ((option_char = getopt()) != -1)
+        switch (option_char) {
+        case 'd':
+            debug = 1;  // debug is a static global
+            break;
+
+        case 'h': {     // help - show test names
+            cerr << "Usage: GSEClauseTest has the following tests:" << endl;
+            const std::vector<Test*> &tests = functions::GSEClauseTest::suite()->getTests();
+            unsigned int prefix_len = functions::GSEClauseTest::suite()->getName().append("::").length();
+            for (std::vector<Test*>::const_iterator i = tests.begin(), e = tests.end(); i != e; ++i) {
+                cerr << (*i)->getName().replace(0, prefix_len, "") << endl;
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+
+    CppUnit::TextTestRunner runner;
+    runner.addTest(CppUnit::TestFactoryRegistry::getRegistry().makeTest());
+
+    bool wasSuccessful = true;
+    string test = "";
+    int i = getopt.optind;
+    if (i == argc) {
+        // run them all
+        wasSuccessful = runner.run("");
+    }
+    else {
+        for (; i < argc; ++i) {
+            if (debug) cerr << "Running " << argv[i] << endl;
+            test = functions::GSEClauseTest::suite()->getName().append("::").append(argv[i]);
+            wasSuccessful = wasSuccessful && runner.run(test);
+        }
+    }
+
+    return wasSuccessful ? 0 : 1;
+}
@@ -34,6 +34,7 @@
 
 #include "GNURegex.h"
 #include "HTTPConnect.h"
+#include "chunked_stream.h"
 #include "RCReader.h"
 
 #include "debug.h"
@@ -162,6 +163,7 @@ public:
 
     CPPUNIT_TEST (set_accept_deflate_test);
     CPPUNIT_TEST (set_xdap_protocol_test);
+    CPPUNIT_TEST (set_chunk_features_test);
     CPPUNIT_TEST (read_url_password_test);
     CPPUNIT_TEST (read_url_password_test2);
 
@@ -717,6 +719,30 @@ public:
         CPPUNIT_ASSERT(count(http->d_request_headers.begin(), http->d_request_headers.end(), "XDAP-Accept: 3.2") == 1);
     }
 
+    void set_chunk_features_test()
+    {
+        http->set_chunk_features(CHUNK_FEATURE_FILTERED);
+        CPPUNIT_ASSERT(
+            count(http->d_request_headers.begin(), http->d_request_headers.end(),
+                "XDAP-Accept-Chunk-Features: filtered") == 1);
+
+        http->set_chunk_features("filtered, other");
+        CPPUNIT_ASSERT(
+            count_if(http->d_request_headers.begin(), http->d_request_headers.end(),
+                HeaderMatch("XDAP-Accept-Chunk-Features:")) == 1);
+        CPPUNIT_ASSERT(
+            count(http->d_request_headers.begin(), http->d_request_headers.end(),
+                "XDAP-Accept-Chunk-Features: filtered, other") == 1);
+
+        // The XDAP-Accept header is not changed
+        http->set_xdap_protocol(4, 0);
+        http->set_chunk_features("");
+        CPPUNIT_ASSERT(
+            count_if(http->d_request_headers.begin(), http->d_request_headers.end(),
+                HeaderMatch("XDAP-Accept-Chunk-Features:")) == 0);
+        CPPUNIT_ASSERT(count(http->d_request_headers.begin(), http->d_request_headers.end(), "XDAP-Accept: 4.0") == 1);
+    }
+
     void read_url_password_test()
     {
         FILE *dump = fopen("/dev/null", "w");
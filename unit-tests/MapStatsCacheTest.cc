@@ -0,0 +1,399 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <vector>
+
+#include "Float64.h"
+#include "Int32.h"
+#include "Array.h"
+#include "Grid.h"
+
+#include "MapStatsCache.h"
+#include "GSEClause.h"
+
+#include "debug.h"
+#include "GetOpt.h"
+
+using namespace CppUnit;
+using namespace std;
+using namespace libdap;
+
+static bool debug = false;
+
+#undef DBG
+#define DBG(x) do { if (debug) {x;} } while(false)
+
+namespace functions {
+
+class MapStatsCacheTest: public TestFixture {
+private:
+    MapStatsCache *d_cache;
+    string d_file;      // the dataset
+
+    // Build a grid from dataset 'ds' (by default the test's file) with one
+    // Float64 map, 'x', that holds 'vals'
+    Grid *make_grid(const vector<dods_float64> &vals, string ds = "")
+    {
+        if (ds.empty())
+            ds = d_file;
+
+        Grid *grid = new Grid("g", ds);
+
+        Array *array = new Array("g", ds, new Float64("g", ds));
+        array->append_dim(vals.size(), "x");
+        grid->add_var_nocopy(array, libdap::array);
+
+        Array *map = new Array("x", ds, new Float64("x", ds));
+        map->append_dim(vals.size(), "x");
+        vector<dods_float64> v(vals);
+        map->set_value(v, v.size());
+        map->set_read_p(true);
+        grid->add_var_nocopy(map, libdap::maps);
+
+        return grid;
+    }
+
+    // Use a clause on map 'x' of 'grid', returning its start and stop
+    void clause_indices(Grid *grid, double value, relop op, int &start, int &stop)
+    {
+        GSEClause *clause = new GSEClause(grid, "x", value, op);
+        start = clause->get_start();
+        stop = clause->get_stop();
+
+        // The clause deletes its map, which belongs to the grid
+        clause->set_map(0);
+        delete clause;
+    }
+
+    map_stats cached_stats(Grid *grid)
+    {
+        map_stats stats;
+        CPPUNIT_ASSERT(d_cache->find(MapStatsCache::key(static_cast<Array*>(grid->var("x"))), stats));
+        return stats;
+    }
+
+public:
+    MapStatsCacheTest() : d_cache(0)
+    {
+    }
+    ~MapStatsCacheTest()
+    {
+    }
+
+    void setUp()
+    {
+        d_cache = MapStatsCache::TheCache();
+        d_cache->clear();
+        d_cache->set_max_entries(1024);
+
+        char name[] = "/tmp/MapStatsCacheTestXXXXXX";
+        int fd = mkstemp(name);
+        CPPUNIT_ASSERT(fd != -1);
+        close(fd);
+        d_file = name;
+    }
+
+    void tearDown()
+    {
+        d_cache->clear();
+        d_cache->set_max_entries(1024);
+
+        unlink(d_file.c_str());
+    }
+
+    CPPUNIT_TEST_SUITE (MapStatsCacheTest);
+
+    CPPUNIT_TEST (key_test);
+    CPPUNIT_TEST (add_find_test);
+    CPPUNIT_TEST (max_entries_test);
+    CPPUNIT_TEST (clause_adds_stats_test);
+    CPPUNIT_TEST (unchanged_map_test);
+    CPPUNIT_TEST (cached_order_test);
+    CPPUNIT_TEST (changed_file_test);
+    CPPUNIT_TEST (not_a_file_test);
+    CPPUNIT_TEST (changed_type_test);
+
+    CPPUNIT_TEST_SUITE_END();
+
+    void key_test()
+    {
+        Array a("x", new Float64("x"));
+        CPPUNIT_ASSERT_EQUAL(string(""), MapStatsCache::key(&a));
+
+        vector<dods_float64> vals(3, 1.0);
+        Grid *grid = make_grid(vals, "ds");
+        CPPUNIT_ASSERT_EQUAL(string(""), MapStatsCache::key(static_cast<Array*>(grid->var("x"))));
+        delete grid;
+
+        grid = make_grid(vals);
+        string key = MapStatsCache::key(static_cast<Array*>(grid->var("x")));
+        DBG(cerr << "key: " << key << endl);
+        CPPUNIT_ASSERT_EQUAL(0, (int)key.find(d_file + "#"));
+        CPPUNIT_ASSERT(key.find("#g.x[0:1:2]") != string::npos);
+        delete grid;
+    }
+
+    void add_find_test()
+    {
+        map_stats stats;
+        stats.type = dods_float64_c;
+        stats.length = 10;
+        stats.order = map_decreasing;
+
+        d_cache->add("ds#x", stats);
+        d_cache->add("", stats);    // not cached
+        CPPUNIT_ASSERT_EQUAL(1U, d_cache->size());
+
+        map_stats found;
+        CPPUNIT_ASSERT(d_cache->find("ds#x", found));
+        CPPUNIT_ASSERT_EQUAL(10, found.length);
+        CPPUNIT_ASSERT(found.order == map_decreasing);
+        CPPUNIT_ASSERT(!d_cache->find("ds#y", found));
+        CPPUNIT_ASSERT(!d_cache->find("", found));
+
+        d_cache->add("ds#y", stats);
+        d_cache->remove("ds#x");
+        CPPUNIT_ASSERT(!d_cache->find("ds#x", found));
+        CPPUNIT_ASSERT(d_cache->find("ds#y", found));
+
+        d_cache->clear();
+        CPPUNIT_ASSERT_EQUAL(0U, d_cache->size());
+    }
+
+    void max_entries_test()
+    {
+        map_stats stats;
+        d_cache->set_max_entries(2);
+        CPPUNIT_ASSERT_EQUAL(2U, d_cache->get_max_entries());
+
+        d_cache->add("a", stats);
+        d_cache->add("b", stats);
+        d_cache->add("b", stats);   // replaced
+        CPPUNIT_ASSERT_EQUAL(2U, d_cache->size());
+
+        // A full cache is emptied
+        d_cache->add("c", stats);
+        CPPUNIT_ASSERT_EQUAL(1U, d_cache->size());
+
+        d_cache->set_max_entries(0);
+        CPPUNIT_ASSERT_EQUAL(0U, d_cache->size());
+        d_cache->add("d", stats);
+        CPPUNIT_ASSERT_EQUAL(0U, d_cache->size());
+    }
+
+    void clause_adds_stats_test()
+    {
+        vector<dods_float64> vals;
+        for (int i = 0; i < 10; ++i)
+            vals.push_back(10 - i);
+        Grid *grid = make_grid(vals);
+
+        int start, stop;
+        clause_indices(grid, 5, dods_greater_op, start, stop);
+        CPPUNIT_ASSERT_EQUAL(0, start);
+        CPPUNIT_ASSERT_EQUAL(4, stop);
+
+        map_stats stats = cached_stats(grid);
+        CPPUNIT_ASSERT(stats.type == dods_float64_c);
+        CPPUNIT_ASSERT_EQUAL(10, stats.length);
+        CPPUNIT_ASSERT(stats.order == map_decreasing);
+        CPPUNIT_ASSERT_EQUAL(1.0, stats.min);
+        CPPUNIT_ASSERT_EQUAL(10.0, stats.max);
+
+        delete grid;
+    }
+
+    // The cached order is used for a second request
+    void unchanged_map_test()
+    {
+        vector<dods_float64> vals;
+        for (int i = 0; i < 10; ++i)
+            vals.push_back(i);
+
+        Grid *grid = make_grid(vals);
+        int start, stop;
+        clause_indices(grid, 3, dods_greater_equal_op, start, stop);
+        delete grid;
+
+        grid = make_grid(vals);
+        clause_indices(grid, 3, dods_greater_equal_op, start, stop);
+        CPPUNIT_ASSERT_EQUAL(3, start);
+        CPPUNIT_ASSERT_EQUAL(9, stop);
+        CPPUNIT_ASSERT(cached_stats(grid).order == map_increasing);
+        CPPUNIT_ASSERT_EQUAL(1U, d_cache->size());
+        delete grid;
+    }
+
+    // A cached entry is used without looking at the map's values
+    void cached_order_test()
+    {
+        vector<dods_float64> vals;
+        for (int i = 0; i < 10; ++i)
+            vals.push_back(i);
+        Grid *grid = make_grid(vals);
+
+        map_stats stats;
+        stats.type = dods_float64_c;
+        stats.length = 10;
+        stats.order = map_unordered;
+        d_cache->add(MapStatsCache::key(static_cast<Array*>(grid->var("x"))), stats);
+
+        // An unordered map is scanned, which works for any map
+        int start, stop;
+        clause_indices(grid, 5, dods_less_op, start, stop);
+        CPPUNIT_ASSERT_EQUAL(0, start);
+        CPPUNIT_ASSERT_EQUAL(4, stop);
+        CPPUNIT_ASSERT(cached_stats(grid).order == map_unordered);
+        delete grid;
+    }
+
+    // When the dataset's file changes, its maps get new entries
+    void changed_file_test()
+    {
+        vector<dods_float64> vals;
+        for (int i = 0; i < 10; ++i)
+            vals.push_back(i);
+
+        Grid *grid = make_grid(vals);
+        int start, stop;
+        clause_indices(grid, 5, dods_less_op, start, stop);
+        CPPUNIT_ASSERT_EQUAL(0, start);
+        CPPUNIT_ASSERT_EQUAL(4, stop);
+        delete grid;
+
+        ofstream file(d_file.c_str());
+        file << "new contents" << endl;
+        file.close();
+
+        vals[7] = 1;    // 0 1 2 3 4 5 6 1 8 9
+        grid = make_grid(vals);
+        clause_indices(grid, 5, dods_less_op, start, stop);
+        CPPUNIT_ASSERT_EQUAL(0, start);
+        CPPUNIT_ASSERT_EQUAL(7, stop);
+        CPPUNIT_ASSERT(cached_stats(grid).order == map_unordered);
+        CPPUNIT_ASSERT_EQUAL(2U, d_cache->size());
+        delete grid;
+    }
+
+    // Maps of datasets that are not files are not cached
+    void not_a_file_test()
+    {
+        vector<dods_float64> vals;
+        for (int i = 0; i < 10; ++i)
+            vals.push_back(i);
+
+        Grid *grid = make_grid(vals, "ds");
+        int start, stop;
+        clause_indices(grid, 5, dods_less_op, start, stop);
+        CPPUNIT_ASSERT_EQUAL(0, start);
+        CPPUNIT_ASSERT_EQUAL(4, stop);
+        CPPUNIT_ASSERT_EQUAL(0U, d_cache->size());
+        delete grid;
+    }
+
+    // Statistics for a map of a different type or length are not used
+    void changed_type_test()
+    {
+        map_stats stats;
+        stats.type = dods_int32_c;
+        stats.length = 10;
+        stats.order = map_decreasing;
+
+        vector<dods_float64> vals;
+        for (int i = 0; i < 10; ++i)
+            vals.push_back(i);
+        Grid *grid = make_grid(vals);
+        d_cache->add(MapStatsCache::key(static_cast<Array*>(grid->var("x"))), stats);
+
+        int start, stop;
+        clause_indices(grid, 5, dods_less_op, start, stop);
+        CPPUNIT_ASSERT_EQUAL(0, start);
+        CPPUNIT_ASSERT_EQUAL(4, stop);
+        CPPUNIT_ASSERT(cached_stats(grid).type == dods_float64_c);
+        CPPUNIT_ASSERT(cached_stats(grid).order == map_increasing);
+        delete grid;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (MapStatsCacheTest);
+
+} // namespace functions
+
+int main(int argc, char *argv[])
+{
+    GetOpt getopt(argc, argv, "dh");
+    int option_char;
+
+    while ((option_char = getopt()) != -1)
+        switch (option_char) {
+        case 'd':
+            debug = 1;  // debug is a static global
+            break;
+
+        case 'h': {     // help - show test names
+            cerr << "Usage: MapStatsCacheTest has the following tests:" << endl;
+            const std::vector<Test*> &tests = functions::MapStatsCacheTest::suite()->getTests();
+            unsigned int prefix_len = functions::MapStatsCacheTest::suite()->getName().append("::").length();
+            for (std::vector<Test*>::const_iterator i = tests.begin(), e = tests.end(); i != e; ++i) {
+                cerr << (*i)->getName().replace(0, prefix_len, "") << endl;
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+
+    CppUnit::TextTestRunner runner;
+    runner.addTest(CppUnit::TestFactoryRegistry::getRegistry().makeTest());
+
+    bool wasSuccessful = true;
+    string test = "";
+    int i = getopt.optind;
+    if (i == argc) {
+        // run them all
+        wasSuccessful = runner.run("");
+    }
+    else {
+        for (; i < argc; ++i) {
+            if (debug) cerr << "Running " << argv[i] << endl;
+            test = functions::MapStatsCacheTest::suite()->getName().append("::").append(argv[i]);
+            wasSuccessful = wasSuccessful && runner.run(test);
+        }
+    }
+
+    return wasSuccessful ? 0 : 1;
+}
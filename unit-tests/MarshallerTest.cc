@@ -17,6 +17,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <cstring>
 
 #include "TestByte.h"
@@ -36,10 +37,13 @@
 #include "DataDDS.h"
 #include "ConstraintEvaluator.h"
 #include "TestTypeFactory.h"
+#include "XDRFdMarshaller.h"
 #include "XDRFileMarshaller.h"
 #include "XDRStreamMarshaller.h"
 #include "XDRFileUnMarshaller.h"
 #include "XDRStreamUnMarshaller.h"
+#include "XDRUtils.h"
+#include "util.h"
 #include "GetOpt.h"
 //#include "Locker.h"
 #include "debug.h"
@@ -56,6 +60,41 @@ using namespace std;
 
 namespace libdap {
 
+// Serialize and then deserialize values that depend on the thread number;
+// used to check that XDRStream(Un)Marshaller instances in different threads
+// do not share state.
+static void *xdr_stream_thread(void *arg)
+{
+    long t = (long) arg;
+    bool *ok = new bool(true);
+
+    for (int pass = 0; pass < 200 && *ok; ++pass) {
+        ostringstream oss;
+        {
+            XDRStreamMarshaller m(oss);
+            for (int i = 0; i < 50; ++i) {
+                m.put_int32(t * 1000 + i);
+                m.put_float64(t + i * 0.5);
+                m.put_str("thread " + long_to_string(t));
+            }
+        }
+
+        istringstream iss(oss.str());
+        XDRStreamUnMarshaller um(iss);
+        for (int i = 0; i < 50 && *ok; ++i) {
+            dods_int32 i32;
+            dods_float64 f64;
+            string str;
+            um.get_int32(i32);
+            um.get_float64(f64);
+            um.get_str(str);
+            *ok = i32 == t * 1000 + i && f64 == t + i * 0.5 && str == "thread " + long_to_string(t);
+        }
+    }
+
+    return ok;
+}
+
 class MarshallerTest: public CppUnit::TestFixture {
 
     CPPUNIT_TEST_SUITE (MarshallerTest);
@@ -109,6 +148,14 @@ class MarshallerTest: public CppUnit::TestFixture {
     CPPUNIT_TEST (array_stream_serialize_part_thread_test);
     CPPUNIT_TEST (array_stream_serialize_part_thread_test_2);
     CPPUNIT_TEST (array_stream_serialize_part_thread_test_3);
+
+    CPPUNIT_TEST (xdr_encode_array_test);
+    CPPUNIT_TEST (xdr_stream_vector_round_trip_test);
+    CPPUNIT_TEST (xdr_stream_vector_too_long_test);
+    CPPUNIT_TEST (xdr_stream_threads_test);
+
+    CPPUNIT_TEST (fd_serialize_test);
+    CPPUNIT_TEST (fd_serialize_part_test);
 #endif
 
     CPPUNIT_TEST_SUITE_END( );
@@ -230,6 +277,65 @@ public:
         s->set_send_p(true);
     }
 
+    // Serialize all of the variables, once using put_vector_part()
+    void serialize_all(Marshaller &m)
+    {
+        b->serialize(eval, dds, m, false);
+        i16->serialize(eval, dds, m, false);
+        i32->serialize(eval, dds, m, false);
+        ui16->serialize(eval, dds, m, false);
+        ui32->serialize(eval, dds, m, false);
+        f32->serialize(eval, dds, m, false);
+        f64->serialize(eval, dds, m, false);
+        str->serialize(eval, dds, m, false);
+        url->serialize(eval, dds, m, false);
+        arr->serialize(eval, dds, m, false);
+        arr_f32->serialize(eval, dds, m, false);
+        arr_f64->serialize(eval, dds, m, false);
+        s->serialize(eval, dds, m, false);
+
+        vector<dods_int16> i16_values(37);
+        for (int i = 0; i < 37; ++i)
+            i16_values[i] = -i * 100;
+        m.put_vector_start(37 + 11);
+        m.put_vector_part((char *) &i16_values[0], 37, sizeof(dods_int16), dods_int16_c);
+        m.put_vector_part((char *) &i16_values[0], 11, sizeof(dods_int16), dods_int16_c);
+        m.put_vector_end();
+
+        m.put_vector_start(7 + 10);
+        m.put_vector_part((char *) &db[0], 7, 1, dods_byte_c);
+        m.put_vector_part((char *) &db[0], 10, 1, dods_byte_c);
+        m.put_vector_end();
+    }
+
+    // Read and close a temporary file
+    string read_file(FILE *f)
+    {
+        string out;
+        rewind(f);
+        char buf[1024];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            out.append(buf, n);
+        fclose(f);
+
+        return out;
+    }
+
+    // The bytes written to a temporary file by an XDRFdMarshaller
+    string fd_serialize(unsigned int buf_size)
+    {
+        FILE *f = tmpfile();
+        CPPUNIT_ASSERT(f);
+        {
+            XDRFdMarshaller m(fileno(f), buf_size);
+            serialize_all(m);
+            m.flush();
+        }
+
+        return read_file(f);
+    }
+
     void tearDown()
     {
         delete b;
@@ -692,6 +798,185 @@ public:
         }
     }
 
+    // Encode values using xdr_array() and XDRUtils::encode_array(); the
+    // latter does not write the element count.
+    template<typename T>
+    void check_encode_array(const vector<T> &vals, Type type)
+    {
+        unsigned int num = vals.size();
+        unsigned int size = num * max(sizeof(T), (size_t) 4) + 4;
+
+        vector<char> xdr_buf(size);
+        XDR sink;
+        xdrmem_create(&sink, &xdr_buf[0], size, XDR_ENCODE);
+        char *val = (char *) &vals[0];
+        CPPUNIT_ASSERT(xdr_array(&sink, &val, &num, size, sizeof(T), XDRUtils::xdr_coder(type)));
+        CPPUNIT_ASSERT_EQUAL(size, (unsigned int) xdr_getpos(&sink));
+        xdr_destroy(&sink);
+
+        vector<char> buf(size - 4);
+        XDRUtils::encode_array((const char *) &vals[0], num, sizeof(T), type, &buf[0]);
+        CPPUNIT_ASSERT(!memcmp(&xdr_buf[4], &buf[0], size - 4));
+
+        vector<T> vals2(num);
+        XDRUtils::decode_array(&buf[0], num, sizeof(T), (char *) &vals2[0]);
+        CPPUNIT_ASSERT(vals == vals2);
+    }
+
+    void xdr_encode_array_test()
+    {
+        vector<dods_int16> i16(37);
+        vector<dods_uint16> ui16(37);
+        vector<dods_int32> i32(37);
+        vector<dods_uint32> ui32(37);
+        vector<dods_float32> f32(37);
+        vector<dods_float64> f64(37);
+        for (int i = 0; i < 37; ++i) {
+            i16[i] = (i - 18) * 1000;
+            ui16[i] = i * 1700;
+            i32[i] = (i - 18) * 100000;
+            ui32[i] = i * 100000000U;
+            f32[i] = (i - 18) / 3.0;
+            f64[i] = (i - 18) / 7.0;
+        }
+
+        check_encode_array(i16, dods_int16_c);
+        check_encode_array(ui16, dods_uint16_c);
+        check_encode_array(i32, dods_int32_c);
+        check_encode_array(ui32, dods_uint32_c);
+        check_encode_array(f32, dods_float32_c);
+        check_encode_array(f64, dods_float64_c);
+    }
+
+    // Arrays of 16-bit values are read into 16-bit values
+    void xdr_stream_vector_round_trip_test()
+    {
+        vector<dods_int16> i16(100);
+        vector<dods_float64> f64(100);
+        for (int i = 0; i < 100; ++i) {
+            i16[i] = -50 * i;
+            f64[i] = i * 0.25;
+        }
+
+        ostringstream oss;
+        {
+            XDRStreamMarshaller m(oss);
+            m.put_vector((char *) &i16[0], 100, sizeof(dods_int16), dods_int16_c);
+            m.put_vector((char *) &f64[0], 100, sizeof(dods_float64), dods_float64_c);
+        }
+        CPPUNIT_ASSERT_EQUAL((size_t) (8 + 400 + 8 + 800), oss.str().size());
+
+        istringstream iss(oss.str());
+        XDRStreamUnMarshaller um(iss);
+        int num;
+        um.get_int(num);
+        CPPUNIT_ASSERT_EQUAL(100, num);
+
+        vector<dods_int16> i16_2(100 + 1, 7);
+        char *val = (char *) &i16_2[0];
+        unsigned int n = 100;
+        um.get_vector(&val, n, sizeof(dods_int16), dods_int16_c);
+        CPPUNIT_ASSERT_EQUAL(100U, n);
+        CPPUNIT_ASSERT(equal(i16.begin(), i16.end(), i16_2.begin()));
+        // Nothing is written past the end of the values
+        CPPUNIT_ASSERT_EQUAL((dods_int16) 7, i16_2[100]);
+
+        um.get_int(num);
+        vector<dods_float64> f64_2(100);
+        val = (char *) &f64_2[0];
+        um.get_vector(&val, n, sizeof(dods_float64), dods_float64_c);
+        CPPUNIT_ASSERT(f64 == f64_2);
+    }
+
+    // A count larger than the buffer given to get_vector() is an error
+    void xdr_stream_vector_too_long_test()
+    {
+        vector<dods_int32> i32(100);
+        ostringstream oss;
+        {
+            XDRStreamMarshaller m(oss);
+            m.put_vector((char *) &i32[0], 100, sizeof(dods_int32), dods_int32_c);
+        }
+
+        istringstream iss(oss.str());
+        XDRStreamUnMarshaller um(iss);
+        int num;
+        um.get_int(num);
+
+        vector<dods_int32> i32_2(10);
+        char *val = (char *) &i32_2[0];
+        unsigned int n = 10;
+        CPPUNIT_ASSERT_THROW(um.get_vector(&val, n, sizeof(dods_int32), dods_int32_c), Error);
+    }
+
+    // Several threads can serialize responses at the same time
+    void xdr_stream_threads_test()
+    {
+        const long num_threads = 8;
+        pthread_t threads[num_threads];
+        for (long t = 0; t < num_threads; ++t)
+            CPPUNIT_ASSERT(pthread_create(&threads[t], 0, xdr_stream_thread, (void *) t) == 0);
+
+        for (long t = 0; t < num_threads; ++t) {
+            void *ok;
+            CPPUNIT_ASSERT(pthread_join(threads[t], &ok) == 0);
+            CPPUNIT_ASSERT(*(bool *) ok);
+            delete (bool *) ok;
+        }
+    }
+
+    // XDRFdMarshaller writes the same response as XDRStreamMarshaller, no
+    // matter how large its buffer is.
+    void fd_serialize_test()
+    {
+        ostringstream oss;
+        {
+            XDRStreamMarshaller m(oss);
+            serialize_all(m);
+        }
+
+        CPPUNIT_ASSERT(fd_serialize(XDR_FD_BUFF_SIZE) == oss.str());
+        // Arrays are encoded in several blocks; Byte arrays and strings are
+        // larger than the buffer.
+        CPPUNIT_ASSERT(fd_serialize(8) == oss.str());
+        CPPUNIT_ASSERT(fd_serialize(20) == oss.str());
+    }
+
+    // Values written using XDRFdMarshaller can be read by XDRStreamUnMarshaller
+    void fd_serialize_part_test()
+    {
+        FILE *f = tmpfile();
+        CPPUNIT_ASSERT(f);
+
+        vector<dods_float64> values(1000);
+        for (int i = 0; i < 1000; ++i)
+            values[i] = i * 0.125;
+        {
+            XDRFdMarshaller m(fileno(f), 100);
+            m.put_str(str_value + "a longer string value");
+            m.put_vector_start(1000);
+            m.put_vector_part((char *) &values[0], 600, sizeof(dods_float64), dods_float64_c);
+            m.put_vector_part((char *) &values[600], 400, sizeof(dods_float64), dods_float64_c);
+            m.put_vector_end();
+        }
+
+        istringstream iss(read_file(f));
+        XDRStreamUnMarshaller um(iss);
+        string s;
+        um.get_str(s);
+        CPPUNIT_ASSERT(s == str_value + "a longer string value");
+
+        int num;
+        um.get_int(num);
+        CPPUNIT_ASSERT_EQUAL(1000, num);
+
+        vector<dods_float64> values_2(1000);
+        char *val = (char *) &values_2[0];
+        unsigned int count = 1000;
+        um.get_vector(&val, count, sizeof(dods_float64), dods_float64_c);
+        CPPUNIT_ASSERT(values == values_2);
+    }
+
     void array_stream_deserialize_test()
     {
         try {
@@ -64,7 +64,7 @@ static const char *s_as_string =
           _send_p: 0\n\
           _synthesized_p: 0\n\
           d_parent: 0.*\n\
-          d_attr: 0x.*\n\
+          d_attr: .*\n\
 BaseType \\(0x.*\\):\n\
           _name: i1\n\
           _type: Int32\n\
@@ -73,7 +73,7 @@ BaseType \\(0x.*\\):\n\
           _send_p: 0\n\
           _synthesized_p: 0\n\
           d_parent: 0x.*\n\
-          d_attr: 0x.*\n\
+          d_attr: .*\n\
 BaseType \\(0x.*\\):\n\
           _name: str1\n\
           _type: String\n\
@@ -82,7 +82,7 @@ BaseType \\(0x.*\\):\n\
           _send_p: 0\n\
           _synthesized_p: 0\n\
           d_parent: 0x.*\n\
-          d_attr: 0x.*\n\
+          d_attr: .*\n\
 BaseType \\(0x.*\\):\n\
           _name: i2\n\
           _type: Int32\n\
@@ -91,7 +91,7 @@ BaseType \\(0x.*\\):\n\
           _send_p: 0\n\
           _synthesized_p: 0\n\
           d_parent: 0x.*\n\
-          d_attr: 0x.*\n\
+          d_attr: .*\n\
 \n";
 
 static Regex s_regex(s_as_string);
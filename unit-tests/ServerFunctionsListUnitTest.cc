@@ -26,6 +26,8 @@
 
 #include <pthread.h>
 
+#include <algorithm>
+
 #include <cppunit/TextTestRunner.h>
 #include <cppunit/extensions/TestFactoryRegistry.h>
 #include <cppunit/extensions/HelperMacros.h>
@@ -59,6 +61,15 @@ void sflut(int, libdap::BaseType *[], libdap::DDS &, libdap::BaseType **btpp)
 
 }
 
+void sflut_proj(int, libdap::BaseType *[], libdap::DDS &, libdap::ConstraintEvaluator &)
+{
+}
+
+libdap::BaseType *sflut_d4(libdap::D4RValueList *, libdap::DMR &)
+{
+    return 0;
+}
+
 class SFLUT: public libdap::ServerFunction {
 public:
     SFLUT()
@@ -107,6 +118,9 @@ public:
     CPPUNIT_TEST_SUITE (libdap::ServerFunctionsListUnitTest);
 
     CPPUNIT_TEST (sflut_test);
+    CPPUNIT_TEST (find_function_test);
+    CPPUNIT_TEST (old_tables_test);
+    CPPUNIT_TEST (is_pure_test);
     //CPPUNIT_TEST(always_pass);
 
     CPPUNIT_TEST_SUITE_END();
@@ -176,6 +190,120 @@ public:
 
     }
 
+    static void *find_in_loop(void *arg)
+    {
+        bool *found = static_cast<bool*>(arg);
+        for (int i = 0; i < 10000 && *found; ++i) {
+            libdap::btp_func f = 0;
+            *found = libdap::ServerFunctionsList::TheList()->find_function("find_test", &f) && f == sflut;
+        }
+        return 0;
+    }
+
+    void find_function_test()
+    {
+        ServerFunctionsList *list = libdap::ServerFunctionsList::TheList();
+
+        SFLUT *btp = new SFLUT();
+        btp->setName("find_test");
+        list->add_function(btp);
+
+        SFLUT *proj = new SFLUT();
+        proj->setName("find_test");
+        proj->setFunction(sflut_proj);
+        list->add_function(proj);
+
+        btp_func bf = 0;
+        CPPUNIT_ASSERT(list->find_function("find_test", &bf));
+        CPPUNIT_ASSERT(bf == sflut);
+
+        proj_func pf = 0;
+        CPPUNIT_ASSERT(list->find_function("find_test", &pf));
+        CPPUNIT_ASSERT(pf == sflut_proj);
+
+        bool_func boolf = 0;
+        CPPUNIT_ASSERT(!list->find_function("find_test", &boolf));
+        CPPUNIT_ASSERT(!list->find_function("no_such_function", &bf));
+
+        // Look up a function in other threads while functions are added
+        bool found[4] = { true, true, true, true };
+        pthread_t threads[4];
+        for (int i = 0; i < 4; ++i)
+            CPPUNIT_ASSERT(pthread_create(&threads[i], 0, find_in_loop, &found[i]) == 0);
+
+        for (int i = 0; i < 100; ++i) {
+            SFLUT *func = new SFLUT();
+            func->setName("find_test_" + long_to_string(i));
+            list->add_function(func);
+        }
+
+        for (int i = 0; i < 4; ++i) {
+            CPPUNIT_ASSERT(pthread_join(threads[i], 0) == 0);
+            CPPUNIT_ASSERT(found[i]);
+        }
+
+        for (int i = 0; i < 100; ++i) {
+            bf = 0;
+            CPPUNIT_ASSERT(list->find_function("find_test_" + long_to_string(i), &bf));
+            CPPUNIT_ASSERT(bf == sflut);
+        }
+    }
+
+    void old_tables_test()
+    {
+        ServerFunctionsList *list = libdap::ServerFunctionsList::TheList();
+
+        // With no lookup in progress, replaced tables are deleted
+        SFLUT *func = new SFLUT();
+        func->setName("old_tables_test_1");
+        list->add_function(func);
+        CPPUNIT_ASSERT(list->d_old_tables.empty());
+
+        // While a lookup is in progress, the table it may be reading is kept
+        __sync_add_and_fetch(&list->d_readers, 1);
+        func = new SFLUT();
+        func->setName("old_tables_test_2");
+        list->add_function(func);
+        CPPUNIT_ASSERT(list->d_old_tables.size() == 1);
+        __sync_sub_and_fetch(&list->d_readers, 1);
+
+        vector<string> names;
+        list->getFunctionNames(&names);
+        CPPUNIT_ASSERT(find(names.begin(), names.end(), "old_tables_test_2") != names.end());
+
+        func = new SFLUT();
+        func->setName("old_tables_test_3");
+        list->add_function(func);
+        CPPUNIT_ASSERT(list->d_old_tables.empty());
+    }
+
+    void is_pure_test()
+    {
+        ServerFunctionsList *list = libdap::ServerFunctionsList::TheList();
+
+        SFLUT *pure = new SFLUT();
+        pure->setName("pure_test");
+        pure->setFunction(sflut_d4);
+        pure->setPure(true);
+        list->add_function(pure);
+
+        SFLUT *impure = new SFLUT();
+        impure->setName("impure_test");
+        impure->setFunction(sflut_d4);
+        list->add_function(impure);
+
+        CPPUNIT_ASSERT(list->is_pure("pure_test"));
+        CPPUNIT_ASSERT(!list->is_pure("impure_test"));
+        CPPUNIT_ASSERT(!list->is_pure("no_such_function"));
+
+        // Only the DAP4 function's declaration counts
+        SFLUT *btp = new SFLUT();
+        btp->setName("btp_pure_test");
+        btp->setPure(true);
+        list->add_function(btp);
+        CPPUNIT_ASSERT(!list->is_pure("btp_pure_test"));
+    }
+
 };
 } // libdap namespace
 
@@ -0,0 +1,262 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "StringColumn.h"
+
+#include "debug.h"
+#include "GetOpt.h"
+
+using namespace CppUnit;
+using namespace std;
+
+static bool debug = false;
+
+#undef DBG
+#define DBG(x) do { if (debug) {x;} } while(false)
+
+namespace libdap {
+
+class StringColumnTest: public TestFixture {
+private:
+    StringColumn *d_col;
+
+public:
+    StringColumnTest() : d_col(0)
+    {
+    }
+
+    ~StringColumnTest()
+    {
+    }
+
+    void setUp()
+    {
+        d_col = new StringColumn;
+        d_col->push_back("station one");
+        d_col->push_back("");
+        d_col->push_back("2020-03-17T00:00:00Z");
+    }
+
+    void tearDown()
+    {
+        delete d_col;
+        d_col = 0;
+    }
+
+    CPPUNIT_TEST_SUITE (StringColumnTest);
+
+    CPPUNIT_TEST (push_back_test);
+    CPPUNIT_TEST (set_longer_test);
+    CPPUNIT_TEST (set_shorter_test);
+    CPPUNIT_TEST (set_past_end_test);
+    CPPUNIT_TEST (resize_test);
+    CPPUNIT_TEST (clear_test);
+    CPPUNIT_TEST (copy_test);
+    CPPUNIT_TEST (set_in_place_test);
+    CPPUNIT_TEST (set_many_test);
+
+    CPPUNIT_TEST_SUITE_END();
+
+    void push_back_test()
+    {
+        CPPUNIT_ASSERT(d_col->size() == 3);
+        CPPUNIT_ASSERT(d_col->get(0) == "station one");
+        CPPUNIT_ASSERT(d_col->get(1) == "");
+        CPPUNIT_ASSERT(d_col->length(1) == 0);
+        CPPUNIT_ASSERT(d_col->get(2) == "2020-03-17T00:00:00Z");
+        CPPUNIT_ASSERT(d_col->bytes() == 31);
+
+        string s = "old value";
+        d_col->get(2, s);
+        CPPUNIT_ASSERT(s == "2020-03-17T00:00:00Z");
+    }
+
+    void set_longer_test()
+    {
+        d_col->set(1, "a new, longer value");
+        CPPUNIT_ASSERT(d_col->size() == 3);
+        CPPUNIT_ASSERT(d_col->get(0) == "station one");
+        CPPUNIT_ASSERT(d_col->get(1) == "a new, longer value");
+        CPPUNIT_ASSERT(d_col->get(2) == "2020-03-17T00:00:00Z");
+    }
+
+    void set_shorter_test()
+    {
+        d_col->set(0, "st1");
+        CPPUNIT_ASSERT(d_col->size() == 3);
+        CPPUNIT_ASSERT(d_col->get(0) == "st1");
+        CPPUNIT_ASSERT(d_col->get(1) == "");
+        CPPUNIT_ASSERT(d_col->get(2) == "2020-03-17T00:00:00Z");
+        CPPUNIT_ASSERT(d_col->bytes() == 23);
+    }
+
+    void set_past_end_test()
+    {
+        d_col->set(5, "five");
+        CPPUNIT_ASSERT(d_col->size() == 6);
+        CPPUNIT_ASSERT(d_col->get(3) == "");
+        CPPUNIT_ASSERT(d_col->get(4) == "");
+        CPPUNIT_ASSERT(d_col->get(5) == "five");
+    }
+
+    void resize_test()
+    {
+        d_col->resize(1);
+        CPPUNIT_ASSERT(d_col->size() == 1);
+        CPPUNIT_ASSERT(d_col->bytes() == 11);
+        CPPUNIT_ASSERT(d_col->get(0) == "station one");
+
+        d_col->resize(3);
+        CPPUNIT_ASSERT(d_col->size() == 3);
+        CPPUNIT_ASSERT(d_col->get(2) == "");
+    }
+
+    void clear_test()
+    {
+        d_col->clear();
+        CPPUNIT_ASSERT(d_col->empty());
+        CPPUNIT_ASSERT(d_col->bytes() == 0);
+
+        d_col->push_back("again");
+        CPPUNIT_ASSERT(d_col->size() == 1);
+        CPPUNIT_ASSERT(d_col->get(0) == "again");
+
+        d_col->release();
+        CPPUNIT_ASSERT(d_col->empty());
+    }
+
+    // A value that fits is written in place of the old one
+    void set_in_place_test()
+    {
+        // String 2 starts 11 characters after string 0
+        d_col->set(0, "station 1");
+        d_col->set(2, "2020-03-18T00:00:00Z");
+        CPPUNIT_ASSERT(d_col->data(2) - d_col->data(0) == 11);
+        CPPUNIT_ASSERT(d_col->get(0) == "station 1");
+        CPPUNIT_ASSERT(d_col->get(2) == "2020-03-18T00:00:00Z");
+        CPPUNIT_ASSERT(d_col->bytes() == 29);
+
+        // The last string grows in place
+        d_col->set(2, "2020-03-18T00:00:00.000Z");
+        CPPUNIT_ASSERT(d_col->data(2) - d_col->data(0) == 11);
+        CPPUNIT_ASSERT(d_col->get(2) == "2020-03-18T00:00:00.000Z");
+    }
+
+    // Replacing the strings at the front of a column, in order, as
+    // Vector::set_value_slice_from_row_major_vector() does
+    void set_many_test()
+    {
+        StringColumn c;
+        vector<string> expected;
+        for (int i = 0; i < 1000; ++i) {
+            c.push_back("");
+            expected.push_back("");
+        }
+
+        for (int pass = 0; pass < 3; ++pass) {
+            for (int i = 0; i < 1000; ++i) {
+                ostringstream oss;
+                oss << "value " << i << string(pass * 3, '+');
+                c.set(i, oss.str());
+                expected[i] = oss.str();
+            }
+        }
+
+        uint64_t bytes = 0;
+        for (int i = 0; i < 1000; ++i) {
+            CPPUNIT_ASSERT_EQUAL(expected[i], c.get(i));
+            bytes += expected[i].length();
+        }
+        CPPUNIT_ASSERT_EQUAL(bytes, c.bytes());
+
+        c.resize(10);
+        CPPUNIT_ASSERT_EQUAL(expected[9], c.get(9));
+    }
+
+    void copy_test()
+    {
+        StringColumn c = *d_col;
+        d_col->set(0, "changed");
+        CPPUNIT_ASSERT(c.size() == 3);
+        CPPUNIT_ASSERT(c.get(0) == "station one");
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (StringColumnTest);
+
+} // namespace libdap
+
+int main(int argc, char *argv[])
+{
+    GetOpt getopt(argc, argv, "dh");
+    int option_char;
+
+    while ((option_char = getopt()) != -1)
+        switch (option_char) {
+        case 'd':
+            debug = 1;  // debug is a static global
+            break;
+
+        case 'h': {     // help - show test names
+            cerr << "Usage: StringColumnTest has the following tests:" << endl;
+            const std::vector<Test*> &tests = libdap::StringColumnTest::suite()->getTests();
+            unsigned int prefix_len = libdap::StringColumnTest::suite()->getName().append("::").length();
+            for (std::vector<Test*>::const_iterator i = tests.begin(), e = tests.end(); i != e; ++i) {
+                cerr << (*i)->getName().replace(0, prefix_len, "") << endl;
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+
+    CppUnit::TextTestRunner runner;
+    runner.addTest(CppUnit::TestFactoryRegistry::getRegistry().makeTest());
+
+    bool wasSuccessful = true;
+    string test = "";
+    int i = getopt.optind;
+    if (i == argc) {
+        // run them all
+        wasSuccessful = runner.run("");
+    }
+    else {
+        for (; i < argc; ++i) {
+            if (debug) cerr << "Running " << argv[i] << endl;
+            test = libdap::StringColumnTest::suite()->getName().append("::").append(argv[i]);
+            wasSuccessful = wasSuccessful && runner.run(test);
+        }
+    }
+
+    return wasSuccessful ? 0 : 1;
+}
@@ -27,17 +27,27 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include <fcntl.h>
+#include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <fstream>
+#include <iterator>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "GetOpt.h"
 
 #include "chunked_ostream.h"
 #include "chunked_istream.h"
+#include "D4StreamMarshaller.h"
+#include "D4StreamUnMarshaller.h"
 
 #include "InternalErr.h"
 #include "test_config.h"
@@ -90,7 +100,7 @@ public:
     {
     }
 
-    void single_char_write(const string &file, int buf_size)
+    void single_char_write(const string &file, int buf_size, int max_buf_size = 0)
     {
         fstream infile(file.c_str(), ios::in | ios::binary);
         DBG(cerr << "infile: " << file << endl);
@@ -99,7 +109,7 @@ public:
         string out = file + ".chunked";
         fstream outfile(out.c_str(), ios::out | ios::binary);
 
-        chunked_ostream chunked_outfile(outfile, buf_size);
+        chunked_ostream chunked_outfile(outfile, buf_size, max_buf_size);
 
         char c;
         infile.read(&c, 1);
@@ -117,7 +127,7 @@ public:
         chunked_outfile.flush();
     }
 
-    void write_128char_data(const string &file, int buf_size)
+    void write_128char_data(const string &file, int buf_size, chunk_codec codec = chunk_codec_none)
     {
         fstream infile(file.c_str(), ios::in | ios::binary);
         if (!infile.good()) CPPUNIT_FAIL("File not open or eof");
@@ -126,6 +136,7 @@ public:
         fstream outfile(out.c_str(), ios::out | ios::binary);
 
         chunked_ostream chunked_outfile(outfile, buf_size);
+        chunked_outfile.set_compression(codec);
 
         char str[128];
         infile.read(str, 128);
@@ -143,7 +154,7 @@ public:
         chunked_outfile.flush();
     }
 
-    void write_9000char_data(const string &file, int buf_size)
+    void write_9000char_data(const string &file, int buf_size, int max_buf_size = 0)
     {
         fstream infile(file.c_str(), ios::in | ios::binary);
         if (!infile.good()) CPPUNIT_FAIL("File not open or eof");
@@ -151,7 +162,7 @@ public:
         string out = file + ".chunked";
         fstream outfile(out.c_str(), ios::out | ios::binary);
 
-        chunked_ostream chunked_outfile(outfile, buf_size);
+        chunked_ostream chunked_outfile(outfile, buf_size, max_buf_size);
 
         char str[9000];
         infile.read(str, 9000);
@@ -169,6 +180,39 @@ public:
         chunked_outfile.flush();
     }
 
+    // Like write_9000char_data() but the chunked stream writes to a file
+    // descriptor
+    void write_9000char_data_fd(const string &file, int buf_size)
+    {
+        fstream infile(file.c_str(), ios::in | ios::binary);
+        if (!infile.good()) CPPUNIT_FAIL("File not open or eof");
+
+        string out = file + ".chunked";
+        int fd = open(out.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (fd < 0) CPPUNIT_FAIL("Could not open the output file");
+
+        {
+            chunked_ostream chunked_outfile(fd, buf_size);
+
+            char str[9000];
+            infile.read(str, 9000);
+            int num = infile.gcount();
+            while (num > 0 && !infile.eof()) {
+                chunked_outfile.write(str, num);
+                infile.read(str, 9000);
+                num = infile.gcount();
+            }
+
+            if (num > 0 && !infile.bad()) {
+                chunked_outfile.write(str, num);
+            }
+
+            chunked_outfile.flush();
+        }
+
+        close(fd);
+    }
+
     // This will not work with the small text file. This code assume that
     // the file to be written has at least 24 bytes for the first chunk,
     // which is deliberately sent using flush before the buffer is full and
@@ -225,7 +269,45 @@ public:
         }
     }
 
-    void single_char_read(const string &file, int buf_size)
+    // Read the chunk headers of a chunked file and return the sizes of the
+    // data chunks
+    vector<uint32_t> data_chunk_sizes(const string &file)
+    {
+        string in = file + ".chunked";
+        fstream infile(in.c_str(), ios::in | ios::binary);
+        if (!infile.good()) CPPUNIT_FAIL("File not open or eof");
+
+        vector<uint32_t> sizes;
+        uint32_t header;
+        while (infile.read((char *) &header, 4)) {
+            header = ntohl(header);
+            uint32_t size = header & CHUNK_SIZE_MASK;
+            if ((header & CHUNK_TYPE_MASK) == CHUNK_DATA) sizes.push_back(size);
+            infile.seekg(size, ios::cur);
+        }
+
+        return sizes;
+    }
+
+    // Count the compressed chunks in a chunked file
+    int compressed_chunks(const string &file)
+    {
+        string in = file + ".chunked";
+        fstream infile(in.c_str(), ios::in | ios::binary);
+        if (!infile.good()) CPPUNIT_FAIL("File not open or eof");
+
+        int count = 0;
+        uint32_t header;
+        while (infile.read((char *) &header, 4)) {
+            header = ntohl(header);
+            if (header & CHUNK_CODEC_MASK) ++count;
+            infile.seekg(header & CHUNK_SIZE_MASK, ios::cur);
+        }
+
+        return count;
+    }
+
+    void single_char_read(const string &file, int buf_size, bool read_ahead = false)
     {
         string in = file + ".chunked";
         fstream infile(in.c_str(), ios::in | ios::binary);
@@ -235,6 +317,7 @@ public:
 #else
         chunked_istream chunked_infile(infile, buf_size);
 #endif
+        if (read_ahead) chunked_infile.start_read_ahead();
         string out = file + ".plain";
         fstream outfile(out.c_str(), ios::out | ios::binary);
 
@@ -257,12 +340,13 @@ public:
         outfile.flush();
     }
 
-    void read_128char_data(const string &file, int buf_size)
+    void read_128char_data(const string &file, int buf_size, bool read_ahead = false)
     {
         string in = file + ".chunked";
         fstream infile(in.c_str(), ios::in | ios::binary);
         if (!infile.good()) cerr << "File not open or eof" << endl;
         chunked_istream chunked_infile(infile, buf_size);
+        if (read_ahead) chunked_infile.start_read_ahead();
 
         string out = file + ".plain";
         fstream outfile(out.c_str(), ios::out | ios::binary);
@@ -286,12 +370,13 @@ public:
         outfile.flush();
     }
 
-    void read_5000char_data(const string &file, int buf_size)
+    void read_5000char_data(const string &file, int buf_size, bool read_ahead = false)
     {
         string in = file + ".chunked";
         fstream infile(in.c_str(), ios::in | ios::binary);
         if (!infile.good()) cerr << "File not open or eof" << endl;
         chunked_istream chunked_infile(infile, buf_size);
+        if (read_ahead) chunked_infile.start_read_ahead();
 
         string out = file + ".plain";
         fstream outfile(out.c_str(), ios::out | ios::binary);
@@ -315,12 +400,13 @@ public:
         outfile.flush();
     }
 
-    void read_24char_data_with_error_option(const string &file, int buf_size)
+    void read_24char_data_with_error_option(const string &file, int buf_size, bool read_ahead = false)
     {
         string in = file + ".chunked";
         fstream infile(in.c_str(), ios::in | ios::binary);
         if (!infile.good()) cerr << "File not open or eof" << endl;
         chunked_istream chunked_infile(infile, buf_size);
+        if (read_ahead) chunked_infile.start_read_ahead();
 
         string out = file + ".plain";
         fstream outfile(out.c_str(), ios::out | ios::binary);
@@ -545,6 +631,414 @@ public:
         CPPUNIT_ASSERT(system(cmp.c_str()) == 0);
     }
 
+    void test_fd_write_9000_read_5000_big_file_3()
+    {
+        // The chunks written to a file descriptor must match those written
+        // to a stream
+        write_9000char_data(big_file_3, 4000);
+        string mv = "mv " + big_file_3 + ".chunked " + big_file_3 + ".chunked.os";
+        CPPUNIT_ASSERT(system(mv.c_str()) == 0);
+
+        write_9000char_data_fd(big_file_3, 4000);
+        string cmp_chunked = "cmp " + big_file_3 + ".chunked " + big_file_3 + ".chunked.os";
+        CPPUNIT_ASSERT(system(cmp_chunked.c_str()) == 0);
+
+        read_5000char_data(big_file_3, 3096);
+        string cmp = "cmp " + big_file_3 + " " + big_file_3 + ".plain";
+        CPPUNIT_ASSERT(system(cmp.c_str()) == 0);
+
+        string rm = "rm -f " + big_file_3 + ".chunked.os";
+        system(rm.c_str());
+    }
+
+    void test_adaptive_write_1_read_128_big_file()
+    {
+        single_char_write(big_file, 28, 4096);
+        read_128char_data(big_file, 28);
+        string cmp = "cmp " + big_file + " " + big_file + ".plain";
+        CPPUNIT_ASSERT(system(cmp.c_str()) == 0);
+
+        // The chunks start at 28 bytes and double until they are 4096 bytes
+        vector<uint32_t> sizes = data_chunk_sizes(big_file);
+        CPPUNIT_ASSERT(sizes.size() > 8);
+        CPPUNIT_ASSERT_EQUAL((uint32_t)28, sizes[0]);
+        CPPUNIT_ASSERT_EQUAL((uint32_t)56, sizes[1]);
+        CPPUNIT_ASSERT_EQUAL((uint32_t)4096, sizes[sizes.size() - 2]);
+        for (unsigned int i = 1; i < sizes.size() - 1; ++i)
+            CPPUNIT_ASSERT(sizes[i] == std::min(sizes[i - 1] * 2, (uint32_t)4096));
+    }
+
+    void test_adaptive_write_9000_read_5000_big_file_3()
+    {
+        write_9000char_data(big_file_3, 1000, CHUNK_SIZE_MAX);
+        read_5000char_data(big_file_3, 3096);
+        string cmp = "cmp " + big_file_3 + " " + big_file_3 + ".plain";
+        CPPUNIT_ASSERT(system(cmp.c_str()) == 0);
+
+        // 425996 bytes are sent as 1000, 2000, ..., 256000 byte chunks
+        vector<uint32_t> sizes = data_chunk_sizes(big_file_3);
+        CPPUNIT_ASSERT_EQUAL((uint32_t)1000, sizes[0]);
+        CPPUNIT_ASSERT(sizes.size() <= 10);
+    }
+
+    void test_adaptive_max_chunk_size()
+    {
+        ostringstream oss;
+        chunked_ostream cos(oss, 32);
+        CPPUNIT_ASSERT_EQUAL(32U, cos.get_chunk_size());
+
+        // The chunk size is fixed by default
+        cos << string(100, 'x');
+        CPPUNIT_ASSERT_EQUAL(32U, cos.get_chunk_size());
+
+        cos.set_max_chunk_size(100);
+        cos << string(32, 'x');
+        CPPUNIT_ASSERT_EQUAL(64U, cos.get_chunk_size());
+        cos << string(64, 'x');
+        CPPUNIT_ASSERT_EQUAL(100U, cos.get_chunk_size());
+
+        CPPUNIT_ASSERT_THROW(cos.set_max_chunk_size(CHUNK_SIZE_MAX + 1), std::out_of_range);
+    }
+
+    void test_direct_read_big_file_3()
+    {
+        write_9000char_data(big_file_3, 1000);
+
+        fstream plain(big_file_3.c_str(), ios::in | ios::binary);
+        vector<char> expected((istreambuf_iterator<char>(plain)), istreambuf_iterator<char>());
+
+        string in = big_file_3 + ".chunked";
+        fstream infile(in.c_str(), ios::in | ios::binary);
+        chunked_istream chunked_infile(infile, 1000);
+
+        // A small read fills the internal buffer with part of the first chunk
+        char c = chunked_infile.get();
+        CPPUNIT_ASSERT_EQUAL(expected[0], c);
+        CPPUNIT_ASSERT_EQUAL(999, chunked_infile.bytes_in_buffer());
+
+        // A large read that crosses many chunks and ends part way through a
+        // chunk goes straight to the caller; nothing is left in the buffer
+        vector<char> data(100000);
+        chunked_infile.read(&data[0], data.size());
+        CPPUNIT_ASSERT_EQUAL((streamsize)data.size(), chunked_infile.gcount());
+        CPPUNIT_ASSERT(equal(data.begin(), data.end(), expected.begin() + 1));
+        CPPUNIT_ASSERT_EQUAL(0, chunked_infile.bytes_in_buffer());
+
+        // The next read picks up in the middle of that chunk
+        chunked_infile.read(&data[0], 10);
+        CPPUNIT_ASSERT(equal(data.begin(), data.begin() + 10, expected.begin() + 100001));
+
+        // Read past the end
+        data.resize(expected.size());
+        chunked_infile.read(&data[0], data.size());
+        CPPUNIT_ASSERT_EQUAL((streamsize)(expected.size() - 100011), chunked_infile.gcount());
+        CPPUNIT_ASSERT(equal(data.begin(), data.begin() + chunked_infile.gcount(), expected.begin() + 100011));
+        CPPUNIT_ASSERT(chunked_infile.eof());
+        CPPUNIT_ASSERT(!chunked_infile.error());
+    }
+
+    void test_read_next_chunk_skips_rest_of_chunk()
+    {
+        write_9000char_data(big_file_3, 1000);
+
+        fstream plain(big_file_3.c_str(), ios::in | ios::binary);
+        vector<char> expected((istreambuf_iterator<char>(plain)), istreambuf_iterator<char>());
+
+        string in = big_file_3 + ".chunked";
+        fstream infile(in.c_str(), ios::in | ios::binary);
+        chunked_istream chunked_infile(infile, 100);
+
+        char data[1500];
+        chunked_infile.read(data, 1500);
+        CPPUNIT_ASSERT_EQUAL(1000, chunked_infile.read_next_chunk());
+        CPPUNIT_ASSERT_EQUAL(1000, chunked_infile.bytes_in_buffer());
+        chunked_infile.read(data, 1000);
+        CPPUNIT_ASSERT(equal(data, data + 1000, expected.begin() + 2000));
+    }
+
+    // Read using a second thread
+
+    void test_read_ahead_write_1_read_1_text_file()
+    {
+        single_char_write(text_file, 32);
+        single_char_read(text_file, 32, true);
+        string cmp = "cmp " + text_file + " " + text_file + ".plain";
+        CPPUNIT_ASSERT(system(cmp.c_str()) == 0);
+    }
+
+    void test_read_ahead_write_128_read_128_big_file()
+    {
+        write_128char_data(big_file, 28);
+        read_128char_data(big_file, 28, true);
+        string cmp = "cmp " + big_file + " " + big_file + ".plain";
+        CPPUNIT_ASSERT(system(cmp.c_str()) == 0);
+    }
+
+    void test_read_ahead_write_9000_read_5000_big_file_3()
+    {
+        write_9000char_data(big_file_3, 1000, CHUNK_SIZE_MAX);
+        read_5000char_data(big_file_3, 3096, true);
+        string cmp = "cmp " + big_file_3 + " " + big_file_3 + ".plain";
+        CPPUNIT_ASSERT(system(cmp.c_str()) == 0);
+    }
+
+    void test_read_ahead_part_way_through_chunk()
+    {
+        write_9000char_data(big_file_3, 1000);
+
+        fstream plain(big_file_3.c_str(), ios::in | ios::binary);
+        vector<char> expected((istreambuf_iterator<char>(plain)), istreambuf_iterator<char>());
+
+        string in = big_file_3 + ".chunked";
+        fstream infile(in.c_str(), ios::in | ios::binary);
+        chunked_istream chunked_infile(infile, 1000);
+
+        // The first chunk holds the DMR in a real response
+        CPPUNIT_ASSERT_EQUAL(1000, chunked_infile.read_next_chunk());
+        char c = chunked_infile.get();
+        CPPUNIT_ASSERT_EQUAL(expected[0], c);
+
+        vector<char> data(expected.size());
+        chunked_infile.read(&data[0], 1500);
+
+        chunked_infile.start_read_ahead();
+        CPPUNIT_ASSERT(chunked_infile.read_ahead());
+
+        chunked_infile.read(&data[1500], expected.size());
+        CPPUNIT_ASSERT_EQUAL((streamsize)(expected.size() - 1501), chunked_infile.gcount());
+        CPPUNIT_ASSERT(equal(data.begin(), data.end() - 1, expected.begin() + 1));
+        CPPUNIT_ASSERT(chunked_infile.eof());
+    }
+
+    void test_read_ahead_stop_early()
+    {
+        write_9000char_data(big_file_3, 100);
+
+        string in = big_file_3 + ".chunked";
+        fstream infile(in.c_str(), ios::in | ios::binary);
+        {
+            chunked_istream chunked_infile(infile, 100);
+            chunked_infile.start_read_ahead(4);
+            char data[250];
+            chunked_infile.read(data, 250);
+            CPPUNIT_ASSERT_EQUAL((streamsize)250, chunked_infile.gcount());
+            // The stream is destroyed while the thread is waiting for space
+        }
+    }
+
+    void test_read_ahead_write_24_read_24_big_file_2_error()
+    {
+        write_24char_data_with_error_option(big_file_2, 2048, true /*error*/);
+        try {
+            read_24char_data_with_error_option(big_file_2, 2048, true);
+            CPPUNIT_FAIL("Should have caught an error message");
+        }
+        catch (Error &e) {
+            CPPUNIT_ASSERT(!e.get_error_message().empty());
+        }
+    }
+
+    // Compressed chunks
+
+    void test_compression_available()
+    {
+        CPPUNIT_ASSERT(chunk_codec_available(chunk_codec_none));
+
+        ostringstream oss;
+        chunked_ostream cos(oss, 32);
+        CPPUNIT_ASSERT_EQUAL(chunk_codec_available(chunk_codec_lz4), cos.set_compression(chunk_codec_lz4));
+        CPPUNIT_ASSERT(cos.set_compression(chunk_codec_none));
+        CPPUNIT_ASSERT_EQUAL(chunk_codec_none, cos.get_compression());
+    }
+
+    void test_zlib_write_128_read_128_text_file()
+    {
+        if (!chunk_codec_available(chunk_codec_zlib)) return;
+
+        write_128char_data(text_file, 1024, chunk_codec_zlib);
+        CPPUNIT_ASSERT(compressed_chunks(text_file) > 0);
+
+        read_128char_data(text_file, 1024);
+        string cmp = "cmp " + text_file + " " + text_file + ".plain";
+        CPPUNIT_ASSERT(system(cmp.c_str()) == 0);
+    }
+
+    void test_zlib_write_128_read_1_text_file()
+    {
+        if (!chunk_codec_available(chunk_codec_zlib)) return;
+
+        write_128char_data(text_file, 1024, chunk_codec_zlib);
+        single_char_read(text_file, 32);
+        string cmp = "cmp " + text_file + " " + text_file + ".plain";
+        CPPUNIT_ASSERT(system(cmp.c_str()) == 0);
+    }
+
+    void test_zlib_read_ahead_write_128_read_128_text_file()
+    {
+        if (!chunk_codec_available(chunk_codec_zlib)) return;
+
+        write_128char_data(text_file, 1024, chunk_codec_zlib);
+        read_128char_data(text_file, 1024, true);
+        string cmp = "cmp " + text_file + " " + text_file + ".plain";
+        CPPUNIT_ASSERT(system(cmp.c_str()) == 0);
+    }
+
+    void test_zlib_write_128_read_5000_big_file()
+    {
+        if (!chunk_codec_available(chunk_codec_zlib)) return;
+
+        write_128char_data(big_file, 4096, chunk_codec_zlib);
+        read_5000char_data(big_file, 4096);
+        string cmp = "cmp " + big_file + " " + big_file + ".plain";
+        CPPUNIT_ASSERT(system(cmp.c_str()) == 0);
+    }
+
+    void test_zlib_read_next_chunk()
+    {
+        if (!chunk_codec_available(chunk_codec_zlib)) return;
+
+        ostringstream oss;
+        {
+            chunked_ostream cos(oss, 1024);
+            cos.set_compression(chunk_codec_zlib);
+            cos << string(500, 'a') << flush;
+            cos << string(200, 'b');
+        }
+        // Both chunks are compressed
+        CPPUNIT_ASSERT(oss.str().size() < 200);
+
+        istringstream iss(oss.str());
+        chunked_istream cis(iss, 100);
+        CPPUNIT_ASSERT_EQUAL(500, cis.read_next_chunk());
+        string data(500, ' ');
+        cis.read(&data[0], 500);
+        CPPUNIT_ASSERT_EQUAL(string(500, 'a'), data);
+
+        // The END chunk holds the rest
+        data.resize(200);
+        cis.read(&data[0], 200);
+        CPPUNIT_ASSERT_EQUAL(string(200, 'b'), data);
+        CPPUNIT_ASSERT(cis.get() == EOF);
+    }
+
+    // Write a field of temperatures using D4StreamMarshaller and zlib
+    string write_temperatures(const vector<dods_float32> &temps, bool filtered)
+    {
+        ostringstream oss;
+        {
+            chunked_ostream cos(oss, 4096, BULK_CHUNK_SIZE);
+            cos.set_compression(chunk_codec_zlib);
+            cos.set_filtered(filtered);
+            cos << "<Dataset/>" << flush;
+
+            D4StreamMarshaller m(cos);
+            m.set_filters(filtered ? vector_filter_shuffle | vector_filter_delta : vector_filter_none);
+            m.put_vector_float32(reinterpret_cast<char*>(const_cast<dods_float32*>(&temps[0])), temps.size());
+            m.put_checksum();
+        }
+        return oss.str();
+    }
+
+    void test_zlib_filtered_arrays()
+    {
+        if (!chunk_codec_available(chunk_codec_zlib)) return;
+
+        vector<dods_float32> temps(200 * 300);
+        for (int y = 0; y < 200; ++y)
+            for (int x = 0; x < 300; ++x)
+                temps[y * 300 + x] = 280.0 + 15.0 * sin(y / 40.0) + 5.0 * cos(x / 25.0);
+
+        string plain = write_temperatures(temps, false);
+        string filtered = write_temperatures(temps, true);
+        DBG(cerr << "compressed: " << plain.size() << ", filtered and compressed: " << filtered.size() << endl);
+        CPPUNIT_ASSERT(filtered.size() < plain.size());
+
+        istringstream iss(filtered);
+        chunked_istream cis(iss, 4096);
+        CPPUNIT_ASSERT_EQUAL(10, cis.read_next_chunk());
+        CPPUNIT_ASSERT(cis.filtered());
+        string dmr(10, ' ');
+        cis.read(&dmr[0], 10);
+
+        D4StreamUnMarshaller um(cis, cis.twiddle_bytes());
+        vector<dods_float32> temps2(temps.size());
+        um.get_vector_float32(reinterpret_cast<char*>(&temps2[0]), temps2.size());
+        CPPUNIT_ASSERT(temps == temps2);
+        um.get_checksum();
+
+        // The unmarshaller makes the stream throw at EOF
+        cis.exceptions(istream::goodbit);
+        CPPUNIT_ASSERT(cis.get() == EOF);
+    }
+
+    // Filters set on a marshaller writing to a stream that is not marked
+    // filtered are not used; the reader would not read the filter byte
+    void test_filters_need_filtered_stream()
+    {
+        vector<dods_int32> vals(100);
+        for (unsigned int i = 0; i < vals.size(); ++i)
+            vals[i] = 1000 + i;
+
+        ostringstream oss;
+        {
+            chunked_ostream cos(oss, 4096);
+            D4StreamMarshaller m(cos);
+            m.set_filters(vector_filter_shuffle | vector_filter_delta);
+            m.put_vector(reinterpret_cast<char*>(&vals[0]), vals.size(), sizeof(dods_int32));
+        }
+        // One END chunk with just the values
+        CPPUNIT_ASSERT_EQUAL(sizeof(uint32_t) + vals.size() * sizeof(dods_int32), oss.str().size());
+
+        istringstream iss(oss.str());
+        chunked_istream cis(iss, 4096);
+        D4StreamUnMarshaller um(cis, cis.twiddle_bytes());
+        vector<dods_int32> vals2(vals.size());
+        um.get_vector(reinterpret_cast<char*>(&vals2[0]), vals2.size(), sizeof(dods_int32));
+        CPPUNIT_ASSERT(!cis.filtered());
+        CPPUNIT_ASSERT(vals == vals2);
+    }
+
+    // The reader uses the CHUNK_FILTERED bit of the first chunk
+    void test_filtered_fixed_after_first_chunk()
+    {
+        ostringstream oss;
+        chunked_ostream cos(oss, 4096);
+        CPPUNIT_ASSERT(cos.set_filtered(true));
+        CPPUNIT_ASSERT(cos.set_filtered(false));
+        CPPUNIT_ASSERT(cos.set_filtered(true));
+
+        cos << "<Dataset/>" << flush;
+        CPPUNIT_ASSERT(!cos.set_filtered(false));
+        CPPUNIT_ASSERT(cos.get_filtered());
+        CPPUNIT_ASSERT(cos.set_filtered(true));
+    }
+
+    void test_chunk_feature_accepted()
+    {
+        CPPUNIT_ASSERT(chunk_feature_accepted("filtered", CHUNK_FEATURE_FILTERED));
+        CPPUNIT_ASSERT(chunk_feature_accepted("zlib, filtered", CHUNK_FEATURE_FILTERED));
+        CPPUNIT_ASSERT(chunk_feature_accepted(" filtered ,zlib", CHUNK_FEATURE_FILTERED));
+        CPPUNIT_ASSERT(!chunk_feature_accepted("", CHUNK_FEATURE_FILTERED));
+        CPPUNIT_ASSERT(!chunk_feature_accepted("unfiltered, filteredx", CHUNK_FEATURE_FILTERED));
+        CPPUNIT_ASSERT(!chunk_feature_accepted(", ,", CHUNK_FEATURE_FILTERED));
+    }
+
+    void test_chunk_codec_accepted()
+    {
+        CPPUNIT_ASSERT(chunk_codec_accepted("", chunk_codec_none));
+        CPPUNIT_ASSERT(!chunk_codec_accepted("filtered", chunk_codec_zlib));
+        CPPUNIT_ASSERT(!chunk_codec_accepted("filtered", chunk_codec_lz4));
+        CPPUNIT_ASSERT_EQUAL(chunk_codec_available(chunk_codec_zlib), chunk_codec_accepted("filtered, zlib", chunk_codec_zlib));
+        CPPUNIT_ASSERT_EQUAL(chunk_codec_available(chunk_codec_lz4), chunk_codec_accepted("lz4,zlib", chunk_codec_lz4));
+
+        // A client built from this library lists what it can read
+        string features = chunk_client_features();
+        DBG(cerr << "Client features: " << features << endl);
+        CPPUNIT_ASSERT(chunk_feature_accepted(features, CHUNK_FEATURE_FILTERED));
+        CPPUNIT_ASSERT_EQUAL(chunk_codec_available(chunk_codec_zlib), chunk_codec_accepted(features, chunk_codec_zlib));
+        CPPUNIT_ASSERT_EQUAL(chunk_codec_available(chunk_codec_lz4), chunk_codec_accepted(features, chunk_codec_lz4));
+    }
+
     // Send an error
 
     void test_write_24_read_24_big_file_2_error()
@@ -590,6 +1084,33 @@ public:
     CPPUNIT_TEST (test_write_24_read_24_big_file_2_error);
 
     CPPUNIT_TEST (test_write_9000_read_5000_big_file_3);
+    CPPUNIT_TEST (test_fd_write_9000_read_5000_big_file_3);
+
+    CPPUNIT_TEST (test_adaptive_write_1_read_128_big_file);
+    CPPUNIT_TEST (test_adaptive_write_9000_read_5000_big_file_3);
+    CPPUNIT_TEST (test_adaptive_max_chunk_size);
+
+    CPPUNIT_TEST (test_direct_read_big_file_3);
+    CPPUNIT_TEST (test_read_next_chunk_skips_rest_of_chunk);
+
+    CPPUNIT_TEST (test_read_ahead_write_1_read_1_text_file);
+    CPPUNIT_TEST (test_read_ahead_write_128_read_128_big_file);
+    CPPUNIT_TEST (test_read_ahead_write_9000_read_5000_big_file_3);
+    CPPUNIT_TEST (test_read_ahead_part_way_through_chunk);
+    CPPUNIT_TEST (test_read_ahead_stop_early);
+    CPPUNIT_TEST (test_read_ahead_write_24_read_24_big_file_2_error);
+
+    CPPUNIT_TEST (test_compression_available);
+    CPPUNIT_TEST (test_zlib_write_128_read_128_text_file);
+    CPPUNIT_TEST (test_zlib_write_128_read_1_text_file);
+    CPPUNIT_TEST (test_zlib_read_ahead_write_128_read_128_text_file);
+    CPPUNIT_TEST (test_zlib_write_128_read_5000_big_file);
+    CPPUNIT_TEST (test_zlib_read_next_chunk);
+    CPPUNIT_TEST (test_zlib_filtered_arrays);
+    CPPUNIT_TEST (test_filters_need_filtered_stream);
+    CPPUNIT_TEST (test_filtered_fixed_after_first_chunk);
+    CPPUNIT_TEST (test_chunk_feature_accepted);
+    CPPUNIT_TEST (test_chunk_codec_accepted);
 
     CPPUNIT_TEST_SUITE_END();
 };
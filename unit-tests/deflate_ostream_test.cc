@@ -0,0 +1,319 @@
+// -*- mode: c++; c-basic-offset:4 -*-
+
+// This file is part of libdap, A C++ implementation of the OPeNDAP Data
+// Access Protocol.
+
+// Copyright (c) 2026 OPeNDAP, Inc.
+// Author: agent <agent@local>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//
+// You can contact OPeNDAP, Inc. at PO Box 112, Saunderstown, RI. 02874-0112.
+
+#include "config.h"
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#if HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+#include "deflate_ostream.h"
+#include "InternalErr.h"
+
+#include "debug.h"
+#include "GetOpt.h"
+
+using namespace CppUnit;
+using namespace std;
+
+static bool debug = false;
+
+#undef DBG
+#define DBG(x) do { if (debug) {x;} } while(false)
+
+namespace libdap {
+
+class deflate_ostream_test: public TestFixture {
+private:
+    string d_data;
+
+    // Decompress a gzip (or zlib) stream using zlib; returns false if the
+    // stream is not valid or has extra bytes after its end.
+    bool inflate_all(const string &in, deflate_format format, string &out)
+    {
+#if HAVE_LIBZ
+        z_stream strm;
+        memset(&strm, 0, sizeof(strm));
+        if (inflateInit2(&strm, format == deflate_gzip ? 15 + 16 : 15) != Z_OK) return false;
+
+        strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        strm.avail_in = in.size();
+
+        char buf[16 * 1024];
+        int status;
+        do {
+            strm.next_out = reinterpret_cast<Bytef*>(buf);
+            strm.avail_out = sizeof(buf);
+            status = inflate(&strm, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END) {
+                DBG(cerr << "inflate: " << status << endl);
+                inflateEnd(&strm);
+                return false;
+            }
+            out.append(buf, sizeof(buf) - strm.avail_out);
+        } while (status != Z_STREAM_END);
+
+        bool all_used = strm.avail_in == 0;
+        inflateEnd(&strm);
+        return all_used;
+#else
+        return false;
+#endif
+    }
+
+    void round_trip(deflate_format format, unsigned int num_threads, unsigned int block_size)
+    {
+        ostringstream oss;
+        {
+            deflate_ostream zout(oss, format, -1, num_threads, block_size);
+            zout.write(d_data.data(), d_data.size());
+        }
+
+        DBG(cerr << "threads: " << num_threads << ", block size: " << block_size << ", compressed "
+            << d_data.size() << " to " << oss.str().size() << endl);
+
+        string out;
+        CPPUNIT_ASSERT(inflate_all(oss.str(), format, out));
+        CPPUNIT_ASSERT(out == d_data);
+        // The data repeat, so they should compress well
+        CPPUNIT_ASSERT(oss.str().size() < d_data.size() / 4);
+    }
+
+public:
+    deflate_ostream_test()
+    {
+        // About 1MB of text that repeats with some variation
+        ostringstream oss;
+        for (int i = 0; i < 40000; ++i)
+            oss << "Row " << i % 997 << ": temperature " << (i * 7) % 113 << "\n";
+        d_data = oss.str();
+    }
+
+    ~deflate_ostream_test()
+    {
+    }
+
+    void setUp()
+    {
+        if (!deflate_ostream::available())
+            throw InternalErr(__FILE__, __LINE__, "This version of libdap was built without zlib.");
+    }
+
+    CPPUNIT_TEST_SUITE (deflate_ostream_test);
+
+    CPPUNIT_TEST (gzip_one_thread_test);
+    CPPUNIT_TEST (gzip_zero_threads_test);
+    CPPUNIT_TEST (gzip_four_threads_test);
+    CPPUNIT_TEST (gzip_small_blocks_test);
+    CPPUNIT_TEST (zlib_four_threads_test);
+    CPPUNIT_TEST (thread_count_test);
+    CPPUNIT_TEST (flush_test);
+    CPPUNIT_TEST (many_blocks_test);
+    CPPUNIT_TEST (empty_stream_test);
+    CPPUNIT_TEST (finish_test);
+
+    CPPUNIT_TEST_SUITE_END();
+
+    void gzip_one_thread_test()
+    {
+        round_trip(deflate_gzip, 1, DEFLATE_BLOCK_SIZE);
+    }
+
+    // Zero threads is the same as one
+    void gzip_zero_threads_test()
+    {
+        round_trip(deflate_gzip, 0, 64 * 1024);
+    }
+
+    void gzip_four_threads_test()
+    {
+        round_trip(deflate_gzip, 4, DEFLATE_BLOCK_SIZE);
+    }
+
+    // Blocks smaller than the 32KB dictionary
+    void gzip_small_blocks_test()
+    {
+        round_trip(deflate_gzip, 3, 1000);
+    }
+
+    void zlib_four_threads_test()
+    {
+        round_trip(deflate_zlib, 4, 64 * 1024);
+    }
+
+    // The response is the same no matter how many threads compress it
+    void thread_count_test()
+    {
+        ostringstream one, many;
+        {
+            deflate_ostream zout(one, deflate_gzip, 6, 1, 64 * 1024);
+            zout << d_data;
+        }
+        {
+            deflate_ostream zout(many, deflate_gzip, 6, 8, 64 * 1024);
+            zout << d_data;
+        }
+
+        CPPUNIT_ASSERT(one.str() == many.str());
+    }
+
+    // Data sent by flush() can be decompressed before the stream ends
+    void flush_test()
+    {
+        ostringstream oss;
+        deflate_ostream zout(oss, deflate_gzip, -1, 2, 4096);
+        zout << "Data:\n" << flush;
+
+#if HAVE_LIBZ
+        z_stream strm;
+        memset(&strm, 0, sizeof(strm));
+        CPPUNIT_ASSERT(inflateInit2(&strm, 15 + 16) == Z_OK);
+        string part = oss.str();
+        strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(part.data()));
+        strm.avail_in = part.size();
+        char buf[64];
+        strm.next_out = reinterpret_cast<Bytef*>(buf);
+        strm.avail_out = sizeof(buf);
+        CPPUNIT_ASSERT(inflate(&strm, Z_SYNC_FLUSH) == Z_OK);
+        inflateEnd(&strm);
+        CPPUNIT_ASSERT(string(buf, sizeof(buf) - strm.avail_out) == "Data:\n");
+#endif
+
+        zout.write(d_data.data(), d_data.size());
+        CPPUNIT_ASSERT(zout.finish());
+
+        string out;
+        CPPUNIT_ASSERT(inflate_all(oss.str(), deflate_gzip, out));
+        CPPUNIT_ASSERT(out == "Data:\n" + d_data);
+    }
+
+    // Many more blocks than threads, with flushes between the writes, so
+    // each thread compresses many blocks.
+    void many_blocks_test()
+    {
+        ostringstream one, many;
+        {
+            deflate_ostream zout(one, deflate_gzip, 6, 1, 1000);
+            for (string::size_type i = 0; i < d_data.size(); i += 7000)
+                zout << d_data.substr(i, 7000) << flush;
+        }
+        {
+            deflate_ostream zout(many, deflate_gzip, 6, 3, 1000);
+            for (string::size_type i = 0; i < d_data.size(); i += 7000)
+                zout << d_data.substr(i, 7000) << flush;
+        }
+
+        CPPUNIT_ASSERT(one.str() == many.str());
+
+        string out;
+        CPPUNIT_ASSERT(inflate_all(many.str(), deflate_gzip, out));
+        CPPUNIT_ASSERT(out == d_data);
+    }
+
+    void empty_stream_test()
+    {
+        ostringstream oss;
+        {
+            deflate_ostream zout(oss);
+        }
+
+        string out;
+        CPPUNIT_ASSERT(inflate_all(oss.str(), deflate_gzip, out));
+        CPPUNIT_ASSERT(out.empty());
+    }
+
+    // Data written after finish() are not sent
+    void finish_test()
+    {
+        ostringstream oss;
+        deflate_ostream zout(oss, deflate_zlib, 9, 2, 1024);
+        zout << d_data.substr(0, 5000);
+        CPPUNIT_ASSERT(zout.finish());
+
+        zout << "more";
+        CPPUNIT_ASSERT(zout.bad());
+
+        string out;
+        CPPUNIT_ASSERT(inflate_all(oss.str(), deflate_zlib, out));
+        CPPUNIT_ASSERT(out == d_data.substr(0, 5000));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(deflate_ostream_test);
+
+} // namespace libdap
+
+int main(int argc, char *argv[])
+{
+    GetOpt getopt(argc, argv, "dh");
+    int option_char;
+
+    while ((option_char = getopt()) != -1)
+        switch (option_char) {
+        case 'd':
+            debug = 1;  // debug is a static global
+            break;
+
+        case 'h': {     // help - show test names
+            cerr << "Usage: deflate_ostream_test has the following tests:" << endl;
+            const std::vector<Test*> &tests = libdap::deflate_ostream_test::suite()->getTests();
+            unsigned int prefix_len = libdap::deflate_ostream_test::suite()->getName().append("::").length();
+            for (std::vector<Test*>::const_iterator i = tests.begin(), e = tests.end(); i != e; ++i) {
+                cerr << (*i)->getName().replace(0, prefix_len, "") << endl;
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+
+    CppUnit::TextTestRunner runner;
+    runner.addTest(CppUnit::TestFactoryRegistry::getRegistry().makeTest());
+
+    bool wasSuccessful = true;
+    string test = "";
+    int i = getopt.optind;
+    if (i == argc) {
+        // run them all
+        wasSuccessful = runner.run("");
+    }
+    else {
+        for (; i < argc; ++i) {
+            if (debug) cerr << "Running " << argv[i] << endl;
+            test = libdap::deflate_ostream_test::suite()->getName().append("::").append(argv[i]);
+            wasSuccessful = wasSuccessful && runner.run(test);
+        }
+    }
+
+    return wasSuccessful ? 0 : 1;
+}
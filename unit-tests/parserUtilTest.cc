@@ -26,6 +26,8 @@
 #include <cppunit/extensions/TestFactoryRegistry.h>
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <pthread.h>
+
 #include "parser.h"
 
 #include "GetOpt.h"
@@ -60,6 +62,7 @@ public:
     CPPUNIT_TEST (check_byte_test);
     CPPUNIT_TEST (check_float32_test);
     CPPUNIT_TEST (check_float64_test);
+    CPPUNIT_TEST (parser_lock_test);
 
     CPPUNIT_TEST_SUITE_END();
 
@@ -140,6 +143,29 @@ public:
         CPPUNIT_ASSERT(!check_float64("2.0E-308"));
         CPPUNIT_ASSERT(!check_float64("-2.0E-308"));
     }
+
+    static void *lock_dds_grammar(void *arg)
+    {
+        parser_lock lock(parser_lock::dds_grammar);
+        *static_cast<bool*>(arg) = true;
+        return 0;
+    }
+
+    void parser_lock_test()
+    {
+        parser_lock lock(parser_lock::das_grammar);
+        {
+            // The locks are recursive
+            parser_lock nested(parser_lock::das_grammar);
+        }
+
+        // Another thread can use a different grammar while this one is locked
+        bool locked = false;
+        pthread_t thread;
+        CPPUNIT_ASSERT(pthread_create(&thread, 0, lock_dds_grammar, &locked) == 0);
+        CPPUNIT_ASSERT(pthread_join(thread, 0) == 0);
+        CPPUNIT_ASSERT(locked);
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION (parserUtilTest);